@@ -4,15 +4,39 @@ elseif (APPLE)
   set(GLSL_VALIDATOR "${VULKAN_SDK}/bin/glslangValidator")
 endif()
 
+# Engine/Shaders is on the include path of every shader, e.g. #include "bvh.glsl"
+set(GLSL_INCLUDE_DIR "${CMAKE_CURRENT_LIST_DIR}/../Engine/Shaders")
+
+# included files are taken from the depfile glslang writes where the generator reads depfiles,
+# otherwise every shader depends on all the includes
+if (CMAKE_GENERATOR MATCHES "Ninja|Makefiles")
+	set(GLSL_DEPFILE ON)
+	set(GLSL_INCLUDES)
+else()
+	set(GLSL_DEPFILE OFF)
+	file(GLOB GLSL_INCLUDES CONFIGURE_DEPENDS "${GLSL_INCLUDE_DIR}/*.glsl")
+endif()
+
+# sets GLSL_DEPENDENCY_OPTIONS for glslang and GLSL_DEPENDENCY_ARGS for add_custom_command
+macro(GLSL_DEPENDENCIES GLSL SPIRV)
+	set(GLSL_DEPENDENCY_OPTIONS)
+	set(GLSL_DEPENDENCY_ARGS DEPENDS ${GLSL} ${GLSL_INCLUDES})
+	if (GLSL_DEPFILE)
+		set(GLSL_DEPENDENCY_OPTIONS --depfile ${SPIRV}.d)
+		list(APPEND GLSL_DEPENDENCY_ARGS DEPFILE ${SPIRV}.d)
+	endif()
+endmacro()
+
 macro(APPEND_GLSL_TO_TARGET target sources)
 	foreach(GLSL ${sources})
 		get_filename_component(FILE_NAME ${GLSL} NAME)
 		set(SPIRV "${CMAKE_CURRENT_BINARY_DIR}/Shaders/${FILE_NAME}.spv")
+		GLSL_DEPENDENCIES(${GLSL} ${SPIRV})
 		add_custom_command(
 			OUTPUT ${SPIRV}
 			COMMAND ${CMAKE_COMMAND} -E make_directory ${CMAKE_CURRENT_BINARY_DIR}/Shaders
-			COMMAND ${GLSL_VALIDATOR} -V ${GLSL} -o ${SPIRV}
-			DEPENDS ${GLSL})
+			COMMAND ${GLSL_VALIDATOR} -V -I${GLSL_INCLUDE_DIR} ${GLSL_DEPENDENCY_OPTIONS} ${GLSL} -o ${SPIRV}
+			${GLSL_DEPENDENCY_ARGS})
 		list(APPEND SPIRV_BINARY_FILES ${SPIRV})
 	endforeach(GLSL)
 
@@ -22,4 +46,28 @@ macro(APPEND_GLSL_TO_TARGET target sources)
 	)
 
 	add_dependencies(${target} ${target}_Shader)
-endmacro()
\ No newline at end of file
+endmacro()
+
+# compile sources again with extra glslang options into <name>.<variant>.<stage>.spv
+macro(APPEND_GLSL_VARIANT_TO_TARGET target variant options sources)
+	set(SPIRV_VARIANT_FILES)
+	foreach(GLSL ${sources})
+		get_filename_component(FILE_NAME ${GLSL} NAME_WE)
+		get_filename_component(FILE_STAGE ${GLSL} LAST_EXT)
+		set(SPIRV "${CMAKE_CURRENT_BINARY_DIR}/Shaders/${FILE_NAME}.${variant}${FILE_STAGE}.spv")
+		GLSL_DEPENDENCIES(${GLSL} ${SPIRV})
+		add_custom_command(
+			OUTPUT ${SPIRV}
+			COMMAND ${CMAKE_COMMAND} -E make_directory ${CMAKE_CURRENT_BINARY_DIR}/Shaders
+			COMMAND ${GLSL_VALIDATOR} -V -I${GLSL_INCLUDE_DIR} ${options} ${GLSL_DEPENDENCY_OPTIONS} ${GLSL} -o ${SPIRV}
+			${GLSL_DEPENDENCY_ARGS})
+		list(APPEND SPIRV_VARIANT_FILES ${SPIRV})
+	endforeach(GLSL)
+
+	add_custom_target(
+	    ${target}_Shader_${variant}
+	    DEPENDS ${SPIRV_VARIANT_FILES}
+	)
+
+	add_dependencies(${target} ${target}_Shader_${variant})
+endmacro()
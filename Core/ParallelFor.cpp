@@ -0,0 +1,96 @@
+#include <Core/ParallelFor.h>
+
+WorkerPool &WorkerPool::Get()
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+WorkerPool::WorkerPool()
+{
+    uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    for (uint32_t i = 1; i < threadCount; i++)
+    {
+        workers.emplace_back(&WorkerPool::workerLoop, this);
+    }
+}
+
+WorkerPool::~WorkerPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto &worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void WorkerPool::Run(uint32_t jobCount, const std::function<void(uint32_t)> &job)
+{
+    if (!jobCount)
+        return;
+
+    Batch batch = {.job = &job, .count = jobCount};
+
+    std::unique_lock<std::mutex> lock(mutex);
+    batches.push_back(&batch);
+    workAvailable.notify_all();
+
+    uint32_t index;
+    while (claim(&batch, index))
+    {
+        lock.unlock();
+        job(index);
+        lock.lock();
+        finish(&batch);
+    }
+
+    // the batch lives on this stack, wait for the jobs claimed by workers
+    batchFinished.wait(lock, [&]()
+                       { return batch.done == batch.count; });
+}
+
+bool WorkerPool::claim(Batch *batch, uint32_t &index)
+{
+    if (batch->next == batch->count)
+        return false;
+
+    index = batch->next++;
+    if (batch->next == batch->count)
+    {
+        batches.erase(std::find(batches.begin(), batches.end(), batch));
+    }
+    return true;
+}
+
+void WorkerPool::finish(Batch *batch)
+{
+    if (++batch->done == batch->count)
+    {
+        batchFinished.notify_all();
+    }
+}
+
+void WorkerPool::workerLoop()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true)
+    {
+        workAvailable.wait(lock, [&]()
+                           { return stopping || !batches.empty(); });
+        if (stopping)
+            return;
+
+        auto batch = batches.front();
+        uint32_t index;
+        claim(batch, index);
+
+        lock.unlock();
+        (*batch->job)(index);
+        lock.lock();
+        finish(batch);
+    }
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// one worker per hardware thread but the calling one, started on first use and kept until exit
+// ParallelFor called every frame only pays for waking the workers, not for creating threads
+class WorkerPool
+{
+public:
+    static WorkerPool &Get();
+
+    ~WorkerPool();
+
+    // workers and the calling thread
+    uint32_t ThreadCount()
+    {
+        return uint32_t(workers.size()) + 1;
+    }
+
+    // job(index) for every index in [0, jobCount), returns once all have finished
+    // the calling thread runs jobs too, so a job may call Run again without starving the pool
+    void Run(uint32_t jobCount, const std::function<void(uint32_t)> &job);
+
+private:
+    WorkerPool();
+
+    struct Batch
+    {
+        const std::function<void(uint32_t)> *job;
+        uint32_t count;
+        uint32_t next = 0;
+        uint32_t done = 0;
+    };
+
+    // next unclaimed index of batch, false once all are claimed, called with mutex held
+    bool claim(Batch *batch, uint32_t &index);
+    void finish(Batch *batch);
+    void workerLoop();
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable batchFinished;
+    // batches with unclaimed indices, oldest first
+    std::deque<Batch *> batches;
+    bool stopping = false;
+};
+
+// fn(begin, end) over [0, count) split into one range per hardware thread
+// runs on the calling thread alone below minCount, where waking the workers costs more than it saves
+template <typename Fn>
+void ParallelFor(uint32_t count, uint32_t minCount, Fn fn)
+{
+    if (count < std::max(minCount, 2u))
+    {
+        fn(0u, count);
+        return;
+    }
+
+    auto &pool = WorkerPool::Get();
+    uint32_t threadCount = pool.ThreadCount();
+    if (threadCount == 1)
+    {
+        fn(0u, count);
+        return;
+    }
+
+    uint32_t chunk = (count + threadCount - 1) / threadCount;
+    uint32_t chunkCount = (count + chunk - 1) / chunk;
+    pool.Run(chunkCount, [&](uint32_t index)
+             { fn(index * chunk, std::min((index + 1) * chunk, count)); });
+}
@@ -0,0 +1,161 @@
+#include <Core/Trace.h>
+
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct TraceEvent
+{
+    const char *name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+struct GPUTraceEvent
+{
+    std::string name;
+    uint64_t begin;
+    uint64_t end;
+};
+
+// owned by the registry so events survive the thread that recorded them
+struct ThreadTraceBuffer
+{
+    uint32_t threadIndex;
+
+    // only contended while exporting
+    std::mutex mutex;
+    std::vector<TraceEvent> events;
+    size_t head = 0;
+};
+
+static std::mutex registryMutex;
+static std::vector<std::shared_ptr<ThreadTraceBuffer>> threadBuffers;
+static std::vector<GPUTraceEvent> gpuEvents;
+static size_t gpuHead = 0;
+
+static ThreadTraceBuffer &localBuffer()
+{
+    thread_local std::shared_ptr<ThreadTraceBuffer> buffer;
+    if (!buffer)
+    {
+        buffer = std::make_shared<ThreadTraceBuffer>();
+        buffer->events.reserve(Trace::RING_SIZE);
+
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffer->threadIndex = threadBuffers.size() + 1;
+        threadBuffers.push_back(buffer);
+    }
+    return *buffer;
+}
+
+template <class T>
+static void pushRing(std::vector<T> &ring, size_t &head, T &&event)
+{
+    if (ring.size() < Trace::RING_SIZE)
+    {
+        ring.push_back(std::move(event));
+        return;
+    }
+
+    ring[head] = std::move(event);
+    head = (head + 1) % Trace::RING_SIZE;
+}
+
+void Trace::AddZone(const char *name, uint64_t begin, uint64_t end)
+{
+    auto &buffer = localBuffer();
+    std::lock_guard<std::mutex> lock(buffer.mutex);
+    pushRing(buffer.events, buffer.head, TraceEvent{name, begin, end});
+}
+
+void Trace::AddGPUZone(const std::string &name, uint64_t begin, uint64_t end)
+{
+    if (!IsEnabled())
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    pushRing(gpuEvents, gpuHead, GPUTraceEvent{name, begin, end});
+}
+
+void Trace::Clear()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    for (auto &buffer : threadBuffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        buffer->events.clear();
+        buffer->head = 0;
+    }
+    gpuEvents.clear();
+    gpuHead = 0;
+}
+
+static std::string escapeJson(const std::string &str)
+{
+    std::string escaped;
+    for (auto c : str)
+    {
+        if (c == '"' || c == '\\')
+            escaped.push_back('\\');
+        escaped.push_back(c);
+    }
+    return escaped;
+}
+
+static void writeEvent(std::ofstream &out, bool &first, const std::string &name, uint32_t tid, uint64_t begin, uint64_t end)
+{
+    // chrome trace timestamps are microseconds, fractions keep the nanoseconds
+    out << (first ? "\n" : ",\n");
+    out << "{\"name\":\"" << escapeJson(name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << tid
+        << ",\"ts\":" << begin / 1000.0 << ",\"dur\":" << (end - begin) / 1000.0 << "}";
+    first = false;
+}
+
+static void writeThreadName(std::ofstream &out, bool &first, uint32_t tid, const std::string &name)
+{
+    out << (first ? "\n" : ",\n");
+    out << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid << ",\"args\":{\"name\":\"" << escapeJson(name) << "\"}}";
+    first = false;
+}
+
+bool Trace::WriteChromeTrace(std::string file)
+{
+    std::ofstream out(file);
+    if (!out.is_open())
+    {
+        return false;
+    }
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+
+    for (auto &buffer : threadBuffers)
+    {
+        std::lock_guard<std::mutex> bufferLock(buffer->mutex);
+        writeThreadName(out, first, buffer->threadIndex, "cpu " + std::to_string(buffer->threadIndex));
+        for (auto &event : buffer->events)
+        {
+            writeEvent(out, first, event.name, buffer->threadIndex, event.begin, event.end);
+        }
+    }
+
+    // gpu track after all cpu threads
+    uint32_t gpuTid = threadBuffers.size() + 1;
+    writeThreadName(out, first, gpuTid, "gpu");
+    for (auto &event : gpuEvents)
+    {
+        writeEvent(out, first, event.name, gpuTid, event.begin, event.end);
+    }
+
+    out << "\n]}\n";
+    return true;
+}
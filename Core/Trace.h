@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// scoped cpu zones recorded into per thread ring buffers, exported as chrome trace json
+// (chrome://tracing, ui.perfetto.dev). gpu timings can be folded onto the same timeline.
+// zones are only recorded while enabled, without PIXEL_ENABLE_TRACE the macros compile to nothing
+class Trace
+{
+public:
+    static void SetEnabled(bool enabled)
+    {
+        Trace::enabled.store(enabled, std::memory_order_relaxed);
+    }
+
+    static bool IsEnabled()
+    {
+        return enabled.load(std::memory_order_relaxed);
+    }
+
+    // nanoseconds on the steady clock
+    static uint64_t Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // name must outlive the trace, string literals only
+    static void AddZone(const char *name, uint64_t begin, uint64_t end);
+
+    // zone on the gpu track, begin/end already converted to the cpu timeline
+    static void AddGPUZone(const std::string &name, uint64_t begin, uint64_t end);
+
+    // drop everything recorded so far
+    static void Clear();
+
+    static bool WriteChromeTrace(std::string file);
+
+    // events kept per thread, older ones are overwritten
+    static constexpr uint32_t RING_SIZE = 64 * 1024;
+
+private:
+    static inline std::atomic<bool> enabled = false;
+};
+
+class TraceScope
+{
+public:
+    TraceScope(const char *name) : name(name), begin(Trace::IsEnabled() ? Trace::Now() : 0)
+    {
+    }
+
+    ~TraceScope()
+    {
+        if (begin)
+        {
+            Trace::AddZone(name, begin, Trace::Now());
+        }
+    }
+
+private:
+    const char *name;
+    uint64_t begin;
+};
+
+#define PIXEL_TRACE_CONCAT_INNER(a, b) a##b
+#define PIXEL_TRACE_CONCAT(a, b) PIXEL_TRACE_CONCAT_INNER(a, b)
+
+#ifdef PIXEL_ENABLE_TRACE
+#define TRACE_SCOPE(name) TraceScope PIXEL_TRACE_CONCAT(traceScope, __LINE__)(name)
+#define TRACE_FUNCTION() TRACE_SCOPE(__FUNCTION__)
+#else
+#define TRACE_SCOPE(name)
+#define TRACE_FUNCTION()
+#endif
@@ -0,0 +1,437 @@
+#include <Engine/AnimatedScene.h>
+#include <Engine/PixelEngine.h>
+#include <Engine/Renderer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <FrameGraph/Graph.h>
+
+#include <RHI/RHIRuntime.h>
+
+#include <json_struct/json_struct.h>
+#include <spdlog/spdlog.h>
+
+#include <Core/ParallelFor.h>
+#include <Core/Trace.h>
+
+// Frame of skin.comp, std430
+struct SkinFrame
+{
+    uint32_t vertexCount;
+    uint32_t targetCount;
+    uint32_t jointCount;
+    uint32_t padding;
+    glm::vec4 weights[AnimatedScene::MAX_MORPH_TARGETS / 4];
+    glm::mat4 joints[AnimatedScene::MAX_JOINTS];
+};
+
+// read as VERTEX_STRIDE floats by skin.comp
+static_assert(sizeof(GLTFVertex) == 20 * sizeof(float));
+
+// fewer are sampled on the calling thread
+static constexpr uint32_t PARALLEL_MIN_CHANNELS = 256;
+static constexpr uint32_t PARALLEL_MIN_INSTANCES = 16;
+
+// width floats of the sampler at time, clamped to the first and last key
+// rotations are x, y, z, w as in the file and interpolated on the sphere
+static void SampleChannel(const GLTFAnimationSampler &sampler, uint32_t width, float time, bool rotation, float *out)
+{
+    auto &times = sampler.times;
+    bool cubic = sampler.interpolation == GLTFAnimationSampler::CUBICSPLINE;
+    uint32_t keyStride = cubic ? width * 3 : width;
+    if (times.empty() || sampler.values.size() < times.size() * keyStride)
+        return;
+
+    // value of key k, past the in tangent for cubic splines
+    auto value = [&](size_t k)
+    { return &sampler.values[k * keyStride + (cubic ? width : 0)]; };
+
+    size_t next = std::upper_bound(times.begin(), times.end(), time) - times.begin();
+    if (next == 0 || next == times.size() || sampler.interpolation == GLTFAnimationSampler::STEP)
+    {
+        auto key = next == 0 ? value(0) : value(next - 1);
+        std::copy(key, key + width, out);
+        return;
+    }
+
+    size_t k0 = next - 1;
+    size_t k1 = next;
+    float dt = times[k1] - times[k0];
+    float u = dt > 0.0f ? (time - times[k0]) / dt : 0.0f;
+
+    if (cubic)
+    {
+        float u2 = u * u;
+        float u3 = u2 * u;
+        auto outTangent = &sampler.values[k0 * keyStride + 2 * width];
+        auto inTangent = &sampler.values[k1 * keyStride];
+        for (uint32_t c = 0; c < width; c++)
+        {
+            out[c] = (2.0f * u3 - 3.0f * u2 + 1.0f) * value(k0)[c] + (u3 - 2.0f * u2 + u) * dt * outTangent[c] + (-2.0f * u3 + 3.0f * u2) * value(k1)[c] + (u3 - u2) * dt * inTangent[c];
+        }
+        if (rotation)
+        {
+            auto q = glm::normalize(glm::vec4(out[0], out[1], out[2], out[3]));
+            std::copy(&q.x, &q.x + 4, out);
+        }
+        return;
+    }
+
+    if (rotation)
+    {
+        auto q0 = glm::quat(value(k0)[3], value(k0)[0], value(k0)[1], value(k0)[2]);
+        auto q1 = glm::quat(value(k1)[3], value(k1)[0], value(k1)[1], value(k1)[2]);
+        auto q = glm::normalize(glm::slerp(q0, q1, u));
+        out[0] = q.x;
+        out[1] = q.y;
+        out[2] = q.z;
+        out[3] = q.w;
+        return;
+    }
+
+    for (uint32_t c = 0; c < width; c++)
+    {
+        out[c] = value(k0)[c] + (value(k1)[c] - value(k0)[c]) * u;
+    }
+}
+
+AnimatedScene::AnimatedScene(PixelEngine *engine, GLTFScene scene, std::string name) : engine(engine), scene(std::move(scene)), name(name)
+{
+    auto &nodes = this->scene.nodes;
+
+    for (auto &skin : this->scene.skins)
+    {
+        if (skin.joints.size() > MAX_JOINTS)
+        {
+            throw std::runtime_error("animated scene: " + std::to_string(skin.joints.size()) + " joints in skin " + skin.name);
+        }
+        for (auto joint : skin.joints)
+        {
+            if (joint >= nodes.size())
+            {
+                throw std::runtime_error("animated scene: invalid joint in skin " + skin.name);
+            }
+        }
+    }
+
+    for (auto &model : this->scene.models)
+    {
+        if (model.morphTargets.size() > MAX_MORPH_TARGETS)
+        {
+            throw std::runtime_error("animated scene: " + std::to_string(model.morphTargets.size()) + " morph targets");
+        }
+    }
+
+    for (auto &node : nodes)
+    {
+        Pose pose = {
+            .translation = node.translation,
+            .rotation = node.rotation,
+            .scale = node.scale,
+            .weights = node.weights};
+        if (node.mesh >= 0 && node.mesh < this->scene.models.size())
+        {
+            auto &model = this->scene.models[node.mesh];
+            if (pose.weights.empty())
+            {
+                pose.weights = model.morphWeights;
+            }
+            pose.weights.resize(model.morphTargets.size(), 0.0f);
+        }
+        poses.push_back(pose);
+    }
+
+    // breadth first from the roots, then whatever the scene does not reach
+    std::vector<bool> visited(nodes.size());
+
+    std::vector<uint32_t> queue;
+    for (auto root : this->scene.roots)
+    {
+        queue.push_back(root);
+    }
+    for (uint32_t i = 0; i < nodes.size(); i++)
+    {
+        if (nodes[i].parent < 0)
+        {
+            queue.push_back(i);
+        }
+    }
+    for (size_t i = 0; i < queue.size(); i++)
+    {
+        auto node = queue[i];
+        if (node >= nodes.size() || visited[node])
+            continue;
+        visited[node] = true;
+        nodeOrder.push_back(node);
+        queue.insert(queue.end(), nodes[node].children.begin(), nodes[node].children.end());
+    }
+
+    globalMatrices.resize(nodes.size(), glm::mat4(1.0f));
+    updateGlobalMatrices();
+
+    buildInstances();
+    buildRenderGroup();
+    writeFrames();
+}
+
+void AnimatedScene::buildInstances()
+{
+    auto &rhiRuntime = engine->GetRHIRuntime();
+    auto auxiliaryExecutor = engine->GetAuxiliaryExecutor();
+    auto &models = scene.models;
+
+    sourceBuffers.resize(models.size());
+    indexBuffers.resize(models.size());
+    morphBuffers.resize(models.size());
+
+    for (uint32_t node = 0; node < scene.nodes.size(); node++)
+    {
+        auto mesh = scene.nodes[node].mesh;
+        if (mesh < 0 || mesh >= models.size() || models[mesh].vertexBuffer.empty())
+            continue;
+
+        auto &model = models[mesh];
+        size_t vertexSize = model.vertexBuffer.size() * sizeof(GLTFVertex);
+
+        if (!sourceBuffers[mesh])
+        {
+            sourceBuffers[mesh] = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_VERTEX_BUFFER_BIT | Buffer::BUFFER_USAGE_STORAGE_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexSize);
+            auxiliaryExecutor->TransferResource(sourceBuffers[mesh], model.vertexBuffer.data(), vertexSize);
+
+            if (!model.indexBuffer.empty())
+            {
+                indexBuffers[mesh] = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_INDEX_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, model.indexBuffer.size() * sizeof(uint32_t));
+                auxiliaryExecutor->TransferResource(indexBuffers[mesh], model.indexBuffer.data(), model.indexBuffer.size() * sizeof(uint32_t));
+            }
+        }
+
+        Instance instance = {
+            .node = node,
+            .mesh = uint32_t(mesh),
+            .animated = scene.nodes[node].skin >= 0 || !model.morphTargets.empty(),
+            .vertexBuffer = sourceBuffers[mesh],
+            .indexBuffer = indexBuffers[mesh]};
+
+        GPUInstance gpuInstance = {};
+        if (instance.animated)
+        {
+            if (!morphBuffers[mesh])
+            {
+                // position, normal and tangent delta of every vertex of every target, one dummy element without targets
+                std::vector<glm::vec4> deltas(std::max<size_t>(model.morphTargets.size() * model.vertexBuffer.size() * 3, 3), glm::vec4(0.0f));
+                for (size_t t = 0; t < model.morphTargets.size(); t++)
+                {
+                    auto &target = model.morphTargets[t];
+                    for (size_t v = 0; v < model.vertexBuffer.size(); v++)
+                    {
+                        auto delta = (t * model.vertexBuffer.size() + v) * 3;
+                        deltas[delta] = glm::vec4(target.positions[v], 0.0f);
+                        deltas[delta + 1] = glm::vec4(target.normals[v], 0.0f);
+                        deltas[delta + 2] = glm::vec4(target.tangents[v], 0.0f);
+                    }
+                }
+                morphBuffers[mesh] = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_STORAGE_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, deltas.size() * sizeof(glm::vec4));
+                auxiliaryExecutor->TransferResource(morphBuffers[mesh], deltas.data(), deltas.size() * sizeof(glm::vec4));
+            }
+
+            instance.vertexBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_VERTEX_BUFFER_BIT | Buffer::BUFFER_USAGE_STORAGE_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_SRC_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexSize);
+            // the rest pose until the first frame ran
+            auxiliaryExecutor->TransferResource(instance.vertexBuffer, model.vertexBuffer.data(), vertexSize);
+
+            gpuInstance.frame = rhiRuntime->CreateDynamicBuffer(sizeof(SkinFrame));
+            memset(gpuInstance.frame->Map(), 0, sizeof(SkinFrame));
+        }
+
+        instances.push_back(instance);
+        gpuInstances.push_back(gpuInstance);
+    }
+}
+
+void AnimatedScene::buildRenderGroup()
+{
+    if (std::none_of(instances.begin(), instances.end(), [](const Instance &instance)
+                     { return instance.animated; }))
+        return;
+
+    RenderSubPassResourceJson frame = {};
+    frame.name = "skinFrame";
+    frame.type = "buffer";
+    frame.dynamic = true;
+    frame.binding = 0;
+
+    // read by the graphic subpasses of other groups through GetDependency()
+    RenderSubPassResourceJson skinned = {};
+    skinned.name = "skinned";
+    skinned.type = "ssbo";
+
+    RenderSubPassJson subpass = {};
+    subpass.name = "skin";
+    subpass.type = "compute";
+    subpass.shaders.compute = "skin.comp.spv";
+    subpass.inputs = {frame};
+    subpass.outputs = {skinned};
+
+    RenderPassJson json = {};
+    json.name = name;
+    json.subpasses = {subpass};
+
+    renderGroup = engine->RegisterRenderGroup(Graph::ParseRenderPassJsonRawString(JS::serializeStruct(json)));
+    if (!renderGroup)
+    {
+        throw std::runtime_error("animated scene: failed to register " + name);
+    }
+
+    // tuned when PIXEL_WORKGROUP_TUNING is set, skinned vertices are rewritten from the source ones
+    auto pipeline = renderGroup->CreatePipeline("skin", ComputePipelineStates{.autotune = true, .idempotent = true});
+    auto &rhiRuntime = engine->GetRHIRuntime();
+
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+        auto &instance = instances[i];
+        if (!instance.animated)
+            continue;
+
+        auto state = rhiRuntime->CreateResourceBindingState(pipeline);
+        state->Bind(0, 0, gpuInstances[i].frame);
+        state->Bind(0, 1, sourceBuffers[instance.mesh]);
+        state->Bind(0, 2, instance.vertexBuffer);
+        state->Bind(0, 3, morphBuffers[instance.mesh]);
+        // one invocation per vertex
+        state->BindDispatchOp({ResourceBindingState::DispatchOP{
+            .type = ResourceBindingState::DispatchOP::RESOURCE_SIZE,
+            .resource = instance.vertexBuffer,
+            .elementSize = sizeof(GLTFVertex)}});
+        state->name = "skin";
+        gpuInstances[i].state = state;
+    }
+}
+
+void AnimatedScene::AddTo(IntrusivePtr<Renderer> renderer)
+{
+    for (auto &gpuInstance : gpuInstances)
+    {
+        if (gpuInstance.state)
+        {
+            renderer->AddDrawState(gpuInstance.state);
+        }
+    }
+}
+
+void AnimatedScene::sample(const GLTFAnimation &animation, float time)
+{
+    ParallelFor(animation.channels.size(), PARALLEL_MIN_CHANNELS, [&](uint32_t begin, uint32_t end)
+                {
+                    for (uint32_t i = begin; i < end; i++)
+                    {
+                        auto &channel = animation.channels[i];
+                        if (channel.node >= poses.size() || channel.sampler >= animation.samplers.size())
+                            continue;
+
+                        // channels of a node drive different members of its pose
+                        auto &sampler = animation.samplers[channel.sampler];
+                        auto &pose = poses[channel.node];
+                        switch (channel.path)
+                        {
+                        case GLTFAnimationChannel::TRANSLATION:
+                            SampleChannel(sampler, 3, time, false, &pose.translation.x);
+                            break;
+                        case GLTFAnimationChannel::SCALE:
+                            SampleChannel(sampler, 3, time, false, &pose.scale.x);
+                            break;
+                        case GLTFAnimationChannel::ROTATION:
+                        {
+                            float rotation[4] = {pose.rotation.x, pose.rotation.y, pose.rotation.z, pose.rotation.w};
+                            SampleChannel(sampler, 4, time, true, rotation);
+                            pose.rotation = glm::quat(rotation[3], rotation[0], rotation[1], rotation[2]);
+                            break;
+                        }
+                        case GLTFAnimationChannel::WEIGHTS:
+                            if (!pose.weights.empty())
+                            {
+                                SampleChannel(sampler, pose.weights.size(), time, false, pose.weights.data());
+                            }
+                            break;
+                        }
+                    }
+                });
+}
+
+void AnimatedScene::updateGlobalMatrices()
+{
+    for (auto node : nodeOrder)
+    {
+        auto &pose = poses[node];
+        auto local = scene.nodes[node].matrix * glm::translate(glm::mat4(1.0f), pose.translation) * glm::mat4_cast(pose.rotation) * glm::scale(glm::mat4(1.0f), pose.scale);
+        auto parent = scene.nodes[node].parent;
+        globalMatrices[node] = parent >= 0 ? globalMatrices[parent] * local : local;
+    }
+}
+
+std::vector<glm::mat4> AnimatedScene::GetJointMatrices(uint32_t instance)
+{
+    auto node = instances.at(instance).node;
+    auto skinIndex = scene.nodes[node].skin;
+    if (skinIndex < 0 || skinIndex >= scene.skins.size())
+        return {};
+
+    auto &skin = scene.skins[skinIndex];
+    // joints are brought into the space of the mesh node, the node matrix is applied when drawing
+    auto inverseNode = glm::inverse(globalMatrices[node]);
+    std::vector<glm::mat4> joints(skin.joints.size());
+    for (size_t j = 0; j < skin.joints.size(); j++)
+    {
+        joints[j] = inverseNode * globalMatrices[skin.joints[j]] * skin.inverseBindMatrices[j];
+    }
+    return joints;
+}
+
+std::vector<float> AnimatedScene::GetMorphWeights(uint32_t instance)
+{
+    return poses[instances.at(instance).node].weights;
+}
+
+void AnimatedScene::writeFrames()
+{
+    ParallelFor(instances.size(), PARALLEL_MIN_INSTANCES, [&](uint32_t begin, uint32_t end)
+                {
+                    for (uint32_t i = begin; i < end; i++)
+                    {
+                        auto &instance = instances[i];
+                        if (!instance.animated)
+                            continue;
+
+                        auto frame = static_cast<SkinFrame *>(gpuInstances[i].frame->Map());
+                        auto joints = GetJointMatrices(i);
+                        auto weights = GetMorphWeights(i);
+
+                        frame->vertexCount = scene.models[instance.mesh].vertexBuffer.size();
+                        frame->targetCount = weights.size();
+                        frame->jointCount = joints.size();
+                        std::copy(joints.begin(), joints.end(), frame->joints);
+                        for (size_t t = 0; t < weights.size(); t++)
+                        {
+                            frame->weights[t / 4][t % 4] = weights[t];
+                        }
+                    }
+                });
+}
+
+void AnimatedScene::Update(float time, uint32_t animation)
+{
+    TRACE_SCOPE("AnimatedScene::Update");
+
+    if (animation < scene.animations.size())
+    {
+        auto &current = scene.animations[animation];
+        auto duration = current.end - current.start;
+        sample(current, duration > 0.0f ? current.start + std::fmod(std::max(time, 0.0f), duration) : current.start);
+    }
+
+    updateGlobalMatrices();
+    writeFrames();
+}
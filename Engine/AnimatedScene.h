@@ -0,0 +1,121 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <Core/IntrusivePtr.h>
+
+#include <IO/GLTFReader.h>
+
+#include <RHI/Buffer.h>
+#include <RHI/DynamicBuffer.h>
+#include <RHI/RenderGroup.h>
+#include <RHI/ResourceBindingState.h>
+
+class PixelEngine;
+class Renderer;
+
+// gltf node hierarchy animated on the cpu, skinned and morphed on the gpu
+// animations are sampled on all hardware threads, joint matrices and morph weights are then
+// written to a compute pass that rewrites the vertex buffer of every animated mesh instance
+// the vertex buffers keep the GLTFVertex layout, graphic pipelines drawing static meshes draw them as they are
+// the pass runs in a render group of its own, graphic subpasses drawing the instances list GetDependency() in their dependencies
+class AnimatedScene : public IntrusiveCounter<AnimatedScene>
+{
+public:
+    // skin.comp limits
+    static constexpr uint32_t MAX_JOINTS = 256;
+    static constexpr uint32_t MAX_MORPH_TARGETS = 64;
+
+    // node with a mesh
+    struct Instance
+    {
+        uint32_t node;
+        uint32_t mesh;
+        // skinned or morphed, the vertex buffer is rewritten every frame
+        bool animated;
+
+        // GLTFVertex, relative to the node, draw with GetGlobalMatrix(node)
+        IntrusivePtr<Buffer> vertexBuffer;
+        IntrusivePtr<Buffer> indexBuffer;
+    };
+
+    // throw if a skin or a mesh is over the limits
+    AnimatedScene(PixelEngine *engine, GLTFScene scene, std::string name = "AnimatedScene");
+
+    void AddTo(IntrusivePtr<Renderer> renderer);
+
+    // pose at time seconds of the animation, looped, the rest pose if there is no such animation
+    // read by the compute pass of the next frame
+    void Update(float time, uint32_t animation = 0);
+
+    const GLTFScene &GetScene()
+    {
+        return scene;
+    }
+
+    const std::vector<Instance> &GetInstances()
+    {
+        return instances;
+    }
+
+    // node to world of the last Update
+    const glm::mat4 &GetGlobalMatrix(uint32_t node)
+    {
+        return globalMatrices[node];
+    }
+
+    // of the last Update, empty if the instance has no skin
+    std::vector<glm::mat4> GetJointMatrices(uint32_t instance);
+    // of the last Update, one per morph target
+    std::vector<float> GetMorphWeights(uint32_t instance);
+
+    // dependency of the graphic subpasses drawing the instances
+    std::string GetDependency()
+    {
+        return name + "::skin::skin";
+    }
+
+private:
+    struct Pose
+    {
+        glm::vec3 translation;
+        glm::quat rotation;
+        glm::vec3 scale;
+        std::vector<float> weights;
+    };
+
+    struct GPUInstance
+    {
+        IntrusivePtr<DynamicBuffer> frame;
+        IntrusivePtr<ResourceBindingState> state;
+    };
+
+    PixelEngine *engine;
+    GLTFScene scene;
+    std::string name;
+
+    std::vector<Pose> poses;
+    std::vector<glm::mat4> globalMatrices;
+    // parents before their children
+    std::vector<uint32_t> nodeOrder;
+
+    // per mesh, shared by its instances
+    std::vector<IntrusivePtr<Buffer>> sourceBuffers;
+    std::vector<IntrusivePtr<Buffer>> indexBuffers;
+    std::vector<IntrusivePtr<Buffer>> morphBuffers;
+
+    std::vector<Instance> instances;
+    // same index as instances, empty for static instances
+    std::vector<GPUInstance> gpuInstances;
+
+    IntrusivePtr<RenderGroup> renderGroup;
+
+    void buildRenderGroup();
+    void buildInstances();
+    void sample(const GLTFAnimation &animation, float time);
+    void updateGlobalMatrices();
+    void writeFrames();
+};
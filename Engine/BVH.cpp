@@ -0,0 +1,315 @@
+#include <Engine/BVH.h>
+
+#include <IO/GLTFReader.h>
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cfloat>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <thread>
+
+#include <spdlog/spdlog.h>
+
+#include <Core/ParallelFor.h>
+#include <Core/Trace.h>
+
+// cost of visiting a node relative to one triangle test
+static constexpr float TRAVERSAL_COST = 1.0f;
+
+// smaller subtrees are not worth a thread
+static constexpr uint32_t PARALLEL_MIN_TRIANGLES = 16384;
+
+struct BVHBounds
+{
+    glm::vec3 min = glm::vec3(FLT_MAX);
+    glm::vec3 max = glm::vec3(-FLT_MAX);
+
+    void Grow(glm::vec3 point)
+    {
+        min = glm::min(min, point);
+        max = glm::max(max, point);
+    }
+
+    void Grow(const BVHBounds &other)
+    {
+        min = glm::min(min, other.min);
+        max = glm::max(max, other.max);
+    }
+
+    // half the surface area, 0 if empty
+    float Area() const
+    {
+        auto extent = max - min;
+        if (extent.x < 0.0f)
+            return 0.0f;
+        return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+    }
+};
+
+// recursive binned sah split of the triangle order
+// children are allocated in pairs from an atomic counter, so a node always comes before its children
+struct BVHBuilder
+{
+    const std::vector<BVHBounds> &triangleBounds;
+    const std::vector<glm::vec3> &centroids;
+    std::vector<uint32_t> &order;
+    std::vector<BVHNode> &nodes;
+
+    std::atomic<uint32_t> nodeCount = 1;
+    // subtrees above this depth are split across threads
+    uint32_t parallelDepth = 0;
+
+    void Subdivide(uint32_t nodeIndex, uint32_t first, uint32_t count, uint32_t depth)
+    {
+        auto &node = nodes[nodeIndex];
+
+        BVHBounds bounds;
+        BVHBounds centroidBounds;
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            bounds.Grow(triangleBounds[order[i]]);
+            centroidBounds.Grow(centroids[order[i]]);
+        }
+        node.boundsMin = bounds.min;
+        node.boundsMax = bounds.max;
+        node.first = first;
+        node.count = count;
+
+        if (count == 1 || depth + 1 >= BVH::MAX_DEPTH)
+            return;
+
+        // cheapest plane between the bins of any axis
+        uint32_t bestAxis = 3;
+        uint32_t bestSplit = 0;
+        float bestCost = FLT_MAX;
+        for (uint32_t axis = 0; axis < 3; axis++)
+        {
+            float lo = centroidBounds.min[axis];
+            float hi = centroidBounds.max[axis];
+            if (hi <= lo)
+                continue;
+
+            struct Bin
+            {
+                BVHBounds bounds;
+                uint32_t count = 0;
+            };
+            std::array<Bin, BVH::BIN_COUNT> bins;
+
+            float scale = BVH::BIN_COUNT / (hi - lo);
+            for (uint32_t i = first; i < first + count; i++)
+            {
+                auto triangle = order[i];
+                auto bin = std::min(BVH::BIN_COUNT - 1, uint32_t((centroids[triangle][axis] - lo) * scale));
+                bins[bin].count++;
+                bins[bin].bounds.Grow(triangleBounds[triangle]);
+            }
+
+            // left sides swept forward, right sides backward
+            std::array<float, BVH::BIN_COUNT - 1> leftArea;
+            std::array<uint32_t, BVH::BIN_COUNT - 1> leftCount;
+            BVHBounds left;
+            uint32_t leftSum = 0;
+            for (uint32_t i = 0; i < BVH::BIN_COUNT - 1; i++)
+            {
+                left.Grow(bins[i].bounds);
+                leftSum += bins[i].count;
+                leftArea[i] = left.Area();
+                leftCount[i] = leftSum;
+            }
+
+            BVHBounds right;
+            uint32_t rightSum = 0;
+            for (uint32_t i = BVH::BIN_COUNT - 1; i > 0; i--)
+            {
+                right.Grow(bins[i].bounds);
+                rightSum += bins[i].count;
+                if (!leftCount[i - 1] || !rightSum)
+                    continue;
+
+                float cost = leftCount[i - 1] * leftArea[i - 1] + rightSum * right.Area();
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = i;
+                }
+            }
+        }
+
+        uint32_t leftCount = 0;
+        if (bestAxis < 3)
+        {
+            float splitCost = TRAVERSAL_COST + bestCost / std::max(bounds.Area(), FLT_MIN);
+            if (splitCost >= count && count <= BVH::MAX_LEAF_SIZE)
+                return;
+
+            float lo = centroidBounds.min[bestAxis];
+            float scale = BVH::BIN_COUNT / (centroidBounds.max[bestAxis] - lo);
+            auto middle = std::partition(order.begin() + first, order.begin() + first + count, [&](uint32_t triangle)
+                                         { return std::min(BVH::BIN_COUNT - 1, uint32_t((centroids[triangle][bestAxis] - lo) * scale)) < bestSplit; });
+            leftCount = uint32_t(middle - (order.begin() + first));
+        }
+        else if (count <= BVH::MAX_LEAF_SIZE)
+        {
+            return;
+        }
+
+        // all centroids in one spot, any halves are as good
+        if (leftCount == 0 || leftCount == count)
+        {
+            leftCount = count / 2;
+        }
+
+        uint32_t leftChild = nodeCount.fetch_add(2);
+        node.first = leftChild;
+        node.count = 0;
+
+        if (depth < parallelDepth && count >= PARALLEL_MIN_TRIANGLES)
+        {
+            auto task = std::async(std::launch::async, [=, this]()
+                                   { Subdivide(leftChild, first, leftCount, depth + 1); });
+            Subdivide(leftChild + 1, first + leftCount, count - leftCount, depth + 1);
+            task.get();
+        }
+        else
+        {
+            Subdivide(leftChild, first, leftCount, depth + 1);
+            Subdivide(leftChild + 1, first + leftCount, count - leftCount, depth + 1);
+        }
+    }
+};
+
+void BVH::Build(const std::vector<glm::vec3> &positions, const std::vector<uint32_t> &indices)
+{
+    TRACE_SCOPE("BVH::Build");
+
+    uint32_t triangleCount = indices.size() / 3;
+    if (!triangleCount)
+    {
+        throw std::runtime_error("bvh: no triangles");
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    this->indices = indices;
+
+    std::vector<BVHBounds> triangleBounds(triangleCount);
+    std::vector<glm::vec3> centroids(triangleCount);
+    ParallelFor(triangleCount, PARALLEL_MIN_TRIANGLES, [&](uint32_t begin, uint32_t end)
+                {
+                    for (uint32_t i = begin; i < end; i++)
+                    {
+                        auto &bounds = triangleBounds[i];
+                        bounds.Grow(positions[indices[i * 3]]);
+                        bounds.Grow(positions[indices[i * 3 + 1]]);
+                        bounds.Grow(positions[indices[i * 3 + 2]]);
+                        centroids[i] = (bounds.min + bounds.max) * 0.5f;
+                    }
+                });
+
+    std::vector<uint32_t> order(triangleCount);
+    for (uint32_t i = 0; i < triangleCount; i++)
+    {
+        order[i] = i;
+    }
+
+    // every split adds 2 nodes and leaves are never empty
+    nodes.resize(triangleCount * 2);
+
+    BVHBuilder builder = {triangleBounds, centroids, order, nodes};
+    uint32_t threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    while ((1u << builder.parallelDepth) < threadCount * 2)
+    {
+        builder.parallelDepth++;
+    }
+    builder.Subdivide(0, 0, triangleCount, 0);
+    nodes.resize(builder.nodeCount);
+    nodes.shrink_to_fit();
+
+    triangles.resize(triangleCount);
+    ParallelFor(triangleCount, PARALLEL_MIN_TRIANGLES, [&](uint32_t begin, uint32_t end)
+                {
+                    for (uint32_t i = begin; i < end; i++)
+                    {
+                        auto source = order[i];
+                        triangles[i] = {
+                            .v0 = positions[indices[source * 3]],
+                            .index = source,
+                            .v1 = positions[indices[source * 3 + 1]],
+                            .v2 = positions[indices[source * 3 + 2]]};
+                    }
+                });
+
+    auto milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    spdlog::info("bvh: {} triangles, {} nodes, built in {:.1f}ms", triangleCount, nodes.size(), milliseconds);
+}
+
+void BVH::Build(const std::vector<GLTFModel> &models)
+{
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> modelIndices;
+    for (auto &model : models)
+    {
+        uint32_t vertexOffset = positions.size();
+        for (auto &vertex : model.vertexBuffer)
+        {
+            positions.push_back(vertex.pos);
+        }
+
+        // triangle lists only, a trailing partial triangle is dropped
+        for (auto &primitive : model.primitives)
+        {
+            for (uint32_t i = 0; i < primitive.indexCount / 3 * 3; i++)
+            {
+                modelIndices.push_back(model.indexBuffer[primitive.firstIndex + i] + vertexOffset);
+            }
+        }
+    }
+
+    Build(positions, modelIndices);
+}
+
+void BVH::Refit(const std::vector<glm::vec3> &positions)
+{
+    TRACE_SCOPE("BVH::Refit");
+
+    ParallelFor(triangles.size(), PARALLEL_MIN_TRIANGLES, [&](uint32_t begin, uint32_t end)
+                {
+                    for (uint32_t i = begin; i < end; i++)
+                    {
+                        auto &triangle = triangles[i];
+                        triangle.v0 = positions[indices[triangle.index * 3]];
+                        triangle.v1 = positions[indices[triangle.index * 3 + 1]];
+                        triangle.v2 = positions[indices[triangle.index * 3 + 2]];
+                    }
+                });
+
+    // children come after their parent, backwards every child is refitted before its parent
+    for (size_t i = nodes.size(); i-- > 0;)
+    {
+        auto &node = nodes[i];
+        BVHBounds bounds;
+        if (node.count)
+        {
+            for (uint32_t t = node.first; t < node.first + node.count; t++)
+            {
+                bounds.Grow(triangles[t].v0);
+                bounds.Grow(triangles[t].v1);
+                bounds.Grow(triangles[t].v2);
+            }
+        }
+        else
+        {
+            bounds.Grow(nodes[node.first].boundsMin);
+            bounds.Grow(nodes[node.first].boundsMax);
+            bounds.Grow(nodes[node.first + 1].boundsMin);
+            bounds.Grow(nodes[node.first + 1].boundsMax);
+        }
+        node.boundsMin = bounds.min;
+        node.boundsMax = bounds.max;
+    }
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <Core/IntrusivePtr.h>
+
+struct GLTFModel;
+
+// 32 bytes, same layout as BVHNode of Engine/Shaders/bvh.glsl (std430)
+// leaves have count > 0 and cover triangles [first, first + count)
+// inner nodes have count 0, their children are first and first + 1
+struct BVHNode
+{
+    glm::vec3 boundsMin;
+    uint32_t first;
+    glm::vec3 boundsMax;
+    uint32_t count;
+};
+
+// triangle in leaf order, index is the source triangle it was built from
+struct BVHTriangle
+{
+    glm::vec3 v0;
+    uint32_t index;
+    glm::vec3 v1;
+    uint32_t padding0;
+    glm::vec3 v2;
+    uint32_t padding1;
+};
+
+// binned sah bvh over indexed triangles, built on the cpu
+// nodes and triangles are uploaded as they are into two storage buffers and traced with bvh.glsl
+class BVH : public IntrusiveCounter<BVH>
+{
+public:
+    static constexpr uint32_t BIN_COUNT = 16;
+    static constexpr uint32_t MAX_LEAF_SIZE = 8;
+    // nodes this deep are leaves whatever their size, bvh.glsl traverses with a stack of this size
+    static constexpr uint32_t MAX_DEPTH = 64;
+
+    // triangle i is positions[indices[3 * i]], positions[indices[3 * i + 1]], positions[indices[3 * i + 2]]
+    // subtrees are built on all hardware threads, throw if there is no triangle
+    void Build(const std::vector<glm::vec3> &positions, const std::vector<uint32_t> &indices);
+
+    // all models in one tree, source triangles are numbered model by model in index order
+    void Build(const std::vector<GLTFModel> &models);
+
+    // moved vertices of the built triangles, the topology is kept and only the bounds are updated
+    // quality degrades with the distance from the built positions, rebuild after large changes
+    void Refit(const std::vector<glm::vec3> &positions);
+
+    const std::vector<BVHNode> &GetNodes()
+    {
+        return nodes;
+    }
+
+    const std::vector<BVHTriangle> &GetTriangles()
+    {
+        return triangles;
+    }
+
+    // bounds of the root
+    glm::vec3 GetBoundsMin()
+    {
+        return nodes.empty() ? glm::vec3(0.0f) : nodes[0].boundsMin;
+    }
+
+    glm::vec3 GetBoundsMax()
+    {
+        return nodes.empty() ? glm::vec3(0.0f) : nodes[0].boundsMax;
+    }
+
+private:
+    // source indices, kept for refitting
+    std::vector<uint32_t> indices;
+
+    std::vector<BVHNode> nodes;
+    std::vector<BVHTriangle> triangles;
+};
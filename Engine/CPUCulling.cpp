@@ -0,0 +1,324 @@
+#include <Engine/CPUCulling.h>
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PIXEL_CULLING_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include <Core/ParallelFor.h>
+#include <Core/Trace.h>
+
+// one frustum plane split for the box test, dot(normal, center) + dot(|normal|, extent) + distance
+struct CullingPlane
+{
+    float normal[3];
+    float absNormal[3];
+    float distance;
+};
+
+struct CullingBoxes
+{
+    const float *centerX;
+    const float *centerY;
+    const float *centerZ;
+    const float *extentX;
+    const float *extentY;
+    const float *extentZ;
+};
+
+// writes the visible objects of [begin, end) to visible, returns their count
+static uint32_t CullScalar(const CullingBoxes &boxes, const CullingPlane (&planes)[6], uint32_t begin, uint32_t end, uint32_t *visible)
+{
+    uint32_t count = 0;
+    for (uint32_t i = begin; i < end; i++)
+    {
+        bool inside = true;
+        for (auto &plane : planes)
+        {
+            float distance = plane.normal[0] * boxes.centerX[i] + plane.normal[1] * boxes.centerY[i] + plane.normal[2] * boxes.centerZ[i] +
+                             plane.absNormal[0] * boxes.extentX[i] + plane.absNormal[1] * boxes.extentY[i] + plane.absNormal[2] * boxes.extentZ[i] + plane.distance;
+            // nan boxes are culled, as by the simd compares
+            inside = inside && distance >= 0.0f;
+        }
+        visible[count] = i;
+        count += inside;
+    }
+    return count;
+}
+
+// lanes set in mask are visible, lane 0 is object first
+static uint32_t AppendVisible(uint32_t mask, uint32_t first, uint32_t *visible)
+{
+    uint32_t count = 0;
+    while (mask)
+    {
+        visible[count++] = first + std::countr_zero(mask);
+        mask &= mask - 1;
+    }
+    return count;
+}
+
+#if defined(__AVX2__)
+
+static uint32_t CullSIMD(const CullingBoxes &boxes, const CullingPlane (&planes)[6], uint32_t begin, uint32_t end, uint32_t *visible)
+{
+    __m256 normals[6][3], absNormals[6][3], distances[6];
+    for (int p = 0; p < 6; p++)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            normals[p][axis] = _mm256_set1_ps(planes[p].normal[axis]);
+            absNormals[p][axis] = _mm256_set1_ps(planes[p].absNormal[axis]);
+        }
+        distances[p] = _mm256_set1_ps(planes[p].distance);
+    }
+    const __m256 zero = _mm256_setzero_ps();
+
+    uint32_t count = 0;
+    uint32_t i = begin;
+    for (; i + 8 <= end; i += 8)
+    {
+        __m256 cx = _mm256_loadu_ps(boxes.centerX + i);
+        __m256 cy = _mm256_loadu_ps(boxes.centerY + i);
+        __m256 cz = _mm256_loadu_ps(boxes.centerZ + i);
+        __m256 ex = _mm256_loadu_ps(boxes.extentX + i);
+        __m256 ey = _mm256_loadu_ps(boxes.extentY + i);
+        __m256 ez = _mm256_loadu_ps(boxes.extentZ + i);
+
+        __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m256 distance = _mm256_add_ps(_mm256_mul_ps(normals[p][0], cx), _mm256_mul_ps(normals[p][1], cy));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(normals[p][2], cz));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(absNormals[p][0], ex));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(absNormals[p][1], ey));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(absNormals[p][2], ez));
+            distance = _mm256_add_ps(distance, distances[p]);
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, zero, _CMP_GE_OQ));
+        }
+        count += AppendVisible(uint32_t(_mm256_movemask_ps(inside)), i, visible + count);
+    }
+    return count + CullScalar(boxes, planes, i, end, visible + count);
+}
+
+#elif defined(PIXEL_CULLING_SSE2)
+
+static uint32_t CullSIMD(const CullingBoxes &boxes, const CullingPlane (&planes)[6], uint32_t begin, uint32_t end, uint32_t *visible)
+{
+    __m128 normals[6][3], absNormals[6][3], distances[6];
+    for (int p = 0; p < 6; p++)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            normals[p][axis] = _mm_set1_ps(planes[p].normal[axis]);
+            absNormals[p][axis] = _mm_set1_ps(planes[p].absNormal[axis]);
+        }
+        distances[p] = _mm_set1_ps(planes[p].distance);
+    }
+    const __m128 zero = _mm_setzero_ps();
+
+    uint32_t count = 0;
+    uint32_t i = begin;
+    for (; i + 4 <= end; i += 4)
+    {
+        __m128 cx = _mm_loadu_ps(boxes.centerX + i);
+        __m128 cy = _mm_loadu_ps(boxes.centerY + i);
+        __m128 cz = _mm_loadu_ps(boxes.centerZ + i);
+        __m128 ex = _mm_loadu_ps(boxes.extentX + i);
+        __m128 ey = _mm_loadu_ps(boxes.extentY + i);
+        __m128 ez = _mm_loadu_ps(boxes.extentZ + i);
+
+        __m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+        for (int p = 0; p < 6; p++)
+        {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(normals[p][0], cx), _mm_mul_ps(normals[p][1], cy));
+            distance = _mm_add_ps(distance, _mm_mul_ps(normals[p][2], cz));
+            distance = _mm_add_ps(distance, _mm_mul_ps(absNormals[p][0], ex));
+            distance = _mm_add_ps(distance, _mm_mul_ps(absNormals[p][1], ey));
+            distance = _mm_add_ps(distance, _mm_mul_ps(absNormals[p][2], ez));
+            distance = _mm_add_ps(distance, distances[p]);
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+        }
+        count += AppendVisible(uint32_t(_mm_movemask_ps(inside)), i, visible + count);
+    }
+    return count + CullScalar(boxes, planes, i, end, visible + count);
+}
+
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+
+static uint32_t CullSIMD(const CullingBoxes &boxes, const CullingPlane (&planes)[6], uint32_t begin, uint32_t end, uint32_t *visible)
+{
+    float32x4_t normals[6][3], absNormals[6][3], distances[6];
+    for (int p = 0; p < 6; p++)
+    {
+        for (int axis = 0; axis < 3; axis++)
+        {
+            normals[p][axis] = vdupq_n_f32(planes[p].normal[axis]);
+            absNormals[p][axis] = vdupq_n_f32(planes[p].absNormal[axis]);
+        }
+        distances[p] = vdupq_n_f32(planes[p].distance);
+    }
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    // summed over the set lanes into a movemask
+    static const uint32_t laneBits[4] = {1, 2, 4, 8};
+    const uint32x4_t lanes = vld1q_u32(laneBits);
+
+    uint32_t count = 0;
+    uint32_t i = begin;
+    for (; i + 4 <= end; i += 4)
+    {
+        float32x4_t cx = vld1q_f32(boxes.centerX + i);
+        float32x4_t cy = vld1q_f32(boxes.centerY + i);
+        float32x4_t cz = vld1q_f32(boxes.centerZ + i);
+        float32x4_t ex = vld1q_f32(boxes.extentX + i);
+        float32x4_t ey = vld1q_f32(boxes.extentY + i);
+        float32x4_t ez = vld1q_f32(boxes.extentZ + i);
+
+        uint32x4_t inside = vdupq_n_u32(0xffffffffu);
+        for (int p = 0; p < 6; p++)
+        {
+            float32x4_t distance = vaddq_f32(vmulq_f32(normals[p][0], cx), vmulq_f32(normals[p][1], cy));
+            distance = vaddq_f32(distance, vmulq_f32(normals[p][2], cz));
+            distance = vaddq_f32(distance, vmulq_f32(absNormals[p][0], ex));
+            distance = vaddq_f32(distance, vmulq_f32(absNormals[p][1], ey));
+            distance = vaddq_f32(distance, vmulq_f32(absNormals[p][2], ez));
+            distance = vaddq_f32(distance, distances[p]);
+            inside = vandq_u32(inside, vcgeq_f32(distance, zero));
+        }
+        count += AppendVisible(vaddvq_u32(vandq_u32(inside, lanes)), i, visible + count);
+    }
+    return count + CullScalar(boxes, planes, i, end, visible + count);
+}
+
+#else
+
+static uint32_t CullSIMD(const CullingBoxes &boxes, const CullingPlane (&planes)[6], uint32_t begin, uint32_t end, uint32_t *visible)
+{
+    return CullScalar(boxes, planes, begin, end, visible);
+}
+
+#endif
+
+const char *CPUCulling::GetInstructionSet()
+{
+#if defined(__AVX2__)
+    return "avx2";
+#elif defined(PIXEL_CULLING_SSE2)
+    return "sse2";
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+uint32_t CPUCulling::Add(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, const glm::mat4 &transform)
+{
+    localCenters.push_back((boundsMin + boundsMax) * 0.5f);
+    localExtents.push_back((boundsMax - boundsMin) * 0.5f);
+
+    centerX.push_back(0.0f);
+    centerY.push_back(0.0f);
+    centerZ.push_back(0.0f);
+    extentX.push_back(0.0f);
+    extentY.push_back(0.0f);
+    extentZ.push_back(0.0f);
+
+    auto index = uint32_t(centerX.size() - 1);
+    SetTransform(index, transform);
+    return index;
+}
+
+void CPUCulling::SetTransform(uint32_t index, const glm::mat4 &transform)
+{
+    if (index >= centerX.size())
+    {
+        throw std::runtime_error("cpu culling: no object " + std::to_string(index));
+    }
+
+    // box of the transformed box, as in cull.comp
+    glm::vec3 center = glm::vec3(transform * glm::vec4(localCenters[index], 1.0f));
+    glm::mat3 absolute = glm::mat3(transform);
+    for (int i = 0; i < 3; i++)
+    {
+        absolute[i] = glm::abs(absolute[i]);
+    }
+    glm::vec3 extent = absolute * localExtents[index];
+
+    centerX[index] = center.x;
+    centerY[index] = center.y;
+    centerZ[index] = center.z;
+    extentX[index] = extent.x;
+    extentY[index] = extent.y;
+    extentZ[index] = extent.z;
+}
+
+void CPUCulling::Clear()
+{
+    localCenters.clear();
+    localExtents.clear();
+    centerX.clear();
+    centerY.clear();
+    centerZ.clear();
+    extentX.clear();
+    extentY.clear();
+    extentZ.clear();
+}
+
+void CPUCulling::Cull(const Frustum &frustum, std::vector<uint32_t> &visible, bool simd, bool parallel)
+{
+    TRACE_SCOPE("CPUCulling::Cull");
+
+    CullingPlane planes[6];
+    for (int p = 0; p < 6; p++)
+    {
+        auto &plane = frustum.planes[p];
+        planes[p] = {
+            .normal = {plane.x, plane.y, plane.z},
+            .absNormal = {std::abs(plane.x), std::abs(plane.y), std::abs(plane.z)},
+            .distance = plane.w};
+    }
+
+    CullingBoxes boxes = {centerX.data(), centerY.data(), centerZ.data(), extentX.data(), extentY.data(), extentZ.data()};
+
+    auto count = GetCount();
+    uint32_t chunkCount = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+    chunkVisible.resize(count);
+    chunkCounts.resize(chunkCount);
+
+    ParallelFor(chunkCount, parallel ? 2 : UINT32_MAX, [&](uint32_t begin, uint32_t end)
+                {
+                    for (uint32_t chunk = begin; chunk < end; chunk++)
+                    {
+                        uint32_t first = chunk * CHUNK_SIZE;
+                        uint32_t last = std::min(first + CHUNK_SIZE, count);
+                        auto output = chunkVisible.data() + first;
+                        chunkCounts[chunk] = simd ? CullSIMD(boxes, planes, first, last, output) : CullScalar(boxes, planes, first, last, output);
+                    }
+                });
+
+    uint32_t visibleCount = 0;
+    for (auto chunkVisibleCount : chunkCounts)
+    {
+        visibleCount += chunkVisibleCount;
+    }
+
+    visible.resize(visibleCount);
+    uint32_t offset = 0;
+    for (uint32_t chunk = 0; chunk < chunkCount; chunk++)
+    {
+        memcpy(visible.data() + offset, chunkVisible.data() + size_t(chunk) * CHUNK_SIZE, chunkCounts[chunk] * sizeof(uint32_t));
+        offset += chunkCounts[chunk];
+    }
+}
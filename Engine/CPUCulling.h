@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <Core/IntrusivePtr.h>
+
+#include <Engine/Frustum.h>
+
+// object boxes tested against a frustum on the cpu, for when gpu culling is not available or not worth a pass
+// the world box of every object is kept as one array per component and tested 8 (avx2) or 4 (sse2, neon) at a time
+// transforms are folded into the world boxes when they are set, culling reads the boxes only
+class CPUCulling : public IntrusiveCounter<CPUCulling>
+{
+public:
+    // objects per parallel task, a multiple of every simd width
+    static constexpr uint32_t CHUNK_SIZE = 16384;
+
+    // object space box, returns the object index
+    uint32_t Add(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, const glm::mat4 &transform);
+
+    void SetTransform(uint32_t index, const glm::mat4 &transform);
+
+    void Clear();
+
+    uint32_t GetCount()
+    {
+        return uint32_t(centerX.size());
+    }
+
+    // indices of the objects whose box intersects the frustum, increasing
+    // simd false runs the scalar loop the simd one must match, parallel false stays on the calling thread
+    void Cull(const Frustum &frustum, std::vector<uint32_t> &visible, bool simd = true, bool parallel = true);
+
+    // avx2, sse2, neon or scalar, chosen at compile time, PIXEL_ENABLE_AVX2 for avx2
+    static const char *GetInstructionSet();
+
+private:
+    // object space box
+    std::vector<glm::vec3> localCenters;
+    std::vector<glm::vec3> localExtents;
+
+    // world box
+    std::vector<float> centerX;
+    std::vector<float> centerY;
+    std::vector<float> centerZ;
+    std::vector<float> extentX;
+    std::vector<float> extentY;
+    std::vector<float> extentZ;
+
+    // every chunk writes its visible objects at its own offset, compacted into the result afterwards
+    std::vector<uint32_t> chunkVisible;
+    std::vector<uint32_t> chunkCounts;
+};
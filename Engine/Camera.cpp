@@ -7,7 +7,7 @@ Camera::Camera(IntrusivePtr<RHIRuntime> rhiRuntime) : rhiRuntime(rhiRuntime)
 
 void Camera::Allocate()
 {
-    this->uniformBuffer = rhiRuntime->CreateMutableBuffer(Buffer::BUFFER_USAGE_UNIFORM_BUFFER_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, sizeof(UBO));
+    this->uniformBuffer = rhiRuntime->CreateDynamicBuffer(sizeof(UBO));
 }
 
 bool Camera::EventCallback(UpdateInput inputs)
@@ -74,9 +74,8 @@ bool Camera::EventCallback(UpdateInput inputs)
 
     this->update(deltaTime / 100.f);
 
-    auto frameUniformBuffer = static_cast<MutableBuffer*>(uniformBuffer.get());
-
-    memcpy(frameUniformBuffer->GetBuffer(inputs.currentImageIndex)->Map(), &ubo, sizeof(ubo));
+    // copied into the frame's uniform slice when command buffer is recorded
+    memcpy(uniformBuffer->Map(), &ubo, sizeof(ubo));
 
     return false;
 }
\ No newline at end of file
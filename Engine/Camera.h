@@ -15,14 +15,14 @@
 
 #include <Core/IntrusivePtr.h>
 #include <RHI/Buffer.h>
-#include <RHI/MutableBuffer.h>
+#include <RHI/DynamicBuffer.h>
 #include <RHI/RHIRuntime.h>
 
 class Camera : public IntrusiveCounter<Camera>
 {
 private:
 	// uniform Buffer for camera matrix
-	IntrusivePtr<MutableBuffer> uniformBuffer;
+	IntrusivePtr<DynamicBuffer> uniformBuffer;
 	IntrusivePtr<RHIRuntime> rhiRuntime;
 	glm::vec2 mousePos = {};
 
@@ -70,7 +70,7 @@ public:
 
 	UBO ubo;
 
-	IntrusivePtr<MutableBuffer> GetUBOBuffer()
+	IntrusivePtr<DynamicBuffer> GetUBOBuffer()
 	{
 		return this->uniformBuffer;
 	}
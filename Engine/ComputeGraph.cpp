@@ -0,0 +1,17 @@
+#include <Engine/ComputeGraph.h>
+
+#include <atomic>
+
+RenderSubPassResourceJson ComputeGraph::ChainResource(const std::string &subpassName)
+{
+    RenderSubPassResourceJson resource = {};
+    resource.name = subpassName + ".out";
+    resource.type = "ssbo";
+    return resource;
+}
+
+std::string ComputeGraph::UniqueName(const std::string &prefix)
+{
+    static std::atomic<uint32_t> groupCount = 0;
+    return prefix + std::to_string(groupCount++);
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <string>
+
+#include <FrameGraph/GraphNodeJson.h>
+
+// shared pieces of the render group json built by the engine compute modules
+namespace ComputeGraph
+{
+    // dummy resource written by a subpass and read by the next one, so that the graph keeps their order
+    RenderSubPassResourceJson ChainResource(const std::string &subpassName);
+
+    // prefix followed by a process wide counter, render group names must be unique
+    // the gpu profiler reports the subpasses as <group>::<subpass>::<subpass>
+    std::string UniqueName(const std::string &prefix);
+}
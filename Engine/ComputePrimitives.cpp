@@ -0,0 +1,292 @@
+#include <Engine/ComputePrimitives.h>
+#include <Engine/ComputeGraph.h>
+#include <Engine/PixelEngine.h>
+#include <Engine/Renderer.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#include <FrameGraph/Graph.h>
+
+#include <RHI/RHIRuntime.h>
+
+#include <json_struct/json_struct.h>
+#include <spdlog/spdlog.h>
+
+static constexpr uint32_t MAX_GROUP_COUNT = 65535;
+
+static uint32_t DivideRoundUp(uint32_t size, uint32_t groupSize)
+{
+    return (size + groupSize - 1) / groupSize;
+}
+
+static uint32_t BlockCount(uint32_t count)
+{
+    auto blockCount = DivideRoundUp(count, ComputePrimitives::BLOCK_SIZE);
+    if (blockCount > MAX_GROUP_COUNT)
+    {
+        throw std::runtime_error("compute primitives: too many elements");
+    }
+    return blockCount;
+}
+
+void ComputeTask::AddTo(IntrusivePtr<Renderer> renderer)
+{
+    for (auto &state : states)
+    {
+        renderer->AddDrawState(state);
+    }
+}
+
+ComputePrimitives::ComputePrimitives(PixelEngine *engine, bool allowSubgroups) : engine(engine)
+{
+    auto runtimeInfo = engine->GetRHIRuntime()->GetRuntimeInfo();
+    subgroups = allowSubgroups && runtimeInfo.subgroupArithmetic;
+    spdlog::info("compute primitives: subgroup kernels {}, subgroup size {}", subgroups, runtimeInfo.subgroupSize);
+}
+
+IntrusivePtr<Buffer> ComputePrimitives::createScratch(uint32_t count)
+{
+    return engine->GetRHIRuntime()->CreateBuffer(Buffer::BUFFER_USAGE_STORAGE_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, std::max(count, 1u) * sizeof(uint32_t));
+}
+
+// scan level by level up to a single block, then the scanned block totals are added back down
+void ComputePrimitives::appendScan(std::vector<Pass> &passes, std::vector<IntrusivePtr<Buffer>> &scratch, IntrusivePtr<Buffer> src, IntrusivePtr<Buffer> dst, uint32_t count, bool inclusive, bool predicate)
+{
+    // data and element count of every level, level 0 is dst
+    std::vector<std::pair<IntrusivePtr<Buffer>, uint32_t>> levels = {{dst, count}};
+
+    auto levelSrc = src;
+    while (true)
+    {
+        auto [levelData, levelCount] = levels.back();
+        auto blockCount = BlockCount(levelCount);
+        auto blockSums = createScratch(blockCount);
+        scratch.push_back(blockSums);
+
+        // upper levels are exclusive and in place, they are rewritten from the level below every time
+        bool first = levels.size() == 1;
+        passes.push_back({
+            .kernel = "scan_blocks",
+            .bindings = {levelSrc, levelData, blockSums},
+            .constants = {levelCount, first && inclusive, first && predicate, 0},
+            .groupCount = blockCount});
+
+        if (blockCount == 1)
+            break;
+
+        levels.push_back({blockSums, blockCount});
+        levelSrc = blockSums;
+    }
+
+    for (size_t level = levels.size() - 1; level > 0; level--)
+    {
+        auto [levelData, levelCount] = levels[level - 1];
+        passes.push_back({
+            .kernel = "scan_add",
+            .bindings = {levelData, levels[level].first},
+            .constants = {levelCount, 0, 0, 0},
+            .groupCount = BlockCount(levelCount)});
+    }
+}
+
+IntrusivePtr<ComputeTask> ComputePrimitives::build(const std::string &name, std::vector<Pass> &passes, std::vector<IntrusivePtr<Buffer>> scratch)
+{
+    auto &rhiRuntime = engine->GetRHIRuntime();
+
+    IntrusivePtr<ComputeTask> task = new ComputeTask;
+    task->name = ComputeGraph::UniqueName(name);
+    task->scratch = std::move(scratch);
+
+    RenderPassJson json = {};
+    json.name = task->name;
+    for (size_t i = 0; i < passes.size(); i++)
+    {
+        RenderSubPassJson subpass = {};
+        subpass.name = passes[i].kernel + std::to_string(i);
+        subpass.type = "compute";
+        subpass.shaders.compute = passes[i].kernel + (subgroups ? ".subgroup.comp.spv" : ".comp.spv");
+        if (i > 0)
+        {
+            subpass.inputs.push_back(ComputeGraph::ChainResource(json.subpasses.back().name));
+        }
+        subpass.outputs.push_back(ComputeGraph::ChainResource(subpass.name));
+        json.subpasses.push_back(subpass);
+    }
+
+    task->renderGroup = engine->RegisterRenderGroup(Graph::ParseRenderPassJsonRawString(JS::serializeStruct(json)));
+    if (!task->renderGroup)
+    {
+        throw std::runtime_error("compute primitives: failed to register " + task->name);
+    }
+
+    for (size_t i = 0; i < passes.size(); i++)
+    {
+        auto &pass = passes[i];
+        auto &passName = json.subpasses[i].name;
+
+        auto pipeline = task->renderGroup->CreatePipeline(passName, ComputePipelineStates{});
+        auto state = rhiRuntime->CreateResourceBindingState(pipeline);
+        for (uint32_t binding = 0; binding < pass.bindings.size(); binding++)
+        {
+            state->Bind(0, binding, pass.bindings[binding]);
+        }
+
+        auto constants = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_UNIFORM_BUFFER_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_LOCAL_BIT, sizeof(pass.constants));
+        memcpy(constants->Map(), pass.constants.data(), sizeof(pass.constants));
+        state->Bind(constants);
+
+        state->BindDispatchOp({ResourceBindingState::DispatchOP{
+            .type = ResourceBindingState::DispatchOP::DIRECT,
+            .groupCount = {pass.groupCount, 1, 1}}});
+        state->name = passName;
+
+        task->states.push_back(state);
+    }
+
+    return task;
+}
+
+IntrusivePtr<ComputeTask> ComputePrimitives::PrefixSum(IntrusivePtr<Buffer> src, IntrusivePtr<Buffer> dst, uint32_t count, bool inclusive)
+{
+    if (!count)
+    {
+        throw std::runtime_error("compute primitives: empty prefix sum");
+    }
+
+    std::vector<Pass> passes;
+    std::vector<IntrusivePtr<Buffer>> scratch;
+    appendScan(passes, scratch, src, dst, count, inclusive, false);
+    return build("PrefixSum", passes, scratch);
+}
+
+IntrusivePtr<ComputeTask> ComputePrimitives::Reduce(IntrusivePtr<Buffer> src, IntrusivePtr<Buffer> result, uint32_t count, ReduceOp op)
+{
+    if (!count)
+    {
+        throw std::runtime_error("compute primitives: empty reduction");
+    }
+
+    std::vector<Pass> passes;
+    std::vector<IntrusivePtr<Buffer>> scratch;
+
+    auto levelSrc = src;
+    auto levelCount = count;
+    while (true)
+    {
+        auto blockCount = BlockCount(levelCount);
+        auto partials = blockCount == 1 ? result : createScratch(blockCount);
+        if (blockCount > 1)
+        {
+            scratch.push_back(partials);
+        }
+
+        passes.push_back({
+            .kernel = "reduce",
+            .bindings = {levelSrc, partials},
+            .constants = {levelCount, uint32_t(op), 0, 0},
+            .groupCount = blockCount});
+
+        if (blockCount == 1)
+            break;
+
+        levelSrc = partials;
+        levelCount = blockCount;
+    }
+
+    return build("Reduce", passes, scratch);
+}
+
+IntrusivePtr<ComputeTask> ComputePrimitives::Compact(IntrusivePtr<Buffer> values, IntrusivePtr<Buffer> flags, IntrusivePtr<Buffer> dst, IntrusivePtr<Buffer> dstCount, uint32_t count)
+{
+    if (!count)
+    {
+        throw std::runtime_error("compute primitives: empty compaction");
+    }
+
+    std::vector<Pass> passes;
+    std::vector<IntrusivePtr<Buffer>> scratch;
+
+    // exclusive scan of flags != 0 gives the output index of every kept value
+    auto offsets = createScratch(count);
+    scratch.push_back(offsets);
+    appendScan(passes, scratch, flags, offsets, count, false, true);
+
+    passes.push_back({
+        .kernel = "compact_scatter",
+        .bindings = {values, flags, offsets, dst, dstCount},
+        .constants = {count, 0, 0, 0},
+        .groupCount = BlockCount(count)});
+
+    return build("Compact", passes, scratch);
+}
+
+IntrusivePtr<ComputeTask> ComputePrimitives::RadixSort(IntrusivePtr<Buffer> keys, uint32_t count, IntrusivePtr<Buffer> values)
+{
+    if (!count)
+    {
+        throw std::runtime_error("compute primitives: empty sort");
+    }
+
+    static constexpr uint32_t RADIX = 1 << RADIX_BITS;
+
+    std::vector<Pass> passes;
+    std::vector<IntrusivePtr<Buffer>> scratch;
+
+    auto blockCount = BlockCount(count);
+    auto blockHist = createScratch(RADIX * blockCount);
+    auto offsets = createScratch(RADIX * blockCount);
+    auto scratchKeys = createScratch(count);
+    // bound in place of the values of a keys only sort
+    auto scratchValues = values ? createScratch(count) : createScratch(1);
+    scratch.insert(scratch.end(), {blockHist, offsets, scratchKeys, scratchValues});
+
+    std::array<IntrusivePtr<Buffer>, 2> keyBuffers = {keys, scratchKeys};
+    std::array<IntrusivePtr<Buffer>, 2> valueBuffers = {values ? values : scratchValues, scratchValues};
+
+    // an even number of digits ends in keys and values
+    for (uint32_t shift = 0, i = 0; shift < 32; shift += RADIX_BITS, i++)
+    {
+        auto &keysIn = keyBuffers[i % 2];
+        auto &keysOut = keyBuffers[(i + 1) % 2];
+        auto &valuesIn = valueBuffers[i % 2];
+        auto &valuesOut = valueBuffers[(i + 1) % 2];
+
+        passes.push_back({
+            .kernel = "radix_histogram",
+            .bindings = {keysIn, blockHist},
+            .constants = {count, shift, blockCount, 0},
+            .groupCount = blockCount});
+
+        appendScan(passes, scratch, blockHist, offsets, RADIX * blockCount, false, false);
+
+        passes.push_back({
+            .kernel = "radix_scatter",
+            .bindings = {keysIn, keysOut, valuesIn, valuesOut, offsets},
+            .constants = {count, shift, blockCount, values ? 1u : 0u},
+            .groupCount = blockCount});
+    }
+
+    return build("RadixSort", passes, scratch);
+}
+
+IntrusivePtr<ComputeTask> ComputePrimitives::Histogram(IntrusivePtr<Buffer> src, IntrusivePtr<Buffer> bins, uint32_t count, uint32_t binCount, uint32_t minValue, uint32_t binWidth)
+{
+    if (!count || !binCount || !binWidth)
+    {
+        throw std::runtime_error("compute primitives: empty histogram");
+    }
+
+    std::vector<Pass> passes = {
+        {.kernel = "fill",
+         .bindings = {bins},
+         .constants = {binCount, 0, 0, 0},
+         .groupCount = BlockCount(binCount)},
+        {.kernel = "histogram",
+         .bindings = {src, bins},
+         .constants = {count, binCount, minValue, binWidth},
+         .groupCount = BlockCount(count)}};
+
+    return build("Histogram", passes, {});
+}
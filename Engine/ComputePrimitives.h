@@ -0,0 +1,90 @@
+#pragma once
+
+#include <array>
+#include <string>
+#include <vector>
+
+#include <Core/IntrusivePtr.h>
+
+#include <RHI/Buffer.h>
+#include <RHI/RenderGroup.h>
+#include <RHI/ResourceBindingState.h>
+
+class PixelEngine;
+class Renderer;
+
+// chain of compute passes in a render group of its own
+// dispatched every frame once added to a renderer, passes of a task are ordered, tasks are not
+class ComputeTask : public IntrusiveCounter<ComputeTask>
+{
+public:
+    // render group name, see ComputeGraph::UniqueName
+    std::string name;
+
+    IntrusivePtr<RenderGroup> renderGroup;
+    std::vector<IntrusivePtr<ResourceBindingState>> states;
+
+    // intermediate buffers owned by the task
+    std::vector<IntrusivePtr<Buffer>> scratch;
+
+    void AddTo(IntrusivePtr<Renderer> renderer);
+};
+
+// scan, reduce, compaction, radix sort and histogram over storage buffers of uint32_t
+// buffers need BUFFER_USAGE_STORAGE_BUFFER_BIT, kernels are read from Engine/Shaders compiled into Shaders/
+class ComputePrimitives : public IntrusiveCounter<ComputePrimitives>
+{
+public:
+    enum ReduceOp
+    {
+        REDUCE_ADD = 0,
+        REDUCE_MIN = 1,
+        REDUCE_MAX = 2,
+    };
+
+    // subgroup kernels (*.subgroup.comp.spv) are used if allowed and the device has subgroup arithmetic in compute
+    ComputePrimitives(PixelEngine *engine, bool allowSubgroups = true);
+
+    bool UsesSubgroups()
+    {
+        return subgroups;
+    }
+
+    // dst[i] is the sum of src[0, i) or src[0, i] if inclusive, src and dst must not alias
+    // a task runs every frame, in place it would scan its own output
+    IntrusivePtr<ComputeTask> PrefixSum(IntrusivePtr<Buffer> src, IntrusivePtr<Buffer> dst, uint32_t count, bool inclusive = false);
+
+    // result[0] is op over src[0, count)
+    IntrusivePtr<ComputeTask> Reduce(IntrusivePtr<Buffer> src, IntrusivePtr<Buffer> result, uint32_t count, ReduceOp op = REDUCE_ADD);
+
+    // values[i] with flags[i] != 0 packed into dst in order, their number into dstCount[0]
+    IntrusivePtr<ComputeTask> Compact(IntrusivePtr<Buffer> values, IntrusivePtr<Buffer> flags, IntrusivePtr<Buffer> dst, IntrusivePtr<Buffer> dstCount, uint32_t count);
+
+    // ascending and stable, in place, values are moved along with their keys
+    IntrusivePtr<ComputeTask> RadixSort(IntrusivePtr<Buffer> keys, uint32_t count, IntrusivePtr<Buffer> values = nullptr);
+
+    // bins[(v - minValue) / binWidth] counts the values v of src, values outside of the bins are dropped
+    IntrusivePtr<ComputeTask> Histogram(IntrusivePtr<Buffer> src, IntrusivePtr<Buffer> bins, uint32_t count, uint32_t binCount, uint32_t minValue = 0, uint32_t binWidth = 1);
+
+    // elements covered by one workgroup, BLOCK_SIZE of primitives.glsl
+    static constexpr uint32_t BLOCK_SIZE = 1024;
+    static constexpr uint32_t WORKGROUP_SIZE = 256;
+    static constexpr uint32_t RADIX_BITS = 4;
+
+private:
+    struct Pass
+    {
+        std::string kernel;
+        // buffer of binding i in set 0
+        std::vector<IntrusivePtr<Buffer>> bindings;
+        std::array<uint32_t, 4> constants;
+        uint32_t groupCount;
+    };
+
+    PixelEngine *engine;
+    bool subgroups = false;
+
+    IntrusivePtr<Buffer> createScratch(uint32_t count);
+    void appendScan(std::vector<Pass> &passes, std::vector<IntrusivePtr<Buffer>> &scratch, IntrusivePtr<Buffer> src, IntrusivePtr<Buffer> dst, uint32_t count, bool inclusive, bool predicate);
+    IntrusivePtr<ComputeTask> build(const std::string &name, std::vector<Pass> &passes, std::vector<IntrusivePtr<Buffer>> scratch);
+};
@@ -0,0 +1,771 @@
+#include <Engine/DynamicBVH.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <stdexcept>
+#include <string>
+
+#include <Core/Trace.h>
+
+// half of the surface area, the sah cost only compares them
+static float Area(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax)
+{
+    glm::vec3 extent = boundsMax - boundsMin;
+    return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+static bool Contains(const glm::vec3 &outerMin, const glm::vec3 &outerMax, const glm::vec3 &innerMin, const glm::vec3 &innerMax)
+{
+    return glm::all(glm::lessThanEqual(outerMin, innerMin)) && glm::all(glm::greaterThanEqual(outerMax, innerMax));
+}
+
+// entry distance of the ray into the box if it enters before limit
+static bool IntersectRay(const glm::vec3 &origin, const glm::vec3 &inverseDirection, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, float limit, float &distance)
+{
+    glm::vec3 t0 = (boundsMin - origin) * inverseDirection;
+    glm::vec3 t1 = (boundsMax - origin) * inverseDirection;
+    glm::vec3 tMin = glm::min(t0, t1);
+    glm::vec3 tMax = glm::max(t0, t1);
+    float enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+    float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, limit));
+    distance = enter;
+    return enter <= exit;
+}
+
+int32_t DynamicBVH::allocateNode()
+{
+    int32_t node = freeList;
+    if (node == NULL_NODE)
+    {
+        node = int32_t(nodes.size());
+        nodes.emplace_back();
+        objectBounds.emplace_back();
+    }
+    else
+    {
+        freeList = nodes[node].parent;
+    }
+
+    nodes[node].parent = NULL_NODE;
+    nodes[node].child1 = NULL_NODE;
+    nodes[node].child2 = NULL_NODE;
+    nodes[node].height = 0;
+    nodes[node].object = 0;
+    return node;
+}
+
+void DynamicBVH::freeNode(int32_t node)
+{
+    nodes[node].parent = freeList;
+    nodes[node].height = -1;
+    freeList = node;
+}
+
+int32_t DynamicBVH::Insert(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, uint32_t object)
+{
+    int32_t proxy = allocateNode();
+    objectBounds[proxy] = {boundsMin, boundsMax};
+    nodes[proxy].boundsMin = boundsMin - glm::vec3(margin);
+    nodes[proxy].boundsMax = boundsMax + glm::vec3(margin);
+    nodes[proxy].object = object;
+
+    insertLeaf(proxy);
+    proxyCount++;
+    return proxy;
+}
+
+void DynamicBVH::Remove(int32_t proxy)
+{
+    if (proxy < 0 || proxy >= int32_t(nodes.size()) || nodes[proxy].height != 0)
+    {
+        throw std::runtime_error("dynamic bvh: no proxy " + std::to_string(proxy));
+    }
+
+    removeLeaf(proxy);
+    freeNode(proxy);
+    proxyCount--;
+}
+
+bool DynamicBVH::Move(int32_t proxy, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, const glm::vec3 &displacement)
+{
+    if (proxy < 0 || proxy >= int32_t(nodes.size()) || nodes[proxy].height != 0)
+    {
+        throw std::runtime_error("dynamic bvh: no proxy " + std::to_string(proxy));
+    }
+
+    objectBounds[proxy] = {boundsMin, boundsMax};
+    if (Contains(nodes[proxy].boundsMin, nodes[proxy].boundsMax, boundsMin, boundsMax))
+    {
+        return false;
+    }
+
+    removeLeaf(proxy);
+
+    // ahead of the motion, so that the next moves fit too
+    glm::vec3 fatMin = boundsMin - glm::vec3(margin);
+    glm::vec3 fatMax = boundsMax + glm::vec3(margin);
+    fatMin += glm::min(displacement, glm::vec3(0.0f));
+    fatMax += glm::max(displacement, glm::vec3(0.0f));
+    nodes[proxy].boundsMin = fatMin;
+    nodes[proxy].boundsMax = fatMax;
+
+    insertLeaf(proxy);
+    return true;
+}
+
+// walks down to the sibling with the lowest sah cost increase, then pairs the leaf with it under a new node
+void DynamicBVH::insertLeaf(int32_t leaf)
+{
+    if (root == NULL_NODE)
+    {
+        root = leaf;
+        nodes[root].parent = NULL_NODE;
+        return;
+    }
+
+    glm::vec3 leafMin = nodes[leaf].boundsMin;
+    glm::vec3 leafMax = nodes[leaf].boundsMax;
+
+    int32_t index = root;
+    while (nodes[index].height > 0)
+    {
+        auto &node = nodes[index];
+        float area = Area(node.boundsMin, node.boundsMax);
+        float combinedArea = Area(glm::min(node.boundsMin, leafMin), glm::max(node.boundsMax, leafMax));
+
+        // pairing with this node, or pushing the leaf into a child which grows this node anyway
+        float cost = 2.0f * combinedArea;
+        float inheritanceCost = 2.0f * (combinedArea - area);
+
+        auto childCost = [&](int32_t child)
+        {
+            auto &childNode = nodes[child];
+            float grownArea = Area(glm::min(childNode.boundsMin, leafMin), glm::max(childNode.boundsMax, leafMax));
+            if (childNode.height > 0)
+            {
+                grownArea -= Area(childNode.boundsMin, childNode.boundsMax);
+            }
+            return grownArea + inheritanceCost;
+        };
+
+        float cost1 = childCost(node.child1);
+        float cost2 = childCost(node.child2);
+        if (cost < cost1 && cost < cost2)
+        {
+            break;
+        }
+        index = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    int32_t sibling = index;
+    int32_t oldParent = nodes[sibling].parent;
+    // nodes may grow here, no reference is held across
+    int32_t newParent = allocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].boundsMin = glm::min(nodes[sibling].boundsMin, leafMin);
+    nodes[newParent].boundsMax = glm::max(nodes[sibling].boundsMax, leafMax);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent == NULL_NODE)
+    {
+        root = newParent;
+    }
+    else if (nodes[oldParent].child1 == sibling)
+    {
+        nodes[oldParent].child1 = newParent;
+    }
+    else
+    {
+        nodes[oldParent].child2 = newParent;
+    }
+
+    refitUp(nodes[leaf].parent);
+}
+
+// the sibling takes the place of the parent, which is freed
+void DynamicBVH::removeLeaf(int32_t leaf)
+{
+    if (leaf == root)
+    {
+        root = NULL_NODE;
+        return;
+    }
+
+    int32_t parent = nodes[leaf].parent;
+    int32_t grandParent = nodes[parent].parent;
+    int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    freeNode(parent);
+    if (grandParent == NULL_NODE)
+    {
+        root = sibling;
+        nodes[sibling].parent = NULL_NODE;
+        return;
+    }
+
+    if (nodes[grandParent].child1 == parent)
+    {
+        nodes[grandParent].child1 = sibling;
+    }
+    else
+    {
+        nodes[grandParent].child2 = sibling;
+    }
+    nodes[sibling].parent = grandParent;
+
+    refitUp(grandParent);
+}
+
+void DynamicBVH::refitUp(int32_t index)
+{
+    while (index != NULL_NODE)
+    {
+        index = balance(index);
+
+        auto &node = nodes[index];
+        auto &child1 = nodes[node.child1];
+        auto &child2 = nodes[node.child2];
+        node.height = 1 + std::max(child1.height, child2.height);
+        node.boundsMin = glm::min(child1.boundsMin, child2.boundsMin);
+        node.boundsMax = glm::max(child1.boundsMax, child2.boundsMax);
+
+        index = node.parent;
+    }
+}
+
+// rotates the higher child of a up if the children differ in height by more than 1, returns the node now in place of a
+int32_t DynamicBVH::balance(int32_t a)
+{
+    if (nodes[a].height < 2)
+    {
+        return a;
+    }
+
+    int32_t b = nodes[a].child1;
+    int32_t c = nodes[a].child2;
+    int32_t difference = nodes[c].height - nodes[b].height;
+    if (difference >= -1 && difference <= 1)
+    {
+        return a;
+    }
+
+    int32_t up = difference > 1 ? c : b;
+    int32_t other = difference > 1 ? b : c;
+
+    // up takes the place of a, a becomes its first child
+    int32_t parent = nodes[a].parent;
+    nodes[up].parent = parent;
+    nodes[a].parent = up;
+    if (parent == NULL_NODE)
+    {
+        root = up;
+    }
+    else if (nodes[parent].child1 == a)
+    {
+        nodes[parent].child1 = up;
+    }
+    else
+    {
+        nodes[parent].child2 = up;
+    }
+
+    // the higher grandchild stays under up, the lower one takes the place of up under a
+    int32_t f = nodes[up].child1;
+    int32_t g = nodes[up].child2;
+    int32_t high = nodes[f].height > nodes[g].height ? f : g;
+    int32_t low = high == f ? g : f;
+
+    nodes[up].child1 = a;
+    nodes[up].child2 = high;
+    if (nodes[a].child1 == up)
+    {
+        nodes[a].child1 = low;
+    }
+    else
+    {
+        nodes[a].child2 = low;
+    }
+    nodes[low].parent = a;
+
+    nodes[a].boundsMin = glm::min(nodes[other].boundsMin, nodes[low].boundsMin);
+    nodes[a].boundsMax = glm::max(nodes[other].boundsMax, nodes[low].boundsMax);
+    nodes[a].height = 1 + std::max(nodes[other].height, nodes[low].height);
+
+    nodes[up].boundsMin = glm::min(nodes[a].boundsMin, nodes[high].boundsMin);
+    nodes[up].boundsMax = glm::max(nodes[a].boundsMax, nodes[high].boundsMax);
+    nodes[up].height = 1 + std::max(nodes[a].height, nodes[high].height);
+
+    return up;
+}
+
+void DynamicBVH::Rebuild()
+{
+    TRACE_SCOPE("DynamicBVH::Rebuild");
+
+    if (root == NULL_NODE)
+    {
+        return;
+    }
+
+    // leaves keep their index, inner nodes are all freed and allocated again
+    std::vector<int32_t> leaves;
+    leaves.reserve(proxyCount);
+    std::vector<glm::vec3> centroids(nodes.size());
+    for (int32_t i = 0; i < int32_t(nodes.size()); i++)
+    {
+        if (nodes[i].height == 0)
+        {
+            leaves.push_back(i);
+            centroids[i] = (nodes[i].boundsMin + nodes[i].boundsMax) * 0.5f;
+        }
+        else if (nodes[i].height > 0)
+        {
+            freeNode(i);
+        }
+    }
+
+    // binned sah over the centroids along the longest axis, returns the first leaf of the second half
+    auto split = [&](uint32_t begin, uint32_t end)
+    {
+        glm::vec3 centroidMin = glm::vec3(FLT_MAX);
+        glm::vec3 centroidMax = glm::vec3(-FLT_MAX);
+        for (uint32_t i = begin; i < end; i++)
+        {
+            centroidMin = glm::min(centroidMin, centroids[leaves[i]]);
+            centroidMax = glm::max(centroidMax, centroids[leaves[i]]);
+        }
+
+        glm::vec3 extent = centroidMax - centroidMin;
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        // all in one place, any order is as good
+        if (extent[axis] <= 0.0f)
+        {
+            return (begin + end) / 2;
+        }
+
+        float scale = BIN_COUNT / extent[axis];
+        auto binOf = [&](int32_t leaf)
+        {
+            return std::min(uint32_t((centroids[leaf][axis] - centroidMin[axis]) * scale), BIN_COUNT - 1);
+        };
+
+        struct Bin
+        {
+            glm::vec3 boundsMin = glm::vec3(FLT_MAX);
+            glm::vec3 boundsMax = glm::vec3(-FLT_MAX);
+            uint32_t count = 0;
+        };
+        Bin bins[BIN_COUNT];
+        for (uint32_t i = begin; i < end; i++)
+        {
+            auto &bin = bins[binOf(leaves[i])];
+            bin.boundsMin = glm::min(bin.boundsMin, nodes[leaves[i]].boundsMin);
+            bin.boundsMax = glm::max(bin.boundsMax, nodes[leaves[i]].boundsMax);
+            bin.count++;
+        }
+
+        // cost of splitting after bin i, swept from the right then from the left
+        float rightCosts[BIN_COUNT] = {};
+        Bin right;
+        for (uint32_t i = BIN_COUNT - 1; i > 0; i--)
+        {
+            right.boundsMin = glm::min(right.boundsMin, bins[i].boundsMin);
+            right.boundsMax = glm::max(right.boundsMax, bins[i].boundsMax);
+            right.count += bins[i].count;
+            rightCosts[i - 1] = right.count ? Area(right.boundsMin, right.boundsMax) * right.count : FLT_MAX;
+        }
+
+        uint32_t bestSplit = 0;
+        float bestCost = FLT_MAX;
+        Bin left;
+        for (uint32_t i = 0; i < BIN_COUNT - 1; i++)
+        {
+            left.boundsMin = glm::min(left.boundsMin, bins[i].boundsMin);
+            left.boundsMax = glm::max(left.boundsMax, bins[i].boundsMax);
+            left.count += bins[i].count;
+            if (!left.count || rightCosts[i] == FLT_MAX)
+            {
+                continue;
+            }
+
+            float cost = Area(left.boundsMin, left.boundsMax) * left.count + rightCosts[i];
+            if (cost < bestCost)
+            {
+                bestCost = cost;
+                bestSplit = i;
+            }
+        }
+
+        auto middle = std::partition(leaves.begin() + begin, leaves.begin() + end, [&](int32_t leaf)
+                                     { return binOf(leaf) <= bestSplit; });
+        return uint32_t(middle - leaves.begin());
+    };
+
+    // top down without recursion, unbalanced splits of large trees would run out of stack
+    struct BuildTask
+    {
+        int32_t node;
+        uint32_t begin;
+        uint32_t end;
+    };
+    std::vector<BuildTask> tasks;
+    // parents come before their children
+    std::vector<int32_t> innerNodes;
+    innerNodes.reserve(leaves.size());
+
+    auto createNode = [&](uint32_t begin, uint32_t end, int32_t parent)
+    {
+        if (end - begin == 1)
+        {
+            nodes[leaves[begin]].parent = parent;
+            return leaves[begin];
+        }
+
+        int32_t node = allocateNode();
+        nodes[node].parent = parent;
+        tasks.push_back({node, begin, end});
+        innerNodes.push_back(node);
+        return node;
+    };
+
+    root = createNode(0, uint32_t(leaves.size()), NULL_NODE);
+    while (!tasks.empty())
+    {
+        auto task = tasks.back();
+        tasks.pop_back();
+
+        uint32_t middle = split(task.begin, task.end);
+        int32_t child1 = createNode(task.begin, middle, task.node);
+        int32_t child2 = createNode(middle, task.end, task.node);
+        nodes[task.node].child1 = child1;
+        nodes[task.node].child2 = child2;
+    }
+
+    for (auto it = innerNodes.rbegin(); it != innerNodes.rend(); it++)
+    {
+        auto &node = nodes[*it];
+        auto &child1 = nodes[node.child1];
+        auto &child2 = nodes[node.child2];
+        node.height = 1 + std::max(child1.height, child2.height);
+        node.boundsMin = glm::min(child1.boundsMin, child2.boundsMin);
+        node.boundsMax = glm::max(child1.boundsMax, child2.boundsMax);
+    }
+}
+
+void DynamicBVH::Clear()
+{
+    nodes.clear();
+    objectBounds.clear();
+    root = NULL_NODE;
+    freeList = NULL_NODE;
+    proxyCount = 0;
+}
+
+float DynamicBVH::GetAreaRatio()
+{
+    if (root == NULL_NODE)
+    {
+        return 0.0f;
+    }
+
+    float rootArea = Area(nodes[root].boundsMin, nodes[root].boundsMax);
+    float totalArea = 0.0f;
+    for (auto &node : nodes)
+    {
+        if (node.height > 0)
+        {
+            totalArea += Area(node.boundsMin, node.boundsMax);
+        }
+    }
+    return rootArea > 0.0f ? totalArea / rootArea : 0.0f;
+}
+
+void DynamicBVH::QueryFrustum(const Frustum &frustum, std::vector<uint32_t> &objects)
+{
+    objects.clear();
+    if (root == NULL_NODE)
+    {
+        return;
+    }
+
+    glm::vec3 absNormals[6];
+    for (int p = 0; p < 6; p++)
+    {
+        absNormals[p] = glm::abs(glm::vec3(frustum.planes[p]));
+    }
+
+    // planes a node is fully in front of are not tested below it
+    stack.clear();
+    stack.push_back({root, 0x3fu, 0.0f});
+    while (!stack.empty())
+    {
+        auto entry = stack.back();
+        stack.pop_back();
+
+        auto &node = nodes[entry.node];
+        bool leaf = node.height == 0;
+        auto &boundsMin = leaf ? objectBounds[entry.node].boundsMin : node.boundsMin;
+        auto &boundsMax = leaf ? objectBounds[entry.node].boundsMax : node.boundsMax;
+        glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+        glm::vec3 extent = (boundsMax - boundsMin) * 0.5f;
+
+        bool outside = false;
+        uint32_t planeMask = entry.planeMask;
+        for (int p = 0; p < 6 && !outside; p++)
+        {
+            if (!(planeMask & (1u << p)))
+            {
+                continue;
+            }
+
+            glm::vec3 normal = glm::vec3(frustum.planes[p]);
+            outside = glm::dot(normal, center) + glm::dot(absNormals[p], extent) + frustum.planes[p].w < 0.0f;
+            if (glm::dot(normal, center) - glm::dot(absNormals[p], extent) + frustum.planes[p].w >= 0.0f)
+            {
+                planeMask &= ~(1u << p);
+            }
+        }
+
+        if (outside)
+        {
+            continue;
+        }
+
+        if (leaf)
+        {
+            objects.push_back(node.object);
+            continue;
+        }
+        stack.push_back({node.child1, planeMask});
+        stack.push_back({node.child2, planeMask});
+    }
+}
+
+void DynamicBVH::QueryOverlap(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, std::vector<uint32_t> &objects)
+{
+    objects.clear();
+    if (root == NULL_NODE)
+    {
+        return;
+    }
+
+    stack.clear();
+    stack.push_back({root});
+    while (!stack.empty())
+    {
+        int32_t index = stack.back().node;
+        stack.pop_back();
+
+        auto &node = nodes[index];
+        bool leaf = node.height == 0;
+        auto &nodeMin = leaf ? objectBounds[index].boundsMin : node.boundsMin;
+        auto &nodeMax = leaf ? objectBounds[index].boundsMax : node.boundsMax;
+        if (glm::any(glm::greaterThan(nodeMin, boundsMax)) || glm::any(glm::lessThan(nodeMax, boundsMin)))
+        {
+            continue;
+        }
+
+        if (leaf)
+        {
+            objects.push_back(node.object);
+            continue;
+        }
+        stack.push_back({node.child1});
+        stack.push_back({node.child2});
+    }
+}
+
+void DynamicBVH::QuerySphere(const glm::vec3 &center, float radius, std::vector<uint32_t> &objects)
+{
+    objects.clear();
+    if (root == NULL_NODE)
+    {
+        return;
+    }
+
+    stack.clear();
+    stack.push_back({root});
+    while (!stack.empty())
+    {
+        int32_t index = stack.back().node;
+        stack.pop_back();
+
+        auto &node = nodes[index];
+        bool leaf = node.height == 0;
+        auto &nodeMin = leaf ? objectBounds[index].boundsMin : node.boundsMin;
+        auto &nodeMax = leaf ? objectBounds[index].boundsMax : node.boundsMax;
+        glm::vec3 offset = glm::clamp(center, nodeMin, nodeMax) - center;
+        if (glm::dot(offset, offset) > radius * radius)
+        {
+            continue;
+        }
+
+        if (leaf)
+        {
+            objects.push_back(node.object);
+            continue;
+        }
+        stack.push_back({node.child1});
+        stack.push_back({node.child2});
+    }
+}
+
+bool DynamicBVH::RayCast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, RayHit &hit)
+{
+    if (root == NULL_NODE)
+    {
+        return false;
+    }
+
+    glm::vec3 inverseDirection = 1.0f / direction;
+    float closest = maxDistance;
+    bool found = false;
+
+    // entry distance of a node into its box, leaves against the object box
+    auto intersect = [&](int32_t index, float &distance)
+    {
+        auto &node = nodes[index];
+        if (node.height == 0)
+        {
+            return IntersectRay(origin, inverseDirection, objectBounds[index].boundsMin, objectBounds[index].boundsMax, closest, distance);
+        }
+        return IntersectRay(origin, inverseDirection, node.boundsMin, node.boundsMax, closest, distance);
+    };
+
+    float rootDistance;
+    if (!intersect(root, rootDistance))
+    {
+        return false;
+    }
+
+    // nearer children are popped first
+    stack.clear();
+    stack.push_back({root, 0, rootDistance});
+    while (!stack.empty())
+    {
+        auto entry = stack.back();
+        stack.pop_back();
+
+        // a closer hit was found after the push
+        float distance = entry.distance;
+        if (distance > closest || (found && distance == closest))
+        {
+            continue;
+        }
+
+        auto &node = nodes[entry.node];
+        if (node.height == 0)
+        {
+            closest = distance;
+            hit = {entry.node, node.object, distance};
+            found = true;
+            continue;
+        }
+
+        float distance1, distance2;
+        int32_t child1 = node.child1;
+        int32_t child2 = node.child2;
+        bool hit1 = intersect(child1, distance1);
+        bool hit2 = intersect(child2, distance2);
+        if (hit1 && hit2)
+        {
+            if (distance1 < distance2)
+            {
+                std::swap(child1, child2);
+                std::swap(distance1, distance2);
+            }
+            stack.push_back({child1, 0, distance1});
+            stack.push_back({child2, 0, distance2});
+        }
+        else if (hit1)
+        {
+            stack.push_back({child1, 0, distance1});
+        }
+        else if (hit2)
+        {
+            stack.push_back({child2, 0, distance2});
+        }
+    }
+    return found;
+}
+
+void DynamicBVH::Validate()
+{
+    auto fail = [](const std::string &message)
+    {
+        throw std::runtime_error("dynamic bvh: " + message);
+    };
+
+    uint32_t freeCount = 0;
+    for (int32_t index = freeList; index != NULL_NODE; index = nodes[index].parent)
+    {
+        if (nodes[index].height != -1 || ++freeCount > nodes.size())
+        {
+            fail("broken free list");
+        }
+    }
+
+    if (root == NULL_NODE)
+    {
+        if (proxyCount || freeCount != nodes.size())
+        {
+            fail("empty tree with nodes in use");
+        }
+        return;
+    }
+    if (nodes[root].parent != NULL_NODE)
+    {
+        fail("root has a parent");
+    }
+
+    uint32_t reached = 0;
+    uint32_t leafCount = 0;
+    std::vector<int32_t> pending = {root};
+    while (!pending.empty())
+    {
+        int32_t index = pending.back();
+        pending.pop_back();
+        reached++;
+
+        auto &node = nodes[index];
+        if (node.height == 0)
+        {
+            leafCount++;
+            if (!Contains(node.boundsMin, node.boundsMax, objectBounds[index].boundsMin, objectBounds[index].boundsMax))
+            {
+                fail("object outside the fat box of proxy " + std::to_string(index));
+            }
+            continue;
+        }
+        if (node.height < 0)
+        {
+            fail("free node " + std::to_string(index) + " in the tree");
+        }
+
+        auto &child1 = nodes[node.child1];
+        auto &child2 = nodes[node.child2];
+        if (child1.parent != index || child2.parent != index)
+        {
+            fail("broken parent link below node " + std::to_string(index));
+        }
+        if (node.height != 1 + std::max(child1.height, child2.height))
+        {
+            fail("wrong height of node " + std::to_string(index));
+        }
+        if (!Contains(node.boundsMin, node.boundsMax, child1.boundsMin, child1.boundsMax) || !Contains(node.boundsMin, node.boundsMax, child2.boundsMin, child2.boundsMax))
+        {
+            fail("children outside the box of node " + std::to_string(index));
+        }
+        pending.push_back(node.child1);
+        pending.push_back(node.child2);
+    }
+
+    if (leafCount != proxyCount || reached + freeCount != nodes.size())
+    {
+        fail("node count mismatch");
+    }
+}
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <Core/IntrusivePtr.h>
+
+#include <Engine/Frustum.h>
+
+// dynamic aabb tree over scene objects, for frustum queries, picking and light assignment
+// leaves keep a fat box grown by the margin, moves within it do not touch the tree
+// inserts and removes keep the tree height balanced with rotations, Rebuild restores the sah quality
+// that incremental updates lose, call it every few hundred frames of heavy motion
+// proxies are node indices, they stay valid until removed, Rebuild included
+class DynamicBVH : public IntrusiveCounter<DynamicBVH>
+{
+public:
+    static constexpr int32_t NULL_NODE = -1;
+    static constexpr uint32_t BIN_COUNT = 16;
+
+    // margin added to every side of the inserted boxes
+    DynamicBVH(float margin = 0.1f) : margin(margin) {}
+
+    // object is returned by the queries, returns the proxy
+    int32_t Insert(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, uint32_t object);
+
+    void Remove(int32_t proxy);
+
+    // new box of the object, false if it still fits the fat box and the tree is unchanged
+    // the fat box is stretched by displacement, the expected motion until the next move
+    bool Move(int32_t proxy, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, const glm::vec3 &displacement = glm::vec3(0.0f));
+
+    // builds the inner nodes again top down with binned sah over the leaves
+    void Rebuild();
+
+    void Clear();
+
+    uint32_t GetObject(int32_t proxy)
+    {
+        return nodes[proxy].object;
+    }
+
+    uint32_t GetProxyCount()
+    {
+        return proxyCount;
+    }
+
+    // 0 for a single leaf or an empty tree
+    uint32_t GetHeight()
+    {
+        return root == NULL_NODE ? 0 : uint32_t(nodes[root].height);
+    }
+
+    // summed surface area of the inner nodes over the root's, lower traverses faster
+    float GetAreaRatio();
+
+    // objects whose box intersects the frustum, same test as Frustum::Intersects
+    void QueryFrustum(const Frustum &frustum, std::vector<uint32_t> &objects);
+
+    // objects whose box overlaps the box
+    void QueryOverlap(const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, std::vector<uint32_t> &objects);
+
+    // objects whose box overlaps the sphere, point light ranges
+    void QuerySphere(const glm::vec3 &center, float radius, std::vector<uint32_t> &objects);
+
+    struct RayHit
+    {
+        int32_t proxy;
+        uint32_t object;
+        // along direction, 0 if the ray starts inside the box
+        float distance;
+    };
+
+    // closest object box hit in [0, maxDistance], distances are in units of direction
+    bool RayCast(const glm::vec3 &origin, const glm::vec3 &direction, float maxDistance, RayHit &hit);
+
+    // throw if the links, boxes or heights of the tree are inconsistent
+    void Validate();
+
+private:
+    // leaves have height 0 and no children, free nodes have height -1 and parent is the next free node
+    struct Node
+    {
+        glm::vec3 boundsMin;
+        int32_t parent;
+        glm::vec3 boundsMax;
+        int32_t child1;
+        int32_t child2;
+        int32_t height;
+        uint32_t object;
+    };
+
+    // box of the object itself, by proxy
+    struct ObjectBounds
+    {
+        glm::vec3 boundsMin;
+        glm::vec3 boundsMax;
+    };
+
+    float margin;
+
+    std::vector<Node> nodes;
+    std::vector<ObjectBounds> objectBounds;
+    int32_t root = NULL_NODE;
+    int32_t freeList = NULL_NODE;
+    uint32_t proxyCount = 0;
+
+    // planeMask: frustum planes still to test below node, distance: ray entry distance into node
+    struct StackEntry
+    {
+        int32_t node;
+        uint32_t planeMask;
+        float distance;
+    };
+
+    // query stack, kept to not allocate every query
+    std::vector<StackEntry> stack;
+
+    int32_t allocateNode();
+    void freeNode(int32_t node);
+
+    void insertLeaf(int32_t leaf);
+    void removeLeaf(int32_t leaf);
+    // refits and rebalances from node to the root
+    void refitUp(int32_t node);
+    int32_t balance(int32_t node);
+};
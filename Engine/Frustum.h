@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// inward planes of a zero to one depth projection, xyz normalized
+// a point p is inside when dot(plane.xyz, p) + plane.w >= 0 for every plane
+struct Frustum
+{
+    // left, right, bottom, top, near, far
+    glm::vec4 planes[6];
+
+    static Frustum FromViewProjection(const glm::mat4 &viewProjection)
+    {
+        auto row = [&](int i)
+        {
+            return glm::vec4(viewProjection[0][i], viewProjection[1][i], viewProjection[2][i], viewProjection[3][i]);
+        };
+
+        Frustum frustum = {};
+        frustum.planes[0] = row(3) + row(0);
+        frustum.planes[1] = row(3) - row(0);
+        frustum.planes[2] = row(3) + row(1);
+        frustum.planes[3] = row(3) - row(1);
+        frustum.planes[4] = row(2);
+        frustum.planes[5] = row(3) - row(2);
+
+        for (auto &plane : frustum.planes)
+        {
+            plane /= glm::length(glm::vec3(plane));
+        }
+        return frustum;
+    }
+
+    // box given by its center and half extent, false only if it is fully behind one of the planes
+    // conservative near the frustum corners, the same test as cull.comp
+    bool Intersects(const glm::vec3 &center, const glm::vec3 &extent) const
+    {
+        for (auto &plane : planes)
+        {
+            if (glm::dot(glm::vec3(plane), center) + glm::dot(glm::abs(glm::vec3(plane)), extent) + plane.w < 0.0f)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+};
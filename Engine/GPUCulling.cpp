@@ -0,0 +1,391 @@
+#include <Engine/GPUCulling.h>
+#include <Engine/ComputeGraph.h>
+#include <Engine/Frustum.h>
+#include <Engine/PixelEngine.h>
+#include <Engine/Renderer.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+
+#include <FrameGraph/Graph.h>
+
+#include <RHI/RHIRuntime.h>
+
+#include <json_struct/json_struct.h>
+#include <spdlog/spdlog.h>
+
+// Params of culling.glsl, std140
+struct CullingParams
+{
+    glm::mat4 viewProjection;
+    glm::mat4 previousViewProjection;
+    glm::vec4 planes[6];
+    uint32_t drawCount;
+    uint32_t hizWidth;
+    uint32_t hizHeight;
+    uint32_t occlusion;
+};
+
+static constexpr const char *RESET_SUBPASS = "cull_reset";
+static constexpr const char *CULL_SUBPASS = "cull";
+static constexpr const char *DRAW_SUBPASS = "cull_draw";
+static constexpr const char *HIZ_COPY_SUBPASS = "hiz_copy";
+static constexpr const char *HIZ_REDUCE_SUBPASS = "hiz_reduce";
+
+// binding of ::depth in hiz_copy.frag
+static constexpr uint32_t DEPTH_BINDING = 5;
+
+// the records follow the counters
+static constexpr uint64_t COMMANDS_OFFSET = sizeof(GPUCulling::Counters);
+static constexpr uint32_t COMMAND_SIZE = 5 * sizeof(uint32_t);
+
+static uint32_t PyramidSize(uint32_t width, uint32_t height)
+{
+    uint32_t size = 0;
+    for (uint32_t level = 0; level < GPUCulling::HIZ_LEVELS; level++)
+    {
+        size += std::max(width >> level, 1u) * std::max(height >> level, 1u);
+    }
+    return size;
+}
+
+GPUCulling::GPUCulling(PixelEngine *engine, GPUCullingConfig config) : engine(engine), config(config)
+{
+    if (!config.hizWidth || !config.hizHeight || config.hizWidth % HIZ_TILE || config.hizHeight % HIZ_TILE)
+    {
+        throw std::runtime_error("gpu culling: depth pyramid size must be a multiple of " + std::to_string(HIZ_TILE));
+    }
+
+    // cull draws reach the vertex shader through the firstInstance of the indirect records
+    auto runtimeInfo = engine->GetRHIRuntime()->GetRuntimeInfo();
+    if (!config.cpuCulling && !runtimeInfo.drawIndirectFirstInstance)
+    {
+        spdlog::warn("gpu culling: drawIndirectFirstInstance is not supported, culling on the cpu");
+        this->config.cpuCulling = true;
+    }
+
+    // hiz_copy folds the depth into the pyramid with fragment shader atomics
+    if (this->config.occlusion && !runtimeInfo.fragmentStoresAndAtomics)
+    {
+        spdlog::warn("gpu culling: fragmentStoresAndAtomics is not supported, occlusion culling is disabled");
+        this->config.occlusion = false;
+    }
+
+    // there is no depth pyramid without the compute passes
+    if (this->config.cpuCulling)
+    {
+        this->config.occlusion = false;
+    }
+
+    name = ComputeGraph::UniqueName("GPUCulling");
+
+    auto &rhiRuntime = engine->GetRHIRuntime();
+    params = rhiRuntime->CreateDynamicBuffer(sizeof(CullingParams));
+    memset(params->Map(), 0, sizeof(CullingParams));
+
+    buildRenderGroup();
+}
+
+uint32_t GPUCulling::AddMesh(const GLTFModel &model)
+{
+    meshes.push_back({
+        .firstVertex = uint32_t(vertices.size()),
+        .firstIndex = uint32_t(indices.size()),
+        .primitives = model.primitives});
+    vertices.insert(vertices.end(), model.vertexBuffer.begin(), model.vertexBuffer.end());
+    indices.insert(indices.end(), model.indexBuffer.begin(), model.indexBuffer.end());
+    return uint32_t(meshes.size() - 1);
+}
+
+uint32_t GPUCulling::AddDraw(uint32_t mesh, const glm::mat4 &model)
+{
+    if (!states.empty())
+    {
+        throw std::runtime_error("gpu culling: draws added after AddTo");
+    }
+    if (mesh >= meshes.size())
+    {
+        throw std::runtime_error("gpu culling: no mesh " + std::to_string(mesh));
+    }
+
+    auto first = uint32_t(draws.size());
+    // model indices are relative to the first vertex of the model
+    for (auto &primitive : meshes[mesh].primitives)
+    {
+        draws.push_back({
+            .model = model,
+            .boundsMin = glm::vec4(primitive.boundsMin, 1.0f),
+            .boundsMax = glm::vec4(primitive.boundsMax, 1.0f),
+            .indexCount = primitive.indexCount,
+            .firstIndex = meshes[mesh].firstIndex + primitive.firstIndex,
+            .vertexOffset = int32_t(meshes[mesh].firstVertex)});
+    }
+    return first;
+}
+
+// reset, cull, draw, then the pyramid of this frame for the next one, chained in that order
+void GPUCulling::buildRenderGroup()
+{
+    RenderSubPassResourceJson paramsResource = {};
+    paramsResource.name = "cullingParams";
+    paramsResource.type = "buffer";
+    paramsResource.dynamic = true;
+    paramsResource.binding = 0;
+
+    RenderSubPassResourceJson color = {};
+    color.name = "::color";
+    color.type = "attachment";
+    color.format = "FORMAT_B8G8R8A8_UNORM";
+    color.swapChain = true;
+    color.shared = true;
+    color.clear = config.clear;
+
+    RenderSubPassResourceJson depth = {};
+    depth.name = "::depth";
+    depth.type = "attachment";
+    depth.format = "FORMAT_D16_UNORM";
+    depth.depthStencil = true;
+    depth.shared = true;
+    depth.clear = true;
+
+    RenderPassJson json = {};
+    json.name = name;
+
+    auto addCompute = [&](const std::string &subpassName)
+    {
+        RenderSubPassJson subpass = {};
+        subpass.name = subpassName;
+        subpass.type = "compute";
+        subpass.shaders.compute = subpassName + ".comp.spv";
+        subpass.inputs.push_back(paramsResource);
+        if (!json.subpasses.empty())
+        {
+            subpass.inputs.push_back(ComputeGraph::ChainResource(json.subpasses.back().name));
+        }
+        subpass.outputs.push_back(ComputeGraph::ChainResource(subpass.name));
+        json.subpasses.push_back(subpass);
+    };
+
+    if (!config.cpuCulling)
+    {
+        addCompute(RESET_SUBPASS);
+        addCompute(CULL_SUBPASS);
+    }
+
+    RenderSubPassJson draw = {};
+    draw.name = DRAW_SUBPASS;
+    draw.type = "graphic";
+    draw.dependencies = config.dependencies;
+    draw.shaders.vertex = config.vertexShader;
+    draw.shaders.fragment = config.fragmentShader;
+    draw.inputs = {paramsResource};
+    if (!config.cpuCulling)
+    {
+        draw.inputs.push_back(ComputeGraph::ChainResource(CULL_SUBPASS));
+    }
+    draw.outputs = {color, depth, ComputeGraph::ChainResource(DRAW_SUBPASS)};
+    json.subpasses.push_back(draw);
+
+    if (config.occlusion)
+    {
+        auto depthInput = depth;
+        depthInput.clear = false;
+        depthInput.binding = DEPTH_BINDING;
+
+        RenderSubPassJson copy = {};
+        copy.name = HIZ_COPY_SUBPASS;
+        copy.type = "graphic";
+        copy.shaders.vertex = std::string(HIZ_COPY_SUBPASS) + ".vert.spv";
+        copy.shaders.fragment = std::string(HIZ_COPY_SUBPASS) + ".frag.spv";
+        copy.inputs = {paramsResource, depthInput, ComputeGraph::ChainResource(DRAW_SUBPASS)};
+        copy.outputs = {ComputeGraph::ChainResource(HIZ_COPY_SUBPASS)};
+        json.subpasses.push_back(copy);
+
+        addCompute(HIZ_REDUCE_SUBPASS);
+    }
+
+    renderGroup = engine->RegisterRenderGroup(Graph::ParseRenderPassJsonRawString(JS::serializeStruct(json)));
+    if (!renderGroup)
+    {
+        throw std::runtime_error("gpu culling: failed to register " + name);
+    }
+}
+
+void GPUCulling::buildStates()
+{
+    auto &rhiRuntime = engine->GetRHIRuntime();
+    auto auxiliaryExecutor = engine->GetAuxiliaryExecutor();
+    auto drawCount = uint32_t(draws.size());
+
+    auto createStorage = [&](uint32_t usage, size_t size)
+    {
+        return rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_STORAGE_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT | usage, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, size);
+    };
+
+    vertexBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_VERTEX_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertices.size() * sizeof(GLTFVertex));
+    auxiliaryExecutor->TransferResource(vertexBuffer, vertices.data(), vertices.size() * sizeof(GLTFVertex));
+    indexBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_INDEX_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indices.size() * sizeof(uint32_t));
+    auxiliaryExecutor->TransferResource(indexBuffer, indices.data(), indices.size() * sizeof(uint32_t));
+
+    drawBuffer = createStorage(0, draws.size() * sizeof(Draw));
+    auxiliaryExecutor->TransferResource(drawBuffer, draws.data(), draws.size() * sizeof(Draw));
+
+    // cull_reset clears the records every frame
+    commands = createStorage(Buffer::BUFFER_USAGE_INDIRECT_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_SRC_BIT, COMMANDS_OFFSET + size_t(drawCount) * COMMAND_SIZE);
+
+    // far everywhere until the first frame is drawn
+    std::vector<float> pyramidDepths(PyramidSize(config.hizWidth, config.hizHeight), 1.0f);
+    pyramid = createStorage(0, pyramidDepths.size() * sizeof(float));
+    auxiliaryExecutor->TransferResource(pyramid, pyramidDepths.data(), pyramidDepths.size() * sizeof(float));
+
+    std::vector<uint32_t> hizBits(size_t(config.hizWidth) * config.hizHeight, 0u);
+    hizDepth = createStorage(0, hizBits.size() * sizeof(uint32_t));
+    auxiliaryExecutor->TransferResource(hizDepth, hizBits.data(), hizBits.size() * sizeof(uint32_t));
+
+    auto bindAll = [&](IntrusivePtr<ResourceBindingState> state)
+    {
+        state->Bind(0, 0, params);
+        state->Bind(0, 1, drawBuffer);
+        state->Bind(0, 2, commands);
+        state->Bind(0, 3, pyramid);
+        state->Bind(0, 4, hizDepth);
+    };
+
+    auto addCompute = [&](const char *subpassName, ResourceBindingState::DispatchOP dispatch)
+    {
+        auto pipeline = renderGroup->CreatePipeline(subpassName, ComputePipelineStates{});
+        auto state = rhiRuntime->CreateResourceBindingState(pipeline);
+        bindAll(state);
+        state->BindDispatchOp({dispatch});
+        state->name = subpassName;
+        states.push_back(state);
+    };
+
+    // one invocation per draw
+    auto perDraw = ResourceBindingState::DispatchOP{
+        .type = ResourceBindingState::DispatchOP::RESOURCE_SIZE,
+        .resource = drawBuffer,
+        .elementSize = sizeof(Draw)};
+    if (!config.cpuCulling)
+    {
+        addCompute(RESET_SUBPASS, perDraw);
+        addCompute(CULL_SUBPASS, perDraw);
+    }
+
+    PipelineStates drawStates = {
+        .inputAssembleState = {.type = InputAssembleState::Type::TRIANGLE_LIST},
+        .rasterizationState = {.polygonMode = RasterizationState::PolygonModeType::FILL, .cullMode = RasterizationState::CullModeType::NONE, .frontFace = RasterizationState::FrontFaceType::COUNTER_CLOCKWISE, .lineWidth = 1.0f},
+        .depthStencilState = {.depthTestEnable = true, .depthWriteEnable = true}};
+
+    auto pipeline = renderGroup->CreatePipeline(DRAW_SUBPASS, drawStates);
+    drawState = rhiRuntime->CreateResourceBindingState(pipeline);
+    bindAll(drawState);
+    drawState->BindVertexBuffer(vertexBuffer);
+    drawState->BindIndexBuffer(indexBuffer, ResourceBindingState::INDEX_TYPE_UINT32);
+    if (config.cpuCulling)
+    {
+        // DrawOPs are bound by Update
+        cpuCulling = new CPUCulling();
+        for (auto &draw : draws)
+        {
+            cpuCulling->Add(glm::vec3(draw.boundsMin), glm::vec3(draw.boundsMax), draw.model);
+        }
+    }
+    else
+    {
+        // written by cull, the count is the visible count
+        drawState->BindIndirectDrawOp({ResourceBindingState::IndirectDrawOP{
+            .resource = commands,
+            .offset = COMMANDS_OFFSET,
+            .drawCount = drawCount,
+            .stride = COMMAND_SIZE,
+            .countResource = commands,
+            .countOffset = offsetof(Counters, visibleCount)}});
+    }
+    drawState->name = DRAW_SUBPASS;
+    states.push_back(drawState);
+
+    if (config.occlusion)
+    {
+        PipelineStates copyStates = {
+            .inputAssembleState = {.type = InputAssembleState::Type::TRIANGLE_LIST},
+            .rasterizationState = {.polygonMode = RasterizationState::PolygonModeType::FILL, .cullMode = RasterizationState::CullModeType::NONE, .frontFace = RasterizationState::FrontFaceType::COUNTER_CLOCKWISE, .lineWidth = 1.0f},
+            .depthStencilState = {.depthTestEnable = false, .depthWriteEnable = false}};
+
+        auto copyPipeline = renderGroup->CreatePipeline(HIZ_COPY_SUBPASS, copyStates);
+        auto copyState = rhiRuntime->CreateResourceBindingState(copyPipeline);
+        // ::depth is bound by the group
+        bindAll(copyState);
+        copyState->BindDrawOp({ResourceBindingState::DrawOP{.vertexCount = 3, .instanceCount = 1}});
+        copyState->name = HIZ_COPY_SUBPASS;
+        states.push_back(copyState);
+
+        // one workgroup per tile of level 0
+        addCompute(HIZ_REDUCE_SUBPASS, {.type = ResourceBindingState::DispatchOP::DIRECT, .groupCount = {config.hizWidth / HIZ_TILE, config.hizHeight / HIZ_TILE, 1}});
+    }
+}
+
+void GPUCulling::AddTo(IntrusivePtr<Renderer> renderer)
+{
+    if (draws.empty())
+    {
+        throw std::runtime_error("gpu culling: nothing to draw");
+    }
+
+    if (states.empty())
+    {
+        buildStates();
+        spdlog::info("gpu culling {}: {} draws of {} meshes, {} vertices", name, draws.size(), meshes.size(), vertices.size());
+    }
+
+    for (auto &state : states)
+    {
+        renderer->AddDrawState(state);
+    }
+}
+
+void GPUCulling::Update(const glm::mat4 &view, const glm::mat4 &projection)
+{
+    auto viewProjection = projection * view;
+    if (!hasPreviousFrame)
+    {
+        previousViewProjection = viewProjection;
+        hasPreviousFrame = true;
+    }
+
+    CullingParams cullingParams = {
+        .viewProjection = viewProjection,
+        .previousViewProjection = previousViewProjection,
+        .drawCount = uint32_t(draws.size()),
+        .hizWidth = config.hizWidth,
+        .hizHeight = config.hizHeight,
+        .occlusion = config.occlusion ? 1u : 0u};
+    auto frustum = Frustum::FromViewProjection(viewProjection);
+    std::copy(std::begin(frustum.planes), std::end(frustum.planes), cullingParams.planes);
+    memcpy(params->Map(), &cullingParams, sizeof(cullingParams));
+
+    if (cpuCulling)
+    {
+        cpuCulling->Cull(frustum, visibleDraws);
+
+        // the draw index reaches culled_mesh.vert as gl_InstanceIndex
+        std::vector<ResourceBindingState::DrawOP> drawOps;
+        drawOps.reserve(visibleDraws.size());
+        for (auto index : visibleDraws)
+        {
+            auto &draw = draws[index];
+            drawOps.push_back({
+                .indexCount = draw.indexCount,
+                .instanceCount = 1,
+                .firstIndex = draw.firstIndex,
+                .vertexOffset = draw.vertexOffset,
+                .firstInstance = index});
+        }
+        drawState->BindDrawOp(drawOps);
+    }
+
+    // the pyramid the next frame reads is built from this frame
+    previousViewProjection = viewProjection;
+}
@@ -0,0 +1,171 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <Core/IntrusivePtr.h>
+
+#include <Engine/CPUCulling.h>
+
+#include <IO/GLTFReader.h>
+
+#include <RHI/Buffer.h>
+#include <RHI/DynamicBuffer.h>
+#include <RHI/RenderGroup.h>
+#include <RHI/ResourceBindingState.h>
+
+class PixelEngine;
+class Renderer;
+
+struct GPUCullingConfig
+{
+    // test the draws against the depth pyramid of the previous frame, the frustum only otherwise
+    // off on devices without fragmentStoresAndAtomics
+    bool occlusion = true;
+    // cull on the cpu with CPUCulling and draw the visible draws directly, for scenes too small for the compute passes,
+    // the frustum only, forced on devices without drawIndirectFirstInstance
+    bool cpuCulling = false;
+    // level 0 of the depth pyramid, multiples of GPUCulling::HIZ_TILE
+    uint32_t hizWidth = 512;
+    uint32_t hizHeight = 256;
+
+    // draw the survivors with, bound like culled_mesh.vert
+    std::string vertexShader = "culled_mesh.vert.spv";
+    std::string fragmentShader = "culled_mesh.frag.spv";
+
+    // clear ::color before drawing, false to draw over a group that draws before
+    bool clear = true;
+    // subpasses the draw subpass waits for, RenderSubPassJson::dependencies
+    std::vector<std::string> dependencies;
+};
+
+// static meshes drawn from gpu culled indirect draws, one draw per primitive
+// cull_reset and cull compute subpasses test every draw box against the frustum and the max depth pyramid
+// built from the previous frame's ::depth, survivors are compacted into one indirect draw of the merged geometry
+// hiz_copy folds ::depth into level 0 after drawing and hiz_reduce builds the other levels for the next frame
+// objects appearing from behind an occluder are drawn one frame late
+// with cpuCulling the group is the draw subpass alone, bound with one DrawOP per visible draw every Update
+// the draw pipeline reads the draw index from firstInstance, kernels are read from Engine/Shaders compiled into Shaders/
+class GPUCulling : public IntrusiveCounter<GPUCulling>
+{
+public:
+    static constexpr uint32_t GROUP_SIZE = 64;
+    // level 0 texels reduced by one hiz_reduce workgroup, HIZ_TILE of culling.glsl
+    static constexpr uint32_t HIZ_TILE = 32;
+    static constexpr uint32_t HIZ_LEVELS = 6;
+
+    // head of the command buffer, read it back from GetCounterBuffer()
+    struct Counters
+    {
+        uint32_t visibleCount;
+        uint32_t frustumCulled;
+        uint32_t occlusionCulled;
+        uint32_t padding;
+    };
+
+    // throw if the pyramid size is not a multiple of HIZ_TILE
+    GPUCulling(PixelEngine *engine, GPUCullingConfig config = {});
+
+    // vertices and indices are appended to the merged geometry, returns the mesh index
+    uint32_t AddMesh(const GLTFModel &model);
+    // one draw per primitive of the mesh, returns the index of the first one
+    // throw once the draws are added to a renderer
+    uint32_t AddDraw(uint32_t mesh, const glm::mat4 &model);
+
+    // uploads the geometry and the draws, throw if there is nothing to draw
+    void AddTo(IntrusivePtr<Renderer> renderer);
+
+    void Update(const glm::mat4 &view, const glm::mat4 &projection);
+
+    uint32_t GetDrawCount()
+    {
+        return uint32_t(draws.size());
+    }
+
+    // Counters then the compacted VkDrawIndexedIndirectCommand records of the last frame
+    IntrusivePtr<Buffer> GetCounterBuffer()
+    {
+        return commands;
+    }
+
+    IntrusivePtr<RenderGroup> GetRenderGroup()
+    {
+        return renderGroup;
+    }
+
+    // the config in use, occlusion and cpuCulling follow what the device supports
+    const GPUCullingConfig &GetConfig()
+    {
+        return config;
+    }
+
+    // render group name, see ComputeGraph::UniqueName
+    const std::string &GetName()
+    {
+        return name;
+    }
+
+    // Draw of culling.glsl, std430
+    struct Draw
+    {
+        glm::mat4 model;
+        glm::vec4 boundsMin;
+        glm::vec4 boundsMax;
+        uint32_t indexCount;
+        uint32_t firstIndex;
+        int32_t vertexOffset;
+        uint32_t padding;
+    };
+
+    const std::vector<Draw> &GetDraws()
+    {
+        return draws;
+    }
+
+    // draws drawn by the last Update, cpuCulling only
+    const std::vector<uint32_t> &GetVisibleDraws()
+    {
+        return visibleDraws;
+    }
+
+private:
+    struct Mesh
+    {
+        uint32_t firstVertex;
+        uint32_t firstIndex;
+        std::vector<GLTFModelPrimitive> primitives;
+    };
+
+    PixelEngine *engine;
+    GPUCullingConfig config;
+    std::string name;
+
+    std::vector<GLTFVertex> vertices;
+    std::vector<uint32_t> indices;
+    std::vector<Mesh> meshes;
+    std::vector<Draw> draws;
+
+    IntrusivePtr<RenderGroup> renderGroup;
+    std::vector<IntrusivePtr<ResourceBindingState>> states;
+    IntrusivePtr<ResourceBindingState> drawState;
+
+    IntrusivePtr<CPUCulling> cpuCulling;
+    std::vector<uint32_t> visibleDraws;
+
+    IntrusivePtr<DynamicBuffer> params;
+    IntrusivePtr<Buffer> vertexBuffer;
+    IntrusivePtr<Buffer> indexBuffer;
+    IntrusivePtr<Buffer> drawBuffer;
+    IntrusivePtr<Buffer> commands;
+    IntrusivePtr<Buffer> pyramid;
+    IntrusivePtr<Buffer> hizDepth;
+
+    // of the frame the pyramid read by the next cull is built from
+    glm::mat4 previousViewProjection = glm::mat4(1.0f);
+    bool hasPreviousFrame = false;
+
+    void buildRenderGroup();
+    void buildStates();
+};
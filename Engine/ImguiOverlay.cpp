@@ -1,9 +1,13 @@
 #include <Engine/ImguiOverlay.h>
 
+#include <fstream>
+
+#include <Core/Trace.h>
+
 #include <imgui.h>
 #include <imgui_internal.h>
 
-ImguiOverlay::ImguiOverlay(PixelEngine *engine) : engine(engine)
+ImguiOverlay::ImguiOverlay(PixelEngine *engine, ImguiOverlayConfig config) : engine(engine), config(config)
 {
     imguiContext = ImGui::CreateContext();
 }
@@ -21,11 +25,140 @@ void ImguiOverlay::ImGUINewFrame()
 
     ImGui::ShowDemoWindow();
 
+    if (config.memoryStatistics)
+    {
+        MemoryStatisticsWindow();
+    }
+
+    GPUProfilerWindow();
+
     ImGui::Render();
 
     ImGui::EndFrame();
 }
 
+void ImguiOverlay::MemoryStatisticsWindow()
+{
+    ImGui::Begin("Memory");
+
+    auto now = std::chrono::steady_clock::now();
+    bool refresh = ImGui::Button("Refresh") || !memoryStatisticsValid ||
+                   std::chrono::duration<float>(now - memoryStatisticsTime).count() >= config.memoryStatisticsInterval;
+    if (refresh)
+    {
+        memoryStatistics = engine->GetRHIRuntime()->GetMemoryStatistics();
+        memoryStatisticsTime = now;
+        memoryStatisticsValid = true;
+    }
+
+    auto &statistics = memoryStatistics;
+    auto toMB = [](uint64_t bytes)
+    { return bytes / (1024.0f * 1024.0f); };
+
+    for (auto &heap : statistics.heaps)
+    {
+        ImGui::Text("heap %u%s: %.1f / %.1f MB", heap.index, heap.deviceLocal ? " (device local)" : "", toMB(heap.usage), toMB(heap.budget));
+        ImGui::ProgressBar(heap.budget ? float(heap.usage) / float(heap.budget) : 0.0f);
+        ImGui::Text("%u blocks %.1f MB, %u allocations %.1f MB", heap.blockCount, toMB(heap.blockBytes), heap.allocationCount, toMB(heap.allocationBytes));
+    }
+
+    ImGui::Separator();
+
+    for (auto &category : statistics.categories)
+    {
+        ImGui::Text("%-10s %6llu %10.2f MB", category.name.c_str(), (unsigned long long)category.allocationCount, toMB(category.allocationBytes));
+    }
+
+    ImGui::Separator();
+
+    ImGui::Text("fragmentation %.2f, %u free ranges", statistics.fragmentation, statistics.unusedRangeCount);
+
+    ImGui::SameLine();
+    if (ImGui::Button("Dump"))
+    {
+        std::ofstream(config.memoryStatisticsDump) << statistics.ToJson();
+    }
+
+    ImGui::End();
+}
+
+void ImguiOverlay::GPUProfilerWindow()
+{
+    auto profiler = engine->GetRHIRuntime()->GetGPUProfiler();
+
+    ImGui::Begin("GPU Profiler");
+
+    bool tracing = Trace::IsEnabled();
+    if (ImGui::Checkbox("Trace", &tracing))
+    {
+        Trace::SetEnabled(tracing);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Write trace.json"))
+    {
+        Trace::WriteChromeTrace("trace.json");
+    }
+
+    auto captureRecorder = engine->GetRHIRuntime()->GetCaptureRecorder();
+    if (captureRecorder->IsEnabled())
+    {
+        ImGui::SameLine();
+        if (ImGui::Button("Capture 10 frames") && !captureRecorder->IsCapturing())
+        {
+            captureRecorder->Capture("capture.pxcap", 10);
+        }
+    }
+
+    if (!profiler->Supported())
+    {
+        ImGui::Text("timestamps are not supported on this device");
+        ImGui::End();
+        return;
+    }
+
+    bool enabled = profiler->IsEnabled();
+    if (ImGui::Checkbox("Enabled", &enabled))
+    {
+        profiler->SetEnabled(enabled);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Clear"))
+    {
+        profiler->ClearTimings();
+    }
+
+    ImGui::Separator();
+
+    if (ImGui::BeginTable("timings", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+    {
+        ImGui::TableSetupColumn("name");
+        ImGui::TableSetupColumn("last ms");
+        ImGui::TableSetupColumn("min ms");
+        ImGui::TableSetupColumn("avg ms");
+        ImGui::TableSetupColumn("max ms");
+        ImGui::TableHeadersRow();
+
+        for (auto &timing : profiler->GetTimings())
+        {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(timing.name.c_str());
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", timing.last);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", timing.min);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", timing.avg);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", timing.max);
+        }
+
+        ImGui::EndTable();
+    }
+
+    ImGui::End();
+}
+
 void ImguiOverlay::BuildPipeline()
 {
     auto imguiPass = Graph::ParseRenderPassJson("Shaders/imgui.json");
@@ -73,15 +206,11 @@ void ImguiOverlay::BuildDrawable()
     io.Fonts->GetTexDataAsRGBA32(&fontData, &texWidth, &texHeight);
     auto uploadSize = texWidth * texHeight * 4 * sizeof(char);
 
-    auto imguiFontHostBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, uploadSize);
-    memcpy(imguiFontHostBuffer->Map(), fontData, uploadSize);
-
     auto imguiFontTexture = rhiRuntime->CreateTexture(TextureFormat::FORMAT_R8G8B8A8_UNORM, Texture::Usage::IMAGE_USAGE_SAMPLED_BIT | Texture::Usage::IMAGE_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, {uint32_t(texWidth), uint32_t(texHeight), 1});
     auto imguiFontSampler = rhiRuntime->CreateSampler(imguiFontTexture);
     imguiDrawable->Bind(0, 0, imguiFontSampler);
 
-    engine->GetAuxiliaryExecutor()->TransferResource(imguiFontTexture, imguiFontHostBuffer);
-    imguiFontHostBuffer.reset();
+    engine->GetAuxiliaryExecutor()->TransferResource(imguiFontTexture, fontData, uploadSize);
 
     auto imguiCBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_UNIFORM_BUFFER_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_LOCAL_BIT, sizeof(ImguiPushConstant));
     auto pimguiCBuffer = (ImguiPushConstant *)imguiCBuffer->Map();
@@ -230,39 +359,18 @@ void ImguiOverlay::BuildDrawable()
         // create buffer if not exist
         if (!vertexBuffers || !indexBuffers)
         {
-            vertexBuffers = rhiRuntime->CreateMutableBuffer(Buffer::BUFFER_USAGE_VERTEX_BUFFER_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, vertexBufferSize);
+            vertexBuffers = rhiRuntime->CreateStreamingBuffer(Buffer::BUFFER_USAGE_VERTEX_BUFFER_BIT);
             imguiDrawable->BindVertexBuffer(vertexBuffers);
-            indexBuffers = rhiRuntime->CreateMutableBuffer(Buffer::BUFFER_USAGE_INDEX_BUFFER_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, indexBufferSize);
+            indexBuffers = rhiRuntime->CreateStreamingBuffer(Buffer::BUFFER_USAGE_INDEX_BUFFER_BIT);
             imguiDrawable->BindIndexBuffer(indexBuffers, ResourceBindingState::INDEX_TYPE_UINT16);
         }
 
-        auto mutableVertexBuffer = static_cast<MutableBuffer *>(vertexBuffers.get());
-        auto mutableIndexBuffer = static_cast<MutableBuffer *>(indexBuffers.get());
-
-        auto &vertexBuffer = mutableVertexBuffer->GetBuffer(inputs.currentImageIndex);
-        auto &indexBuffer = mutableIndexBuffer->GetBuffer(inputs.currentImageIndex);
-
-        // mutate buffer if change
-        if (vertexBuffers && indexBuffers)
-        {
-            auto b1 = vertexBuffer->Size() != imDrawData->TotalVtxCount;
-            if (b1)
-            {
-                auto vBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_VERTEX_BUFFER_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, vertexBufferSize);
-                mutableVertexBuffer->SetBuffer(inputs.currentImageIndex, vBuffer);
-            }
-
-            auto b2 = indexBuffer->Size() != imDrawData->TotalIdxCount;
-            if (b2)
-            {
-                auto iBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_INDEX_BUFFER_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, indexBufferSize);
-                mutableIndexBuffer->SetBuffer(inputs.currentImageIndex, iBuffer);
-            }
-        }
+        auto streamingVertexBuffer = static_cast<StreamingBuffer *>(vertexBuffers.get());
+        auto streamingIndexBuffer = static_cast<StreamingBuffer *>(indexBuffers.get());
 
-        // Upload data
-        ImDrawVert *vtxDst = (ImDrawVert *)vertexBuffer->Map();
-        ImDrawIdx *idxDst = (ImDrawIdx *)indexBuffer->Map();
+        // Upload data, buffers only grow when the high-water mark is exceeded
+        ImDrawVert *vtxDst = (ImDrawVert *)streamingVertexBuffer->Map(inputs.currentImageIndex, vertexBufferSize);
+        ImDrawIdx *idxDst = (ImDrawIdx *)streamingIndexBuffer->Map(inputs.currentImageIndex, indexBufferSize);
 
         for (int n = 0; n < imDrawData->CmdListsCount; n++)
         {
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <chrono>
+#include <string>
+
 #include <glm/glm.hpp>
 #include <spdlog/spdlog.h>
 
@@ -7,21 +10,37 @@
 
 #include <RHI/ResourceBindingState.h>
 #include <RHI/Texture.h>
-#include <RHI/MutableBuffer.h>
+#include <RHI/StreamingBuffer.h>
 #include <RHI/RHIRuntime.h>
 #include <RHI/RenderGroup.h>
 
+struct ImguiOverlayConfig
+{
+    // the memory window, it walks every vma block on refresh
+    bool memoryStatistics = false;
+    // seconds between refreshes of the memory window, the Refresh button refreshes at once
+    float memoryStatisticsInterval = 1.0f;
+    // written by the Dump button of the memory window
+    std::string memoryStatisticsDump = "memory_statistics.json";
+};
+
 class ImGuiContext;
 class ImguiOverlay : public IntrusiveCounter<ImguiOverlay>
 {
 public:
-    ImguiOverlay(PixelEngine *engine);
+    ImguiOverlay(PixelEngine *engine, ImguiOverlayConfig config = {});
     virtual ~ImguiOverlay();
 
     PixelEngine *engine;
 
     virtual void ImGUINewFrame();
 
+    // heap budgets and per category usage of device memory, shown if ImguiOverlayConfig::memoryStatistics
+    void MemoryStatisticsWindow();
+
+    // rolling gpu timings per render group and subpass
+    void GPUProfilerWindow();
+
     struct ImguiPushConstant
     {
         glm::vec2 scale;
@@ -39,6 +58,13 @@ public:
 protected:
     ImGuiContext *imguiContext;
 
+    ImguiOverlayConfig config;
+
+    // of the last refresh
+    MemoryStatistics memoryStatistics;
+    std::chrono::steady_clock::time_point memoryStatisticsTime;
+    bool memoryStatisticsValid = false;
+
     // ui event handler might recursively call ImGUINewFrame
     // call only frameEnd == true
     bool frameEnd = true;
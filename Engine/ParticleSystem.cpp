@@ -0,0 +1,242 @@
+#include <Engine/ParticleSystem.h>
+#include <Engine/ComputeGraph.h>
+#include <Engine/PixelEngine.h>
+#include <Engine/Renderer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <numeric>
+#include <stdexcept>
+
+#include <FrameGraph/Graph.h>
+
+#include <RHI/RHIRuntime.h>
+
+#include <json_struct/json_struct.h>
+#include <spdlog/spdlog.h>
+
+// Params of particles.glsl, std140
+struct ParticleParams
+{
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::vec4 cameraPosition;
+    glm::vec4 emitterPosition;
+    glm::vec4 emitterVelocity;
+    glm::vec4 gravity;
+    glm::vec4 startColor;
+    glm::vec4 endColor;
+    uint32_t emitCount;
+    uint32_t seed;
+    float lifetimeMin;
+    float lifetimeMax;
+    float size;
+    uint32_t padding[3];
+};
+
+// 32 bytes, Particle of particles.glsl
+static constexpr uint32_t PARTICLE_SIZE = 32;
+
+// compute subpasses in order, all bind the same buffers
+static const std::vector<std::string> kernels = {
+    "particle_begin",
+    "particle_emit",
+    "particle_simulate",
+    "particle_sort_scan",
+    "particle_sort_scatter"};
+
+static constexpr const char *RENDER_SUBPASS = "particle_render";
+
+// offsets of the indirect arguments in Counters
+static constexpr uint64_t EMIT_ARGS_OFFSET = offsetof(ParticleSystem::Counters, emitArgs);
+static constexpr uint64_t SIMULATE_ARGS_OFFSET = offsetof(ParticleSystem::Counters, simulateArgs);
+static constexpr uint64_t DRAW_ARGS_OFFSET = offsetof(ParticleSystem::Counters, drawArgs);
+
+ParticleSystem::ParticleSystem(PixelEngine *engine, ParticleSystemConfig config) : engine(engine), config(config)
+{
+    if (!config.capacity)
+    {
+        throw std::runtime_error("particle system: zero capacity");
+    }
+
+    name = ComputeGraph::UniqueName("Particles");
+
+    auto &rhiRuntime = engine->GetRHIRuntime();
+    auto createStorage = [&](size_t size)
+    {
+        return rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_STORAGE_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, size);
+    };
+
+    params = rhiRuntime->CreateDynamicBuffer(sizeof(ParticleParams));
+    memset(params->Map(), 0, sizeof(ParticleParams));
+
+    // all particles start dead
+    Counters initialCounters = {};
+    initialCounters.deadCount = config.capacity;
+    counters = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_STORAGE_BUFFER_BIT | Buffer::BUFFER_USAGE_INDIRECT_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT | Buffer::BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, sizeof(Counters));
+    engine->GetAuxiliaryExecutor()->TransferResource(counters, &initialCounters, sizeof(initialCounters));
+
+    std::vector<uint32_t> deadList(config.capacity);
+    std::iota(deadList.begin(), deadList.end(), 0u);
+
+    buffers = {
+        createStorage(size_t(config.capacity) * PARTICLE_SIZE),
+        createStorage(deadList.size() * sizeof(uint32_t)),
+        createStorage(size_t(config.capacity) * sizeof(uint32_t)),
+        createStorage(size_t(config.capacity) * sizeof(uint32_t)),
+        createStorage(size_t(config.capacity) * sizeof(uint32_t)),
+        createStorage(SORT_BUCKETS * sizeof(uint32_t))};
+    engine->GetAuxiliaryExecutor()->TransferResource(buffers[1], deadList.data(), deadList.size() * sizeof(uint32_t));
+
+    buildRenderGroup();
+    buildStates();
+
+    spdlog::info("particle system {}: capacity {}", name, config.capacity);
+}
+
+// kernels chained in order, then the draw
+void ParticleSystem::buildRenderGroup()
+{
+    RenderSubPassResourceJson paramsResource = {};
+    paramsResource.name = "particleParams";
+    paramsResource.type = "buffer";
+    paramsResource.dynamic = true;
+    paramsResource.binding = 0;
+
+    RenderPassJson json = {};
+    json.name = name;
+    for (auto &kernel : kernels)
+    {
+        RenderSubPassJson subpass = {};
+        subpass.name = kernel;
+        subpass.type = "compute";
+        subpass.shaders.compute = kernel + ".comp.spv";
+        subpass.inputs.push_back(paramsResource);
+        if (!json.subpasses.empty())
+        {
+            subpass.inputs.push_back(ComputeGraph::ChainResource(json.subpasses.back().name));
+        }
+        subpass.outputs.push_back(ComputeGraph::ChainResource(subpass.name));
+        json.subpasses.push_back(subpass);
+    }
+
+    RenderSubPassResourceJson color = {};
+    color.name = "::color";
+    color.type = "attachment";
+    color.format = "FORMAT_B8G8R8A8_UNORM";
+    color.swapChain = true;
+    color.shared = true;
+    color.clear = config.clear;
+
+    RenderSubPassJson render = {};
+    render.name = RENDER_SUBPASS;
+    render.type = "graphic";
+    render.dependencies = config.dependencies;
+    render.shaders.vertex = "particle.vert.spv";
+    render.shaders.fragment = "particle.frag.spv";
+    // reading the output of particle_begin too puts the vertex shader into its first barrier, so the
+    // next frame's emit and simulate, ordered after begin, wait for this frame's draw before writing
+    render.inputs = {paramsResource, ComputeGraph::ChainResource(kernels.front()), ComputeGraph::ChainResource(json.subpasses.back().name)};
+    render.outputs = {color};
+    json.subpasses.push_back(render);
+
+    renderGroup = engine->RegisterRenderGroup(Graph::ParseRenderPassJsonRawString(JS::serializeStruct(json)));
+    if (!renderGroup)
+    {
+        throw std::runtime_error("particle system: failed to register " + name);
+    }
+}
+
+void ParticleSystem::buildStates()
+{
+    auto &rhiRuntime = engine->GetRHIRuntime();
+
+    auto bindAll = [&](IntrusivePtr<ResourceBindingState> state)
+    {
+        state->Bind(0, 0, params);
+        state->Bind(0, 1, counters);
+        for (uint32_t i = 0; i < buffers.size(); i++)
+        {
+            state->Bind(0, 2 + i, buffers[i]);
+        }
+    };
+
+    // begin and scan are single workgroups, the others are sized by begin
+    std::vector<ResourceBindingState::DispatchOP> dispatches = {
+        {.type = ResourceBindingState::DispatchOP::DIRECT, .groupCount = {1, 1, 1}},
+        {.type = ResourceBindingState::DispatchOP::INDIRECT, .resource = counters, .offset = EMIT_ARGS_OFFSET},
+        {.type = ResourceBindingState::DispatchOP::INDIRECT, .resource = counters, .offset = SIMULATE_ARGS_OFFSET},
+        {.type = ResourceBindingState::DispatchOP::DIRECT, .groupCount = {1, 1, 1}},
+        {.type = ResourceBindingState::DispatchOP::INDIRECT, .resource = counters, .offset = SIMULATE_ARGS_OFFSET}};
+
+    for (size_t i = 0; i < kernels.size(); i++)
+    {
+        auto pipeline = renderGroup->CreatePipeline(kernels[i], ComputePipelineStates{});
+        auto state = rhiRuntime->CreateResourceBindingState(pipeline);
+        bindAll(state);
+        state->BindDispatchOp({dispatches[i]});
+        state->name = kernels[i];
+        states.push_back(state);
+    }
+
+    ColorBlendAttachmentState blendState = {
+        .blendEnable = true,
+        .srcColorBlendFactor = BLEND_FACTOR_SRC_ALPHA,
+        .dstColorBlendFactor = BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+        .colorBlendOp = BLEND_OP_ADD,
+        .srcAlphaBlendFactor = BLEND_FACTOR_ONE,
+        .dstAlphaBlendFactor = BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+        .alphaBlendOp = BLEND_OP_ADD,
+        .colorWriteMask = COLOR_COMPONENT_ALL_BIT};
+
+    // sorted back to front, no depth
+    PipelineStates renderStates = {
+        .inputAssembleState = {.type = InputAssembleState::Type::TRIANGLE_LIST},
+        .rasterizationState = {.polygonMode = RasterizationState::PolygonModeType::FILL, .cullMode = RasterizationState::CullModeType::NONE, .frontFace = RasterizationState::FrontFaceType::COUNTER_CLOCKWISE, .lineWidth = 1.0f},
+        .colorBlendAttachmentStates = {blendState},
+        .depthStencilState = {.depthTestEnable = false, .depthWriteEnable = false}};
+
+    auto pipeline = renderGroup->CreatePipeline(RENDER_SUBPASS, renderStates);
+    auto state = rhiRuntime->CreateResourceBindingState(pipeline);
+    bindAll(state);
+    // 6 vertices per alive particle, written by particle_sort_scan
+    state->BindIndirectDrawOp({ResourceBindingState::IndirectDrawOP{
+        .resource = counters,
+        .offset = DRAW_ARGS_OFFSET}});
+    state->name = RENDER_SUBPASS;
+    states.push_back(state);
+}
+
+void ParticleSystem::AddTo(IntrusivePtr<Renderer> renderer)
+{
+    for (auto &state : states)
+    {
+        renderer->AddDrawState(state);
+    }
+}
+
+void ParticleSystem::Update(float deltaTime, const glm::mat4 &view, const glm::mat4 &projection)
+{
+    // particle_begin clamps to the dead particles, the remainder only carries fractions
+    float emit = emitter.rate * deltaTime + emitRemainder;
+    uint32_t emitCount = std::min(uint32_t(std::max(emit, 0.0f)), config.capacity);
+    emitRemainder = std::clamp(emit - float(emitCount), 0.0f, 1.0f);
+
+    ParticleParams particleParams = {
+        .view = view,
+        .projection = projection,
+        .cameraPosition = glm::vec4(glm::vec3(glm::inverse(view)[3]), config.sortDistance),
+        .emitterPosition = glm::vec4(emitter.position, emitter.radius),
+        .emitterVelocity = glm::vec4(emitter.velocity, emitter.velocitySpread),
+        .gravity = glm::vec4(emitter.gravity, deltaTime),
+        .startColor = emitter.startColor,
+        .endColor = emitter.endColor,
+        .emitCount = emitCount,
+        .seed = frameCount++ * 0x9e3779b9u,
+        .lifetimeMin = emitter.lifetimeMin,
+        .lifetimeMax = std::max(emitter.lifetimeMin, emitter.lifetimeMax),
+        .size = emitter.size};
+    memcpy(params->Map(), &particleParams, sizeof(particleParams));
+}
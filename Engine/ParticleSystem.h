@@ -0,0 +1,131 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <Core/IntrusivePtr.h>
+
+#include <RHI/Buffer.h>
+#include <RHI/DynamicBuffer.h>
+#include <RHI/RenderGroup.h>
+#include <RHI/ResourceBindingState.h>
+
+class PixelEngine;
+class Renderer;
+
+// point emitter, particles spawn in a sphere around position
+struct ParticleEmitter
+{
+    glm::vec3 position = glm::vec3(0.0f);
+    float radius = 0.1f;
+
+    glm::vec3 velocity = glm::vec3(0.0f, 4.0f, 0.0f);
+    // random speed added in any direction
+    float velocitySpread = 1.5f;
+
+    glm::vec3 gravity = glm::vec3(0.0f, -9.8f, 0.0f);
+
+    // particles per second
+    float rate = 10000.0f;
+    // seconds
+    float lifetimeMin = 1.0f;
+    float lifetimeMax = 3.0f;
+
+    // half width of the quads in world units
+    float size = 0.02f;
+    // interpolated over the lifetime
+    glm::vec4 startColor = glm::vec4(1.0f, 0.8f, 0.3f, 1.0f);
+    glm::vec4 endColor = glm::vec4(0.8f, 0.1f, 0.05f, 0.0f);
+};
+
+struct ParticleSystemConfig
+{
+    uint32_t capacity = 65536;
+
+    // particles farther from the camera share the last depth bucket
+    float sortDistance = 100.0f;
+
+    // clear ::color before drawing, false to blend over a group that draws before
+    bool clear = true;
+    // subpasses the render subpass waits for, RenderSubPassJson::dependencies
+    std::vector<std::string> dependencies;
+};
+
+// particles emitted, simulated, sorted and drawn on the gpu, the cpu only writes the emitter every frame
+// one render group per system: begin, emit, simulate, sort_scan, sort_scatter compute subpasses then a graphic one
+// dispatch sizes and the draw are indirect, written by the passes from the live counts
+// kernels are read from Engine/Shaders compiled into Shaders/
+class ParticleSystem : public IntrusiveCounter<ParticleSystem>
+{
+public:
+    // depth buckets of the back to front counting sort, SORT_BUCKETS of particles.glsl
+    static constexpr uint32_t SORT_BUCKETS = 1024;
+    static constexpr uint32_t GROUP_SIZE = 64;
+
+    // Counters of particles.glsl, read it back from GetCounterBuffer()
+    struct Counters
+    {
+        uint32_t aliveCount;
+        uint32_t deadCount;
+        uint32_t emitCount;
+        uint32_t aliveBase;
+        uint32_t survivorCount;
+        uint32_t padding[3];
+        uint32_t emitArgs[4];
+        uint32_t simulateArgs[4];
+        uint32_t drawArgs[4];
+    };
+
+    // throw if capacity is 0
+    ParticleSystem(PixelEngine *engine, ParticleSystemConfig config = {});
+
+    ParticleEmitter emitter;
+
+    void AddTo(IntrusivePtr<Renderer> renderer);
+
+    // deltaTime in seconds, emission below one particle per frame is carried over to the next frames
+    // particles are sorted by their distance to the camera position of view
+    void Update(float deltaTime, const glm::mat4 &view, const glm::mat4 &projection);
+
+    uint32_t GetCapacity()
+    {
+        return config.capacity;
+    }
+
+    IntrusivePtr<Buffer> GetCounterBuffer()
+    {
+        return counters;
+    }
+
+    IntrusivePtr<RenderGroup> GetRenderGroup()
+    {
+        return renderGroup;
+    }
+
+    // render group name, see ComputeGraph::UniqueName
+    const std::string &GetName()
+    {
+        return name;
+    }
+
+private:
+    PixelEngine *engine;
+    ParticleSystemConfig config;
+    std::string name;
+
+    IntrusivePtr<RenderGroup> renderGroup;
+    std::vector<IntrusivePtr<ResourceBindingState>> states;
+
+    IntrusivePtr<DynamicBuffer> params;
+    IntrusivePtr<Buffer> counters;
+    // particles, deadList, aliveList, survivors, sortKeys, buckets
+    std::vector<IntrusivePtr<Buffer>> buffers;
+
+    float emitRemainder = 0.0f;
+    uint32_t frameCount = 0;
+
+    void buildRenderGroup();
+    void buildStates();
+};
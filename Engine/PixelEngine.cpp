@@ -3,12 +3,20 @@
 
 #include <spdlog/spdlog.h>
 
+#include <Core/Trace.h>
+
 #include <RHI/RenderGroup.h>
 #include <RHI/Pipeline.h>
 
-PixelEngine::PixelEngine()
+PixelEngine::PixelEngine(bool headless) : headless(headless)
+{
+    rhiRuntime = RuntimeEntry(RuntimeEntry::Type::VULKAN, headless).Create();
+    this->auxExecutor = rhiRuntime->CreateAuxiliaryExecutor();
+}
+
+PixelEngine::PixelEngine(RuntimeConfig config) : headless(config.headless)
 {
-    rhiRuntime = RuntimeEntry(RuntimeEntry::Type::VULKAN).Create();
+    rhiRuntime = RuntimeEntry(RuntimeEntry::Type::VULKAN, config).Create();
     this->auxExecutor = rhiRuntime->CreateAuxiliaryExecutor();
 }
 
@@ -63,6 +71,8 @@ void PixelEngine::Frame()
                 continue;
             }
 
+            TRACE_SCOPE("PixelEngine::Frame");
+
             // perform global update before renderer frame
             this->auxExecutor->Execute();
 
@@ -15,7 +15,9 @@ class Renderer;
 class PixelEngine : public IntrusiveCounter<PixelEngine>
 {
 public:
-    PixelEngine();
+    // headless engine renders into offscreen images, no window or presentation
+    PixelEngine(bool headless = false);
+    PixelEngine(RuntimeConfig config);
     ~PixelEngine();
     IntrusivePtr<RenderGroup> RegisterRenderGroup(IntrusivePtr<Graph> graph);
 
@@ -30,6 +32,11 @@ public:
         return auxExecutor;
     }
 
+    bool IsHeadless()
+    {
+        return headless;
+    }
+
 private:
     std::unordered_map<std::string, IntrusivePtr<RenderGroup>> renderGroupTemplates;
     IntrusivePtr<RHIRuntime> rhiRuntime;
@@ -38,4 +45,6 @@ private:
     std::vector<IntrusivePtr<Renderer>> renderers;
 
     IntrusivePtr<AuxiliaryExecutor> auxExecutor;
+
+    bool headless = false;
 };
\ No newline at end of file
@@ -5,9 +5,18 @@
 
 #include <spdlog/spdlog.h>
 
+#include <Core/Trace.h>
+
 Renderer::Renderer(PixelEngine *engine) : engine(engine)
 {
-    InitWindow();
+    if (engine->IsHeadless())
+    {
+        InitOffscreen();
+    }
+    else
+    {
+        InitWindow();
+    }
 }
 
 Renderer::~Renderer()
@@ -42,26 +51,27 @@ void Renderer::InitWindow()
     this->swapChain = engine->rhiRuntime->CreateSwapChain(this->window->hwnd, 1024, 768, nullptr);
 }
 
+void Renderer::InitOffscreen()
+{
+    this->swapChain = engine->rhiRuntime->CreateSwapChain(nullptr, 1024, 768, nullptr);
+}
+
 void Renderer::ReCreateSwapChain(uint32_t width, uint32_t height)
 {
     if (width == 0 || height == 0)
     {
         return;
     }
-    renderGroupExecutor->WaitIdle();
-
     Event event = {};
     event.type = Event::RESIZE;
     event.resizeEvent.width = width;
     event.resizeEvent.height = height;
     EventCallback(event);
 
+    // old swapchain is handed over as oldSwapchain, presentation goes on during the resize
     auto oldSwapChain = renderGroupExecutor->GetSwapChain();
     swapChain = engine->rhiRuntime->CreateSwapChain(this->window->hwnd, width, height, oldSwapChain);
-    renderGroupExecutor->Reset();
-    renderGroupExecutor->SetSwapChain(swapChain);
-    renderGroupExecutor->Prepare();
-    renderGroupExecutor->Acquire();
+    renderGroupExecutor->Resize(swapChain);
 }
 
 void Renderer::Build()
@@ -94,7 +104,10 @@ void Renderer::Update()
     // acquire image so that it's save to update resource at imageIndex
     renderGroupExecutor->Acquire();
 
-    window->Update();
+    if (window)
+    {
+        window->Update();
+    }
 
     // update call back may involved resource change
     Event event = {};
@@ -106,12 +119,12 @@ void Renderer::Update()
 
 bool Renderer::Stopped()
 {
-    return window->Stopped();
+    return stopped || (window && window->Stopped());
 }
 
 void Renderer::Frame()
 {
-    if (window->Stopped())
+    if (Stopped())
     {
         return;
     }
@@ -122,6 +135,8 @@ void Renderer::Frame()
 
 void Renderer::EventCallback(Event event)
 {
+    TRACE_SCOPE("Renderer::EventCallback");
+
     this->ioState.Update(event);
     UpdateInput updateInput = {.event = event,
                                .deltaTime = deltaTime,
@@ -134,10 +149,7 @@ void Renderer::EventCallback(Event event)
         groupCallbacks.insert(groupCallbacks.end(), drawState->updateCallbacks.begin(), drawState->updateCallbacks.end());
     }
 
-    for (auto cb : updateCallbacks)
-    {
-        groupCallbacks.insert(groupCallbacks.end(), updateCallbacks.begin(), updateCallbacks.end());
-    }
+    groupCallbacks.insert(groupCallbacks.end(), updateCallbacks.begin(), updateCallbacks.end());
 
     std::sort(groupCallbacks.begin(), groupCallbacks.end(), [](UpdateCallback &left, UpdateCallback &right)
               { return left.priority > right.priority; });
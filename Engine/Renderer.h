@@ -36,6 +36,17 @@ public:
 
     bool Stopped();
 
+    // stop rendering loop, the only way to end a headless renderer
+    void Stop()
+    {
+        stopped = true;
+    }
+
+    IntrusivePtr<SwapChain> GetSwapChain()
+    {
+        return swapChain;
+    }
+
     void RegisterUpdateCallback(UpdateCallback callback)
     {
         updateCallbacks.push_back(callback);
@@ -56,7 +67,10 @@ private:
 
     std::vector<UpdateCallback> updateCallbacks;
 
+    bool stopped = false;
+
     void InitWindow();
+    void InitOffscreen();
     void ReCreateSwapChain(uint32_t width, uint32_t height);
     void EventCallback(Event event);
 
@@ -0,0 +1,165 @@
+// traversal of the bvh built by Engine/BVH.cpp
+// define BVH_NODES_BINDING and BVH_TRIANGLES_BINDING before including, both buffers are in set 0
+
+// BVH::MAX_DEPTH, one far child is pushed per level at most
+#define BVH_STACK_SIZE 64
+
+#define BVH_MISS 1e30
+
+struct BVHNode
+{
+	vec3 boundsMin;
+	// leaves: first triangle, inner nodes: left child, the right one follows it
+	uint first;
+	vec3 boundsMax;
+	// 0 for inner nodes
+	uint count;
+};
+
+struct BVHTriangle
+{
+	vec3 v0;
+	// source triangle
+	uint index;
+	vec3 v1;
+	uint padding0;
+	vec3 v2;
+	uint padding1;
+};
+
+layout (binding = BVH_NODES_BINDING) readonly buffer BVHNodes
+{
+	BVHNode bvhNodes[];
+};
+
+layout (binding = BVH_TRIANGLES_BINDING) readonly buffer BVHTriangles
+{
+	BVHTriangle bvhTriangles[];
+};
+
+struct BVHHit
+{
+	float t;
+	// index into bvhTriangles, bvhTriangles[triangle].index is the source triangle
+	uint triangle;
+	vec2 barycentrics;
+};
+
+// entry distance of the ray into the box, BVH_MISS if it misses it within [tMin, tMax)
+float BVHIntersectBounds(vec3 boundsMin, vec3 boundsMax, vec3 origin, vec3 invDir, float tMin, float tMax)
+{
+	vec3 t0 = (boundsMin - origin) * invDir;
+	vec3 t1 = (boundsMax - origin) * invDir;
+	vec3 tEnter = min(t0, t1);
+	vec3 tExit = max(t0, t1);
+	float enter = max(max(tEnter.x, tEnter.y), max(tEnter.z, tMin));
+	float exit = min(min(tExit.x, tExit.y), min(tExit.z, tMax));
+	return enter <= exit ? enter : BVH_MISS;
+}
+
+// moller trumbore, both faces
+bool BVHIntersectTriangle(BVHTriangle triangle, vec3 origin, vec3 dir, float tMin, float tMax, out float t, out vec2 barycentrics)
+{
+	vec3 e1 = triangle.v1 - triangle.v0;
+	vec3 e2 = triangle.v2 - triangle.v0;
+	vec3 p = cross(dir, e2);
+	float det = dot(e1, p);
+	if (abs(det) < 1e-12)
+		return false;
+
+	float invDet = 1.0 / det;
+	vec3 s = origin - triangle.v0;
+	float u = dot(s, p) * invDet;
+	if (u < 0.0 || u > 1.0)
+		return false;
+
+	vec3 q = cross(s, e1);
+	float v = dot(dir, q) * invDet;
+	if (v < 0.0 || u + v > 1.0)
+		return false;
+
+	t = dot(e2, q) * invDet;
+	barycentrics = vec2(u, v);
+	return t > tMin && t < tMax;
+}
+
+// closest hit in (tMin, tMax), or the first one found if anyHit
+// nearer children are visited first, the farther ones wait on a short stack
+bool BVHTraverse(vec3 origin, vec3 dir, float tMin, float tMax, bool anyHit, out BVHHit hit)
+{
+	vec3 invDir = 1.0 / dir;
+	hit.t = tMax;
+	hit.triangle = 0;
+	hit.barycentrics = vec2(0.0);
+
+	if (BVHIntersectBounds(bvhNodes[0].boundsMin, bvhNodes[0].boundsMax, origin, invDir, tMin, tMax) == BVH_MISS)
+		return false;
+
+	uint stack[BVH_STACK_SIZE];
+	uint stackSize = 0;
+	uint nodeIndex = 0;
+	bool found = false;
+
+	while (true)
+	{
+		BVHNode node = bvhNodes[nodeIndex];
+		if (node.count > 0)
+		{
+			for (uint i = node.first; i < node.first + node.count; i++)
+			{
+				float t;
+				vec2 barycentrics;
+				if (BVHIntersectTriangle(bvhTriangles[i], origin, dir, tMin, hit.t, t, barycentrics))
+				{
+					hit.t = t;
+					hit.triangle = i;
+					hit.barycentrics = barycentrics;
+					found = true;
+					if (anyHit)
+						return true;
+				}
+			}
+		}
+		else
+		{
+			uint nearChild = node.first;
+			uint farChild = node.first + 1;
+			float tNear = BVHIntersectBounds(bvhNodes[nearChild].boundsMin, bvhNodes[nearChild].boundsMax, origin, invDir, tMin, hit.t);
+			float tFar = BVHIntersectBounds(bvhNodes[farChild].boundsMin, bvhNodes[farChild].boundsMax, origin, invDir, tMin, hit.t);
+			if (tFar < tNear)
+			{
+				uint child = nearChild;
+				nearChild = farChild;
+				farChild = child;
+				float t = tNear;
+				tNear = tFar;
+				tFar = t;
+			}
+
+			if (tNear != BVH_MISS)
+			{
+				if (tFar != BVH_MISS)
+					stack[stackSize++] = farChild;
+				nodeIndex = nearChild;
+				continue;
+			}
+		}
+
+		if (stackSize == 0)
+			break;
+		nodeIndex = stack[--stackSize];
+	}
+
+	return found;
+}
+
+bool BVHClosestHit(vec3 origin, vec3 dir, float tMin, float tMax, out BVHHit hit)
+{
+	return BVHTraverse(origin, dir, tMin, tMax, false, hit);
+}
+
+bool BVHOccluded(vec3 origin, vec3 dir, float tMin, float tMax)
+{
+	BVHHit hit;
+	return BVHTraverse(origin, dir, tMin, tMax, true, hit);
+}
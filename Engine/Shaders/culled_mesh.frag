@@ -0,0 +1,15 @@
+#version 450
+
+layout (location = 0) in vec3 inNormal;
+layout (location = 1) in vec3 inColor;
+
+layout (location = 0) out vec4 outFragColor;
+
+const vec3 lightDir = normalize(vec3(-0.5, 1.0, 0.6));
+
+void main()
+{
+	vec3 normal = normalize(inNormal);
+	float diffuse = abs(dot(normal, lightDir));
+	outFragColor = vec4(inColor * (0.2 + 0.8 * diffuse), 1.0);
+}
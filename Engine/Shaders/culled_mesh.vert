@@ -0,0 +1,32 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : enable
+#define CULLING_BUFFER_ACCESS readonly
+#include "culling.glsl"
+
+// GLTFVertex, every attribute is declared so that the stride matches
+layout (location = 0) in vec3 inPos;
+layout (location = 1) in vec3 inNormal;
+layout (location = 2) in vec2 inUV;
+layout (location = 3) in vec4 inJoint0;
+layout (location = 4) in vec4 inWeight0;
+layout (location = 5) in vec4 inTangent;
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec3 outColor;
+
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+
+// firstInstance of every compacted record is the draw index
+void main()
+{
+	Draw draw = draws[gl_InstanceIndex];
+
+	uint hash = uint(gl_InstanceIndex) * 0x9e3779b9u;
+	outColor = vec3(hash & 0xffu, (hash >> 8) & 0xffu, (hash >> 16) & 0xffu) / 255.0 * 0.5 + 0.5;
+	outNormal = mat3(draw.model) * inNormal;
+	gl_Position = params.viewProjection * draw.model * vec4(inPos, 1.0);
+}
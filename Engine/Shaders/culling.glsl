@@ -0,0 +1,94 @@
+// shared by the gpu culling shaders, layouts match Engine/GPUCulling.h
+// every culling pass binds the same buffers, stages that only read them define CULLING_BUFFER_ACCESS readonly
+
+#ifndef CULLING_BUFFER_ACCESS
+#define CULLING_BUFFER_ACCESS
+#endif
+
+#define CULL_GROUP_SIZE 64
+// level 0 texels reduced by one hiz_reduce workgroup, GPUCulling::HIZ_TILE
+#define HIZ_TILE 32
+// level 0 and the 5 levels a tile reduces to, GPUCulling::HIZ_LEVELS
+#define HIZ_LEVELS 6
+
+// written by the cpu every frame, bound dynamic
+layout (binding = 0) uniform Params
+{
+	mat4 viewProjection;
+	// of the frame the depth pyramid was built from
+	mat4 previousViewProjection;
+	// world space, xyz inward normal, w distance
+	vec4 planes[6];
+	uint drawCount;
+	// size of level 0
+	uint hizWidth;
+	uint hizHeight;
+	// 0 to test the frustum only
+	uint occlusion;
+} params;
+
+struct Draw
+{
+	mat4 model;
+	// object space box of the primitive
+	vec4 boundsMin;
+	vec4 boundsMax;
+	// VkDrawIndexedIndirectCommand fields of the primitive
+	uint indexCount;
+	uint firstIndex;
+	int vertexOffset;
+	uint padding;
+};
+
+layout (binding = 1) readonly buffer Draws
+{
+	Draw draws[];
+};
+
+struct DrawCommand
+{
+	uint indexCount;
+	uint instanceCount;
+	uint firstIndex;
+	int vertexOffset;
+	// index of the draw, read back as gl_InstanceIndex
+	uint firstInstance;
+};
+
+// counters then the compacted VkDrawIndexedIndirectCommand records, drawn with the count
+layout (binding = 2) CULLING_BUFFER_ACCESS buffer Commands
+{
+	uint visibleCount;
+	uint frustumCulled;
+	uint occlusionCulled;
+	uint padding0;
+	DrawCommand commands[];
+};
+
+// max depth of every level, level 0 first, of the previous frame
+layout (binding = 3) CULLING_BUFFER_ACCESS buffer Pyramid
+{
+	float pyramid[];
+};
+
+// float bits of the max depth under every level 0 texel, accumulated by hiz_copy, cleared by hiz_reduce
+layout (binding = 4) CULLING_BUFFER_ACCESS buffer HiZDepth
+{
+	uint hizDepth[];
+};
+
+uvec2 HiZLevelSize(uint level)
+{
+	return max(uvec2(params.hizWidth, params.hizHeight) >> level, uvec2(1));
+}
+
+uint HiZLevelOffset(uint level)
+{
+	uint offset = 0;
+	for (uint i = 0; i < level; i++)
+	{
+		uvec2 size = HiZLevelSize(i);
+		offset += size.x * size.y;
+	}
+	return offset;
+}
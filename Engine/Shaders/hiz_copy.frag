@@ -0,0 +1,18 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : enable
+#include "culling.glsl"
+
+// the depth attachment the culled draws wrote
+layout (binding = 5) uniform sampler2D depthAttachment;
+
+// every pixel folds its depth into the level 0 texel covering it, depths in [0, 1] order like their bits
+void main()
+{
+	ivec2 pixel = ivec2(gl_FragCoord.xy);
+	float depth = texelFetch(depthAttachment, pixel, 0).r;
+
+	uvec2 size = uvec2(params.hizWidth, params.hizHeight);
+	uvec2 texel = min(uvec2(gl_FragCoord.xy / vec2(textureSize(depthAttachment, 0)) * vec2(size)), size - 1);
+	atomicMax(hizDepth[texel.y * size.x + texel.x], floatBitsToUint(depth));
+}
@@ -0,0 +1,15 @@
+#version 450
+
+layout (location = 0) in vec2 inCorner;
+layout (location = 1) in vec4 inColor;
+
+layout (location = 0) out vec4 outFragColor;
+
+// round soft sprite
+void main()
+{
+	float falloff = 1.0 - smoothstep(0.5, 1.0, length(inCorner));
+	if (falloff <= 0.0)
+		discard;
+	outFragColor = vec4(inColor.rgb, inColor.a * falloff);
+}
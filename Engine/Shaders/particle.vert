@@ -0,0 +1,27 @@
+#version 450
+
+#extension GL_GOOGLE_include_directive : enable
+#define PARTICLE_BUFFER_ACCESS readonly
+#include "particles.glsl"
+
+layout (location = 0) out vec2 outCorner;
+layout (location = 1) out vec4 outColor;
+
+const vec2 corners[6] = vec2[](
+	vec2(-1.0, -1.0), vec2(1.0, -1.0), vec2(1.0, 1.0),
+	vec2(-1.0, -1.0), vec2(1.0, 1.0), vec2(-1.0, 1.0)
+);
+
+// one instance per alive particle, a camera facing quad of 6 vertices
+void main()
+{
+	Particle particle = particles[aliveList[gl_InstanceIndex]];
+	vec2 corner = corners[gl_VertexIndex];
+
+	vec4 viewPosition = params.view * vec4(particle.position, 1.0);
+	viewPosition.xy += corner * params.size;
+	gl_Position = params.projection * viewPosition;
+
+	outCorner = corner;
+	outColor = mix(params.startColor, params.endColor, clamp(particle.age / particle.lifetime, 0.0, 1.0));
+}
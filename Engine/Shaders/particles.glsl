@@ -0,0 +1,110 @@
+// shared by the particle system shaders, layouts match Engine/ParticleSystem.h
+// every particle pass binds the same buffers, stages that only read them define PARTICLE_BUFFER_ACCESS readonly
+
+#ifndef PARTICLE_BUFFER_ACCESS
+#define PARTICLE_BUFFER_ACCESS
+#endif
+
+#define PARTICLE_GROUP_SIZE 64
+// depth buckets of the counting sort, ParticleSystem::SORT_BUCKETS
+#define SORT_BUCKETS 1024
+
+struct Particle
+{
+	vec3 position;
+	float age;
+	vec3 velocity;
+	float lifetime;
+};
+
+// written by the cpu every frame, bound dynamic
+layout (binding = 0) uniform Params
+{
+	mat4 view;
+	mat4 projection;
+	// w: distance covered by the depth sort
+	vec4 cameraPosition;
+	// w: radius particles are spawned in
+	vec4 emitterPosition;
+	// w: random speed added in any direction
+	vec4 emitterVelocity;
+	// w: delta time
+	vec4 gravity;
+	vec4 startColor;
+	vec4 endColor;
+	uint emitCount;
+	uint seed;
+	float lifetimeMin;
+	float lifetimeMax;
+	float size;
+} params;
+
+layout (binding = 1) PARTICLE_BUFFER_ACCESS buffer Counters
+{
+	// alive list length, emitted particles included once begin ran
+	uint aliveCount;
+	uint deadCount;
+	uint emitCount;
+	// alive slot of the first particle emitted this frame
+	uint aliveBase;
+	uint survivorCount;
+	uint padding0;
+	uint padding1;
+	uint padding2;
+	// VkDispatchIndirectCommand at offset 32 and 48, VkDrawIndirectCommand at 64
+	uvec4 emitArgs;
+	uvec4 simulateArgs;
+	uvec4 drawArgs;
+} counters;
+
+layout (binding = 2) PARTICLE_BUFFER_ACCESS buffer Particles
+{
+	Particle particles[];
+};
+
+// free particle indices, the first deadCount are valid
+layout (binding = 3) PARTICLE_BUFFER_ACCESS buffer DeadList
+{
+	uint deadList[];
+};
+
+// live particle indices, back to front after the sort
+layout (binding = 4) PARTICLE_BUFFER_ACCESS buffer AliveList
+{
+	uint aliveList[];
+};
+
+// live particle indices compacted by the simulation, unsorted
+layout (binding = 5) PARTICLE_BUFFER_ACCESS buffer Survivors
+{
+	uint survivors[];
+};
+
+// depth bucket of every survivor
+layout (binding = 6) PARTICLE_BUFFER_ACCESS buffer SortKeys
+{
+	uint sortKeys[];
+};
+
+// survivors per bucket, then the first alive slot of every bucket
+layout (binding = 7) PARTICLE_BUFFER_ACCESS buffer Buckets
+{
+	uint buckets[SORT_BUCKETS];
+};
+
+uint ParticleHash(uint x)
+{
+	x ^= x >> 16;
+	x *= 0x7feb352du;
+	x ^= x >> 15;
+	x *= 0x846ca68bu;
+	x ^= x >> 16;
+	return x;
+}
+
+// [0, 1), advances the state
+float ParticleRandom(inout uint state)
+{
+	state = ParticleHash(state);
+	return float(state >> 8) / 16777216.0;
+}
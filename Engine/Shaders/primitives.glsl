@@ -0,0 +1,138 @@
+// shared by the compute primitives kernels, included before any declaration
+// PIXEL_SUBGROUP selects the subgroup arithmetic paths, otherwise shared memory only
+
+#ifdef PIXEL_SUBGROUP
+#extension GL_KHR_shader_subgroup_basic : require
+#extension GL_KHR_shader_subgroup_arithmetic : require
+#endif
+
+#define WORKGROUP_SIZE 256
+#define ITEMS_PER_THREAD 4
+// elements covered by one workgroup
+#define BLOCK_SIZE (WORKGROUP_SIZE * ITEMS_PER_THREAD)
+
+#define OP_ADD 0
+#define OP_MIN 1
+#define OP_MAX 2
+
+layout (local_size_x = WORKGROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+
+shared uint sharedPartials[WORKGROUP_SIZE];
+shared uint sharedTotal;
+
+uint Identity(uint op)
+{
+	return op == OP_MIN ? 0xffffffffu : 0u;
+}
+
+uint Combine(uint a, uint b, uint op)
+{
+	if (op == OP_MIN)
+		return min(a, b);
+	if (op == OP_MAX)
+		return max(a, b);
+	return a + b;
+}
+
+// position of the invocation in scan order
+// subgroups are not guaranteed to be contiguous ranges of gl_LocalInvocationIndex
+uint LaneIndex()
+{
+#ifdef PIXEL_SUBGROUP
+	return gl_SubgroupID * gl_SubgroupSize + gl_SubgroupInvocationID;
+#else
+	return gl_LocalInvocationIndex;
+#endif
+}
+
+// inclusive sum over the lanes up to LaneIndex(), total of the workgroup in total
+// must be reached by the whole workgroup
+uint WorkgroupInclusiveAdd(uint value, out uint total)
+{
+#ifdef PIXEL_SUBGROUP
+	uint scan = subgroupInclusiveAdd(value);
+	if (gl_SubgroupInvocationID == gl_SubgroupSize - 1)
+		sharedPartials[gl_SubgroupID] = scan;
+	barrier();
+
+	// the first subgroup turns subgroup totals into exclusive offsets
+	if (gl_SubgroupID == 0)
+	{
+		uint carry = 0;
+		for (uint base = 0; base < gl_NumSubgroups; base += gl_SubgroupSize)
+		{
+			uint index = base + gl_SubgroupInvocationID;
+			uint partial = index < gl_NumSubgroups ? sharedPartials[index] : 0;
+			uint offset = subgroupExclusiveAdd(partial);
+			if (index < gl_NumSubgroups)
+				sharedPartials[index] = carry + offset;
+			carry += subgroupAdd(partial);
+		}
+		if (subgroupElect())
+			sharedTotal = carry;
+	}
+	barrier();
+
+	uint result = sharedPartials[gl_SubgroupID] + scan;
+	total = sharedTotal;
+#else
+	uint lane = gl_LocalInvocationIndex;
+	sharedPartials[lane] = value;
+	barrier();
+
+	for (uint offset = 1; offset < WORKGROUP_SIZE; offset <<= 1)
+	{
+		uint partial = lane >= offset ? sharedPartials[lane - offset] : 0;
+		barrier();
+		sharedPartials[lane] += partial;
+		barrier();
+	}
+
+	uint result = sharedPartials[lane];
+	total = sharedPartials[WORKGROUP_SIZE - 1];
+#endif
+	// shared memory is reused by the next call
+	barrier();
+	return result;
+}
+
+#ifdef PIXEL_SUBGROUP
+uint SubgroupReduce(uint value, uint op)
+{
+	if (op == OP_MIN)
+		return subgroupMin(value);
+	if (op == OP_MAX)
+		return subgroupMax(value);
+	return subgroupAdd(value);
+}
+#endif
+
+// op over the values of the whole workgroup, returned to every invocation
+uint WorkgroupReduce(uint value, uint op)
+{
+#ifdef PIXEL_SUBGROUP
+	uint partial = SubgroupReduce(value, op);
+	if (subgroupElect())
+		sharedPartials[gl_SubgroupID] = partial;
+	barrier();
+
+	uint result = Identity(op);
+	for (uint i = 0; i < gl_NumSubgroups; i++)
+		result = Combine(result, sharedPartials[i], op);
+#else
+	uint lane = gl_LocalInvocationIndex;
+	sharedPartials[lane] = value;
+	barrier();
+
+	for (uint stride = WORKGROUP_SIZE / 2; stride > 0; stride >>= 1)
+	{
+		if (lane < stride)
+			sharedPartials[lane] = Combine(sharedPartials[lane], sharedPartials[lane + stride], op);
+		barrier();
+	}
+
+	uint result = sharedPartials[0];
+#endif
+	barrier();
+	return result;
+}
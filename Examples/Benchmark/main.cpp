@@ -0,0 +1,499 @@
+#include <FrameGraph/Graph.h>
+#include <RHI/RuntimeEntry.h>
+
+#include <Core/Trace.h>
+
+#include <Engine/PixelEngine.h>
+#include <Engine/Renderer.h>
+#include <Engine/Camera.h>
+#include <Engine/ImguiOverlay.h>
+
+#include <IO/GLTFReader.h>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+#include <spdlog/spdlog.h>
+#include <json_struct/json_struct.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+
+// every heap allocation of the process is counted, the per frame delta is the cpu side churn
+static std::atomic<uint64_t> allocationCount = 0;
+static std::atomic<uint64_t> allocationBytes = 0;
+
+void *operator new(size_t size)
+{
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    if (auto ptr = std::malloc(size ? size : 1))
+        return ptr;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    std::free(ptr);
+}
+
+struct BenchmarkConfig
+{
+    uint32_t warmupFrames = 30;
+    uint32_t frames = 300;
+    std::string scene = "all";
+    std::string output = "benchmark.json";
+};
+
+struct BenchmarkResult
+{
+    struct Percentiles
+    {
+        double mean;
+        double p50;
+        double p90;
+        double p99;
+        double max;
+
+        JS_OBJ(mean, p50, p90, p99, max);
+    };
+
+    struct PassTiming
+    {
+        std::string name;
+        double avg;
+        double min;
+        double max;
+
+        JS_OBJ(name, avg, min, max);
+    };
+
+    std::string scene;
+    uint32_t frames;
+    uint32_t width;
+    uint32_t height;
+
+    // cpu time between frame starts, milliseconds
+    Percentiles cpuFrameTime;
+
+    // empty if the device has no usable timestamps
+    std::vector<PassTiming> gpuTimings;
+
+    Percentiles allocationsPerFrame;
+    Percentiles allocatedBytesPerFrame;
+
+    // device memory allocated through vma
+    uint64_t gpuMemoryPeak;
+    uint64_t gpuMemoryFinal;
+
+    FrameStatistics frameStatistics;
+
+    // device and swapchain settings granted by the runtime
+    RuntimeInfo runtime;
+
+    JS_OBJ(scene, frames, width, height, cpuFrameTime, gpuTimings, allocationsPerFrame, allocatedBytesPerFrame, gpuMemoryPeak, gpuMemoryFinal, frameStatistics, runtime);
+};
+
+static BenchmarkResult::Percentiles percentiles(std::vector<double> values)
+{
+    if (values.empty())
+    {
+        return {};
+    }
+
+    std::sort(values.begin(), values.end());
+    auto at = [&](double p)
+    { return values[std::min(values.size() - 1, size_t(p * values.size()))]; };
+
+    double sum = 0.0;
+    for (auto value : values)
+    {
+        sum += value;
+    }
+
+    return {
+        .mean = sum / values.size(),
+        .p50 = at(0.5),
+        .p90 = at(0.9),
+        .p99 = at(0.99),
+        .max = values.back()};
+}
+
+static PipelineStates defaultPipelineStates()
+{
+    return {
+        .inputAssembleState = {.type = InputAssembleState::Type::TRIANGLE_LIST},
+        .rasterizationState = {.polygonMode = RasterizationState::PolygonModeType::FILL, .cullMode = RasterizationState::CullModeType::NONE, .frontFace = RasterizationState::FrontFaceType::COUNTER_CLOCKWISE, .lineWidth = 1.0f},
+        .depthStencilState = {.depthTestEnable = true, .depthWriteEnable = true}};
+}
+
+// rgba8 checker board, stands in for the ktx assets of the examples
+static IntrusivePtr<Texture> createCheckerTexture(PixelEngine *engine, uint32_t size, glm::u8vec4 a, glm::u8vec4 b)
+{
+    std::vector<glm::u8vec4> pixels(size * size);
+    for (uint32_t y = 0; y < size; y++)
+    {
+        for (uint32_t x = 0; x < size; x++)
+        {
+            pixels[y * size + x] = ((x / 32) + (y / 32)) % 2 ? a : b;
+        }
+    }
+
+    auto texture = engine->GetRHIRuntime()->CreateTexture(TextureFormat::FORMAT_R8G8B8A8_UNORM, Texture::IMAGE_USAGE_TRANSFER_DST_BIT | Texture::IMAGE_USAGE_SAMPLED_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, {size, size, 1});
+    engine->GetAuxiliaryExecutor()->TransferResource(texture, pixels.data(), pixels.size() * sizeof(glm::u8vec4));
+    return texture;
+}
+
+static void buildTriangleScene(PixelEngine *engine, IntrusivePtr<Renderer> renderer)
+{
+    struct Vertex
+    {
+        float position[3];
+        float color[3];
+    };
+
+    std::vector<Vertex> vertices = {
+        {{1.0f, 1.0f, 0.0f}, {1.0f, 0.0f, 0.0f}},
+        {{-1.0f, 1.0f, 0.0f}, {0.0f, 1.0f, 0.0f}},
+        {{0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}}};
+    std::vector<uint32_t> indices = {0, 1, 2};
+
+    auto renderGroup = engine->RegisterRenderGroup(Graph::ParseRenderPassJson("triangle.json"));
+    auto pipeline = renderGroup->CreatePipeline("single", defaultPipelineStates());
+
+    auto &rhiRuntime = engine->GetRHIRuntime();
+    auto vBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_VERTEX_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertices.size() * sizeof(Vertex));
+    auto iBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_INDEX_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indices.size() * sizeof(uint32_t));
+    engine->GetAuxiliaryExecutor()->TransferResource(vBuffer, vertices.data(), vertices.size() * sizeof(Vertex));
+    engine->GetAuxiliaryExecutor()->TransferResource(iBuffer, indices.data(), indices.size() * sizeof(uint32_t));
+
+    glm::mat4 model = glm::mat4(1.0f);
+    auto uBuffer = rhiRuntime->CreateDynamicBuffer(sizeof(model));
+    memcpy(uBuffer->Map(), &model, sizeof(model));
+
+    auto rbs = rhiRuntime->CreateResourceBindingState(pipeline);
+    rbs->Bind(0, 0, renderer->GetCamera()->GetUBOBuffer());
+    rbs->Bind(0, 1, uBuffer);
+    rbs->BindVertexBuffer(vBuffer);
+    rbs->BindIndexBuffer(iBuffer, ResourceBindingState::INDEX_TYPE_UINT32);
+    rbs->BindDrawOp({ResourceBindingState::DrawOP{
+        .indexCount = 3,
+        .instanceCount = 1}});
+    renderer->AddDrawState(rbs);
+}
+
+static void buildTextureScene(PixelEngine *engine, IntrusivePtr<Renderer> renderer)
+{
+    struct Vertex
+    {
+        float pos[3];
+        float uv[2];
+        float normal[3];
+    };
+
+    struct TextureUBO
+    {
+        glm::mat4 model;
+        float lodBias;
+    };
+
+    std::vector<Vertex> vertices = {
+        {{1.0f, 1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 0.0f, 1.0f}},
+        {{-1.0f, 1.0f, 0.0f}, {0.0f, 1.0f}, {0.0f, 0.0f, 1.0f}},
+        {{-1.0f, -1.0f, 0.0f}, {0.0f, 0.0f}, {0.0f, 0.0f, 1.0f}},
+        {{1.0f, -1.0f, 0.0f}, {1.0f, 0.0f}, {0.0f, 0.0f, 1.0f}}};
+    std::vector<uint32_t> indices = {0, 1, 2, 2, 3, 0};
+
+    auto renderGroup = engine->RegisterRenderGroup(Graph::ParseRenderPassJson("texture.json"));
+    auto pipeline = renderGroup->CreatePipeline("texture", defaultPipelineStates());
+
+    auto &rhiRuntime = engine->GetRHIRuntime();
+    auto vBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_VERTEX_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertices.size() * sizeof(Vertex));
+    auto iBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_INDEX_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indices.size() * sizeof(uint32_t));
+    engine->GetAuxiliaryExecutor()->TransferResource(vBuffer, vertices.data(), vertices.size() * sizeof(Vertex));
+    engine->GetAuxiliaryExecutor()->TransferResource(iBuffer, indices.data(), indices.size() * sizeof(uint32_t));
+
+    auto texture = createCheckerTexture(engine, 512, {200, 200, 200, 255}, {60, 60, 60, 255});
+
+    TextureUBO textureUBO = {
+        .model = glm::mat4(1.5f),
+        .lodBias = 1.0f};
+    auto uBuffer = rhiRuntime->CreateDynamicBuffer(sizeof(TextureUBO));
+    memcpy(uBuffer->Map(), &textureUBO, sizeof(textureUBO));
+
+    auto rbs = rhiRuntime->CreateResourceBindingState(pipeline);
+    rbs->Bind(0, 0, renderer->GetCamera()->GetUBOBuffer());
+    rbs->Bind(0, 1, uBuffer);
+    rbs->Bind(0, 2, rhiRuntime->CreateSampler(texture));
+    rbs->BindVertexBuffer(vBuffer);
+    rbs->BindIndexBuffer(iBuffer, ResourceBindingState::INDEX_TYPE_UINT32);
+    rbs->BindDrawOp({ResourceBindingState::DrawOP{
+        .indexCount = uint32_t(indices.size()),
+        .instanceCount = 1}});
+    renderer->AddDrawState(rbs);
+}
+
+// grid of cubes in the gltf vertex layout, one draw state per cube like the gltf meshes of the example
+static void buildDeferredScene(PixelEngine *engine, IntrusivePtr<Renderer> renderer)
+{
+    struct Light
+    {
+        glm::vec4 position;
+        glm::vec3 color;
+        float radius;
+    };
+
+    struct LightsUBO
+    {
+        Light lights[6];
+        glm::vec4 viewPos;
+        int debugDisplayTarget = 0;
+    };
+
+    static constexpr int GRID_SIZE = 8;
+
+    auto renderGroup = engine->RegisterRenderGroup(Graph::ParseRenderPassJson("deferred.json"));
+    auto gbufferPipeline = renderGroup->CreatePipeline("deferred", defaultPipelineStates());
+    auto composePipeline = renderGroup->CreatePipeline("compose", defaultPipelineStates());
+
+    auto &rhiRuntime = engine->GetRHIRuntime();
+    auto camera = renderer->GetCamera();
+
+    std::vector<GLTFVertex> vertices;
+    std::vector<uint32_t> indices;
+    for (int face = 0; face < 6; face++)
+    {
+        glm::vec3 normal(0.0f);
+        normal[face / 2] = face % 2 ? -1.0f : 1.0f;
+        glm::vec3 tangent(0.0f);
+        tangent[(face / 2 + 1) % 3] = 1.0f;
+        auto bitangent = glm::cross(normal, tangent);
+
+        uint32_t base = vertices.size();
+        glm::vec2 corners[4] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+        for (auto corner : corners)
+        {
+            vertices.push_back(GLTFVertex{
+                .pos = (normal + tangent * corner.x + bitangent * corner.y) * 0.25f,
+                .normal = normal,
+                .uv = corner * 0.5f + 0.5f,
+                .tangent = glm::vec4(tangent, 1.0f)});
+        }
+        indices.insert(indices.end(), {base, base + 1, base + 2, base + 2, base + 3, base});
+    }
+
+    auto vBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_VERTEX_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertices.size() * sizeof(GLTFVertex));
+    auto iBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_INDEX_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indices.size() * sizeof(uint32_t));
+    engine->GetAuxiliaryExecutor()->TransferResource(vBuffer, vertices.data(), vertices.size() * sizeof(GLTFVertex));
+    engine->GetAuxiliaryExecutor()->TransferResource(iBuffer, indices.data(), indices.size() * sizeof(uint32_t));
+
+    auto colorSampler = rhiRuntime->CreateSampler(createCheckerTexture(engine, 256, {180, 120, 80, 255}, {90, 60, 40, 255}));
+    auto normalSampler = rhiRuntime->CreateSampler(createCheckerTexture(engine, 4, {128, 128, 255, 255}, {128, 128, 255, 255}));
+
+    for (int x = 0; x < GRID_SIZE; x++)
+    {
+        for (int z = 0; z < GRID_SIZE; z++)
+        {
+            glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(x - GRID_SIZE / 2, 0.0f, z - GRID_SIZE / 2));
+            auto uBuffer = rhiRuntime->CreateDynamicBuffer(sizeof(model));
+            memcpy(uBuffer->Map(), &model, sizeof(model));
+
+            auto rbs = rhiRuntime->CreateResourceBindingState(gbufferPipeline);
+            rbs->Bind(0, 0, camera->GetUBOBuffer());
+            rbs->Bind(0, 1, uBuffer);
+            rbs->Bind(0, 2, colorSampler);
+            rbs->Bind(0, 3, normalSampler);
+            rbs->BindVertexBuffer(vBuffer);
+            rbs->BindIndexBuffer(iBuffer, ResourceBindingState::INDEX_TYPE_UINT32);
+            rbs->BindDrawOp({ResourceBindingState::DrawOP{
+                .indexCount = uint32_t(indices.size()),
+                .instanceCount = 1}});
+            renderer->AddDrawState(rbs);
+        }
+    }
+
+    LightsUBO lightsUBO = {};
+    for (int i = 0; i < 6; i++)
+    {
+        float angle = glm::radians(60.0f * i);
+        lightsUBO.lights[i].position = glm::vec4(sin(angle) * 4.0f, -1.0f, cos(angle) * 4.0f, 0.0f);
+        lightsUBO.lights[i].color = glm::vec3(1.0f);
+        lightsUBO.lights[i].radius = 8.0f;
+    }
+    lightsUBO.viewPos = glm::vec4(camera->position, 0.0f) * glm::vec4(-1.0f, 1.0f, -1.0f, 1.0f);
+
+    auto lightsBuffer = rhiRuntime->CreateDynamicBuffer(sizeof(LightsUBO));
+    memcpy(lightsBuffer->Map(), &lightsUBO, sizeof(lightsUBO));
+
+    auto rbs = rhiRuntime->CreateResourceBindingState(composePipeline);
+    rbs->Bind(0, 0, lightsBuffer);
+    ResourceBindingState::DrawOP drawOP = {};
+    drawOP.vertexCount = 3;
+    drawOP.instanceCount = 1;
+    rbs->BindDrawOp({drawOP});
+    renderer->AddDrawState(rbs);
+}
+
+struct Scene
+{
+    std::string name;
+
+    // null for the overlay only scene
+    std::function<void(PixelEngine *, IntrusivePtr<Renderer>)> build;
+    bool overlay;
+};
+
+static BenchmarkResult runScene(const Scene &scene, const BenchmarkConfig &config)
+{
+    spdlog::info("benchmark {}: {} + {} frames", scene.name, config.warmupFrames, config.frames);
+
+    IntrusivePtr<PixelEngine> engine = new PixelEngine(true);
+    engine->GetRHIRuntime()->GetGPUProfiler()->SetEnabled(true);
+
+    auto renderer = engine->CreateRenderer();
+
+    IntrusivePtr<ImguiOverlay> ui;
+    if (scene.overlay)
+    {
+        ui = new ImguiOverlay(engine.get());
+        ui->BuildPipeline();
+        ui->BuildDrawable();
+        renderer->AddDrawState(ui->drawState);
+    }
+
+    if (scene.build)
+    {
+        scene.build(engine.get(), renderer);
+    }
+
+    BenchmarkResult result = {
+        .scene = scene.name,
+        .frames = config.frames,
+        .width = renderer->GetSwapChain()->GetExtent().width,
+        .height = renderer->GetSwapChain()->GetExtent().height};
+
+    std::vector<double> frameTimes;
+    std::vector<double> frameAllocations;
+    std::vector<double> frameAllocatedBytes;
+
+    uint32_t frameCount = 0;
+    uint64_t frameStart = 0;
+    uint64_t allocationStart = 0;
+    uint64_t allocatedBytesStart = 0;
+
+    renderer->RegisterUpdateCallback({GENERAL, [&, renderer = renderer.get()](UpdateInput inputs)
+                                      {
+                                          if (inputs.event.type != Event::FRAME)
+                                              return false;
+
+                                          auto now = Trace::Now();
+                                          auto allocations = allocationCount.load();
+                                          auto allocatedBytes = allocationBytes.load();
+
+                                          if (frameCount++ > config.warmupFrames)
+                                          {
+                                              frameTimes.push_back((now - frameStart) / 1000000.0);
+                                              frameAllocations.push_back(double(allocations - allocationStart));
+                                              frameAllocatedBytes.push_back(double(allocatedBytes - allocatedBytesStart));
+                                          }
+
+                                          // memory is walked between the measured intervals
+                                          auto memoryStatistics = engine->GetRHIRuntime()->GetMemoryStatistics();
+                                          result.gpuMemoryPeak = std::max(result.gpuMemoryPeak, memoryStatistics.allocationBytes);
+                                          result.gpuMemoryFinal = memoryStatistics.allocationBytes;
+
+                                          if (frameCount > config.warmupFrames + config.frames)
+                                          {
+                                              renderer->Stop();
+                                          }
+
+                                          frameStart = Trace::Now();
+                                          allocationStart = allocationCount.load();
+                                          allocatedBytesStart = allocationBytes.load();
+                                          return false;
+                                      }});
+
+    engine->Frame();
+
+    result.cpuFrameTime = percentiles(frameTimes);
+    result.allocationsPerFrame = percentiles(frameAllocations);
+    result.allocatedBytesPerFrame = percentiles(frameAllocatedBytes);
+    result.frameStatistics = engine->GetRHIRuntime()->GetFrameStatistics();
+    result.runtime = engine->GetRHIRuntime()->GetRuntimeInfo();
+
+    for (auto &timing : engine->GetRHIRuntime()->GetGPUProfiler()->GetTimings())
+    {
+        result.gpuTimings.push_back({
+            .name = timing.name,
+            .avg = timing.avg,
+            .min = timing.min,
+            .max = timing.max});
+    }
+
+    renderer.reset();
+    ui.reset();
+    engine.reset();
+
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    spdlog::set_level(spdlog::level::warn);
+
+    BenchmarkConfig config;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        std::string option = argv[i];
+        if (option == "--frames")
+            config.frames = std::stoul(argv[i + 1]);
+        else if (option == "--warmup")
+            config.warmupFrames = std::stoul(argv[i + 1]);
+        else if (option == "--scene")
+            config.scene = argv[i + 1];
+        else if (option == "--output")
+            config.output = argv[i + 1];
+        else
+        {
+            std::cerr << "usage: Benchmark [--scene name|all] [--frames n] [--warmup n] [--output file]" << std::endl;
+            return 1;
+        }
+    }
+
+    std::vector<Scene> scenes = {
+        {"triangle", buildTriangleScene, false},
+        {"texture", buildTextureScene, false},
+        {"deferred", buildDeferredScene, false},
+        {"imgui", nullptr, true},
+        {"triangle_imgui", buildTriangleScene, true}};
+
+    std::vector<BenchmarkResult> results;
+    for (auto &scene : scenes)
+    {
+        if (config.scene == "all" || config.scene == scene.name)
+        {
+            results.push_back(runScene(scene, config));
+        }
+    }
+
+    if (results.empty())
+    {
+        std::cerr << "unknown scene " << config.scene << std::endl;
+        return 1;
+    }
+
+    auto json = JS::serializeStruct(results);
+    std::ofstream(config.output) << json;
+    std::cout << json << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,183 @@
+#include <Engine/CPUCulling.h>
+#include <Engine/Frustum.h>
+
+#include <Core/ParallelFor.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+#include <json_struct/json_struct.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+
+// the default run checks the simd and parallel paths against the scalar one and fails on mismatch
+// --benchmark reports the time of every path instead, no gpu is needed
+struct CPUCullingConfig
+{
+    bool benchmark = false;
+    uint32_t count = 1 << 20;
+    uint32_t iterations = 100;
+    std::string output = "cpu_culling.json";
+};
+
+struct CullResult
+{
+    std::string instructionSet;
+    bool parallel;
+    uint32_t count;
+    // of the first frustum
+    uint32_t visible;
+
+    // milliseconds per cull
+    double avg;
+    double min;
+    double objectsPerSecond;
+    // milliseconds of an empty ParallelFor, the part of avg spent waking and waiting for the workers, 0 when serial
+    double dispatch;
+
+    JS_OBJ(instructionSet, parallel, count, visible, avg, min, objectsPerSecond, dispatch);
+};
+
+// unit boxes scattered in a cube around the camera, rotated and scaled
+static void CreateObjects(IntrusivePtr<CPUCulling> culling, uint32_t count)
+{
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> scale(0.5f, 4.0f);
+    std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        auto model = glm::translate(glm::mat4(1.0f), glm::vec3(position(random), position(random), position(random)));
+        model = glm::rotate(model, angle(random), glm::normalize(glm::vec3(position(random), position(random), position(random)) + glm::vec3(1e-3f)));
+        model = glm::scale(model, glm::vec3(scale(random), scale(random), scale(random)));
+        culling->Add(glm::vec3(-0.5f), glm::vec3(0.5f), model);
+    }
+}
+
+// turning on the spot, one frustum per iteration
+static Frustum CameraFrustum(uint32_t iteration)
+{
+    float yaw = iteration * 0.05f;
+    auto view = glm::lookAt(glm::vec3(0.0f), glm::vec3(std::sin(yaw), 0.0f, std::cos(yaw)), glm::vec3(0.0f, 1.0f, 0.0f));
+    auto projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 400.0f);
+    return Frustum::FromViewProjection(projection * view);
+}
+
+static CullResult Measure(IntrusivePtr<CPUCulling> culling, bool simd, bool parallel, uint32_t iterations)
+{
+    std::vector<uint32_t> visible;
+    CullResult result = {
+        .instructionSet = simd ? CPUCulling::GetInstructionSet() : "scalar",
+        .parallel = parallel,
+        .count = culling->GetCount(),
+        .min = 1e30};
+
+    // warm the caches and the result allocation
+    culling->Cull(CameraFrustum(0), visible, simd, parallel);
+    result.visible = uint32_t(visible.size());
+
+    double total = 0.0;
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+        auto frustum = CameraFrustum(i);
+        auto start = std::chrono::steady_clock::now();
+        culling->Cull(frustum, visible, simd, parallel);
+        double time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        total += time;
+        result.min = std::min(result.min, time);
+    }
+    result.avg = total / iterations;
+    result.objectsPerSecond = result.count / (result.avg / 1000.0);
+
+    if (parallel)
+    {
+        auto threadCount = WorkerPool::Get().ThreadCount();
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < iterations; i++)
+        {
+            ParallelFor(threadCount, 2, [](uint32_t, uint32_t) {});
+        }
+        result.dispatch = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() / iterations;
+    }
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+    CPUCullingConfig config;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--benchmark")
+            config.benchmark = true;
+        else if (option == "--count" && i + 1 < argc)
+            config.count = std::max(std::stoul(argv[++i]), 1ul);
+        else if (option == "--iterations" && i + 1 < argc)
+            config.iterations = std::max(std::stoul(argv[++i]), 1ul);
+        else if (option == "--output" && i + 1 < argc)
+            config.output = argv[++i];
+        else
+        {
+            std::cerr << "usage: CPUCulling [--benchmark] [--count n] [--iterations n] [--output file]" << std::endl;
+            return 1;
+        }
+    }
+
+    IntrusivePtr<CPUCulling> culling = new CPUCulling();
+    CreateObjects(culling, config.count);
+    spdlog::info("cpu culling: {} objects, {}", culling->GetCount(), CPUCulling::GetInstructionSet());
+
+    if (config.benchmark)
+    {
+        std::vector<CullResult> results;
+        for (bool simd : {false, true})
+        {
+            for (bool parallel : {false, true})
+            {
+                results.push_back(Measure(culling, simd, parallel, config.iterations));
+            }
+        }
+
+        auto json = JS::serializeStruct(results);
+        std::ofstream(config.output) << json;
+        std::cout << json << std::endl;
+        return 0;
+    }
+
+    int status = 0;
+    for (uint32_t i = 0; i < std::min(config.iterations, 16u); i++)
+    {
+        auto frustum = CameraFrustum(i);
+        std::vector<uint32_t> reference, simd, parallel;
+        culling->Cull(frustum, reference, false, false);
+        culling->Cull(frustum, simd, true, false);
+        culling->Cull(frustum, parallel, true, true);
+
+        // the scalar loop may be contracted into fma where the simd one is not, boxes touching a plane can differ
+        std::vector<uint32_t> difference;
+        std::set_symmetric_difference(reference.begin(), reference.end(), simd.begin(), simd.end(), std::back_inserter(difference));
+        if (!std::is_sorted(simd.begin(), simd.end()) || difference.size() > config.count / 100000)
+        {
+            spdlog::error("frustum {}: simd culling differs from scalar in {} objects", i, difference.size());
+            status = 1;
+        }
+        if (parallel != simd)
+        {
+            spdlog::error("frustum {}: parallel culling differs from serial", i);
+            status = 1;
+        }
+    }
+
+    if (!status)
+    {
+        spdlog::info("cpu culling: simd and parallel paths match the scalar one");
+    }
+    return status;
+}
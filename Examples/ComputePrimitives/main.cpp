@@ -0,0 +1,275 @@
+#include <RHI/RuntimeEntry.h>
+
+#include <Engine/PixelEngine.h>
+#include <Engine/Renderer.h>
+#include <Engine/ComputePrimitives.h>
+
+#include <spdlog/spdlog.h>
+#include <json_struct/json_struct.h>
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <random>
+
+// the default run checks every primitive against a cpu reference and fails on mismatch
+// --benchmark reports the gpu time of each primitive instead
+struct PrimitivesConfig
+{
+    bool benchmark = false;
+    uint32_t count = 1 << 20;
+    uint32_t frames = 100;
+    std::string output = "compute_primitives.json";
+};
+
+struct PrimitiveResult
+{
+    std::string primitive;
+    bool subgroups;
+    uint32_t count;
+
+    // gpu time of the task, milliseconds
+    double avg;
+    double min;
+    double elementsPerSecond;
+
+    JS_OBJ(primitive, subgroups, count, avg, min, elementsPerSecond);
+};
+
+static const uint32_t HISTOGRAM_BINS = 256;
+
+static IntrusivePtr<Buffer> createBuffer(PixelEngine *engine, uint32_t count, const std::vector<uint32_t> &data = {})
+{
+    auto buffer = engine->GetRHIRuntime()->CreateBuffer(Buffer::BUFFER_USAGE_STORAGE_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_SRC_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, count * sizeof(uint32_t));
+    if (!data.empty())
+    {
+        engine->GetAuxiliaryExecutor()->TransferResource(buffer, data.data(), data.size() * sizeof(uint32_t));
+    }
+    return buffer;
+}
+
+static std::vector<uint32_t> readBuffer(PixelEngine *engine, IntrusivePtr<Buffer> buffer, uint32_t count)
+{
+    auto readback = engine->GetAuxiliaryExecutor()->ReadbackResource(buffer, 0, count * sizeof(uint32_t));
+    auto data = static_cast<const uint32_t *>(readback->Data());
+    return std::vector<uint32_t>(data, data + count);
+}
+
+// one primitive of a run, check compares the gpu result with the cpu reference
+struct Case
+{
+    std::string name;
+    IntrusivePtr<ComputeTask> task;
+    std::function<bool()> check;
+};
+
+static std::vector<Case> buildCases(PixelEngine *engine, ComputePrimitives *primitives, uint32_t count)
+{
+    std::mt19937 random(7);
+    std::vector<uint32_t> values(count);
+    std::vector<uint32_t> small(count);
+    std::vector<uint32_t> flags(count);
+    for (uint32_t i = 0; i < count; i++)
+    {
+        values[i] = random();
+        small[i] = random() % 1000;
+        flags[i] = random() % 3 == 0 ? random() : 0;
+    }
+
+    std::vector<Case> cases;
+
+    // sums wrap around like the uint arithmetic of the shaders
+    auto scanCase = [&](std::string name, bool inclusive)
+    {
+        auto src = createBuffer(engine, count, small);
+        auto dst = createBuffer(engine, count);
+        std::vector<uint32_t> expected(count);
+        if (inclusive)
+            std::inclusive_scan(small.begin(), small.end(), expected.begin());
+        else
+            std::exclusive_scan(small.begin(), small.end(), expected.begin(), 0u);
+
+        cases.push_back({name, primitives->PrefixSum(src, dst, count, inclusive), [=]()
+                         { return readBuffer(engine, dst, count) == expected; }});
+    };
+    scanCase("exclusive_scan", false);
+    scanCase("inclusive_scan", true);
+
+    auto reduceCase = [&](std::string name, ComputePrimitives::ReduceOp op, uint32_t expected)
+    {
+        auto src = createBuffer(engine, count, values);
+        auto result = createBuffer(engine, 1);
+        cases.push_back({name, primitives->Reduce(src, result, count, op), [=]()
+                         { return readBuffer(engine, result, 1)[0] == expected; }});
+    };
+    reduceCase("reduce_add", ComputePrimitives::REDUCE_ADD, std::accumulate(values.begin(), values.end(), 0u));
+    reduceCase("reduce_min", ComputePrimitives::REDUCE_MIN, *std::min_element(values.begin(), values.end()));
+    reduceCase("reduce_max", ComputePrimitives::REDUCE_MAX, *std::max_element(values.begin(), values.end()));
+
+    {
+        std::vector<uint32_t> expected;
+        for (uint32_t i = 0; i < count; i++)
+        {
+            if (flags[i])
+                expected.push_back(values[i]);
+        }
+
+        auto dst = createBuffer(engine, count);
+        auto dstCount = createBuffer(engine, 1);
+        auto task = primitives->Compact(createBuffer(engine, count, values), createBuffer(engine, count, flags), dst, dstCount, count);
+        cases.push_back({"compact", task, [=]()
+                         { return readBuffer(engine, dstCount, 1)[0] == expected.size() &&
+                                  (expected.empty() || readBuffer(engine, dst, expected.size()) == expected); }});
+    }
+
+    {
+        auto keys = createBuffer(engine, count, values);
+        auto expected = values;
+        std::sort(expected.begin(), expected.end());
+        cases.push_back({"radix_sort", primitives->RadixSort(keys, count), [=]()
+                         { return readBuffer(engine, keys, count) == expected; }});
+    }
+
+    {
+        // few distinct keys, values are the original indices so stability is checked as well
+        std::vector<uint32_t> indices(count);
+        std::iota(indices.begin(), indices.end(), 0u);
+        std::vector<uint32_t> expected = indices;
+        std::stable_sort(expected.begin(), expected.end(), [&](uint32_t a, uint32_t b)
+                         { return small[a] < small[b]; });
+
+        auto keys = createBuffer(engine, count, small);
+        auto payload = createBuffer(engine, count, indices);
+        cases.push_back({"radix_sort_pairs", primitives->RadixSort(keys, count, payload), [=]()
+                         { return readBuffer(engine, payload, count) == expected; }});
+    }
+
+    {
+        // 1000 values into 256 bins of 3, the values past the last bin are dropped
+        std::vector<uint32_t> expected(HISTOGRAM_BINS);
+        for (auto value : small)
+        {
+            if (value / 3 < HISTOGRAM_BINS)
+                expected[value / 3]++;
+        }
+
+        auto bins = createBuffer(engine, HISTOGRAM_BINS);
+        cases.push_back({"histogram", primitives->Histogram(createBuffer(engine, count, small), bins, count, HISTOGRAM_BINS, 0, 3), [=]()
+                         { return readBuffer(engine, bins, HISTOGRAM_BINS) == expected; }});
+    }
+
+    return cases;
+}
+
+// false if a check failed
+static bool run(const PrimitivesConfig &config, bool allowSubgroups, std::vector<PrimitiveResult> &results)
+{
+    IntrusivePtr<PixelEngine> engine = new PixelEngine(RuntimeConfig::FromEnvironment(true));
+    IntrusivePtr<ComputePrimitives> primitives = new ComputePrimitives(engine.get(), allowSubgroups);
+    if (allowSubgroups && !primitives->UsesSubgroups())
+    {
+        spdlog::warn("no subgroup arithmetic in compute, subgroup kernels skipped");
+        return true;
+    }
+
+    auto profiler = engine->GetRHIRuntime()->GetGPUProfiler();
+    profiler->SetEnabled(config.benchmark);
+
+    auto renderer = engine->CreateRenderer();
+    auto cases = buildCases(engine.get(), primitives.get(), config.count);
+    for (auto &c : cases)
+    {
+        c.task->AddTo(renderer);
+    }
+
+    // every frame repeats all tasks, their results do not change once the inputs are uploaded
+    uint32_t frames = config.benchmark ? config.frames : 2;
+    renderer->RegisterUpdateCallback({GENERAL, [renderer = renderer.get(), frames, frameCount = 0u](UpdateInput inputs) mutable
+                                      {
+                                          if (inputs.event.type == Event::FRAME && ++frameCount >= frames)
+                                          {
+                                              renderer->Stop();
+                                          }
+                                          return false;
+                                      }});
+
+    engine->Frame();
+
+    bool passed = true;
+    for (auto &c : cases)
+    {
+        if (config.benchmark)
+        {
+            GPUProfiler::Timing timing;
+            if (profiler->GetTiming(c.task->name, timing))
+            {
+                results.push_back({
+                    .primitive = c.name,
+                    .subgroups = primitives->UsesSubgroups(),
+                    .count = config.count,
+                    .avg = timing.avg,
+                    .min = timing.min,
+                    .elementsPerSecond = timing.avg > 0.0 ? config.count / (timing.avg / 1000.0) : 0.0});
+            }
+            continue;
+        }
+
+        bool ok = c.check();
+        passed &= ok;
+        if (ok)
+            spdlog::info("{} subgroups {}: ok", c.name, primitives->UsesSubgroups());
+        else
+            spdlog::error("{} subgroups {}: mismatch", c.name, primitives->UsesSubgroups());
+    }
+
+    cases.clear();
+    renderer.reset();
+    primitives.reset();
+    engine.reset();
+
+    return passed;
+}
+
+int main(int argc, char **argv)
+{
+    spdlog::set_level(spdlog::level::warn);
+
+    PrimitivesConfig config;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--benchmark")
+            config.benchmark = true;
+        else if (option == "--headless")
+            continue;
+        else if (option == "--count" && i + 1 < argc)
+            config.count = std::stoul(argv[++i]);
+        else if (option == "--frames" && i + 1 < argc)
+            config.frames = std::stoul(argv[++i]);
+        else if (option == "--output" && i + 1 < argc)
+            config.output = argv[++i];
+        else
+        {
+            std::cerr << "usage: ComputePrimitives [--headless] [--benchmark] [--count n] [--frames n] [--output file]" << std::endl;
+            return 1;
+        }
+    }
+
+    // the shared memory kernels, then the subgroup ones if the device has them
+    std::vector<PrimitiveResult> results;
+    bool passed = run(config, false, results);
+    passed &= run(config, true, results);
+
+    if (config.benchmark)
+    {
+        auto json = JS::serializeStruct(results);
+        std::ofstream(config.output) << json;
+        std::cout << json << std::endl;
+        return 0;
+    }
+
+    std::cout << (passed ? "all primitives match the cpu reference" : "compute primitives failed") << std::endl;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+#version 450
+
+layout (location = 0) in vec2 inUV;
+
+layout (location = 0) out vec4 outFragcolor;
+
+layout (binding = 0) readonly buffer Pixels
+{
+	uint pixels[];
+};
+
+layout (binding = 1) uniform Params
+{
+	uvec2 extent;
+} params;
+
+void main()
+{
+	// the traced image is stretched over the swapchain
+	uvec2 pixel = min(uvec2(inUV * vec2(params.extent)), params.extent - 1);
+	outFragcolor = unpackUnorm4x8(pixels[pixel.y * params.extent.x + pixel.x]);
+}
@@ -6,32 +6,274 @@
 #include <Engine/Camera.h>
 
 #include <Engine/ImguiOverlay.h>
+#include <Engine/BVH.h>
+
+#include <IO/GLTFReader.h>
+#include <IO/ImageWriter.h>
 
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
 #include <spdlog/spdlog.h>
+#include <json_struct/json_struct.h>
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+// resolution of the traced image, stretched over the swapchain
+static const glm::u32vec2 traceExtent = {1024, 768};
+
+// Params of raytrace.comp, std140
+struct TraceParams
+{
+    glm::u32vec2 extent;
+    uint32_t triangleCount;
+    float groundHeight;
+    glm::vec4 origin;
+    glm::vec4 forward;
+    glm::vec4 right;
+    glm::vec4 up;
+};
+
+// without --scene three tessellated spheres are traced, 3 * 2 * segments * segments / 2 triangles
+struct RayTracingConfig
+{
+    bool headless = false;
+    bool benchmark = false;
+    std::string scene;
+    uint32_t segments = 384;
+    uint32_t frames = 100;
+    std::string output = "compute_ray_tracing.json";
+};
+
+struct RayTracingResult
+{
+    std::string scene;
+    uint32_t triangles;
+    uint32_t nodes;
+
+    // cpu milliseconds
+    double buildTime;
+    double refitTime;
+
+    // gpu milliseconds of the raytrace pass
+    double traceAvg;
+    double traceMin;
+    // primary rays, one per pixel, shadow rays come on top
+    double raysPerSecond;
+
+    JS_OBJ(scene, triangles, nodes, buildTime, refitTime, traceAvg, traceMin, raysPerSecond);
+};
+
+struct Scene
+{
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices;
+    // packed albedo per triangle
+    std::vector<uint32_t> colors;
+};
 
-void CreatePresentDrawable(PixelEngine *engine, IntrusivePtr<Renderer> renderer, IntrusivePtr<Pipeline> pipeline)
+// read back with unpackUnorm4x8
+static uint32_t PackColor(glm::vec3 color)
+{
+    return glm::packUnorm4x8(glm::vec4(color, 1.0f));
+}
+
+static void AppendSphere(Scene &scene, glm::vec3 center, float radius, glm::vec3 albedo, uint32_t segments)
+{
+    uint32_t rings = std::max(segments / 2, 2u);
+    uint32_t first = scene.positions.size();
+    for (uint32_t ring = 0; ring <= rings; ring++)
+    {
+        float theta = glm::pi<float>() * ring / rings;
+        for (uint32_t segment = 0; segment <= segments; segment++)
+        {
+            float phi = glm::two_pi<float>() * segment / segments;
+            scene.positions.push_back(center + radius * glm::vec3(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)));
+        }
+    }
+
+    for (uint32_t ring = 0; ring < rings; ring++)
+    {
+        for (uint32_t segment = 0; segment < segments; segment++)
+        {
+            uint32_t a = first + ring * (segments + 1) + segment;
+            uint32_t b = a + segments + 1;
+            scene.indices.insert(scene.indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+            scene.colors.insert(scene.colors.end(), 2, PackColor(albedo));
+        }
+    }
+}
+
+// every model gets a color of its own
+static void AppendGLTF(Scene &scene, const std::vector<GLTFModel> &models)
+{
+    for (size_t m = 0; m < models.size(); m++)
+    {
+        auto &model = models[m];
+        uint32_t vertexOffset = scene.positions.size();
+        for (auto &vertex : model.vertexBuffer)
+        {
+            scene.positions.push_back(vertex.pos);
+        }
+
+        auto albedo = glm::vec3(0.35f) + 0.6f * glm::fract(glm::vec3(0.31f, 0.57f, 0.83f) * float(m + 1));
+        for (auto &primitive : model.primitives)
+        {
+            for (uint32_t i = 0; i < primitive.indexCount / 3 * 3; i++)
+            {
+                scene.indices.push_back(model.indexBuffer[primitive.firstIndex + i] + vertexOffset);
+            }
+            scene.colors.insert(scene.colors.end(), primitive.indexCount / 3, PackColor(albedo));
+        }
+    }
+}
+
+// looks at the scene from the front and above, the ground is put under it
+static TraceParams CreateParams(IntrusivePtr<BVH> bvh, bool procedural)
+{
+    glm::vec3 origin = {0.0f, 1.5f, -6.0f};
+    glm::vec3 forward = {0.0f, 0.0f, 1.0f};
+    float groundHeight = 0.0f;
+    if (!procedural)
+    {
+        auto center = (bvh->GetBoundsMin() + bvh->GetBoundsMax()) * 0.5f;
+        auto radius = glm::length(bvh->GetBoundsMax() - bvh->GetBoundsMin()) * 0.5f;
+        forward = glm::normalize(glm::vec3(0.0f, -0.3f, 1.0f));
+        origin = center - forward * radius * 2.2f;
+        groundHeight = bvh->GetBoundsMin().y;
+    }
+
+    auto right = glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), forward));
+    auto up = glm::cross(forward, right);
+    return {
+        .extent = traceExtent,
+        .triangleCount = uint32_t(bvh->GetTriangles().size()),
+        .groundHeight = groundHeight,
+        .origin = glm::vec4(origin, 1.0f),
+        // focal length 2
+        .forward = glm::vec4(forward * 2.0f, 0.0f),
+        .right = glm::vec4(right, 0.0f),
+        .up = glm::vec4(up, 0.0f)};
+}
+
+template <typename T>
+static IntrusivePtr<Buffer> CreateStorageBuffer(PixelEngine *engine, const std::vector<T> &data)
+{
+    auto buffer = engine->GetRHIRuntime()->CreateBuffer(Buffer::BUFFER_USAGE_STORAGE_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, data.size() * sizeof(T));
+    engine->GetAuxiliaryExecutor()->TransferResource(buffer, data.data(), data.size() * sizeof(T));
+    return buffer;
+}
+
+void CreateRayTracingDispatch(PixelEngine *engine, IntrusivePtr<Renderer> renderer, IntrusivePtr<Pipeline> pipeline, IntrusivePtr<Buffer> pixels, IntrusivePtr<Buffer> params, std::vector<IntrusivePtr<Buffer>> sceneBuffers)
+{
+    auto rhiRuntime = engine->GetRHIRuntime();
+    auto rbs = rhiRuntime->CreateResourceBindingState(pipeline);
+    rbs->Bind(0, 0, pixels);
+    rbs->Bind(0, 1, params);
+    // nodes, triangles, colors
+    for (uint32_t i = 0; i < sceneBuffers.size(); i++)
+    {
+        rbs->Bind(0, 2 + i, sceneBuffers[i]);
+    }
+
+    // one invocation per pixel
+    rbs->BindDispatchOp({ResourceBindingState::DispatchOP{
+        .type = ResourceBindingState::DispatchOP::RESOURCE_SIZE,
+        .resource = pixels,
+        .elementSize = sizeof(uint32_t)}});
+    rbs->name = "raytrace";
+
+    renderer->AddDrawState(rbs);
+}
+
+void CreatePresentDrawable(PixelEngine *engine, IntrusivePtr<Renderer> renderer, IntrusivePtr<Pipeline> pipeline, IntrusivePtr<Buffer> pixels, IntrusivePtr<Buffer> params)
 {
     auto rhiRuntime = engine->GetRHIRuntime();
     auto rbs = rhiRuntime->CreateResourceBindingState(pipeline);
+    rbs->Bind(0, 0, pixels);
+    rbs->Bind(0, 1, params);
 
     ResourceBindingState::DrawOP drawOP = {};
     drawOP.vertexCount = 3;
     drawOP.instanceCount = 1;
     rbs->BindDrawOp({drawOP});
+    rbs->name = "present";
 
     renderer->AddDrawState(rbs);
 }
 
-int main()
+int main(int argc, char **argv)
 {
     spdlog::set_level(spdlog::level::debug);
 
-    auto graph = Graph::ParseRenderPassJson("C:/Users/Mario/Desktop/Pixel/Examples/ComputeRayTracing/ComputeRayTracing.json");
+    // --headless renders a few frames offscreen and exits
+    // --benchmark also times the bvh build and the traversal and writes them to --output
+    RayTracingConfig config;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--headless")
+            config.headless = true;
+        else if (option == "--benchmark")
+            config.headless = config.benchmark = true;
+        else if (option == "--scene" && i + 1 < argc)
+            config.scene = argv[++i];
+        else if (option == "--segments" && i + 1 < argc)
+            config.segments = std::max(std::stoul(argv[++i]), 3ul);
+        else if (option == "--frames" && i + 1 < argc)
+            config.frames = std::stoul(argv[++i]);
+        else if (option == "--output" && i + 1 < argc)
+            config.output = argv[++i];
+        else
+        {
+            std::cerr << "usage: ComputeRayTracing [--headless] [--benchmark] [--scene file.gltf] [--segments n] [--frames n] [--output file]" << std::endl;
+            return 1;
+        }
+    }
+    bool headless = config.headless;
+
+    auto graph = Graph::ParseRenderPassJson("ComputeRayTracing.json");
+
+    IntrusivePtr<PixelEngine> engine = new PixelEngine(headless);
+
+    Scene scene;
+    if (config.scene.empty())
+    {
+        AppendSphere(scene, {0.0f, 1.0f, 0.0f}, 1.0f, {0.9f, 0.2f, 0.2f}, config.segments);
+        AppendSphere(scene, {-2.2f, 0.7f, 0.8f}, 0.7f, {0.2f, 0.8f, 0.3f}, config.segments);
+        AppendSphere(scene, {2.0f, 0.5f, 1.2f}, 0.5f, {0.2f, 0.4f, 0.9f}, config.segments);
+    }
+    else
+    {
+        AppendGLTF(scene, GLTFReader::ReadFile(engine.get(), config.scene));
+        if (scene.indices.empty())
+        {
+            spdlog::error("no triangles in {}", config.scene);
+            return 1;
+        }
+    }
+
+    IntrusivePtr<BVH> bvh = new BVH;
+    auto buildStart = std::chrono::steady_clock::now();
+    bvh->Build(scene.positions, scene.indices);
+    auto refitStart = std::chrono::steady_clock::now();
+    // same positions, only times the refit of animated geometry
+    bvh->Refit(scene.positions);
+    auto refitEnd = std::chrono::steady_clock::now();
+
+    RayTracingResult result = {
+        .scene = config.scene.empty() ? "spheres" : config.scene,
+        .triangles = uint32_t(bvh->GetTriangles().size()),
+        .nodes = uint32_t(bvh->GetNodes().size()),
+        .buildTime = std::chrono::duration<double, std::milli>(refitStart - buildStart).count(),
+        .refitTime = std::chrono::duration<double, std::milli>(refitEnd - refitStart).count()};
+    spdlog::info("{} triangles, {} nodes, build {:.1f}ms, refit {:.1f}ms", result.triangles, result.nodes, result.buildTime, result.refitTime);
 
-    IntrusivePtr<PixelEngine> engine = new PixelEngine;
     auto renderGroup = engine->RegisterRenderGroup(graph);
-    auto computePipeline = renderGroup->CreatePipeline("compute 0", ComputePipelineStates{});
+    // tuned when PIXEL_WORKGROUP_TUNING is set, every pixel is rewritten from the scene
+    auto computePipeline = renderGroup->CreatePipeline("raytrace", ComputePipelineStates{.autotune = true, .idempotent = true});
 
     auto &rhiRuntime = engine->GetRHIRuntime();
     auto renderer = engine->CreateRenderer();
@@ -45,16 +287,71 @@ int main()
     PipelineStates presentPipelineStates = {
         .inputAssembleState = {.type = InputAssembleState::Type::TRIANGLE_LIST},
         .rasterizationState = {.polygonMode = RasterizationState::PolygonModeType::FILL, .cullMode = RasterizationState::CullModeType::NONE, .frontFace = RasterizationState::FrontFaceType::COUNTER_CLOCKWISE, .lineWidth = 1.0f},
-        .depthStencilState = {.depthTestEnable = true, .depthWriteEnable = true}};
+        .depthStencilState = {.depthTestEnable = false, .depthWriteEnable = false}};
 
     auto presentPipeline = renderGroup->CreatePipeline("present", presentPipelineStates);
 
-    CreatePresentDrawable(engine.get(), renderer, presentPipeline);
+    // written by the compute pass, read by the present pass
+    auto pixels = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_STORAGE_BUFFER_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, traceExtent.x * traceExtent.y * sizeof(uint32_t));
+    auto params = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_UNIFORM_BUFFER_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, sizeof(TraceParams));
+    auto traceParams = CreateParams(bvh, config.scene.empty());
+    memcpy(params->Map(), &traceParams, sizeof(traceParams));
+
+    std::vector<IntrusivePtr<Buffer>> sceneBuffers = {
+        CreateStorageBuffer(engine.get(), bvh->GetNodes()),
+        CreateStorageBuffer(engine.get(), bvh->GetTriangles()),
+        CreateStorageBuffer(engine.get(), scene.colors)};
+
+    CreateRayTracingDispatch(engine.get(), renderer, computePipeline, pixels, params, sceneBuffers);
+    CreatePresentDrawable(engine.get(), renderer, presentPipeline, pixels, params);
+
+    auto profiler = rhiRuntime->GetGPUProfiler();
+    profiler->SetEnabled(config.benchmark);
+
+    uint32_t lastImageIndex = 0;
+    if (headless)
+    {
+        uint32_t frames = config.benchmark ? config.frames : 3;
+        renderer->RegisterUpdateCallback({GENERAL, [renderer = renderer.get(), &lastImageIndex, frames, frameCount = 0u](UpdateInput inputs) mutable
+                                          {
+                                              if (inputs.event.type == Event::FRAME && ++frameCount >= frames)
+                                              {
+                                                  lastImageIndex = inputs.currentImageIndex;
+                                                  renderer->Stop();
+                                              }
+                                              return false;
+                                          }});
+    }
 
     engine->Frame();
 
+    if (headless)
+    {
+        auto readback = engine->GetAuxiliaryExecutor()->ReadbackResource(renderer->GetSwapChain()->GetTexture(lastImageIndex));
+        ImageWriter::WriteFile(readback, "compute_ray_tracing.png");
+    }
+
+    if (config.benchmark)
+    {
+        GPUProfiler::Timing timing;
+        if (profiler->GetTiming("ComputeRayTracing::raytrace::raytrace", timing))
+        {
+            result.traceAvg = timing.avg;
+            result.traceMin = timing.min;
+            result.raysPerSecond = timing.avg > 0.0 ? traceExtent.x * traceExtent.y / (timing.avg / 1000.0) : 0.0;
+        }
+        else
+        {
+            spdlog::warn("no gpu timing of the raytrace pass");
+        }
+
+        auto json = JS::serializeStruct(result);
+        std::ofstream(config.output) << json;
+        std::cout << json << std::endl;
+    }
+
     renderer.reset();
     engine.reset();
 
     return 0;
-}
\ No newline at end of file
+}
@@ -1,10 +0,0 @@
-#version 450
-
-layout (location = 0) in vec2 inUV;
-
-layout (location = 0) out vec4 outFragcolor;
-
-void main() 
-{
-  outFragcolor = vec4(1.0, 1.0, 1.0, 1.0);	
-}
\ No newline at end of file
@@ -0,0 +1,310 @@
+#include <RHI/RuntimeEntry.h>
+
+#include <Engine/PixelEngine.h>
+#include <Engine/Renderer.h>
+#include <Engine/Camera.h>
+#include <Engine/GPUCulling.h>
+#include <Engine/Frustum.h>
+
+#include <IO/GLTFReader.h>
+#include <IO/ImageWriter.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+#include <json_struct/json_struct.h>
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+// headless runs move the camera by a fixed delta so that they do not depend on the frame rate
+static constexpr float FIXED_DELTA_TIME = 1.0f / 60.0f;
+
+// distance between the centers of neighbouring blocks, streets run between them
+static constexpr float BLOCK_SPACING = 6.0f;
+
+struct CullingConfig
+{
+    bool headless = false;
+    bool benchmark = false;
+    bool occlusion = true;
+    // GPUCullingConfig::cpuCulling
+    bool cpu = false;
+    // blocks per side of the city
+    uint32_t grid = 128;
+    uint32_t frames = 300;
+    std::string output = "culling.json";
+};
+
+struct PassResult
+{
+    std::string pass;
+    // gpu milliseconds
+    double avg;
+    double min;
+
+    JS_OBJ(pass, avg, min);
+};
+
+struct CullingResult
+{
+    bool occlusion;
+    bool cpu;
+    uint32_t draws;
+    uint32_t frames;
+    // read back after the last frame
+    uint32_t visibleCount;
+    uint32_t frustumCulled;
+    uint32_t occlusionCulled;
+    // boxes inside the frustum of the last frame on the cpu
+    uint32_t cpuFrustumVisible;
+
+    // sum of the pass averages
+    double frameAvg;
+    std::vector<PassResult> passes;
+
+    JS_OBJ(occlusion, cpu, draws, frames, visibleCount, frustumCulled, occlusionCulled, cpuFrustumVisible, frameAvg, passes);
+};
+
+// unit box standing on the origin, 4 vertices per face
+static GLTFModel CreateBox()
+{
+    GLTFModel model;
+    for (int axis = 0; axis < 3; axis++)
+    {
+        for (float side : {-1.0f, 1.0f})
+        {
+            glm::vec3 normal(0.0f);
+            normal[axis] = side;
+            glm::vec3 u(0.0f), v(0.0f);
+            u[(axis + 1) % 3] = 1.0f;
+            v[(axis + 2) % 3] = 1.0f;
+
+            auto first = uint32_t(model.vertexBuffer.size());
+            for (int corner = 0; corner < 4; corner++)
+            {
+                glm::vec3 offset = normal * 0.5f + u * ((corner & 1) ? 0.5f : -0.5f) + v * ((corner & 2) ? 0.5f : -0.5f);
+
+                GLTFVertex vertex = {};
+                vertex.pos = offset + glm::vec3(0.0f, 0.5f, 0.0f);
+                vertex.normal = normal;
+                vertex.uv = {float(corner & 1), float(corner >> 1)};
+                vertex.tangent = glm::vec4(u, 1.0f);
+                model.vertexBuffer.push_back(vertex);
+            }
+            model.indexBuffer.insert(model.indexBuffer.end(), {first, first + 1, first + 3, first, first + 3, first + 2});
+        }
+    }
+
+    model.primitives.push_back({
+        .firstVertex = 0,
+        .vertexCount = uint32_t(model.vertexBuffer.size()),
+        .firstIndex = 0,
+        .indexCount = uint32_t(model.indexBuffer.size()),
+        .boundsMin = glm::vec3(-0.5f, 0.0f, -0.5f),
+        .boundsMax = glm::vec3(0.5f, 1.0f, 0.5f)});
+    return model;
+}
+
+// grid x grid blocks of buildings on a ground plate, the streets hide most of the city from the street level
+static void CreateCity(IntrusivePtr<GPUCulling> culling, uint32_t grid)
+{
+    auto box = culling->AddMesh(CreateBox());
+
+    float extent = grid * BLOCK_SPACING;
+    culling->AddDraw(box, glm::scale(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -0.1f, 0.0f)), glm::vec3(extent, 0.1f, extent)));
+
+    std::mt19937 random(7);
+    std::uniform_real_distribution<float> height(3.0f, 24.0f);
+    std::uniform_real_distribution<float> width(1.2f, 2.0f);
+    for (uint32_t z = 0; z < grid; z++)
+    {
+        for (uint32_t x = 0; x < grid; x++)
+        {
+            glm::vec3 blockCenter = glm::vec3((x + 0.5f) * BLOCK_SPACING - extent * 0.5f, 0.0f, (z + 0.5f) * BLOCK_SPACING - extent * 0.5f);
+            // four buildings per block
+            for (uint32_t i = 0; i < 4; i++)
+            {
+                glm::vec3 offset = glm::vec3((i & 1) ? 1.0f : -1.0f, 0.0f, (i & 2) ? 1.0f : -1.0f);
+                float buildingWidth = width(random);
+                auto model = glm::translate(glm::mat4(1.0f), blockCenter + offset);
+                culling->AddDraw(box, glm::scale(model, glm::vec3(buildingWidth, height(random), buildingWidth)));
+            }
+        }
+    }
+}
+
+// walks along the street crossing the city center, looking ahead
+static glm::mat4 StreetView(float time, uint32_t grid)
+{
+    float extent = grid * BLOCK_SPACING;
+    float x = std::fmod(time * 8.0f, extent) - extent * 0.5f;
+    glm::vec3 eye = glm::vec3(x, 1.7f, 0.0f);
+    glm::vec3 forward = glm::vec3(std::cos(time * 0.2f), 0.0f, std::sin(time * 0.2f) * 0.3f);
+    return glm::lookAt(eye, eye + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+}
+
+// same test as cull.comp, one box at a time
+static uint32_t CountFrustumVisible(IntrusivePtr<GPUCulling> culling, const glm::mat4 &viewProjection)
+{
+    auto frustum = Frustum::FromViewProjection(viewProjection);
+
+    uint32_t visible = 0;
+    for (auto &draw : culling->GetDraws())
+    {
+        glm::vec3 center = glm::vec3(draw.model * glm::vec4((glm::vec3(draw.boundsMin) + glm::vec3(draw.boundsMax)) * 0.5f, 1.0f));
+        glm::mat3 absolute = glm::mat3(draw.model);
+        for (int i = 0; i < 3; i++)
+            absolute[i] = glm::abs(absolute[i]);
+        glm::vec3 extent = absolute * ((glm::vec3(draw.boundsMax) - glm::vec3(draw.boundsMin)) * 0.5f);
+        visible += frustum.Intersects(center, extent);
+    }
+    return visible;
+}
+
+int main(int argc, char **argv)
+{
+    spdlog::set_level(spdlog::level::debug);
+
+    // --headless walks through the city offscreen and exits
+    // --benchmark also reports the culled counts and the gpu time of every culling pass to --output
+    CullingConfig config;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--headless")
+            config.headless = true;
+        else if (option == "--benchmark")
+            config.headless = config.benchmark = true;
+        else if (option == "--no-occlusion")
+            config.occlusion = false;
+        else if (option == "--cpu")
+            config.cpu = true;
+        else if (option == "--grid" && i + 1 < argc)
+            config.grid = std::max(std::stoul(argv[++i]), 1ul);
+        else if (option == "--frames" && i + 1 < argc)
+            config.frames = std::max(std::stoul(argv[++i]), 2ul);
+        else if (option == "--output" && i + 1 < argc)
+            config.output = argv[++i];
+        else
+        {
+            std::cerr << "usage: Culling [--headless] [--benchmark] [--no-occlusion] [--cpu] [--grid n] [--frames n] [--output file]" << std::endl;
+            return 1;
+        }
+    }
+    bool headless = config.headless;
+
+    IntrusivePtr<PixelEngine> engine = new PixelEngine(headless);
+    auto &rhiRuntime = engine->GetRHIRuntime();
+    auto renderer = engine->CreateRenderer();
+
+    IntrusivePtr<GPUCulling> culling = new GPUCulling(engine.get(), {.occlusion = config.occlusion && !config.cpu, .cpuCulling = config.cpu});
+    CreateCity(culling, config.grid);
+    culling->AddTo(renderer);
+
+    auto camera = renderer->GetCamera();
+    camera->setPerspective(60.0f, 1024.0f / 768.0f, 0.1f, 400.0f);
+
+    auto profiler = rhiRuntime->GetGPUProfiler();
+    profiler->SetEnabled(config.benchmark);
+
+    int status = 0;
+    uint32_t lastImageIndex = 0;
+    glm::mat4 lastViewProjection = glm::mat4(1.0f);
+    uint32_t frames = headless ? config.frames : 0;
+    renderer->RegisterUpdateCallback({GENERAL, [renderer = renderer.get(), culling = culling.get(), camera, &lastImageIndex, &lastViewProjection, headless, frames, grid = config.grid, frameCount = 0u, time = 0.0f](UpdateInput inputs) mutable
+                                      {
+                                          if (inputs.event.type != Event::FRAME)
+                                              return false;
+
+                                          time += headless ? FIXED_DELTA_TIME : inputs.deltaTime / 1000.0f;
+
+                                          auto view = StreetView(time, grid);
+                                          culling->Update(view, camera->matrices.perspective);
+                                          lastViewProjection = camera->matrices.perspective * view;
+
+                                          if (headless && ++frameCount >= frames)
+                                          {
+                                              lastImageIndex = inputs.currentImageIndex;
+                                              renderer->Stop();
+                                          }
+                                          return false;
+                                      }});
+
+    engine->Frame();
+
+    if (headless)
+    {
+        // the device may have turned occlusion or gpu culling off
+        auto &cullingConfig = culling->GetConfig();
+
+        auto readback = engine->GetAuxiliaryExecutor()->ReadbackResource(renderer->GetSwapChain()->GetTexture(lastImageIndex));
+        ImageWriter::WriteFile(readback, "culling.png");
+
+        CullingResult result = {
+            .occlusion = cullingConfig.occlusion,
+            .cpu = cullingConfig.cpuCulling,
+            .draws = culling->GetDrawCount(),
+            .frames = config.frames,
+            .cpuFrustumVisible = CountFrustumVisible(culling, lastViewProjection)};
+
+        // the counters are not written when culling on the cpu
+        if (cullingConfig.cpuCulling)
+        {
+            result.visibleCount = uint32_t(culling->GetVisibleDraws().size());
+            result.frustumCulled = result.draws - result.visibleCount;
+            result.occlusionCulled = 0;
+        }
+        else
+        {
+            auto countersReadback = engine->GetAuxiliaryExecutor()->ReadbackResource(culling->GetCounterBuffer());
+            auto counters = static_cast<const GPUCulling::Counters *>(countersReadback->Data());
+            result.visibleCount = counters->visibleCount;
+            result.frustumCulled = counters->frustumCulled;
+            result.occlusionCulled = counters->occlusionCulled;
+        }
+
+        // every draw is either drawn or culled once
+        if (result.visibleCount + result.frustumCulled + result.occlusionCulled != result.draws)
+        {
+            spdlog::error("draws lost: {} visible, {} outside, {} occluded of {}", result.visibleCount, result.frustumCulled, result.occlusionCulled, result.draws);
+            status = 1;
+        }
+        // boxes touching a plane may land on either side
+        uint32_t frustumVisible = result.draws - result.frustumCulled;
+        if (std::abs(int64_t(frustumVisible) - int64_t(result.cpuFrustumVisible)) > int64_t(result.draws / 1000 + 1))
+        {
+            spdlog::error("frustum test differs: {} inside when culling, {} box by box", frustumVisible, result.cpuFrustumVisible);
+            status = 1;
+        }
+
+        if (config.benchmark)
+        {
+            for (auto pass : {"cull_reset", "cull", "cull_draw", "hiz_copy", "hiz_reduce"})
+            {
+                GPUProfiler::Timing timing;
+                // hiz passes are only there with occlusion, cull_reset and cull only on the gpu
+                if (!profiler->GetTiming(culling->GetName() + "::" + pass + "::" + pass, timing))
+                    continue;
+                result.passes.push_back({.pass = pass, .avg = timing.avg, .min = timing.min});
+                result.frameAvg += timing.avg;
+            }
+
+            auto json = JS::serializeStruct(result);
+            std::ofstream(config.output) << json;
+            std::cout << json << std::endl;
+        }
+        else
+        {
+            spdlog::info("{} of {} draws visible, {} outside the frustum, {} occluded", result.visibleCount, result.draws, result.frustumCulled, result.occlusionCulled);
+        }
+    }
+
+    culling.reset();
+    renderer.reset();
+    engine.reset();
+
+    return status;
+}
@@ -44,16 +44,10 @@ void CreateTextureDrawable(PixelEngine *engine, IntrusivePtr<Renderer> renderer,
         uint32_t vertexBufferSize = model.vertexBuffer.size() * sizeof(GLTFVertex);
         uint32_t indexBufferSize = model.indexBuffer.size() * sizeof(uint32_t);
 
-        auto vBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, vertexBufferSize);
-        memcpy(vBuffer->Map(), model.vertexBuffer.data(), vertexBufferSize);
-        auto iBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, indexBufferSize);
-        memcpy(iBuffer->Map(), model.indexBuffer.data(), indexBufferSize);
         auto vBufferGPU = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_VERTEX_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBufferSize);
         auto iBufferGPU = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_INDEX_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBufferSize);
-        engine->GetAuxiliaryExecutor()->TransferResource(vBufferGPU, vBuffer);
-        engine->GetAuxiliaryExecutor()->TransferResource(iBufferGPU, iBuffer);
-        vBuffer.reset();
-        iBuffer.reset();
+        engine->GetAuxiliaryExecutor()->TransferResource(vBufferGPU, model.vertexBuffer.data(), vertexBufferSize);
+        engine->GetAuxiliaryExecutor()->TransferResource(iBufferGPU, model.indexBuffer.data(), indexBufferSize);
 
         spdlog::info("colorTexture");
         auto colorTexture = KTXReader::ReadFile(engine, "C:/Users/Mario/Desktop/Pixel/Examples/Deferred/assets/colormap_rgba.ktx");
@@ -64,8 +58,8 @@ void CreateTextureDrawable(PixelEngine *engine, IntrusivePtr<Renderer> renderer,
 
         TextureUBO textureUBO = {
             .model = glm::mat4(1.5f)};
-        auto uBuffer = rhiRuntime->CreateMutableBuffer(Buffer::BUFFER_USAGE_UNIFORM_BUFFER_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, sizeof(TextureUBO));
-        memcpy(uBuffer->GetBuffer(0)->Map(), &textureUBO, sizeof(textureUBO));
+        auto uBuffer = rhiRuntime->CreateDynamicBuffer(sizeof(TextureUBO));
+        memcpy(uBuffer->Map(), &textureUBO, sizeof(textureUBO));
 
         auto rbs = rhiRuntime->CreateResourceBindingState(pipeline);
         rbs->Bind(0, 0, camera->GetUBOBuffer());
@@ -143,9 +137,9 @@ void CreateComposeDrawable(PixelEngine *engine, IntrusivePtr<Renderer> renderer,
     lightsUBO.viewPos = glm::vec4(renderer->GetCamera()->position, 0.0f) * glm::vec4(-1.0f, 1.0f, -1.0f, 1.0f);
 
     auto siz = sizeof(LightsUBO);
-    auto uBuffer = rhiRuntime->CreateMutableBuffer(Buffer::BUFFER_USAGE_UNIFORM_BUFFER_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, sizeof(LightsUBO));
+    auto uBuffer = rhiRuntime->CreateDynamicBuffer(sizeof(LightsUBO));
 
-    memcpy(uBuffer->GetBuffer(0)->Map(), &lightsUBO, sizeof(lightsUBO));
+    memcpy(uBuffer->Map(), &lightsUBO, sizeof(lightsUBO));
 
     rbs->Bind(0, 0, uBuffer);
     ResourceBindingState::DrawOP drawOP = {};
@@ -157,7 +151,7 @@ void CreateComposeDrawable(PixelEngine *engine, IntrusivePtr<Renderer> renderer,
         .priority = GENERAL,
         .callback = [uBuffer, camera = renderer->GetCamera()](UpdateInput input)
         {
-            auto ubo = (LightsUBO *)uBuffer->GetBuffer(input.currentImageIndex)->Map();
+            auto ubo = (LightsUBO *)uBuffer->Map();
             ubo->viewPos = camera->viewPos;
             return false;
         }};
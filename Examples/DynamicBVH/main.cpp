@@ -0,0 +1,460 @@
+#include <Engine/DynamicBVH.h>
+#include <Engine/Frustum.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+#include <json_struct/json_struct.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+// the default run moves objects through the tree, validates it and checks every query against a brute force list
+// --benchmark reports the cost of every operation at each object count instead, no gpu is needed
+struct DynamicBVHConfig
+{
+    bool benchmark = false;
+    std::vector<uint32_t> counts = {10000, 100000, 1000000};
+    // per query type
+    uint32_t queries = 1000;
+    // frames of motion before the rebuild
+    uint32_t frames = 10;
+    std::string output = "dynamic_bvh.json";
+};
+
+// microseconds per call, bruteForce is 0 where a list needs no work
+struct OperationResult
+{
+    std::string operation;
+    double bvh;
+    double bruteForce;
+
+    JS_OBJ(operation, bvh, bruteForce);
+};
+
+struct CountResult
+{
+    uint32_t count;
+    // moves that left their fat box and went through the tree
+    double movedFraction;
+    // milliseconds
+    double rebuildTime;
+    uint32_t height;
+    float areaRatio;
+    uint32_t rebuiltHeight;
+    float rebuiltAreaRatio;
+    std::vector<OperationResult> operations;
+
+    JS_OBJ(count, movedFraction, rebuildTime, height, areaRatio, rebuiltHeight, rebuiltAreaRatio, operations);
+};
+
+struct SceneObject
+{
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+    glm::vec3 velocity;
+    int32_t proxy;
+};
+
+// boxes of 0.5 to 4 in a cube keeping the density of 1 object per 64 cubic units
+static std::vector<SceneObject> CreateObjects(uint32_t count, float &sceneSize)
+{
+    sceneSize = 4.0f * std::cbrt(float(count));
+
+    std::mt19937 random(11);
+    std::uniform_real_distribution<float> position(-sceneSize * 0.5f, sceneSize * 0.5f);
+    std::uniform_real_distribution<float> size(0.5f, 4.0f);
+    std::uniform_real_distribution<float> speed(-1.0f, 1.0f);
+
+    std::vector<SceneObject> objects(count);
+    for (auto &object : objects)
+    {
+        glm::vec3 center = glm::vec3(position(random), position(random), position(random));
+        glm::vec3 extent = glm::vec3(size(random), size(random), size(random)) * 0.5f;
+        object.boundsMin = center - extent;
+        object.boundsMax = center + extent;
+        // a third of the scene moves, a walking pace at 60 fps
+        object.velocity = random() % 3 ? glm::vec3(0.0f) : glm::vec3(speed(random), speed(random) * 0.1f, speed(random)) * (2.0f / 60.0f);
+    }
+    return objects;
+}
+
+// every query of the run draws its parameters from the same sequence for the tree and the list
+struct QueryGenerator
+{
+    std::mt19937 random;
+    float sceneSize;
+
+    Frustum NextFrustum()
+    {
+        std::uniform_real_distribution<float> unit(-0.5f, 0.5f);
+        glm::vec3 eye = glm::vec3(unit(random), unit(random) * 0.1f, unit(random)) * sceneSize;
+        glm::vec3 forward = glm::vec3(unit(random), unit(random) * 0.2f, unit(random));
+        auto view = glm::lookAt(eye, eye + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+        auto projection = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f);
+        return Frustum::FromViewProjection(projection * view);
+    }
+
+    // picking ray from a point of the scene in a random direction
+    void NextRay(glm::vec3 &origin, glm::vec3 &direction)
+    {
+        std::uniform_real_distribution<float> unit(-0.5f, 0.5f);
+        origin = glm::vec3(unit(random), unit(random), unit(random)) * sceneSize;
+        direction = glm::normalize(glm::vec3(unit(random), unit(random), unit(random)) + glm::vec3(1e-3f));
+    }
+
+    // point light range
+    void NextSphere(glm::vec3 &center, float &radius)
+    {
+        std::uniform_real_distribution<float> unit(-0.5f, 0.5f);
+        center = glm::vec3(unit(random), unit(random), unit(random)) * sceneSize;
+        radius = 4.0f + (unit(random) + 0.5f) * 12.0f;
+    }
+
+    // bounds of a spot light or a light probe volume
+    void NextBox(glm::vec3 &boundsMin, glm::vec3 &boundsMax)
+    {
+        std::uniform_real_distribution<float> unit(-0.5f, 0.5f);
+        glm::vec3 center = glm::vec3(unit(random), unit(random), unit(random)) * sceneSize;
+        glm::vec3 extent = glm::vec3(unit(random), unit(random), unit(random)) * 6.0f + glm::vec3(5.0f);
+        boundsMin = center - extent;
+        boundsMax = center + extent;
+    }
+};
+
+static constexpr float RAY_DISTANCE = 1000.0f;
+
+static void BruteForceFrustum(const std::vector<SceneObject> &objects, const Frustum &frustum, std::vector<uint32_t> &result)
+{
+    result.clear();
+    for (uint32_t i = 0; i < objects.size(); i++)
+    {
+        if (frustum.Intersects((objects[i].boundsMin + objects[i].boundsMax) * 0.5f, (objects[i].boundsMax - objects[i].boundsMin) * 0.5f))
+            result.push_back(i);
+    }
+}
+
+static void BruteForceSphere(const std::vector<SceneObject> &objects, const glm::vec3 &center, float radius, std::vector<uint32_t> &result)
+{
+    result.clear();
+    for (uint32_t i = 0; i < objects.size(); i++)
+    {
+        glm::vec3 offset = glm::clamp(center, objects[i].boundsMin, objects[i].boundsMax) - center;
+        if (glm::dot(offset, offset) <= radius * radius)
+            result.push_back(i);
+    }
+}
+
+// touching boxes overlap, same test as DynamicBVH::QueryOverlap
+static void BruteForceOverlap(const std::vector<SceneObject> &objects, const glm::vec3 &boundsMin, const glm::vec3 &boundsMax, std::vector<uint32_t> &result)
+{
+    result.clear();
+    for (uint32_t i = 0; i < objects.size(); i++)
+    {
+        if (!glm::any(glm::greaterThan(objects[i].boundsMin, boundsMax)) && !glm::any(glm::lessThan(objects[i].boundsMax, boundsMin)))
+            result.push_back(i);
+    }
+}
+
+// closest entry distance, negative if nothing is hit
+static float BruteForceRay(const std::vector<SceneObject> &objects, const glm::vec3 &origin, const glm::vec3 &direction)
+{
+    glm::vec3 inverseDirection = 1.0f / direction;
+    float closest = RAY_DISTANCE;
+    bool found = false;
+    for (auto &object : objects)
+    {
+        glm::vec3 t0 = (object.boundsMin - origin) * inverseDirection;
+        glm::vec3 t1 = (object.boundsMax - origin) * inverseDirection;
+        glm::vec3 tMin = glm::min(t0, t1);
+        glm::vec3 tMax = glm::max(t0, t1);
+        float enter = std::max(std::max(tMin.x, tMin.y), std::max(tMin.z, 0.0f));
+        float exit = std::min(std::min(tMax.x, tMax.y), std::min(tMax.z, closest));
+        if (enter <= exit)
+        {
+            closest = enter;
+            found = true;
+        }
+    }
+    return found ? closest : -1.0f;
+}
+
+// moves every moving object one frame, returns the moves that went through the tree
+static uint32_t MoveObjects(IntrusivePtr<DynamicBVH> tree, std::vector<SceneObject> &objects, float sceneSize)
+{
+    uint32_t moved = 0;
+    for (auto &object : objects)
+    {
+        if (object.velocity == glm::vec3(0.0f))
+            continue;
+
+        // bounce off the scene bounds
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (object.boundsMin[axis] < -sceneSize * 0.5f || object.boundsMax[axis] > sceneSize * 0.5f)
+                object.velocity[axis] = object.boundsMin[axis] < -sceneSize * 0.5f ? std::abs(object.velocity[axis]) : -std::abs(object.velocity[axis]);
+        }
+        object.boundsMin += object.velocity;
+        object.boundsMax += object.velocity;
+        moved += tree->Move(object.proxy, object.boundsMin, object.boundsMax, object.velocity * 4.0f);
+    }
+    return moved;
+}
+
+using Clock = std::chrono::steady_clock;
+
+static double Microseconds(Clock::time_point start, uint64_t operations)
+{
+    return std::chrono::duration<double, std::micro>(Clock::now() - start).count() / std::max(operations, uint64_t(1));
+}
+
+static CountResult Benchmark(uint32_t count, const DynamicBVHConfig &config)
+{
+    float sceneSize;
+    auto objects = CreateObjects(count, sceneSize);
+    IntrusivePtr<DynamicBVH> tree = new DynamicBVH();
+
+    CountResult result = {.count = count};
+
+    auto start = Clock::now();
+    for (uint32_t i = 0; i < count; i++)
+    {
+        objects[i].proxy = tree->Insert(objects[i].boundsMin, objects[i].boundsMax, i);
+    }
+    result.operations.push_back({.operation = "insert", .bvh = Microseconds(start, count)});
+
+    uint64_t moves = 0;
+    uint64_t moved = 0;
+    start = Clock::now();
+    for (uint32_t frame = 0; frame < config.frames; frame++)
+    {
+        moved += MoveObjects(tree, objects, sceneSize);
+    }
+    for (auto &object : objects)
+    {
+        moves += object.velocity != glm::vec3(0.0f);
+    }
+    moves *= config.frames;
+    result.operations.push_back({.operation = "move", .bvh = Microseconds(start, moves)});
+    result.movedFraction = double(moved) / std::max(moves, uint64_t(1));
+
+    result.height = tree->GetHeight();
+    result.areaRatio = tree->GetAreaRatio();
+    start = Clock::now();
+    tree->Rebuild();
+    result.rebuildTime = Microseconds(start, 1) / 1000.0;
+    result.rebuiltHeight = tree->GetHeight();
+    result.rebuiltAreaRatio = tree->GetAreaRatio();
+
+    // the list scans every object per query, fewer of them keep the large counts short
+    uint32_t bruteForceQueries = std::max(config.queries * 10000 / count, 1u);
+    std::vector<uint32_t> visible;
+
+    auto measure = [&](const char *operation, auto bvhQuery, auto bruteForceQuery)
+    {
+        QueryGenerator generator = {std::mt19937(5), sceneSize};
+        auto queryStart = Clock::now();
+        for (uint32_t i = 0; i < config.queries; i++)
+        {
+            bvhQuery(generator);
+        }
+        double bvh = Microseconds(queryStart, config.queries);
+
+        generator = {std::mt19937(5), sceneSize};
+        queryStart = Clock::now();
+        for (uint32_t i = 0; i < bruteForceQueries; i++)
+        {
+            bruteForceQuery(generator);
+        }
+        result.operations.push_back({.operation = operation, .bvh = bvh, .bruteForce = Microseconds(queryStart, bruteForceQueries)});
+    };
+
+    measure(
+        "frustum", [&](QueryGenerator &generator)
+        { tree->QueryFrustum(generator.NextFrustum(), visible); },
+        [&](QueryGenerator &generator)
+        { BruteForceFrustum(objects, generator.NextFrustum(), visible); });
+
+    measure(
+        "ray", [&](QueryGenerator &generator)
+        {
+            glm::vec3 origin, direction;
+            generator.NextRay(origin, direction);
+            DynamicBVH::RayHit hit;
+            tree->RayCast(origin, direction, RAY_DISTANCE, hit); },
+        [&](QueryGenerator &generator)
+        {
+            glm::vec3 origin, direction;
+            generator.NextRay(origin, direction);
+            BruteForceRay(objects, origin, direction); });
+
+    measure(
+        "sphere", [&](QueryGenerator &generator)
+        {
+            glm::vec3 center;
+            float radius;
+            generator.NextSphere(center, radius);
+            tree->QuerySphere(center, radius, visible); },
+        [&](QueryGenerator &generator)
+        {
+            glm::vec3 center;
+            float radius;
+            generator.NextSphere(center, radius);
+            BruteForceSphere(objects, center, radius, visible); });
+
+    measure(
+        "box", [&](QueryGenerator &generator)
+        {
+            glm::vec3 boundsMin, boundsMax;
+            generator.NextBox(boundsMin, boundsMax);
+            tree->QueryOverlap(boundsMin, boundsMax, visible); },
+        [&](QueryGenerator &generator)
+        {
+            glm::vec3 boundsMin, boundsMax;
+            generator.NextBox(boundsMin, boundsMax);
+            BruteForceOverlap(objects, boundsMin, boundsMax, visible); });
+
+    start = Clock::now();
+    for (auto &object : objects)
+    {
+        tree->Remove(object.proxy);
+    }
+    result.operations.push_back({.operation = "remove", .bvh = Microseconds(start, count)});
+
+    return result;
+}
+
+// queries of the tree against the list after inserts, removes, moves and a rebuild, returns the mismatches
+static uint32_t Check(uint32_t count, const DynamicBVHConfig &config)
+{
+    float sceneSize;
+    auto objects = CreateObjects(count, sceneSize);
+    IntrusivePtr<DynamicBVH> tree = new DynamicBVH();
+
+    // every third object goes in after the others moved
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (i % 3)
+            objects[i].proxy = tree->Insert(objects[i].boundsMin, objects[i].boundsMax, i);
+    }
+    for (uint32_t i = 0; i < count; i += 3)
+    {
+        objects[i].proxy = tree->Insert(objects[i].boundsMin, objects[i].boundsMax, i);
+    }
+    tree->Validate();
+
+    for (uint32_t i = 0; i < count; i += 2)
+    {
+        tree->Remove(objects[i].proxy);
+    }
+    for (uint32_t i = 0; i < count; i += 2)
+    {
+        objects[i].proxy = tree->Insert(objects[i].boundsMin, objects[i].boundsMax, i);
+    }
+    for (uint32_t frame = 0; frame < config.frames; frame++)
+    {
+        MoveObjects(tree, objects, sceneSize);
+    }
+    tree->Validate();
+
+    uint32_t mismatches = 0;
+    auto compare = [&](const std::string &query)
+    {
+        uint32_t differing = 0;
+        QueryGenerator generator = {std::mt19937(5), sceneSize};
+        std::vector<uint32_t> expected, found;
+        for (uint32_t i = 0; i < std::min(config.queries, 100u); i++)
+        {
+            auto frustum = generator.NextFrustum();
+            tree->QueryFrustum(frustum, found);
+            BruteForceFrustum(objects, frustum, expected);
+            std::sort(found.begin(), found.end());
+            differing += found != expected;
+
+            glm::vec3 center;
+            float radius;
+            generator.NextSphere(center, radius);
+            tree->QuerySphere(center, radius, found);
+            BruteForceSphere(objects, center, radius, expected);
+            std::sort(found.begin(), found.end());
+            differing += found != expected;
+
+            glm::vec3 boundsMin, boundsMax;
+            generator.NextBox(boundsMin, boundsMax);
+            tree->QueryOverlap(boundsMin, boundsMax, found);
+            BruteForceOverlap(objects, boundsMin, boundsMax, expected);
+            std::sort(found.begin(), found.end());
+            differing += found != expected;
+
+            glm::vec3 origin, direction;
+            generator.NextRay(origin, direction);
+            DynamicBVH::RayHit hit;
+            float distance = tree->RayCast(origin, direction, RAY_DISTANCE, hit) ? hit.distance : -1.0f;
+            differing += distance != BruteForceRay(objects, origin, direction);
+        }
+        if (differing)
+            spdlog::error("dynamic bvh: {} objects, {} queries differ from the list {}", count, differing, query);
+        mismatches += differing;
+    };
+
+    compare("after moving");
+    tree->Rebuild();
+    tree->Validate();
+    compare("after rebuilding");
+    return mismatches;
+}
+
+int main(int argc, char **argv)
+{
+    DynamicBVHConfig config;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--benchmark")
+            config.benchmark = true;
+        else if (option == "--count" && i + 1 < argc)
+            config.counts = {uint32_t(std::max(std::stoul(argv[++i]), 1ul))};
+        else if (option == "--queries" && i + 1 < argc)
+            config.queries = std::max(std::stoul(argv[++i]), 1ul);
+        else if (option == "--frames" && i + 1 < argc)
+            config.frames = std::stoul(argv[++i]);
+        else if (option == "--output" && i + 1 < argc)
+            config.output = argv[++i];
+        else
+        {
+            std::cerr << "usage: DynamicBVH [--benchmark] [--count n] [--queries n] [--frames n] [--output file]" << std::endl;
+            return 1;
+        }
+    }
+
+    if (config.benchmark)
+    {
+        std::vector<CountResult> results;
+        for (auto count : config.counts)
+        {
+            results.push_back(Benchmark(count, config));
+            spdlog::info("dynamic bvh: {} objects done", count);
+        }
+
+        auto json = JS::serializeStruct(results);
+        std::ofstream(config.output) << json;
+        std::cout << json << std::endl;
+        return 0;
+    }
+
+    // the list is scanned per query, the check stops at 100000 objects
+    uint32_t mismatches = 0;
+    for (auto count : config.counts)
+    {
+        mismatches += Check(std::min(count, 100000u), config);
+    }
+    if (mismatches)
+        return 1;
+
+    spdlog::info("dynamic bvh: queries match the brute force list");
+    return 0;
+}
@@ -0,0 +1,169 @@
+#include <RHI/RuntimeEntry.h>
+
+#include <Engine/PixelEngine.h>
+#include <Engine/Renderer.h>
+#include <Engine/Camera.h>
+#include <Engine/ParticleSystem.h>
+
+#include <IO/ImageWriter.h>
+
+#include <glm/glm.hpp>
+#include <spdlog/spdlog.h>
+#include <json_struct/json_struct.h>
+
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+// headless runs step the simulation by a fixed delta so that they do not depend on the frame rate
+static constexpr float FIXED_DELTA_TIME = 1.0f / 60.0f;
+
+struct ParticlesConfig
+{
+    bool headless = false;
+    bool benchmark = false;
+    uint32_t capacity = 1 << 20;
+    uint32_t frames = 300;
+    std::string output = "particles.json";
+};
+
+struct PassResult
+{
+    std::string pass;
+    // gpu milliseconds
+    double avg;
+    double min;
+
+    JS_OBJ(pass, avg, min);
+};
+
+struct ParticlesResult
+{
+    uint32_t capacity;
+    uint32_t frames;
+    // read back after the last frame
+    uint32_t aliveCount;
+    uint32_t deadCount;
+
+    // sum of the pass averages
+    double frameAvg;
+    std::vector<PassResult> passes;
+
+    JS_OBJ(capacity, frames, aliveCount, deadCount, frameAvg, passes);
+};
+
+int main(int argc, char **argv)
+{
+    spdlog::set_level(spdlog::level::debug);
+
+    // --headless renders a few hundred frames offscreen and exits
+    // --benchmark also reports the gpu time of every particle pass to --output
+    ParticlesConfig config;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--headless")
+            config.headless = true;
+        else if (option == "--benchmark")
+            config.headless = config.benchmark = true;
+        else if (option == "--capacity" && i + 1 < argc)
+            config.capacity = std::max(std::stoul(argv[++i]), 1ul);
+        else if (option == "--frames" && i + 1 < argc)
+            config.frames = std::max(std::stoul(argv[++i]), 1ul);
+        else if (option == "--output" && i + 1 < argc)
+            config.output = argv[++i];
+        else
+        {
+            std::cerr << "usage: Particles [--headless] [--benchmark] [--capacity n] [--frames n] [--output file]" << std::endl;
+            return 1;
+        }
+    }
+    bool headless = config.headless;
+
+    IntrusivePtr<PixelEngine> engine = new PixelEngine(headless);
+    auto &rhiRuntime = engine->GetRHIRuntime();
+    auto renderer = engine->CreateRenderer();
+
+    IntrusivePtr<ParticleSystem> particles = new ParticleSystem(engine.get(), {.capacity = config.capacity});
+    // about as many particles are emitted per second as live at once
+    particles->emitter.rate = config.capacity / ((particles->emitter.lifetimeMin + particles->emitter.lifetimeMax) * 0.5f);
+    particles->AddTo(renderer);
+
+    auto camera = renderer->GetCamera();
+    camera->setPosition({0.0f, -1.5f, -8.0f});
+
+    auto profiler = rhiRuntime->GetGPUProfiler();
+    profiler->SetEnabled(config.benchmark);
+
+    int status = 0;
+    uint32_t lastImageIndex = 0;
+    uint32_t frames = headless ? config.frames : 0;
+    renderer->RegisterUpdateCallback({GENERAL, [renderer = renderer.get(), particles = particles.get(), camera, &lastImageIndex, headless, frames, frameCount = 0u, time = 0.0f](UpdateInput inputs) mutable
+                                      {
+                                          if (inputs.event.type != Event::FRAME)
+                                              return false;
+
+                                          float deltaTime = headless ? FIXED_DELTA_TIME : inputs.deltaTime / 1000.0f;
+                                          time += deltaTime;
+
+                                          // the emitter circles around the origin
+                                          particles->emitter.position = glm::vec3(std::cos(time) * 1.5f, 0.0f, std::sin(time) * 1.5f);
+                                          particles->Update(deltaTime, camera->matrices.view, camera->matrices.perspective);
+
+                                          if (headless && ++frameCount >= frames)
+                                          {
+                                              lastImageIndex = inputs.currentImageIndex;
+                                              renderer->Stop();
+                                          }
+                                          return false;
+                                      }});
+
+    engine->Frame();
+
+    if (headless)
+    {
+        auto readback = engine->GetAuxiliaryExecutor()->ReadbackResource(renderer->GetSwapChain()->GetTexture(lastImageIndex));
+        ImageWriter::WriteFile(readback, "particles.png");
+    }
+
+    if (config.benchmark)
+    {
+        auto readback = engine->GetAuxiliaryExecutor()->ReadbackResource(particles->GetCounterBuffer());
+        auto counters = static_cast<const ParticleSystem::Counters *>(readback->Data());
+
+        ParticlesResult result = {
+            .capacity = config.capacity,
+            .frames = config.frames,
+            .aliveCount = counters->aliveCount,
+            .deadCount = counters->deadCount};
+
+        for (auto pass : {"particle_begin", "particle_emit", "particle_simulate", "particle_sort_scan", "particle_sort_scatter", "particle_render"})
+        {
+            GPUProfiler::Timing timing;
+            if (!profiler->GetTiming(particles->GetName() + "::" + pass + "::" + pass, timing))
+            {
+                spdlog::warn("no gpu timing of {}", pass);
+                continue;
+            }
+            result.passes.push_back({.pass = pass, .avg = timing.avg, .min = timing.min});
+            result.frameAvg += timing.avg;
+        }
+
+        // every particle is either alive or dead between frames
+        if (result.aliveCount + result.deadCount != config.capacity)
+        {
+            spdlog::error("particles lost: {} alive, {} dead, capacity {}", result.aliveCount, result.deadCount, config.capacity);
+            status = 1;
+        }
+
+        auto json = JS::serializeStruct(result);
+        std::ofstream(config.output) << json;
+        std::cout << json << std::endl;
+    }
+
+    particles.reset();
+    renderer.reset();
+    engine.reset();
+
+    return status;
+}
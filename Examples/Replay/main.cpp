@@ -0,0 +1,61 @@
+#include <RHI/RuntimeEntry.h>
+#include <RHI/CaptureReplayer.h>
+
+#include <Core/Trace.h>
+
+#include <IO/ImageWriter.h>
+
+#include <spdlog/spdlog.h>
+
+#include <iostream>
+#include <string>
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        std::cerr << "usage: Replay capture.pxcap [--output frame.png]" << std::endl;
+        return 1;
+    }
+
+    std::string capturePath = argv[1];
+    std::string output;
+    for (int i = 2; i + 1 < argc; i += 2)
+    {
+        std::string option = argv[i];
+        if (option == "--output")
+            output = argv[i + 1];
+    }
+
+    auto rhiRuntime = RuntimeEntry(RuntimeEntry::Type::VULKAN, true).Create();
+
+    IntrusivePtr<CaptureReplayer> replayer = new CaptureReplayer(rhiRuntime);
+    replayer->Load(capturePath);
+
+    uint32_t lastImageIndex = 0;
+    uint64_t frameBegin = Trace::Now();
+    uint64_t totalTime = 0;
+
+    replayer->Replay([&](uint32_t frame, uint32_t imageIndex)
+                     {
+                         auto now = Trace::Now();
+                         totalTime += now - frameBegin;
+                         frameBegin = now;
+                         lastImageIndex = imageIndex; });
+
+    if (replayer->FrameCount())
+    {
+        spdlog::info("replayed {} frames, {:.3f} ms cpu per frame", replayer->FrameCount(), totalTime / 1e6 / replayer->FrameCount());
+    }
+
+    if (!output.empty() && replayer->GetSwapChain())
+    {
+        auto readback = replayer->GetAuxiliaryExecutor()->ReadbackResource(replayer->GetSwapChain()->GetTexture(lastImageIndex));
+        ImageWriter::WriteFile(readback, output);
+    }
+
+    replayer.reset();
+    rhiRuntime.reset();
+
+    return 0;
+}
@@ -0,0 +1,37 @@
+#version 450
+
+// GLTFVertex, every attribute is declared so that the stride matches
+layout (location = 0) in vec3 inPos;
+layout (location = 1) in vec3 inNormal;
+layout (location = 2) in vec2 inUV;
+layout (location = 3) in vec4 inJoint0;
+layout (location = 4) in vec4 inWeight0;
+layout (location = 5) in vec4 inTangent;
+
+layout (binding = 0) uniform UBO
+{
+	mat4 projection;
+	mat4 viewMatrix;
+} ubo;
+
+// global matrix of the instance node
+layout (binding = 1) uniform ModelUBO
+{
+	mat4 model;
+	vec4 color;
+} modelUBO;
+
+layout (location = 0) out vec3 outNormal;
+layout (location = 1) out vec3 outColor;
+
+out gl_PerVertex
+{
+	vec4 gl_Position;
+};
+
+void main()
+{
+	outNormal = mat3(modelUBO.model) * inNormal;
+	outColor = modelUBO.color.rgb;
+	gl_Position = ubo.projection * ubo.viewMatrix * modelUBO.model * vec4(inPos, 1.0);
+}
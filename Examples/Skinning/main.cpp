@@ -0,0 +1,444 @@
+#include <FrameGraph/Graph.h>
+#include <RHI/RuntimeEntry.h>
+
+#include <Engine/PixelEngine.h>
+#include <Engine/Renderer.h>
+#include <Engine/Camera.h>
+#include <Engine/AnimatedScene.h>
+
+#include <IO/GLTFReader.h>
+#include <IO/ImageWriter.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <spdlog/spdlog.h>
+#include <json_struct/json_struct.h>
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+// headless runs step the animation by a fixed delta so that they do not depend on the frame rate
+static constexpr float FIXED_DELTA_TIME = 1.0f / 60.0f;
+
+// bones of a procedural character, stacked along y, one unit long
+static constexpr uint32_t BONE_COUNT = 3;
+
+// without --scene a grid of bending and bulging tubes is animated
+struct SkinningConfig
+{
+    bool headless = false;
+    bool benchmark = false;
+    std::string scene;
+    uint32_t characters = 16;
+    uint32_t segments = 64;
+    uint32_t frames = 100;
+    std::string output = "skinning.json";
+};
+
+struct SkinningResult
+{
+    std::string scene;
+    uint32_t instances;
+    uint32_t vertices;
+
+    // cpu milliseconds of AnimatedScene::Update
+    double updateAvg;
+    // gpu milliseconds of the skin pass
+    double skinAvg;
+    double skinMin;
+    double verticesPerSecond;
+
+    JS_OBJ(scene, instances, vertices, updateAvg, skinAvg, skinMin, verticesPerSecond);
+};
+
+// ModelUBO of mesh.vert
+struct ModelUBO
+{
+    glm::mat4 model;
+    glm::vec4 color;
+};
+
+// tube of BONE_COUNT bones, weighted linearly between neighbouring bones, one morph target bulging its middle
+static GLTFModel CreateTube(uint32_t segments)
+{
+    GLTFModel model;
+    uint32_t rings = segments * BONE_COUNT / 4;
+    float radius = 0.25f;
+    float height = float(BONE_COUNT);
+
+    GLTFMorphTarget bulge;
+    for (uint32_t ring = 0; ring <= rings; ring++)
+    {
+        float y = height * ring / rings;
+        uint32_t bone = std::min(uint32_t(y), BONE_COUNT - 1);
+        float blend = y - bone;
+        for (uint32_t segment = 0; segment <= segments; segment++)
+        {
+            float phi = glm::two_pi<float>() * segment / segments;
+            glm::vec3 normal = {std::cos(phi), 0.0f, std::sin(phi)};
+
+            GLTFVertex vertex = {};
+            vertex.pos = normal * radius + glm::vec3(0.0f, y, 0.0f);
+            vertex.normal = normal;
+            vertex.uv = {float(segment) / segments, y / height};
+            vertex.joint0 = {float(bone), float(std::min(bone + 1, BONE_COUNT - 1)), 0.0f, 0.0f};
+            vertex.weight0 = bone + 1 < BONE_COUNT ? glm::vec4(1.0f - blend, blend, 0.0f, 0.0f) : glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+            vertex.tangent = {-std::sin(phi), 0.0f, std::cos(phi), 1.0f};
+            model.vertexBuffer.push_back(vertex);
+
+            bulge.positions.push_back(normal * 0.15f * std::sin(glm::pi<float>() * y / height));
+            bulge.normals.push_back(glm::vec3(0.0f));
+            bulge.tangents.push_back(glm::vec3(0.0f));
+        }
+    }
+
+    for (uint32_t ring = 0; ring < rings; ring++)
+    {
+        for (uint32_t segment = 0; segment < segments; segment++)
+        {
+            uint32_t a = ring * (segments + 1) + segment;
+            uint32_t b = a + segments + 1;
+            model.indexBuffer.insert(model.indexBuffer.end(), {a, b, a + 1, a + 1, b, b + 1});
+        }
+    }
+
+    model.primitives.push_back({
+        .firstVertex = 0,
+        .vertexCount = uint32_t(model.vertexBuffer.size()),
+        .firstIndex = 0,
+        .indexCount = uint32_t(model.indexBuffer.size()),
+        .boundsMin = glm::vec3(-radius, 0.0f, -radius),
+        .boundsMax = glm::vec3(radius, height, radius)});
+    model.morphTargets.push_back(bulge);
+    model.morphWeights = {0.0f};
+    return model;
+}
+
+// every character is a root with a chain of joints and a mesh node, all share one animation
+static GLTFScene CreateCharacters(uint32_t count, uint32_t segments)
+{
+    GLTFScene scene;
+    scene.models.push_back(CreateTube(segments));
+
+    GLTFAnimation animation;
+    // bones bend back and forth around z
+    GLTFAnimationSampler bend = {.interpolation = GLTFAnimationSampler::LINEAR, .times = {0.0f, 1.0f, 2.0f}};
+    for (float angle : {0.0f, 0.6f, 0.0f})
+    {
+        auto q = glm::angleAxis(angle, glm::vec3(0.0f, 0.0f, 1.0f));
+        bend.values.insert(bend.values.end(), {q.x, q.y, q.z, q.w});
+    }
+    GLTFAnimationSampler bulge = {.interpolation = GLTFAnimationSampler::CUBICSPLINE, .times = {0.0f, 1.0f, 2.0f}, .values = {0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f}};
+    animation.samplers = {bend, bulge};
+    animation.start = 0.0f;
+    animation.end = 2.0f;
+
+    uint32_t columns = std::max(uint32_t(std::ceil(std::sqrt(float(count)))), 1u);
+    for (uint32_t c = 0; c < count; c++)
+    {
+        uint32_t root = scene.nodes.size();
+        GLTFNode rootNode;
+        rootNode.translation = {float(c % columns) * 1.5f, 0.0f, float(c / columns) * 1.5f};
+        scene.nodes.push_back(rootNode);
+        scene.roots.push_back(root);
+
+        GLTFSkin skin;
+        uint32_t parent = root;
+        for (uint32_t bone = 0; bone < BONE_COUNT; bone++)
+        {
+            GLTFNode joint;
+            joint.parent = parent;
+            joint.translation = {0.0f, bone == 0 ? 0.0f : 1.0f, 0.0f};
+            uint32_t index = scene.nodes.size();
+            scene.nodes[parent].children.push_back(index);
+            scene.nodes.push_back(joint);
+
+            skin.joints.push_back(index);
+            skin.inverseBindMatrices.push_back(glm::translate(glm::mat4(1.0f), glm::vec3(0.0f, -float(bone), 0.0f)));
+            if (bone > 0)
+            {
+                animation.channels.push_back({.path = GLTFAnimationChannel::ROTATION, .node = index, .sampler = 0});
+            }
+            parent = index;
+        }
+
+        GLTFNode meshNode;
+        meshNode.parent = root;
+        meshNode.mesh = 0;
+        meshNode.skin = scene.skins.size();
+        uint32_t meshIndex = scene.nodes.size();
+        scene.nodes[root].children.push_back(meshIndex);
+        scene.nodes.push_back(meshNode);
+        animation.channels.push_back({.path = GLTFAnimationChannel::WEIGHTS, .node = meshIndex, .sampler = 1});
+
+        scene.skins.push_back(skin);
+    }
+
+    scene.animations.push_back(animation);
+    return scene;
+}
+
+// same as skin.comp for the position of one vertex
+static glm::vec3 SkinPosition(const GLTFModel &model, uint32_t v, const std::vector<glm::mat4> &joints, const std::vector<float> &weights)
+{
+    auto &vertex = model.vertexBuffer[v];
+    auto position = vertex.pos;
+    for (size_t t = 0; t < weights.size(); t++)
+    {
+        position += model.morphTargets[t].positions[v] * weights[t];
+    }
+
+    float weightSum = vertex.weight0.x + vertex.weight0.y + vertex.weight0.z + vertex.weight0.w;
+    if (joints.empty() || weightSum <= 0.0f)
+        return position;
+
+    glm::mat4 skin(0.0f);
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        skin += vertex.weight0[i] * joints[std::min(uint32_t(vertex.joint0[i]), uint32_t(joints.size() - 1))];
+    }
+    return glm::vec3(skin * glm::vec4(position, 1.0f));
+}
+
+// gpu output of the first animated instance against the cpu, false on mismatch
+static bool CheckInstance(PixelEngine *engine, IntrusivePtr<AnimatedScene> animatedScene)
+{
+    auto &instances = animatedScene->GetInstances();
+    for (uint32_t i = 0; i < instances.size(); i++)
+    {
+        if (!instances[i].animated)
+            continue;
+
+        auto &model = animatedScene->GetScene().models[instances[i].mesh];
+        auto joints = animatedScene->GetJointMatrices(i);
+        auto weights = animatedScene->GetMorphWeights(i);
+
+        auto readback = engine->GetAuxiliaryExecutor()->ReadbackResource(instances[i].vertexBuffer);
+        auto skinned = static_cast<const GLTFVertex *>(readback->Data());
+
+        uint32_t mismatches = 0;
+        for (uint32_t v = 0; v < model.vertexBuffer.size(); v++)
+        {
+            auto expected = SkinPosition(model, v, joints, weights);
+            if (glm::length(expected - skinned[v].pos) > 1e-3f * std::max(glm::length(expected), 1.0f) && mismatches++ < 8)
+            {
+                spdlog::error("vertex {}: expected ({}, {}, {}), skinned ({}, {}, {})", v, expected.x, expected.y, expected.z, skinned[v].pos.x, skinned[v].pos.y, skinned[v].pos.z);
+            }
+        }
+        spdlog::info("instance {}: {} vertices, {} mismatches", i, model.vertexBuffer.size(), mismatches);
+        return mismatches == 0;
+    }
+    return true;
+}
+
+// model matrix of a drawn instance, rewritten after every animation update
+struct InstanceDrawable
+{
+    IntrusivePtr<DynamicBuffer> ubo;
+    uint32_t node;
+    glm::vec3 color;
+};
+
+std::vector<InstanceDrawable> CreateInstanceDrawables(PixelEngine *engine, IntrusivePtr<Renderer> renderer, IntrusivePtr<Pipeline> pipeline, IntrusivePtr<AnimatedScene> animatedScene)
+{
+    auto rhiRuntime = engine->GetRHIRuntime();
+    auto camera = renderer->GetCamera();
+    auto &instances = animatedScene->GetInstances();
+
+    std::vector<InstanceDrawable> drawables;
+    for (uint32_t i = 0; i < instances.size(); i++)
+    {
+        auto &instance = instances[i];
+        if (!instance.indexBuffer)
+            continue;
+
+        auto uBuffer = rhiRuntime->CreateDynamicBuffer(sizeof(ModelUBO));
+        auto color = glm::vec3(0.35f) + 0.6f * glm::fract(glm::vec3(0.31f, 0.57f, 0.83f) * float(i + 1));
+
+        auto rbs = rhiRuntime->CreateResourceBindingState(pipeline);
+        rbs->Bind(0, 0, camera->GetUBOBuffer());
+        rbs->Bind(0, 1, uBuffer);
+        // skinned in place every frame for animated instances
+        rbs->BindVertexBuffer(instance.vertexBuffer);
+        rbs->BindIndexBuffer(instance.indexBuffer, ResourceBindingState::INDEX_TYPE_UINT32);
+
+        // indices already point into the whole model vertex buffer
+        std::vector<ResourceBindingState::DrawOP> drawOps;
+        for (auto &primitive : animatedScene->GetScene().models[instance.mesh].primitives)
+        {
+            drawOps.push_back({
+                .indexCount = primitive.indexCount,
+                .instanceCount = 1,
+                .firstIndex = primitive.firstIndex,
+                .vertexOffset = 0,
+                .firstInstance = 0});
+        }
+        rbs->BindDrawOp(drawOps);
+        rbs->name = "mesh";
+        renderer->AddDrawState(rbs);
+
+        drawables.push_back({uBuffer, instance.node, color});
+    }
+    return drawables;
+}
+
+int main(int argc, char **argv)
+{
+    spdlog::set_level(spdlog::level::debug);
+
+    // --headless animates a few frames offscreen, checks the skinned vertices against the cpu and exits
+    // --benchmark also times the animation update and the skin pass and writes them to --output
+    SkinningConfig config;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--headless")
+            config.headless = true;
+        else if (option == "--benchmark")
+            config.headless = config.benchmark = true;
+        else if (option == "--scene" && i + 1 < argc)
+            config.scene = argv[++i];
+        else if (option == "--characters" && i + 1 < argc)
+            config.characters = std::max(std::stoul(argv[++i]), 1ul);
+        else if (option == "--segments" && i + 1 < argc)
+            config.segments = std::max(std::stoul(argv[++i]), 4ul);
+        else if (option == "--frames" && i + 1 < argc)
+            config.frames = std::max(std::stoul(argv[++i]), 3ul);
+        else if (option == "--output" && i + 1 < argc)
+            config.output = argv[++i];
+        else
+        {
+            std::cerr << "usage: Skinning [--headless] [--benchmark] [--scene file.gltf] [--characters n] [--segments n] [--frames n] [--output file]" << std::endl;
+            return 1;
+        }
+    }
+    bool headless = config.headless;
+
+    auto graph = Graph::ParseRenderPassJson("Skinning.json");
+
+    IntrusivePtr<PixelEngine> engine = new PixelEngine(headless);
+
+    auto scene = config.scene.empty() ? CreateCharacters(config.characters, config.segments) : GLTFReader::ReadScene(engine.get(), config.scene);
+    if (scene.models.empty())
+    {
+        spdlog::error("no meshes in {}", config.scene);
+        return 1;
+    }
+
+    // named as the dependency of Skinning.json
+    IntrusivePtr<AnimatedScene> animatedScene = new AnimatedScene(engine.get(), scene);
+
+    auto renderGroup = engine->RegisterRenderGroup(graph);
+    PipelineStates meshPipelineStates = {
+        .inputAssembleState = {.type = InputAssembleState::Type::TRIANGLE_LIST},
+        .rasterizationState = {.polygonMode = RasterizationState::PolygonModeType::FILL, .cullMode = RasterizationState::CullModeType::NONE, .frontFace = RasterizationState::FrontFaceType::COUNTER_CLOCKWISE, .lineWidth = 1.0f},
+        .depthStencilState = {.depthTestEnable = true, .depthWriteEnable = true}};
+    auto meshPipeline = renderGroup->CreatePipeline("mesh", meshPipelineStates);
+
+    auto &rhiRuntime = engine->GetRHIRuntime();
+    auto renderer = engine->CreateRenderer();
+
+    animatedScene->AddTo(renderer);
+    auto drawables = CreateInstanceDrawables(engine.get(), renderer, meshPipeline, animatedScene);
+
+    // in front of the characters, or of the origin of a loaded scene
+    auto camera = renderer->GetCamera();
+    float columns = std::ceil(std::sqrt(float(config.characters)));
+    camera->setPosition(config.scene.empty() ? glm::vec3(-columns * 0.75f, -1.5f, -columns * 1.5f - 4.0f) : glm::vec3(0.0f, -1.0f, -5.0f));
+
+    auto profiler = rhiRuntime->GetGPUProfiler();
+    profiler->SetEnabled(config.benchmark);
+
+    double updateTime = 0.0;
+    uint32_t updateCount = 0;
+    uint32_t lastImageIndex = 0;
+    uint32_t frames = config.benchmark ? config.frames : 10;
+    renderer->RegisterUpdateCallback({GENERAL, [renderer = renderer.get(), animatedScene, &drawables, &lastImageIndex, &updateTime, &updateCount, headless, frames, frameCount = 0u, time = 0.0f](UpdateInput inputs) mutable
+                                      {
+                                          if (inputs.event.type != Event::FRAME)
+                                              return false;
+
+                                          // the last frames hold the pose, so that the vertex buffers match the matrices read back by the check
+                                          if (!headless || frameCount + 2 < frames)
+                                          {
+                                              time += headless ? FIXED_DELTA_TIME : inputs.deltaTime / 1000.0f;
+                                          }
+
+                                          auto start = std::chrono::steady_clock::now();
+                                          animatedScene->Update(time);
+                                          updateTime += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                                          updateCount++;
+
+                                          for (auto &drawable : drawables)
+                                          {
+                                              auto ubo = static_cast<ModelUBO *>(drawable.ubo->Map());
+                                              ubo->model = animatedScene->GetGlobalMatrix(drawable.node);
+                                              ubo->color = glm::vec4(drawable.color, 1.0f);
+                                          }
+
+                                          if (headless && ++frameCount >= frames)
+                                          {
+                                              lastImageIndex = inputs.currentImageIndex;
+                                              renderer->Stop();
+                                          }
+                                          return false;
+                                      }});
+
+    engine->Frame();
+
+    int status = 0;
+    if (headless)
+    {
+        auto readback = engine->GetAuxiliaryExecutor()->ReadbackResource(renderer->GetSwapChain()->GetTexture(lastImageIndex));
+        ImageWriter::WriteFile(readback, "skinning.png");
+
+        if (!CheckInstance(engine.get(), animatedScene))
+        {
+            status = 1;
+        }
+    }
+
+    if (config.benchmark)
+    {
+        uint32_t vertices = 0;
+        uint32_t animated = 0;
+        for (auto &instance : animatedScene->GetInstances())
+        {
+            if (!instance.animated)
+                continue;
+            vertices += animatedScene->GetScene().models[instance.mesh].vertexBuffer.size();
+            animated++;
+        }
+
+        SkinningResult result = {
+            .scene = config.scene.empty() ? "characters" : config.scene,
+            .instances = animated,
+            .vertices = vertices,
+            .updateAvg = updateCount ? updateTime / updateCount : 0.0};
+
+        GPUProfiler::Timing timing;
+        if (profiler->GetTiming(animatedScene->GetDependency(), timing))
+        {
+            result.skinAvg = timing.avg;
+            result.skinMin = timing.min;
+            result.verticesPerSecond = timing.avg > 0.0 ? vertices / (timing.avg / 1000.0) : 0.0;
+        }
+        else
+        {
+            spdlog::warn("no gpu timing of the skin pass");
+        }
+
+        auto json = JS::serializeStruct(result);
+        std::ofstream(config.output) << json;
+        std::cout << json << std::endl;
+    }
+
+    animatedScene.reset();
+    renderer.reset();
+    engine.reset();
+
+    return status;
+}
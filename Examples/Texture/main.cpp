@@ -42,18 +42,11 @@ void CreateTextureDrawable(PixelEngine *engine, IntrusivePtr<Renderer> renderer,
 
     auto camera = renderer->GetCamera();
 
-    auto vBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, vertexBufferSize);
-    memcpy(vBuffer->Map(), vertexBuffer.data(), vertexBufferSize);
-    auto iBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, indexBufferSize);
-    memcpy(iBuffer->Map(), indexBuffer.data(), indexBufferSize);
-
     auto vBufferGPU = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_VERTEX_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, vertexBufferSize);
     auto iBufferGPU = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_INDEX_BUFFER_BIT | Buffer::BUFFER_USAGE_TRANSFER_DST_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, indexBufferSize);
 
-    engine->GetAuxiliaryExecutor()->TransferResource(vBufferGPU, vBuffer);
-    engine->GetAuxiliaryExecutor()->TransferResource(iBufferGPU, iBuffer);
-    vBuffer.reset();
-    iBuffer.reset();
+    engine->GetAuxiliaryExecutor()->TransferResource(vBufferGPU, vertexBuffer.data(), vertexBufferSize);
+    engine->GetAuxiliaryExecutor()->TransferResource(iBufferGPU, indexBuffer.data(), indexBufferSize);
 
     auto texture = KTXReader::ReadFile(engine, "C:/Users/Mario/Documents/GitHub/Vulkan/data/textures/metalplate01_rgba.ktx");
     auto textureSampler = rhiRuntime->CreateSampler(texture);
@@ -62,7 +55,7 @@ void CreateTextureDrawable(PixelEngine *engine, IntrusivePtr<Renderer> renderer,
         .model = glm::mat4(1.5f),
         .lodBias = 1.0f,
     };
-    auto uBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_UNIFORM_BUFFER_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, sizeof(TextureUBO));
+    auto uBuffer = rhiRuntime->CreateDynamicBuffer(sizeof(TextureUBO));
     memcpy(uBuffer->Map(), &textureUBO, sizeof(textureUBO));
 
     auto rbs = rhiRuntime->CreateResourceBindingState(pipeline);
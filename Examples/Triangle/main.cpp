@@ -10,6 +10,8 @@
 
 #include <Engine/ImguiOverlay.h>
 
+#include <IO/ImageWriter.h>
+
 struct Vertex
 {
     float position[3];
@@ -37,8 +39,8 @@ void CreateTriangleDrawable(IntrusivePtr<RHIRuntime> rhiRuntime, IntrusivePtr<Re
 
     glm::mat4 model = glm::mat4(1.0f);
 
-    auto uBuffer = rhiRuntime->CreateMutableBuffer(Buffer::BUFFER_USAGE_UNIFORM_BUFFER_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, sizeof(model));
-    memcpy(uBuffer->GetBuffer(0)->Map(), &model, sizeof(model));
+    auto uBuffer = rhiRuntime->CreateDynamicBuffer(sizeof(model));
+    memcpy(uBuffer->Map(), &model, sizeof(model));
 
     auto rbs = rhiRuntime->CreateResourceBindingState(pipeline);
     rbs->Bind(0, 0, camera->GetUBOBuffer());
@@ -55,17 +57,20 @@ void CreateTriangleDrawable(IntrusivePtr<RHIRuntime> rhiRuntime, IntrusivePtr<Re
     renderer->AddDrawState(rbs);
 }
 
-int main()
+int main(int argc, char **argv)
 {
     spdlog::set_level(spdlog::level::debug);
 
+    // --headless renders a few frames offscreen and exits
+    bool headless = argc > 1 && std::string(argv[1]) == "--headless";
+
     auto graph = Graph::ParseRenderPassJson("triangle.json");
     PipelineStates colorPipelineStates = {
         .inputAssembleState = {.type = InputAssembleState::Type::TRIANGLE_LIST},
         .rasterizationState = {.polygonMode = RasterizationState::PolygonModeType::FILL, .cullMode = RasterizationState::CullModeType::NONE, .frontFace = RasterizationState::FrontFaceType::COUNTER_CLOCKWISE, .lineWidth = 1.0f},
         .depthStencilState = {.depthTestEnable = true, .depthWriteEnable = true}};
 
-    IntrusivePtr<PixelEngine> engine = new PixelEngine;
+    IntrusivePtr<PixelEngine> engine = new PixelEngine(headless);
     auto renderGroup = engine->RegisterRenderGroup(graph);
     auto colorPipeline = renderGroup->CreatePipeline("single", colorPipelineStates);
 
@@ -80,8 +85,28 @@ int main()
 
     CreateTriangleDrawable(rhiRuntime, renderer, colorPipeline);
 
+    uint32_t lastImageIndex = 0;
+    if (headless)
+    {
+        renderer->RegisterUpdateCallback({GENERAL, [renderer = renderer.get(), &lastImageIndex, frameCount = 0](UpdateInput inputs) mutable
+                                          {
+                                              if (inputs.event.type == Event::FRAME && ++frameCount >= 3)
+                                              {
+                                                  lastImageIndex = inputs.currentImageIndex;
+                                                  renderer->Stop();
+                                              }
+                                              return false;
+                                          }});
+    }
+
     engine->Frame();
 
+    if (headless)
+    {
+        auto readback = engine->GetAuxiliaryExecutor()->ReadbackResource(renderer->GetSwapChain()->GetTexture(lastImageIndex));
+        ImageWriter::WriteFile(readback, "triangle.png");
+    }
+
     renderer.reset();
     engine.reset();
 
@@ -8,6 +8,7 @@
 #include <spdlog/spdlog.h>
 
 #include <Core/ReadFile.h>
+#include <Core/Trace.h>
 
 static TextureFormat TranslateFormat(std::string formatStr)
 {
@@ -32,6 +33,17 @@ static TextureFormat TranslateFormat(std::string formatStr)
 #undef STRINGIFY
 }
 
+// json descriptor resource type to node type
+static GraphNode::Type TranslateDescriptorNodeType(std::string typeStr)
+{
+    if (typeStr == "sampler")
+        return GraphNode::SAMPLER;
+    if (typeStr == "texture" || typeStr == "image")
+        return GraphNode::TEXTURE;
+    // buffer, ssbo, texel_buffer
+    return GraphNode::BUFFER;
+}
+
 bool isPipelineNode(IntrusivePtr<GraphNode> node)
 {
     return node->type == GraphNode::Type::GRAPHIC_PASS || node->type == GraphNode::Type::COMPUTE_PASS;
@@ -90,10 +102,13 @@ IntrusivePtr<Graph> Graph::ParseRenderPassJsonRawString(std::string jsonStr)
                 attachment->color = attachment->depthStencil ? false : true;
                 inputNode = attachment;
             }
-            else if (input.type == "buffer" || input.type == "sampler" || input.type == "ssbo")
+            else if (input.type == "buffer" || input.type == "sampler" || input.type == "ssbo" || input.type == "texel_buffer" ||
+                     input.type == "texture" || input.type == "image")
             {
-                auto dn = new DescriptorGraphNode(input.name, input.type == "sampler" ? GraphNode::SAMPLER : GraphNode::BUFFER);
+                // descriptor type is reflected from the shader, the node type only tells the resource kind
+                auto dn = new DescriptorGraphNode(input.name, TranslateDescriptorNodeType(input.type));
                 dn->set = 0;
+                dn->dynamic = input.dynamic;
                 inputNode = dn;
             }
 
@@ -114,6 +129,11 @@ IntrusivePtr<Graph> Graph::ParseRenderPassJsonRawString(std::string jsonStr)
                 }
                 resolvedMap[inputNode->GlobalName()] = inputNode;
             }
+            else
+            {
+                // shared attachments are allocated from the resolved node, it has to know all of its readers
+                resolvedMap[inputNode->GlobalName()]->inputSubPassNames.insert(subpass.name);
+            }
 
             resourceNodes.push_back(inputNode);
             node->inputs.push_back(inputNode);
@@ -134,9 +154,13 @@ IntrusivePtr<Graph> Graph::ParseRenderPassJsonRawString(std::string jsonStr)
                 attachment->format = TranslateFormat(output.format);
                 outputNode = attachment;
             }
-            else if (output.type == "buffer" || output.type == "ssbo")
+            else if (output.type == "buffer" || output.type == "ssbo" || output.type == "texel_buffer" || output.type == "image")
             {
-                outputNode = new DescriptorGraphNode(output.name, GraphNode::BUFFER);
+                // written through a storage buffer, storage texel buffer or storage image descriptor
+                auto dn = new DescriptorGraphNode(output.name, TranslateDescriptorNodeType(output.type));
+                dn->set = 0;
+                dn->binding = output.binding;
+                outputNode = dn;
             }
 
             outputNode->passName = node->name;
@@ -166,9 +190,49 @@ IntrusivePtr<Graph> Graph::ParseRenderPassJsonRawString(std::string jsonStr)
         for (unsigned i = 0; i < passNode->inputs.size(); i++)
         {
             auto resNode = (DescriptorGraphNode *)passNode->inputs[i].get();
-            passNode->bindingSets[resNode->GlobalName()] = {resNode->set, resNode->binding, passNode->inputs[i]->type};
+            auto dynamic = passNode->inputs[i]->type == GraphNode::BUFFER && resNode->dynamic;
+            passNode->bindingSets[resNode->GlobalName()] = {resNode->set, resNode->binding, passNode->inputs[i]->type, dynamic};
+        }
+
+        for (auto &output : passNode->outputs)
+        {
+            if (output->type != GraphNode::BUFFER && output->type != GraphNode::TEXTURE)
+                continue;
+            auto resNode = output->As<DescriptorGraphNode *>();
+            passNode->bindingSets[resNode->GlobalName()] = {resNode->set, resNode->binding, output->type};
+        }
+    }
+
+    // buffers and images are scoped by pass, a pass reading one another pass writes depends on the writer
+    for (auto [name, node] : resolvedMap)
+    {
+        if (!isPipelineNode(node))
+            continue;
+
+        std::unordered_set<GraphNode *> consumers;
+        for (auto &output : node->outputs)
+        {
+            if (output->type != GraphNode::BUFFER && output->type != GraphNode::TEXTURE)
+                continue;
+
+            for (auto [consumerName, consumer] : resolvedMap)
+            {
+                if (!isPipelineNode(consumer) || consumer == node)
+                    continue;
+
+                for (auto &input : consumer->inputs)
+                {
+                    if (input->type == output->type && input->LocalName() == output->LocalName())
+                        consumers.insert(consumer.get());
+                }
+            }
+        }
+
+        for (auto consumer : consumers)
+        {
+            node->outputs.push_back(consumer);
+            consumer->inputs.push_back(node);
         }
-        // TODO, handle outputs (BUFFER SSBO)
     }
 
     // append subpass dependency
@@ -228,6 +292,8 @@ Graph::TopoResult &Graph::Topo()
         return topoResultCache.value();
     }
 
+    TRACE_SCOPE("Graph::Topo");
+
     std::map<uint16_t, std::vector<GraphNode *>> result;
 
     auto getSameNodes = [&](const std::string &name)
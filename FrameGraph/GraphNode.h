@@ -17,7 +17,9 @@ struct GraphNode : public IntrusiveUnsafeCounter<GraphNode>
 
         ATTACHMENT,
         BUFFER,
-        SAMPLER
+        SAMPLER,
+        // sampled or storage image bound by the user
+        TEXTURE
     };
 
     explicit GraphNode(std::string name, Type type);
@@ -92,6 +94,7 @@ struct DescriptorGraphNode : public ResourceNode
 {
     DescriptorGraphNode(std::string name, Type type) : ResourceNode(name, type) {}
     bool sampler = false;
+    bool dynamic = false;
     uint8_t set;
 };
 
@@ -104,6 +107,7 @@ struct RenderPassGraphNode : public GraphNode
         uint32_t set;
         uint32_t binding;
         Type type;
+        bool dynamic = false;
     };
     std::unordered_map<std::string, ResourceBindingPack> bindingSets;
 
@@ -17,10 +17,13 @@ struct RenderSubPassResourceJson
     bool shared;
     bool clear;
 
+    // buffer resourcefield, bind with dynamic offset
+    bool dynamic;
+
     uint8_t binding;
     uint8_t set;
 
-    JS_OBJ(name, type, format, depthStencil, swapChain, shared, clear, set, binding);
+    JS_OBJ(name, type, format, depthStencil, swapChain, shared, clear, dynamic, set, binding);
 };
 
 struct ShaderPaths
@@ -7,23 +7,96 @@
 
 #include <spdlog/spdlog.h>
 
+#include <Core/Trace.h>
+
 #include <RHI/ResourceBindingState.h>
 
-std::vector<GLTFModel> GLTFReader::ReadFile(PixelEngine *engine, std::string file)
+#include <algorithm>
+#include <cfloat>
+#include <cstring>
+#include <stdexcept>
+
+// elements of the accessor as floats, normalized integers are mapped to [0, 1] or [-1, 1]
+static std::vector<float> ReadAccessor(const tinygltf::Model &model, int accessorIndex)
 {
-    std::vector<GLTFModel> gltfModels;
+    auto &accessor = model.accessors[accessorIndex];
+    uint32_t components = tinygltf::GetNumComponentsInType(accessor.type);
+    std::vector<float> values(accessor.count * components, 0.0f);
+    if (accessor.bufferView < 0)
+        return values;
+
+    auto &bufferView = model.bufferViews[accessor.bufferView];
+    auto stride = accessor.ByteStride(bufferView);
+    auto componentSize = tinygltf::GetComponentSizeInBytes(accessor.componentType);
+    if (stride <= 0 || componentSize <= 0)
+    {
+        throw std::runtime_error("gltf: invalid accessor " + std::to_string(accessorIndex));
+    }
+
+    auto data = &model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
+    for (size_t i = 0; i < accessor.count; i++)
+    {
+        for (uint32_t c = 0; c < components; c++)
+        {
+            auto component = data + i * stride + c * componentSize;
+            auto &value = values[i * components + c];
+            switch (accessor.componentType)
+            {
+            case TINYGLTF_COMPONENT_TYPE_FLOAT:
+                memcpy(&value, component, sizeof(float));
+                break;
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+                value = accessor.normalized ? *component / 255.0f : *component;
+                break;
+            case TINYGLTF_COMPONENT_TYPE_BYTE:
+                value = accessor.normalized ? std::max(int8_t(*component) / 127.0f, -1.0f) : int8_t(*component);
+                break;
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+            {
+                uint16_t v;
+                memcpy(&v, component, sizeof(v));
+                value = accessor.normalized ? v / 65535.0f : v;
+                break;
+            }
+            case TINYGLTF_COMPONENT_TYPE_SHORT:
+            {
+                int16_t v;
+                memcpy(&v, component, sizeof(v));
+                value = accessor.normalized ? std::max(v / 32767.0f, -1.0f) : v;
+                break;
+            }
+            case TINYGLTF_COMPONENT_TYPE_UNSIGNED_INT:
+            {
+                uint32_t v;
+                memcpy(&v, component, sizeof(v));
+                value = float(v);
+                break;
+            }
+            default:
+                throw std::runtime_error("gltf: unsupported component type " + std::to_string(accessor.componentType));
+            }
+        }
+    }
+    return values;
+}
 
+static bool LoadModel(std::string file, tinygltf::Model &model)
+{
     tinygltf::TinyGLTF loader;
     std::string err;
     std::string warn;
 
-    tinygltf::Model model;
     auto result = loader.LoadASCIIFromFile(&model, &err, &warn, file);
     if (!result)
     {
         spdlog::info("tinygltf read failed: {}", err);
-        return {};
     }
+    return result;
+}
+
+static std::vector<GLTFModel> ReadModels(tinygltf::Model &model)
+{
+    std::vector<GLTFModel> gltfModels;
 
     for (auto mesh : model.meshes)
     {
@@ -45,13 +118,13 @@ std::vector<GLTFModel> GLTFReader::ReadFile(PixelEngine *engine, std::string fil
             uint32_t indexCount = 0;
             uint32_t vertexCount = 0;
 
-            const float *bufferPos = nullptr;
-            const float *bufferNormals = nullptr;
-            const float *bufferTexCoords = nullptr;
-            const float *bufferTangents = nullptr;
-            uint32_t numColorComponents;
-            const uint16_t *bufferJoints = nullptr;
-            const float *bufferWeights = nullptr;
+            // any component type and byte stride, read through ReadAccessor
+            std::vector<float> bufferPos;
+            std::vector<float> bufferNormals;
+            std::vector<float> bufferTexCoords;
+            std::vector<float> bufferTangents;
+            std::vector<float> bufferJoints;
+            std::vector<float> bufferWeights;
 
             glm::vec3 posMin{};
             glm::vec3 posMax{};
@@ -60,12 +133,25 @@ std::vector<GLTFModel> GLTFReader::ReadFile(PixelEngine *engine, std::string fil
                 if (primitive.attributes.count("POSITION") == 0)
                     continue;
 
-                auto accessor = model.accessors[primitive.attributes["POSITION"]];
-                auto bufferView = model.bufferViews[accessor.bufferView];
-                bufferPos = (float *)&model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
+                auto &accessor = model.accessors[primitive.attributes["POSITION"]];
+                bufferPos = ReadAccessor(model, primitive.attributes["POSITION"]);
 
-                posMin = glm::vec3(accessor.minValues[0], accessor.minValues[1], accessor.minValues[2]);
-                posMax = glm::vec3(accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2]);
+                // required by the spec, exporters still skip it sometimes
+                if (accessor.minValues.size() >= 3 && accessor.maxValues.size() >= 3)
+                {
+                    posMin = glm::vec3(accessor.minValues[0], accessor.minValues[1], accessor.minValues[2]);
+                    posMax = glm::vec3(accessor.maxValues[0], accessor.maxValues[1], accessor.maxValues[2]);
+                }
+                else if (accessor.count)
+                {
+                    posMin = glm::vec3(FLT_MAX);
+                    posMax = glm::vec3(-FLT_MAX);
+                    for (uint32_t v = 0; v < accessor.count; v++)
+                    {
+                        posMin = glm::min(posMin, glm::make_vec3(&bufferPos[v * 3]));
+                        posMax = glm::max(posMax, glm::make_vec3(&bufferPos[v * 3]));
+                    }
+                }
 
                 vertexCount = accessor.count;
             }
@@ -73,57 +159,80 @@ std::vector<GLTFModel> GLTFReader::ReadFile(PixelEngine *engine, std::string fil
             // read NORMAL
             if (primitive.attributes.count("NORMAL"))
             {
-                auto accessor = model.accessors[primitive.attributes["NORMAL"]];
-                auto bufferView = model.bufferViews[accessor.bufferView];
-                bufferNormals = (float *)&model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
+                bufferNormals = ReadAccessor(model, primitive.attributes["NORMAL"]);
             }
 
             // read TEXCOORD_0
             if (primitive.attributes.count("TEXCOORD_0"))
             {
-                auto accessor = model.accessors[primitive.attributes["TEXCOORD_0"]];
-                auto bufferView = model.bufferViews[accessor.bufferView];
-                bufferTexCoords = (float *)&model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
+                bufferTexCoords = ReadAccessor(model, primitive.attributes["TEXCOORD_0"]);
             }
 
             if (primitive.attributes.count("TANGENT"))
             {
-                auto accessor = model.accessors[primitive.attributes["TANGENT"]];
-                auto bufferView = model.bufferViews[accessor.bufferView];
-                bufferTangents = (float *)&model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
+                bufferTangents = ReadAccessor(model, primitive.attributes["TANGENT"]);
             }
 
             // read skinning joints
             if (primitive.attributes.count("JOINTS_0"))
             {
-                auto accessor = model.accessors[primitive.attributes["JOINTS_0"]];
-                auto bufferView = model.bufferViews[accessor.bufferView];
-                bufferJoints = (uint16_t *)&model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
+                bufferJoints = ReadAccessor(model, primitive.attributes["JOINTS_0"]);
             }
 
             if (primitive.attributes.count("WEIGHTS_0"))
             {
-                auto accessor = model.accessors[primitive.attributes["WEIGHTS_0"]];
-                auto bufferView = model.bufferViews[accessor.bufferView];
-                bufferWeights = (float *)&model.buffers[bufferView.buffer].data[bufferView.byteOffset + accessor.byteOffset];
+                bufferWeights = ReadAccessor(model, primitive.attributes["WEIGHTS_0"]);
             }
 
-            auto hasSkin = (bufferJoints && bufferWeights);
+            auto hasNormals = bufferNormals.size() >= vertexCount * 3;
+            auto hasTexCoords = bufferTexCoords.size() >= vertexCount * 2;
+            auto hasTangents = bufferTangents.size() >= vertexCount * 4;
+            auto hasSkin = bufferJoints.size() >= vertexCount * 4 && bufferWeights.size() >= vertexCount * 4;
 
             for (uint32_t v = 0; v < vertexCount; v++)
             {
                 GLTFVertex vert = {};
                 vert.pos = glm::vec4(glm::make_vec3(&bufferPos[v * 3]), 1.0f);
-                vert.normal = glm::normalize(glm::vec3(bufferNormals ? glm::make_vec3(&bufferNormals[v * 3]) : glm::vec3(0.0f)));
-                vert.uv = bufferTexCoords ? glm::make_vec2(&bufferTexCoords[v * 2]) : glm::vec3(0.0f);
-                vert.tangent = bufferTangents ? glm::vec4(glm::make_vec4(&bufferTangents[v * 4])) : glm::vec4(0.0f);
-                vert.joint0 = hasSkin ? glm::vec4(glm::make_vec4(&bufferJoints[v * 4])) : glm::vec4(0.0f);
+                vert.normal = glm::normalize(glm::vec3(hasNormals ? glm::make_vec3(&bufferNormals[v * 3]) : glm::vec3(0.0f)));
+                vert.uv = hasTexCoords ? glm::make_vec2(&bufferTexCoords[v * 2]) : glm::vec3(0.0f);
+                vert.tangent = hasTangents ? glm::make_vec4(&bufferTangents[v * 4]) : glm::vec4(0.0f);
+                vert.joint0 = hasSkin ? glm::make_vec4(&bufferJoints[v * 4]) : glm::vec4(0.0f);
                 vert.weight0 = hasSkin ? glm::make_vec4(&bufferWeights[v * 4]) : glm::vec4(0.0f);
                 vertexBuffer.push_back(vert);
             }
 
             spdlog::info("{}", vertexBuffer.size());
 
+            // morph targets, the displacements of the model vertices this primitive does not cover stay zero
+            auto &morphTargets = gltfModel.morphTargets;
+            if (morphTargets.size() < primitive.targets.size())
+            {
+                morphTargets.resize(primitive.targets.size());
+            }
+            for (auto &target : morphTargets)
+            {
+                target.positions.resize(vertexBuffer.size(), glm::vec3(0.0f));
+                target.normals.resize(vertexBuffer.size(), glm::vec3(0.0f));
+                target.tangents.resize(vertexBuffer.size(), glm::vec3(0.0f));
+            }
+            for (size_t t = 0; t < primitive.targets.size(); t++)
+            {
+                auto &target = primitive.targets[t];
+                auto readTarget = [&](const char *attribute, std::vector<glm::vec3> &deltas)
+                {
+                    if (!target.count(attribute))
+                        return;
+                    auto values = ReadAccessor(model, target.at(attribute));
+                    for (uint32_t v = 0; v < vertexCount && v * 3 + 2 < values.size(); v++)
+                    {
+                        deltas[vertexOffset + v] = glm::make_vec3(&values[v * 3]);
+                    }
+                };
+                readTarget("POSITION", morphTargets[t].positions);
+                readTarget("NORMAL", morphTargets[t].normals);
+                readTarget("TANGENT", morphTargets[t].tangents);
+            }
+
             {
                 // read indices
                 auto &accessor = model.accessors[primitive.indices];
@@ -176,11 +285,160 @@ std::vector<GLTFModel> GLTFReader::ReadFile(PixelEngine *engine, std::string fil
                 {.firstVertex = vertexOffset,
                  .vertexCount = vertexCount,
                  .firstIndex = indexOffset,
-                 .indexCount = indexCount});
+                 .indexCount = indexCount,
+                 .boundsMin = posMin,
+                 .boundsMax = posMax});
         }
 
+        gltfModel.morphWeights.assign(mesh.weights.begin(), mesh.weights.end());
+        gltfModel.morphWeights.resize(gltfModel.morphTargets.size(), 0.0f);
+
         gltfModels.push_back(gltfModel);
     }
 
     return gltfModels;
 }
+
+std::vector<GLTFModel> GLTFReader::ReadFile(PixelEngine *engine, std::string file)
+{
+    TRACE_SCOPE("GLTFReader::ReadFile");
+
+    tinygltf::Model model;
+    if (!LoadModel(file, model))
+        return {};
+
+    return ReadModels(model);
+}
+
+GLTFScene GLTFReader::ReadScene(PixelEngine *engine, std::string file)
+{
+    TRACE_SCOPE("GLTFReader::ReadScene");
+
+    tinygltf::Model model;
+    if (!LoadModel(file, model))
+        return {};
+
+    GLTFScene scene;
+    scene.models = ReadModels(model);
+
+    for (auto &node : model.nodes)
+    {
+        GLTFNode gltfNode;
+        gltfNode.name = node.name;
+        gltfNode.mesh = node.mesh;
+        gltfNode.skin = node.skin;
+        gltfNode.children.assign(node.children.begin(), node.children.end());
+        if (node.translation.size() == 3)
+            gltfNode.translation = glm::vec3(glm::make_vec3(node.translation.data()));
+        // stored as x, y, z, w
+        if (node.rotation.size() == 4)
+            gltfNode.rotation = glm::quat(float(node.rotation[3]), float(node.rotation[0]), float(node.rotation[1]), float(node.rotation[2]));
+        if (node.scale.size() == 3)
+            gltfNode.scale = glm::vec3(glm::make_vec3(node.scale.data()));
+        if (node.matrix.size() == 16)
+            gltfNode.matrix = glm::mat4(glm::make_mat4(node.matrix.data()));
+        gltfNode.weights.assign(node.weights.begin(), node.weights.end());
+        scene.nodes.push_back(gltfNode);
+    }
+
+    for (uint32_t i = 0; i < scene.nodes.size(); i++)
+    {
+        for (auto child : scene.nodes[i].children)
+        {
+            if (child >= scene.nodes.size())
+            {
+                throw std::runtime_error("gltf: invalid child of node " + std::to_string(i));
+            }
+            scene.nodes[child].parent = i;
+        }
+    }
+
+    // every root if there is no scene
+    if (!model.scenes.empty())
+    {
+        auto &roots = model.scenes[std::max(model.defaultScene, 0)].nodes;
+        scene.roots.assign(roots.begin(), roots.end());
+    }
+    else
+    {
+        for (uint32_t i = 0; i < scene.nodes.size(); i++)
+        {
+            if (scene.nodes[i].parent < 0)
+                scene.roots.push_back(i);
+        }
+    }
+
+    for (auto &skin : model.skins)
+    {
+        GLTFSkin gltfSkin;
+        gltfSkin.name = skin.name;
+        gltfSkin.joints.assign(skin.joints.begin(), skin.joints.end());
+        gltfSkin.inverseBindMatrices.resize(skin.joints.size(), glm::mat4(1.0f));
+        if (skin.inverseBindMatrices >= 0)
+        {
+            auto matrices = ReadAccessor(model, skin.inverseBindMatrices);
+            for (size_t j = 0; j < gltfSkin.joints.size() && j * 16 + 15 < matrices.size(); j++)
+            {
+                gltfSkin.inverseBindMatrices[j] = glm::make_mat4(&matrices[j * 16]);
+            }
+        }
+        scene.skins.push_back(gltfSkin);
+    }
+
+    for (auto &animation : model.animations)
+    {
+        GLTFAnimation gltfAnimation;
+        gltfAnimation.name = animation.name;
+        gltfAnimation.start = FLT_MAX;
+        gltfAnimation.end = 0.0f;
+
+        for (auto &sampler : animation.samplers)
+        {
+            GLTFAnimationSampler gltfSampler;
+            if (sampler.interpolation == "STEP")
+                gltfSampler.interpolation = GLTFAnimationSampler::STEP;
+            else if (sampler.interpolation == "CUBICSPLINE")
+                gltfSampler.interpolation = GLTFAnimationSampler::CUBICSPLINE;
+            gltfSampler.times = ReadAccessor(model, sampler.input);
+            gltfSampler.values = ReadAccessor(model, sampler.output);
+            if (!gltfSampler.times.empty())
+            {
+                gltfAnimation.start = std::min(gltfAnimation.start, gltfSampler.times.front());
+                gltfAnimation.end = std::max(gltfAnimation.end, gltfSampler.times.back());
+            }
+            gltfAnimation.samplers.push_back(gltfSampler);
+        }
+
+        for (auto &channel : animation.channels)
+        {
+            // KHR_animation_pointer and friends have no target node
+            if (channel.target_node < 0 || channel.sampler < 0)
+                continue;
+
+            GLTFAnimationChannel gltfChannel;
+            if (channel.target_path == "translation")
+                gltfChannel.path = GLTFAnimationChannel::TRANSLATION;
+            else if (channel.target_path == "rotation")
+                gltfChannel.path = GLTFAnimationChannel::ROTATION;
+            else if (channel.target_path == "scale")
+                gltfChannel.path = GLTFAnimationChannel::SCALE;
+            else if (channel.target_path == "weights")
+                gltfChannel.path = GLTFAnimationChannel::WEIGHTS;
+            else
+                continue;
+            gltfChannel.node = channel.target_node;
+            gltfChannel.sampler = channel.sampler;
+            gltfAnimation.channels.push_back(gltfChannel);
+        }
+
+        if (gltfAnimation.start > gltfAnimation.end)
+        {
+            gltfAnimation.start = gltfAnimation.end = 0.0f;
+        }
+        scene.animations.push_back(gltfAnimation);
+    }
+
+    spdlog::info("gltf {}: {} meshes, {} nodes, {} skins, {} animations", file, scene.models.size(), scene.nodes.size(), scene.skins.size(), scene.animations.size());
+
+    return scene;
+}
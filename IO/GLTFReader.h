@@ -1,6 +1,10 @@
 #pragma once
 
 #include <string>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/quaternion.hpp>
 
 #include <Core/IntrusivePtr.h>
 
@@ -23,6 +27,18 @@ struct GLTFModelPrimitive
 
     uint32_t firstIndex;
     uint32_t indexCount;
+
+    // object space box of the POSITION accessor
+    glm::vec3 boundsMin;
+    glm::vec3 boundsMax;
+};
+
+// displacements of every vertex of the model, zero for primitives without the target
+struct GLTFMorphTarget
+{
+    std::vector<glm::vec3> positions;
+    std::vector<glm::vec3> normals;
+    std::vector<glm::vec3> tangents;
 };
 
 struct GLTFModel
@@ -30,10 +46,104 @@ struct GLTFModel
     std::vector<GLTFVertex> vertexBuffer;
     std::vector<uint32_t> indexBuffer;
     std::vector<GLTFModelPrimitive> primitives;
+
+    std::vector<GLTFMorphTarget> morphTargets;
+    // mesh weights, nodes may override them
+    std::vector<float> morphWeights;
+};
+
+// local transform is matrix * translation * rotation * scale, animations only drive nodes without matrix
+struct GLTFNode
+{
+    std::string name;
+    int32_t parent = -1;
+    std::vector<uint32_t> children;
+
+    // index into GLTFScene::models and GLTFScene::skins
+    int32_t mesh = -1;
+    int32_t skin = -1;
+
+    glm::vec3 translation = glm::vec3(0.0f);
+    glm::quat rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+    glm::vec3 scale = glm::vec3(1.0f);
+    glm::mat4 matrix = glm::mat4(1.0f);
+
+    // morph weights of the mesh instance, empty for the mesh weights
+    std::vector<float> weights;
+};
+
+struct GLTFSkin
+{
+    std::string name;
+    // node of every joint, JOINTS_0 indexes this list
+    std::vector<uint32_t> joints;
+    // identity if the file has none
+    std::vector<glm::mat4> inverseBindMatrices;
+};
+
+struct GLTFAnimationSampler
+{
+    enum Interpolation
+    {
+        LINEAR,
+        STEP,
+        // values hold in tangent, value and out tangent of every key
+        CUBICSPLINE,
+    };
+
+    Interpolation interpolation = LINEAR;
+    // seconds, ascending
+    std::vector<float> times;
+    // flat floats, the channel path gives the width of an element
+    std::vector<float> values;
+};
+
+struct GLTFAnimationChannel
+{
+    enum Path
+    {
+        TRANSLATION,
+        ROTATION,
+        SCALE,
+        WEIGHTS,
+    };
+
+    Path path;
+    uint32_t node;
+    uint32_t sampler;
+};
+
+struct GLTFAnimation
+{
+    std::string name;
+    std::vector<GLTFAnimationSampler> samplers;
+    std::vector<GLTFAnimationChannel> channels;
+
+    // seconds, span of all sampler inputs
+    float start = 0.0f;
+    float end = 0.0f;
+};
+
+// node hierarchy of the default scene with the skins and animations driving it
+struct GLTFScene
+{
+    // one per gltf mesh, as ReadFile returns them
+    std::vector<GLTFModel> models;
+    std::vector<GLTFNode> nodes;
+    std::vector<GLTFSkin> skins;
+    std::vector<GLTFAnimation> animations;
+
+    // nodes without parent of the default scene
+    std::vector<uint32_t> roots;
 };
 
 class GLTFReader
 {
 public:
+    // meshes only, empty if the file cannot be read
     static std::vector<GLTFModel> ReadFile(PixelEngine *engine, std::string file);
+
+    // meshes, nodes, skins, morph targets and animations, empty if the file cannot be read
+    // sparse accessors are not supported and read as zeros
+    static GLTFScene ReadScene(PixelEngine *engine, std::string file);
 };
\ No newline at end of file
@@ -0,0 +1,93 @@
+#include <IO/ImageWriter.h>
+
+#include <vector>
+
+#include <stb_image_write.h>
+
+#include <glm/gtc/packing.hpp>
+
+#include <spdlog/spdlog.h>
+
+bool ImageWriter::WriteFile(IntrusivePtr<Readback> readback, std::string file)
+{
+    auto extent = readback->GetExtent();
+    int width = extent.width;
+    int height = extent.height;
+    size_t pixelCount = size_t(width) * height;
+
+    auto data = readback->Data();
+    if (!data)
+    {
+        spdlog::error("readback for {} failed", file);
+        return false;
+    }
+
+    int result = 0;
+    switch (readback->GetTextureFormat())
+    {
+    case TextureFormat::FORMAT_R8G8B8A8_UNORM:
+    {
+        result = stbi_write_png(file.c_str(), width, height, 4, data, width * 4);
+        break;
+    }
+    case TextureFormat::FORMAT_B8G8R8A8_SRGB:
+    case TextureFormat::FORMAT_B8G8R8A8_UNORM:
+    {
+        auto src = (const uint8_t *)data;
+        std::vector<uint8_t> pixels(pixelCount * 4);
+        for (size_t i = 0; i < pixelCount; i++)
+        {
+            pixels[i * 4 + 0] = src[i * 4 + 2];
+            pixels[i * 4 + 1] = src[i * 4 + 1];
+            pixels[i * 4 + 2] = src[i * 4 + 0];
+            pixels[i * 4 + 3] = src[i * 4 + 3];
+        }
+        result = stbi_write_png(file.c_str(), width, height, 4, pixels.data(), width * 4);
+        break;
+    }
+    case TextureFormat::FORMAT_R16G16B16A16_SFLOAT:
+    {
+        auto src = (const uint16_t *)data;
+        std::vector<float> pixels(pixelCount * 4);
+        for (size_t i = 0; i < pixels.size(); i++)
+        {
+            pixels[i] = glm::unpackHalf1x16(src[i]);
+        }
+        result = stbi_write_hdr(file.c_str(), width, height, 4, pixels.data());
+        break;
+    }
+    case TextureFormat::FORMAT_R32G32_SFLOAT:
+    {
+        auto src = (const float *)data;
+        std::vector<float> pixels(pixelCount * 3, 0.0f);
+        for (size_t i = 0; i < pixelCount; i++)
+        {
+            pixels[i * 3 + 0] = src[i * 2 + 0];
+            pixels[i * 3 + 1] = src[i * 2 + 1];
+        }
+        result = stbi_write_hdr(file.c_str(), width, height, 3, pixels.data());
+        break;
+    }
+    case TextureFormat::FORMAT_D16_UNORM:
+    {
+        auto src = (const uint16_t *)data;
+        std::vector<uint8_t> pixels(pixelCount);
+        for (size_t i = 0; i < pixelCount; i++)
+        {
+            pixels[i] = uint8_t(src[i] >> 8);
+        }
+        result = stbi_write_png(file.c_str(), width, height, 1, pixels.data(), width);
+        break;
+    }
+    default:
+        spdlog::error("ImageWriter: unsupported readback format");
+        return false;
+    }
+
+    if (!result)
+    {
+        spdlog::error("ImageWriter: failed to write {}", file);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <string>
+
+#include <RHI/Readback.h>
+
+class ImageWriter
+{
+public:
+    // 8 bit formats are written as png, float formats as radiance hdr
+    static bool WriteFile(IntrusivePtr<Readback> readback, std::string file);
+};
@@ -17,9 +17,6 @@ IntrusivePtr<Texture> KTXReader::ReadFile(PixelEngine *engine, std::string file)
     auto ktxTextureData = ktxTexture_GetData(ktxTexture);
     auto ktxTextureSize = ktxTexture_GetDataSize(ktxTexture);
 
-    auto uploadBuffer = rhiRuntime->CreateBuffer(Buffer::BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, ktxTextureSize);
-    memcpy(uploadBuffer->Map(), ktxTextureData, ktxTextureSize);
-
     auto texture = rhiRuntime->CreateTexture(TextureFormat::FORMAT_R8G8B8A8_UNORM, Texture::IMAGE_USAGE_TRANSFER_DST_BIT | Texture::IMAGE_USAGE_SAMPLED_BIT, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, {ktxTexture->baseWidth, ktxTexture->baseHeight, 1}, config);
 
     AuxiliaryExecutor::TransferConfig transferConfigs;
@@ -33,7 +30,8 @@ IntrusivePtr<Texture> KTXReader::ReadFile(PixelEngine *engine, std::string file)
         transferConfigs.mipmapBufferLevelOffsets.push_back(offset);
     }
 
-    engine->GetAuxiliaryExecutor()->TransferResource(texture, uploadBuffer, transferConfigs);
+    engine->GetAuxiliaryExecutor()->TransferResource(texture, ktxTextureData, ktxTextureSize, transferConfigs);
+    ktxTexture_Destroy(ktxTexture);
 
     return texture;
 }
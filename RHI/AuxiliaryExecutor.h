@@ -3,6 +3,7 @@
 #include <RHI/Executor.h>
 #include <RHI/Texture.h>
 #include <RHI/Buffer.h>
+#include <RHI/Readback.h>
 
 class AuxiliaryExecutor : public Executor
 {
@@ -19,4 +20,14 @@ public:
 
     virtual void TransferResource(IntrusivePtr<Texture> gpuTexture, IntrusivePtr<Buffer> hostBuffer, TransferConfig config = {}) = 0;
     virtual void TransferResource(IntrusivePtr<Buffer> gpuBuffer, IntrusivePtr<Buffer> hostBuffer) = 0;
+
+    // copy host data through the runtime staging memory, no dedicated host buffer required
+    virtual void TransferResource(IntrusivePtr<Texture> gpuTexture, const void *data, size_t size, TransferConfig config = {}) = 0;
+    virtual void TransferResource(IntrusivePtr<Buffer> gpuBuffer, const void *data, size_t size) = 0;
+
+    // copy gpu data back to host memory, recorded on the next Execute
+    // texture is read from the layout the runtime leaves it in (attachment, sampled or swapchain)
+    virtual IntrusivePtr<Readback> ReadbackResource(IntrusivePtr<Texture> gpuTexture, uint32_t mipLevel = 0, uint32_t arrayLayer = 0) = 0;
+    // buffer requires BUFFER_USAGE_TRANSFER_SRC_BIT, size 0 reads until the end of buffer, throws if the range is outside it
+    virtual IntrusivePtr<Readback> ReadbackResource(IntrusivePtr<Buffer> gpuBuffer, size_t offset = 0, size_t size = 0) = 0;
 };
\ No newline at end of file
@@ -0,0 +1,209 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <stdexcept>
+#include <type_traits>
+
+#include <RHI/PipelineStates.h>
+
+// binary layout of a frame capture
+// header followed by records, each record is | type u32 | size u64 | payload |
+// objects are referred by capture ids, 0 is null or a resource created outside the runtime
+namespace CaptureFormat
+{
+    static constexpr char MAGIC[8] = {'P', 'X', 'C', 'A', 'P', 'T', 'U', 'R'};
+    static constexpr uint32_t VERSION = 6;
+
+    enum class Record : uint32_t
+    {
+        // spir-v referenced by a graph or pipeline, keyed by the original path
+        SHADER,
+        SWAPCHAIN,
+        RENDER_GROUP,
+        GRAPHICS_PIPELINE,
+        COMPUTE_PIPELINE,
+        BUFFER,
+        MUTABLE_BUFFER,
+        DYNAMIC_BUFFER,
+        STREAMING_BUFFER,
+        TEXTURE,
+        SAMPLER,
+        BINDING_STATE,
+        BIND,
+        BIND_CONSTANT,
+        ADD_BINDING_STATE,
+        ADD_RENDER_GROUP,
+        BIND_GLOBAL_RESOURCE,
+        TRANSFER_BUFFER,
+        TRANSFER_TEXTURE,
+        // draw state and host memory changes since the previous frame, then the frame is executed
+        FRAME,
+    };
+
+    // ResourceBindingState::DispatchOP with the resource replaced by its id
+    struct Dispatch
+    {
+        uint32_t type;
+        uint32_t groupCount[3];
+        uint32_t resource;
+        uint32_t elementSize;
+        uint64_t offset;
+    };
+
+    // ResourceBindingState::IndirectDrawOP with the resource replaced by its id
+    struct IndirectDraw
+    {
+        uint32_t resource;
+        uint32_t drawCount;
+        uint64_t offset;
+        uint32_t stride;
+        uint32_t countResource;
+        uint64_t countOffset;
+    };
+
+    class Writer
+    {
+    public:
+        template <class T>
+        void Write(const T &value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            Write(&value, sizeof(T));
+        }
+
+        void Write(const void *data, size_t size)
+        {
+            auto offset = buffer.size();
+            buffer.resize(offset + size);
+            if (size)
+                memcpy(buffer.data() + offset, data, size);
+        }
+
+        void WriteString(const std::string &str)
+        {
+            WriteBytes(str.data(), str.size());
+        }
+
+        // size prefixed
+        void WriteBytes(const void *data, size_t size)
+        {
+            Write(uint64_t(size));
+            Write(data, size);
+        }
+
+        template <class T>
+        void WriteVector(const std::vector<T> &values)
+        {
+            WriteBytes(values.data(), values.size() * sizeof(T));
+        }
+
+        std::vector<char> &Data()
+        {
+            return buffer;
+        }
+
+    private:
+        std::vector<char> buffer;
+    };
+
+    class Reader
+    {
+    public:
+        Reader(const char *data, size_t size) : data(data), size(size) {}
+
+        template <class T>
+        T Read()
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            T value;
+            memcpy(&value, take(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        std::string ReadString()
+        {
+            auto length = Read<uint64_t>();
+            return std::string(take(length), length);
+        }
+
+        // points into the capture, valid as long as the capture data
+        const char *ReadBytes(size_t &length)
+        {
+            length = Read<uint64_t>();
+            return take(length);
+        }
+
+        template <class T>
+        std::vector<T> ReadVector()
+        {
+            size_t length;
+            auto bytes = ReadBytes(length);
+            std::vector<T> values(length / sizeof(T));
+            if (length)
+                memcpy(values.data(), bytes, values.size() * sizeof(T));
+            return values;
+        }
+
+        bool End()
+        {
+            return offset >= size;
+        }
+
+    private:
+        const char *data;
+        size_t size;
+        size_t offset = 0;
+
+        const char *take(size_t length)
+        {
+            if (offset + length > size)
+            {
+                throw std::runtime_error("capture record is truncated!");
+            }
+            auto result = data + offset;
+            offset += length;
+            return result;
+        }
+    };
+
+    inline void WriteShaderState(Writer &writer, const ShaderState &shaderState)
+    {
+        writer.WriteString(shaderState.vertexShaderPath);
+        writer.WriteString(shaderState.fragmentShaderPath);
+        writer.WriteString(shaderState.computeShaderPath);
+    }
+
+    inline ShaderState ReadShaderState(Reader &reader)
+    {
+        ShaderState shaderState;
+        shaderState.vertexShaderPath = reader.ReadString();
+        shaderState.fragmentShaderPath = reader.ReadString();
+        shaderState.computeShaderPath = reader.ReadString();
+        return shaderState;
+    }
+
+    inline void WritePipelineStates(Writer &writer, const PipelineStates &pipelineStates)
+    {
+        writer.WriteVector(pipelineStates.vertexInputStates);
+        writer.Write(pipelineStates.inputAssembleState);
+        writer.Write(pipelineStates.rasterizationState);
+        writer.WriteVector(pipelineStates.colorBlendAttachmentStates);
+        writer.Write(pipelineStates.depthStencilState);
+        WriteShaderState(writer, pipelineStates.shaderState);
+    }
+
+    inline PipelineStates ReadPipelineStates(Reader &reader)
+    {
+        PipelineStates pipelineStates;
+        pipelineStates.vertexInputStates = reader.ReadVector<VertexInputState>();
+        pipelineStates.inputAssembleState = reader.Read<InputAssembleState>();
+        pipelineStates.rasterizationState = reader.Read<RasterizationState>();
+        pipelineStates.colorBlendAttachmentStates = reader.ReadVector<ColorBlendAttachmentState>();
+        pipelineStates.depthStencilState = reader.Read<DepthStencilState>();
+        pipelineStates.shaderState = ReadShaderState(reader);
+        return pipelineStates;
+    }
+}
@@ -0,0 +1,626 @@
+#include <RHI/CaptureRecorder.h>
+
+#include <fstream>
+
+#include <spdlog/spdlog.h>
+
+#include <Core/ReadFile.h>
+
+using CaptureFormat::Record;
+using CaptureFormat::Writer;
+
+CaptureRecorder::~CaptureRecorder()
+{
+    // handles outliving the recorder must not report to it
+    for (auto &[_, object] : tracked)
+    {
+        if (object.resource)
+            object.resource->captureRecorder = nullptr;
+        if (object.pipeline)
+            object.pipeline->captureRecorder = nullptr;
+    }
+}
+
+void CaptureRecorder::Capture(std::string path, uint32_t frameCount)
+{
+    if (!enabled)
+    {
+        spdlog::warn("capture recorder is not enabled, {} is not written", path);
+        return;
+    }
+
+    this->path = path;
+    this->frameCount = frameCount;
+    this->capturedFrames = 0;
+
+    capture.clear();
+    for (auto &[_, record] : preamble)
+    {
+        capture.insert(capture.end(), record.begin(), record.end());
+    }
+
+    // first frame of a capture carries every draw state and host buffer
+    lastContents.clear();
+}
+
+uint32_t CaptureRecorder::assignId(const void *object, ResourceHandle *resource, Pipeline *pipeline)
+{
+    // a recreated object at the same address starts over
+    if (auto previous = id(object))
+    {
+        forget(previous);
+    }
+
+    auto newId = nextId++;
+    ids[object] = newId;
+    tracked[newId] = {.object = object, .resource = resource, .pipeline = pipeline};
+
+    if (resource)
+        resource->captureRecorder = this;
+    if (pipeline)
+        pipeline->captureRecorder = this;
+    return newId;
+}
+
+uint32_t CaptureRecorder::id(const void *object)
+{
+    auto it = ids.find(object);
+    return it == ids.end() ? 0 : it->second;
+}
+
+void CaptureRecorder::forget(uint32_t objectId)
+{
+    auto it = tracked.find(objectId);
+    if (it == tracked.end())
+    {
+        return;
+    }
+
+    for (auto sequence : it->second.records)
+    {
+        preamble.erase(sequence);
+    }
+    std::erase_if(latest, [&](auto &entry)
+                  { return std::get<0>(entry.first) == objectId; });
+    std::erase_if(lastContents, [&](auto &entry)
+                  { return uint32_t(entry.first >> 32) == objectId; });
+
+    // bound handles are dereferenced when the frame is sampled
+    if (it->second.resource)
+    {
+        for (auto &[_, bindings] : stateBindings)
+        {
+            for (auto &[binding, resources] : bindings)
+            {
+                std::erase(resources, it->second.resource);
+            }
+        }
+    }
+    stateBindings.erase(objectId);
+    hostBuffers.erase(objectId);
+
+    ids.erase(it->second.object);
+    tracked.erase(it);
+}
+
+void CaptureRecorder::append(Record type, Writer &payload, uint32_t owner, std::optional<uint64_t> key)
+{
+    Writer header;
+    header.Write(type);
+    header.Write(uint64_t(payload.Data().size()));
+
+    std::vector<char> record;
+    record.reserve(header.Data().size() + payload.Data().size());
+    record.insert(record.end(), header.Data().begin(), header.Data().end());
+    record.insert(record.end(), payload.Data().begin(), payload.Data().end());
+
+    if (IsCapturing())
+    {
+        capture.insert(capture.end(), record.begin(), record.end());
+    }
+
+    if (type == Record::FRAME)
+    {
+        return;
+    }
+
+    auto ownerIt = tracked.find(owner);
+    if (owner && ownerIt == tracked.end())
+    {
+        return;
+    }
+
+    auto sequence = nextSequence++;
+    if (key)
+    {
+        auto &last = latest[{owner, type, *key}];
+        if (preamble.erase(last) && owner)
+        {
+            std::erase(ownerIt->second.records, last);
+        }
+        last = sequence;
+    }
+
+    preamble[sequence] = std::move(record);
+    if (owner)
+    {
+        ownerIt->second.records.push_back(sequence);
+    }
+}
+
+void CaptureRecorder::recordShader(const std::string &path)
+{
+    if (path.empty() || recordedShaders.count(path))
+    {
+        return;
+    }
+    recordedShaders.insert(path);
+
+    auto code = ReadBinaryFile(path);
+    if (code.empty())
+    {
+        spdlog::warn("capture: shader {} not found", path);
+    }
+
+    Writer payload;
+    payload.WriteString(path);
+    payload.WriteVector(code);
+    append(Record::SHADER, payload);
+}
+
+bool CaptureRecorder::changed(uint64_t key, const void *data, size_t size)
+{
+    auto &last = lastContents[key];
+    if (last.size() == size && memcmp(last.data(), data, size) == 0)
+    {
+        return false;
+    }
+
+    last.assign((const char *)data, (const char *)data + size);
+    return true;
+}
+
+void CaptureRecorder::RecordSwapChain(uint32_t width, uint32_t height)
+{
+    if (!enabled)
+        return;
+
+    Writer payload;
+    payload.Write(width);
+    payload.Write(height);
+    append(Record::SWAPCHAIN, payload, 0, 0);
+}
+
+void CaptureRecorder::RecordRenderGroup(RenderGroup *group, Graph *graph)
+{
+    if (!enabled)
+        return;
+
+    for (auto &subpass : graph->GetJson().subpasses)
+    {
+        recordShader(subpass.shaders.vertex);
+        recordShader(subpass.shaders.fragment);
+        recordShader(subpass.shaders.compute);
+    }
+
+    auto groupId = assignId(group);
+
+    Writer payload;
+    payload.Write(groupId);
+    payload.WriteString(JS::serializeStruct(graph->GetJson()));
+    append(Record::RENDER_GROUP, payload, groupId);
+}
+
+void CaptureRecorder::RecordPipeline(Pipeline *pipeline, RenderGroup *group, const std::string &subPassName, const PipelineStates &pipelineStates)
+{
+    if (!enabled)
+        return;
+
+    recordShader(pipelineStates.shaderState.vertexShaderPath);
+    recordShader(pipelineStates.shaderState.fragmentShaderPath);
+
+    auto pipelineId = assignId(pipeline, nullptr, pipeline);
+
+    Writer payload;
+    payload.Write(pipelineId);
+    payload.Write(id(group));
+    payload.WriteString(subPassName);
+    CaptureFormat::WritePipelineStates(payload, pipelineStates);
+    append(Record::GRAPHICS_PIPELINE, payload, pipelineId);
+}
+
+void CaptureRecorder::RecordPipeline(Pipeline *pipeline, RenderGroup *group, const std::string &subPassName, const ComputePipelineStates &pipelineStates)
+{
+    if (!enabled)
+        return;
+
+    recordShader(pipelineStates.shaderState.computeShaderPath);
+
+    auto pipelineId = assignId(pipeline, nullptr, pipeline);
+
+    Writer payload;
+    payload.Write(pipelineId);
+    payload.Write(id(group));
+    payload.WriteString(subPassName);
+    payload.Write(pipelineStates.localGroupSize);
+    payload.Write(pipelineStates.autotune);
+    payload.Write(pipelineStates.idempotent);
+    CaptureFormat::WriteShaderState(payload, pipelineStates.shaderState);
+    append(Record::COMPUTE_PIPELINE, payload, pipelineId);
+}
+
+void CaptureRecorder::RecordBuffer(Buffer *buffer, Buffer::TypeBits type, MemoryPropertyBits memoryProperties, uint32_t size)
+{
+    if (!enabled)
+        return;
+
+    auto bufferId = assignId(buffer, buffer);
+    if (memoryProperties & (MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_LOCAL_BIT))
+    {
+        hostBuffers.insert(bufferId);
+    }
+
+    Writer payload;
+    payload.Write(bufferId);
+    payload.Write(type);
+    payload.Write(memoryProperties);
+    payload.Write(size);
+    append(Record::BUFFER, payload, bufferId);
+}
+
+void CaptureRecorder::RecordMutableBuffer(MutableBuffer *buffer, Buffer *defaultBuffer)
+{
+    if (!enabled)
+        return;
+
+    auto bufferId = assignId(buffer, buffer);
+    if (hostBuffers.count(id(defaultBuffer)))
+    {
+        hostBuffers.insert(bufferId);
+    }
+
+    Writer payload;
+    payload.Write(bufferId);
+    payload.Write(id(defaultBuffer));
+    append(Record::MUTABLE_BUFFER, payload, bufferId);
+}
+
+void CaptureRecorder::RecordDynamicBuffer(DynamicBuffer *buffer)
+{
+    if (!enabled)
+        return;
+
+    auto bufferId = assignId(buffer, buffer);
+
+    Writer payload;
+    payload.Write(bufferId);
+    payload.Write(uint32_t(buffer->Size()));
+    append(Record::DYNAMIC_BUFFER, payload, bufferId);
+}
+
+void CaptureRecorder::RecordStreamingBuffer(StreamingBuffer *buffer, Buffer::TypeBits type, uint32_t initialCapacity)
+{
+    if (!enabled)
+        return;
+
+    auto bufferId = assignId(buffer, buffer);
+
+    Writer payload;
+    payload.Write(bufferId);
+    payload.Write(type);
+    payload.Write(initialCapacity);
+    append(Record::STREAMING_BUFFER, payload, bufferId);
+}
+
+void CaptureRecorder::RecordTexture(Texture *texture, TextureFormat format, Texture::UsageBits type, MemoryPropertyBits memoryProperties, Texture::Extent extent, Texture::Configuration config)
+{
+    if (!enabled)
+        return;
+
+    auto textureId = assignId(texture, texture);
+
+    Writer payload;
+    payload.Write(textureId);
+    payload.Write(format);
+    payload.Write(type);
+    payload.Write(memoryProperties);
+    payload.Write(extent);
+    payload.Write(config);
+    append(Record::TEXTURE, payload, textureId);
+}
+
+void CaptureRecorder::RecordSampler(Sampler *sampler, Texture *texture, Sampler::Configuration config)
+{
+    if (!enabled)
+        return;
+
+    auto samplerId = assignId(sampler, sampler);
+
+    Writer payload;
+    payload.Write(samplerId);
+    payload.Write(id(texture));
+    payload.Write(config);
+    append(Record::SAMPLER, payload, samplerId);
+}
+
+void CaptureRecorder::RecordBindingState(ResourceBindingState *state, Pipeline *pipeline)
+{
+    if (!enabled)
+        return;
+
+    auto stateId = assignId(state);
+    stateBindings[stateId].clear();
+
+    Writer payload;
+    payload.Write(stateId);
+    payload.Write(id(pipeline));
+    append(Record::BINDING_STATE, payload, stateId);
+}
+
+void CaptureRecorder::RecordBind(ResourceBindingState *state, uint32_t set, uint32_t binding, const std::vector<IntrusivePtr<ResourceHandle>> &resources)
+{
+    if (!enabled)
+        return;
+
+    auto stateId = id(state);
+    auto &bound = stateBindings[stateId][{set, binding}];
+    bound.clear();
+
+    std::vector<uint32_t> resourceIds;
+    for (auto &resource : resources)
+    {
+        resourceIds.push_back(id(resource.get()));
+        bound.push_back(resource.get());
+    }
+
+    Writer payload;
+    payload.Write(stateId);
+    payload.Write(set);
+    payload.Write(binding);
+    payload.WriteVector(resourceIds);
+    append(Record::BIND, payload, stateId, uint64_t(set) << 32 | binding);
+}
+
+void CaptureRecorder::RecordBindConstant(ResourceBindingState *state, ResourceHandle *resource)
+{
+    if (!enabled)
+        return;
+
+    auto stateId = id(state);
+    stateBindings[stateId][{UINT32_MAX, UINT32_MAX}] = {resource};
+
+    Writer payload;
+    payload.Write(stateId);
+    payload.Write(id(resource));
+    append(Record::BIND_CONSTANT, payload, stateId, 0);
+}
+
+void CaptureRecorder::RecordAddBindingState(RenderGroup *group, ResourceBindingState *state)
+{
+    if (!enabled)
+        return;
+
+    Writer payload;
+    payload.Write(id(group));
+    payload.Write(id(state));
+    append(Record::ADD_BINDING_STATE, payload, id(state));
+}
+
+void CaptureRecorder::RecordAddRenderGroup(RenderGroup *group)
+{
+    if (!enabled)
+        return;
+
+    Writer payload;
+    payload.Write(id(group));
+    append(Record::ADD_RENDER_GROUP, payload, id(group));
+}
+
+void CaptureRecorder::RecordBindGlobalResource(const std::string &name, const std::vector<IntrusivePtr<ResourceHandle>> &resources)
+{
+    if (!enabled)
+        return;
+
+    std::vector<uint32_t> resourceIds;
+    for (auto &resource : resources)
+    {
+        resourceIds.push_back(id(resource.get()));
+    }
+
+    Writer payload;
+    payload.WriteString(name);
+    payload.WriteVector(resourceIds);
+    append(Record::BIND_GLOBAL_RESOURCE, payload, 0, std::hash<std::string>{}(name));
+}
+
+void CaptureRecorder::RecordTransfer(Buffer *buffer, const void *data, size_t size)
+{
+    if (!enabled)
+        return;
+
+    // an upload replaces the whole content, only the latest one is kept
+    auto bufferId = id(buffer);
+    if (!bufferId)
+        return;
+
+    Writer payload;
+    payload.Write(bufferId);
+    payload.WriteBytes(data, size);
+    append(Record::TRANSFER_BUFFER, payload, bufferId, 0);
+}
+
+void CaptureRecorder::RecordTransfer(Texture *texture, const void *data, size_t size, const AuxiliaryExecutor::TransferConfig &config)
+{
+    if (!enabled)
+        return;
+
+    auto textureId = id(texture);
+    if (!textureId)
+        return;
+
+    Writer payload;
+    payload.Write(textureId);
+    payload.WriteVector(config.mipmapBufferLevelOffsets);
+    payload.WriteBytes(data, size);
+    append(Record::TRANSFER_TEXTURE, payload, textureId, 0);
+}
+
+void CaptureRecorder::RecordDestroy(const void *object)
+{
+    forget(id(object));
+}
+
+void CaptureRecorder::snapshot(Writer &writer, uint32_t &count, ResourceHandle *resource, uint32_t imageIndex)
+{
+    auto resourceId = id(resource);
+    if (!resourceId)
+    {
+        return;
+    }
+
+    const void *data = nullptr;
+    size_t size = 0;
+    uint32_t slot = 0;
+
+    switch (resource->type)
+    {
+    case ResourceHandle::DYNAMIC_BUFFER:
+    {
+        auto buffer = resource->As<DynamicBuffer>();
+        data = buffer->Map();
+        size = buffer->Size();
+        break;
+    }
+    case ResourceHandle::BUFFER:
+    {
+        if (!hostBuffers.count(resourceId))
+            return;
+        auto buffer = resource->As<Buffer>();
+        data = buffer->Map();
+        size = buffer->Size();
+        break;
+    }
+    case ResourceHandle::BUFFER_ARRAY:
+    {
+        if (!hostBuffers.count(resourceId))
+            return;
+        auto &buffer = resource->As<MutableBuffer>()->GetBuffer(imageIndex);
+        data = buffer->Map();
+        size = buffer->Size();
+        slot = imageIndex;
+        break;
+    }
+    case ResourceHandle::STREAMING_BUFFER:
+    {
+        // mapped memory is write-only, the buffer keeps a copy of what was written while capturing
+        data = resource->As<StreamingBuffer>()->CapturedContent(imageIndex, size);
+        slot = imageIndex;
+        break;
+    }
+    default:
+        return;
+    }
+
+    if (!data || !changed(uint64_t(resourceId) << 32 | slot, data, size))
+    {
+        return;
+    }
+
+    writer.Write(resourceId);
+    writer.WriteBytes(data, size);
+    count++;
+}
+
+void CaptureRecorder::RecordFrame(uint32_t imageIndex, const std::vector<ResourceBindingState *> &states)
+{
+    if (!IsCapturing())
+        return;
+
+    Writer drawStates;
+    uint32_t drawStateCount = 0;
+
+    Writer contents;
+    uint32_t contentCount = 0;
+
+    for (auto state : states)
+    {
+        auto stateId = id(state);
+        if (!stateId)
+        {
+            continue;
+        }
+
+        Writer drawState;
+        drawState.Write(stateId);
+        drawState.Write(id(state->GetVertexBuffers().get()));
+        drawState.Write(id(state->GetIndexBuffers().get()));
+        drawState.Write(state->GetIndexBufferType());
+        drawState.WriteVector(state->GetDrawOps());
+
+        std::vector<CaptureFormat::Dispatch> dispatches;
+        for (auto &dispatchOp : state->GetDispatchOps())
+        {
+            dispatches.push_back({uint32_t(dispatchOp.type),
+                                  {dispatchOp.groupCount.x, dispatchOp.groupCount.y, dispatchOp.groupCount.z},
+                                  id(dispatchOp.resource.get()),
+                                  dispatchOp.elementSize,
+                                  dispatchOp.offset});
+        }
+        drawState.WriteVector(dispatches);
+
+        std::vector<CaptureFormat::IndirectDraw> indirectDraws;
+        for (auto &drawOp : state->GetIndirectDrawOps())
+        {
+            indirectDraws.push_back({id(drawOp.resource.get()), drawOp.drawCount, drawOp.offset, drawOp.stride, id(drawOp.countResource.get()), drawOp.countOffset});
+        }
+        drawState.WriteVector(indirectDraws);
+
+        if (changed(uint64_t(stateId) << 32 | UINT32_MAX, drawState.Data().data(), drawState.Data().size()))
+        {
+            drawStates.Write(drawState.Data().data(), drawState.Data().size());
+            drawStateCount++;
+        }
+
+        snapshot(contents, contentCount, state->GetVertexBuffers().get(), imageIndex);
+        snapshot(contents, contentCount, state->GetIndexBuffers().get(), imageIndex);
+        for (auto &[_, resources] : stateBindings[stateId])
+        {
+            for (auto resource : resources)
+            {
+                snapshot(contents, contentCount, resource, imageIndex);
+            }
+        }
+    }
+
+    Writer payload;
+    payload.Write(imageIndex);
+    payload.Write(drawStateCount);
+    payload.Write(drawStates.Data().data(), drawStates.Data().size());
+    payload.Write(contentCount);
+    payload.Write(contents.Data().data(), contents.Data().size());
+    append(Record::FRAME, payload);
+}
+
+void CaptureRecorder::EndFrame()
+{
+    if (!IsCapturing())
+        return;
+
+    if (++capturedFrames < frameCount)
+        return;
+
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("failed to open capture file!");
+    }
+
+    file.write(CaptureFormat::MAGIC, sizeof(CaptureFormat::MAGIC));
+    file.write((const char *)&CaptureFormat::VERSION, sizeof(CaptureFormat::VERSION));
+    file.write(capture.data(), capture.size());
+
+    spdlog::info("capture of {} frames written to {}, {} bytes", frameCount, path, capture.size());
+
+    capture.clear();
+    capture.shrink_to_fit();
+}
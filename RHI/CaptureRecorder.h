@@ -0,0 +1,137 @@
+#pragma once
+
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <Core/IntrusivePtr.h>
+
+#include <FrameGraph/Graph.h>
+
+#include <RHI/CaptureFormat.h>
+#include <RHI/PipelineStates.h>
+#include <RHI/AuxiliaryExecutor.h>
+#include <RHI/ResourceBindingState.h>
+#include <RHI/RenderGroup.h>
+#include <RHI/Pipeline.h>
+#include <RHI/Buffer.h>
+#include <RHI/MutableBuffer.h>
+#include <RHI/DynamicBuffer.h>
+#include <RHI/StreamingBuffer.h>
+#include <RHI/Texture.h>
+#include <RHI/Sampler.h>
+
+// records rhi level calls so a few frames can be replayed without the application
+// must be enabled before the resources of interest are created, creation, binds and
+// uploads of live objects are kept in memory from then on, Capture writes them followed by the next frames
+class CaptureRecorder : public IntrusiveCounter<CaptureRecorder>
+{
+public:
+    ~CaptureRecorder();
+
+    void SetEnabled(bool enabled)
+    {
+        this->enabled = enabled;
+    }
+
+    bool IsEnabled()
+    {
+        return enabled;
+    }
+
+    bool IsCapturing()
+    {
+        return enabled && capturedFrames < frameCount;
+    }
+
+    // write a capture of the next frameCount frames to path once they are submitted
+    void Capture(std::string path, uint32_t frameCount = 1);
+
+    // runtime hooks, no-op unless enabled
+    void RecordSwapChain(uint32_t width, uint32_t height);
+    void RecordRenderGroup(RenderGroup *group, Graph *graph);
+    void RecordPipeline(Pipeline *pipeline, RenderGroup *group, const std::string &subPassName, const PipelineStates &pipelineStates);
+    void RecordPipeline(Pipeline *pipeline, RenderGroup *group, const std::string &subPassName, const ComputePipelineStates &pipelineStates);
+    void RecordBuffer(Buffer *buffer, Buffer::TypeBits type, MemoryPropertyBits memoryProperties, uint32_t size);
+    void RecordMutableBuffer(MutableBuffer *buffer, Buffer *defaultBuffer);
+    void RecordDynamicBuffer(DynamicBuffer *buffer);
+    void RecordStreamingBuffer(StreamingBuffer *buffer, Buffer::TypeBits type, uint32_t initialCapacity);
+    void RecordTexture(Texture *texture, TextureFormat format, Texture::UsageBits type, MemoryPropertyBits memoryProperties, Texture::Extent extent, Texture::Configuration config);
+    void RecordSampler(Sampler *sampler, Texture *texture, Sampler::Configuration config);
+    void RecordBindingState(ResourceBindingState *state, Pipeline *pipeline);
+    void RecordBind(ResourceBindingState *state, uint32_t set, uint32_t binding, const std::vector<IntrusivePtr<ResourceHandle>> &resources);
+    void RecordBindConstant(ResourceBindingState *state, ResourceHandle *resource);
+    void RecordAddBindingState(RenderGroup *group, ResourceBindingState *state);
+    void RecordAddRenderGroup(RenderGroup *group);
+    void RecordBindGlobalResource(const std::string &name, const std::vector<IntrusivePtr<ResourceHandle>> &resources);
+    void RecordTransfer(Buffer *buffer, const void *data, size_t size);
+    void RecordTransfer(Texture *texture, const void *data, size_t size, const AuxiliaryExecutor::TransferConfig &config);
+
+    // object destroyed, its records leave the preamble and its address may be reused
+    void RecordDestroy(const void *object);
+
+    // draw states about to be recorded for imageIndex, after all update callbacks ran
+    void RecordFrame(uint32_t imageIndex, const std::vector<ResourceBindingState *> &states);
+
+    // frame submitted, the capture is written after the last one
+    void EndFrame();
+
+private:
+    bool enabled = false;
+
+    std::string path;
+    uint32_t frameCount = 0;
+    uint32_t capturedFrames = 0;
+
+    // ids are never reused, the address of a destroyed object is given a new one
+    uint32_t nextId = 1;
+    std::unordered_map<const void *, uint32_t> ids;
+
+    // records kept for an id, dropped with the object
+    struct Tracked
+    {
+        const void *object;
+        // handles and pipelines point back to the recorder to report their destruction
+        ResourceHandle *resource;
+        Pipeline *pipeline;
+        std::vector<uint64_t> records;
+    };
+    std::unordered_map<uint32_t, Tracked> tracked;
+
+    // buffers whose content lives on the host and is written by the application
+    std::unordered_set<uint32_t> hostBuffers;
+
+    // non frame records of live objects by sequence starting at 1, the head of every capture
+    uint64_t nextSequence = 1;
+    std::map<uint64_t, std::vector<char>> preamble;
+
+    // sequence of the record that replaces earlier ones with the same (owner, type, key)
+    std::map<std::tuple<uint32_t, CaptureFormat::Record, uint64_t>, uint64_t> latest;
+
+    // preamble at Capture() followed by everything recorded while capturing
+    std::vector<char> capture;
+
+    std::unordered_set<std::string> recordedShaders;
+
+    // resources bound to each binding state, their host content is sampled every frame
+    std::unordered_map<uint32_t, std::map<std::pair<uint32_t, uint32_t>, std::vector<ResourceHandle *>>> stateBindings;
+
+    // last written draw state and content per (id, slot), only changes are written
+    std::unordered_map<uint64_t, std::vector<char>> lastContents;
+
+    uint32_t assignId(const void *object, ResourceHandle *resource = nullptr, Pipeline *pipeline = nullptr);
+    uint32_t id(const void *object);
+    void forget(uint32_t objectId);
+
+    // owner 0 keeps the record for the whole session, a key makes it replace the previous one
+    void append(CaptureFormat::Record type, CaptureFormat::Writer &payload, uint32_t owner = 0, std::optional<uint64_t> key = std::nullopt);
+    void recordShader(const std::string &path);
+
+    // true if the bytes differ from the last ones written under key
+    bool changed(uint64_t key, const void *data, size_t size);
+    void snapshot(CaptureFormat::Writer &writer, uint32_t &count, ResourceHandle *resource, uint32_t imageIndex);
+};
@@ -0,0 +1,499 @@
+#include <RHI/CaptureReplayer.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+#include <spdlog/spdlog.h>
+
+#include <Core/Trace.h>
+
+using CaptureFormat::Reader;
+using CaptureFormat::Record;
+
+static constexpr size_t HEADER_SIZE = sizeof(CaptureFormat::MAGIC) + sizeof(CaptureFormat::VERSION);
+
+CaptureReplayer::CaptureReplayer(IntrusivePtr<RHIRuntime> rhiRuntime, std::string shaderDirectory) : rhiRuntime(rhiRuntime), shaderDirectory(shaderDirectory)
+{
+    auxExecutor = rhiRuntime->CreateAuxiliaryExecutor();
+    executor = rhiRuntime->CreateRenderGroupExecutor();
+}
+
+CaptureReplayer::~CaptureReplayer()
+{
+    executor->WaitIdle();
+    executor->Reset();
+    executor.reset();
+
+    bindingStates.clear();
+    pipelines.clear();
+    resources.clear();
+    renderGroups.clear();
+    swapChain.reset();
+
+    auxExecutor->WaitIdle();
+    auxExecutor.reset();
+}
+
+void CaptureReplayer::Load(std::string path)
+{
+    std::ifstream file(path, std::ios::binary | std::ios::ate);
+    if (!file.is_open())
+    {
+        throw std::runtime_error("failed to open capture file!");
+    }
+
+    slotContents.clear();
+    data.resize(file.tellg());
+    file.seekg(0, std::ios::beg);
+    file.read(data.data(), data.size());
+
+    uint32_t version = 0;
+    if (data.size() >= HEADER_SIZE)
+    {
+        memcpy(&version, data.data() + sizeof(CaptureFormat::MAGIC), sizeof(version));
+    }
+    if (data.size() < HEADER_SIZE || memcmp(data.data(), CaptureFormat::MAGIC, sizeof(CaptureFormat::MAGIC)) != 0 || version != CaptureFormat::VERSION)
+    {
+        throw std::runtime_error("not a capture file or unsupported capture version!");
+    }
+
+    frameCount = 0;
+    Reader reader(data.data() + HEADER_SIZE, data.size() - HEADER_SIZE);
+    while (!reader.End())
+    {
+        auto type = reader.Read<Record>();
+        size_t length;
+        reader.ReadBytes(length);
+        if (type == Record::FRAME)
+        {
+            frameCount++;
+        }
+    }
+
+    spdlog::info("capture {}: {} frames, {} bytes", path, frameCount, data.size());
+}
+
+void CaptureReplayer::Replay(std::function<void(uint32_t frame, uint32_t imageIndex)> frameCallback)
+{
+    std::filesystem::create_directories(shaderDirectory);
+    slotContents.clear();
+
+    uint32_t frame = 0;
+    Reader reader(data.data() + HEADER_SIZE, data.size() - HEADER_SIZE);
+    while (!reader.End())
+    {
+        auto type = reader.Read<Record>();
+        size_t length;
+        auto payload = reader.ReadBytes(length);
+        Reader record(payload, length);
+
+        if (type != Record::FRAME)
+        {
+            replayRecord(type, record);
+            continue;
+        }
+
+        replayFrame(record);
+        if (frameCallback)
+        {
+            frameCallback(frame, executor->CurrentImage());
+        }
+        frame++;
+    }
+}
+
+IntrusivePtr<ResourceHandle> CaptureReplayer::resource(uint32_t id)
+{
+    auto it = resources.find(id);
+    return it == resources.end() ? nullptr : it->second;
+}
+
+bool CaptureReplayer::resolve(const std::vector<uint32_t> &ids, std::vector<IntrusivePtr<ResourceHandle>> &handles)
+{
+    for (auto id : ids)
+    {
+        auto handle = resource(id);
+        if (!handle)
+        {
+            return false;
+        }
+        handles.push_back(handle);
+    }
+    return true;
+}
+
+std::string CaptureReplayer::shaderPath(const std::string &path)
+{
+    auto it = shaderPaths.find(path);
+    return it == shaderPaths.end() ? path : it->second;
+}
+
+void CaptureReplayer::replayRecord(Record type, Reader &record)
+{
+    switch (type)
+    {
+    case Record::SHADER:
+    {
+        auto path = record.ReadString();
+        auto code = record.ReadVector<char>();
+
+        auto fileName = path;
+        std::replace_if(
+            fileName.begin(), fileName.end(), [](char c)
+            { return c == '/' || c == '\\' || c == ':'; },
+            '_');
+        auto extractedPath = (std::filesystem::path(shaderDirectory) / fileName).string();
+        std::ofstream(extractedPath, std::ios::binary).write(code.data(), code.size());
+        shaderPaths[path] = extractedPath;
+        break;
+    }
+    case Record::SWAPCHAIN:
+    {
+        width = record.Read<uint32_t>();
+        height = record.Read<uint32_t>();
+        executorDirty = true;
+        break;
+    }
+    case Record::RENDER_GROUP:
+    {
+        auto id = record.Read<uint32_t>();
+        auto jsonStr = record.ReadString();
+
+        RenderPassJson json;
+        JS::ParseContext context(jsonStr);
+        context.parseTo(json);
+        for (auto &subpass : json.subpasses)
+        {
+            subpass.shaders.vertex = shaderPath(subpass.shaders.vertex);
+            subpass.shaders.fragment = shaderPath(subpass.shaders.fragment);
+            subpass.shaders.compute = shaderPath(subpass.shaders.compute);
+        }
+
+        auto renderGroup = rhiRuntime->CreateRenderGroup(Graph::ParseRenderPassJsonRawString(JS::serializeStruct(json)));
+        renderGroup->Build();
+        renderGroups[id] = renderGroup;
+        break;
+    }
+    case Record::GRAPHICS_PIPELINE:
+    {
+        auto id = record.Read<uint32_t>();
+        auto groupId = record.Read<uint32_t>();
+        auto subPassName = record.ReadString();
+        auto pipelineStates = CaptureFormat::ReadPipelineStates(record);
+        if (!pipelineStates.shaderState.Empty())
+        {
+            pipelineStates.shaderState.vertexShaderPath = shaderPath(pipelineStates.shaderState.vertexShaderPath);
+            pipelineStates.shaderState.fragmentShaderPath = shaderPath(pipelineStates.shaderState.fragmentShaderPath);
+        }
+        pipelines[id] = renderGroups.at(groupId)->CreatePipeline(subPassName, pipelineStates);
+        break;
+    }
+    case Record::COMPUTE_PIPELINE:
+    {
+        auto id = record.Read<uint32_t>();
+        auto groupId = record.Read<uint32_t>();
+        auto subPassName = record.ReadString();
+        ComputePipelineStates pipelineStates;
+        pipelineStates.localGroupSize = record.Read<std::array<uint32_t, 3>>();
+        pipelineStates.autotune = record.Read<bool>();
+        pipelineStates.idempotent = record.Read<bool>();
+        pipelineStates.shaderState = CaptureFormat::ReadShaderState(record);
+        pipelineStates.shaderState.computeShaderPath = shaderPath(pipelineStates.shaderState.computeShaderPath);
+        pipelines[id] = renderGroups.at(groupId)->CreatePipeline(subPassName, pipelineStates);
+        break;
+    }
+    case Record::BUFFER:
+    {
+        auto id = record.Read<uint32_t>();
+        auto bufferType = record.Read<Buffer::TypeBits>();
+        auto memoryProperties = record.Read<MemoryPropertyBits>();
+        auto size = record.Read<uint32_t>();
+        resources[id] = rhiRuntime->CreateBuffer(bufferType, memoryProperties, size);
+        break;
+    }
+    case Record::MUTABLE_BUFFER:
+    {
+        auto id = record.Read<uint32_t>();
+        auto defaultBuffer = resource(record.Read<uint32_t>());
+        if (defaultBuffer)
+        {
+            resources[id] = new MutableBuffer(defaultBuffer->As<Buffer>());
+        }
+        break;
+    }
+    case Record::DYNAMIC_BUFFER:
+    {
+        auto id = record.Read<uint32_t>();
+        resources[id] = rhiRuntime->CreateDynamicBuffer(record.Read<uint32_t>());
+        break;
+    }
+    case Record::STREAMING_BUFFER:
+    {
+        auto id = record.Read<uint32_t>();
+        auto bufferType = record.Read<Buffer::TypeBits>();
+        auto initialCapacity = record.Read<uint32_t>();
+        resources[id] = rhiRuntime->CreateStreamingBuffer(bufferType, initialCapacity);
+        break;
+    }
+    case Record::TEXTURE:
+    {
+        auto id = record.Read<uint32_t>();
+        auto format = record.Read<TextureFormat>();
+        auto usage = record.Read<Texture::UsageBits>();
+        auto memoryProperties = record.Read<MemoryPropertyBits>();
+        auto extent = record.Read<Texture::Extent>();
+        auto config = record.Read<Texture::Configuration>();
+        resources[id] = rhiRuntime->CreateTexture(format, usage, memoryProperties, extent, config);
+        break;
+    }
+    case Record::SAMPLER:
+    {
+        auto id = record.Read<uint32_t>();
+        auto texture = resource(record.Read<uint32_t>());
+        auto config = record.Read<Sampler::Configuration>();
+        if (texture)
+        {
+            resources[id] = rhiRuntime->CreateSampler(texture->As<Texture>(), config);
+        }
+        break;
+    }
+    case Record::BINDING_STATE:
+    {
+        auto id = record.Read<uint32_t>();
+        auto pipelineId = record.Read<uint32_t>();
+        if (pipelines.count(pipelineId))
+        {
+            bindingStates[id] = rhiRuntime->CreateResourceBindingState(pipelines[pipelineId]);
+        }
+        break;
+    }
+    case Record::BIND:
+    {
+        auto stateId = record.Read<uint32_t>();
+        auto set = record.Read<uint32_t>();
+        auto binding = record.Read<uint32_t>();
+        auto ids = record.ReadVector<uint32_t>();
+
+        // resources the runtime created internally are bound again by the render group
+        std::vector<IntrusivePtr<ResourceHandle>> handles;
+        if (bindingStates.count(stateId) && resolve(ids, handles))
+        {
+            bindingStates[stateId]->Bind(set, binding, handles);
+        }
+        break;
+    }
+    case Record::BIND_CONSTANT:
+    {
+        auto stateId = record.Read<uint32_t>();
+        auto handle = resource(record.Read<uint32_t>());
+        if (bindingStates.count(stateId) && handle)
+        {
+            bindingStates[stateId]->Bind(handle);
+        }
+        break;
+    }
+    case Record::ADD_BINDING_STATE:
+    {
+        auto groupId = record.Read<uint32_t>();
+        auto stateId = record.Read<uint32_t>();
+        if (renderGroups.count(groupId) && bindingStates.count(stateId))
+        {
+            renderGroups[groupId]->AddBindingState(bindingStates[stateId]);
+            executorDirty = true;
+        }
+        break;
+    }
+    case Record::ADD_RENDER_GROUP:
+    {
+        auto groupId = record.Read<uint32_t>();
+        if (renderGroups.count(groupId))
+        {
+            executor->AddRenderGroup(renderGroups[groupId]);
+            executorDirty = true;
+        }
+        break;
+    }
+    case Record::BIND_GLOBAL_RESOURCE:
+    {
+        auto name = record.ReadString();
+        auto ids = record.ReadVector<uint32_t>();
+        std::vector<IntrusivePtr<ResourceHandle>> handles;
+        if (resolve(ids, handles))
+        {
+            executor->BindResource(name, handles);
+        }
+        break;
+    }
+    case Record::TRANSFER_BUFFER:
+    {
+        auto buffer = resource(record.Read<uint32_t>());
+        size_t size;
+        auto bytes = record.ReadBytes(size);
+        if (buffer)
+        {
+            auxExecutor->TransferResource(buffer->As<Buffer>(), bytes, size);
+        }
+        break;
+    }
+    case Record::TRANSFER_TEXTURE:
+    {
+        auto texture = resource(record.Read<uint32_t>());
+        AuxiliaryExecutor::TransferConfig config = {
+            .mipmapBufferLevelOffsets = record.ReadVector<uint64_t>()};
+        size_t size;
+        auto bytes = record.ReadBytes(size);
+        if (texture)
+        {
+            auxExecutor->TransferResource(texture->As<Texture>(), bytes, size, config);
+        }
+        break;
+    }
+    default:
+        spdlog::warn("capture: unknown record {}", uint32_t(type));
+        break;
+    }
+}
+
+void CaptureReplayer::prepareExecutor()
+{
+    if (!executorDirty)
+    {
+        return;
+    }
+
+    if (swapChain)
+    {
+        executor->WaitIdle();
+        executor->Reset();
+    }
+
+    swapChain = rhiRuntime->CreateSwapChain(nullptr, width, height, swapChain);
+    executor->SetSwapChain(swapChain);
+    executor->Prepare();
+    executorDirty = false;
+}
+
+void CaptureReplayer::writeContent(ResourceHandle *handle, uint32_t imageIndex, const char *bytes, size_t size)
+{
+    void *target = nullptr;
+    size_t targetSize = 0;
+    switch (handle->type)
+    {
+    case ResourceHandle::DYNAMIC_BUFFER:
+        target = handle->As<DynamicBuffer>()->Map();
+        targetSize = handle->As<DynamicBuffer>()->Size();
+        break;
+    case ResourceHandle::BUFFER:
+        target = handle->As<Buffer>()->Map();
+        targetSize = handle->As<Buffer>()->Size();
+        break;
+    case ResourceHandle::BUFFER_ARRAY:
+    {
+        auto &buffer = handle->As<MutableBuffer>()->GetBuffer(imageIndex);
+        target = buffer->Map();
+        targetSize = buffer->Size();
+        break;
+    }
+    case ResourceHandle::STREAMING_BUFFER:
+        target = handle->As<StreamingBuffer>()->Map(imageIndex, size);
+        targetSize = size;
+        break;
+    default:
+        break;
+    }
+
+    if (target)
+    {
+        memcpy(target, bytes, std::min(size, targetSize));
+    }
+}
+
+void CaptureReplayer::replayFrame(Reader &record)
+{
+    TRACE_SCOPE("CaptureReplayer::replayFrame");
+
+    prepareExecutor();
+
+    // same order as the engine frame, uploads first, then acquire and update the draw states
+    auxExecutor->Execute();
+    executor->Acquire();
+
+    auto imageIndex = executor->CurrentImage();
+    auto recordedImageIndex = record.Read<uint32_t>();
+
+    auto drawStateCount = record.Read<uint32_t>();
+    for (uint32_t i = 0; i < drawStateCount; i++)
+    {
+        auto stateId = record.Read<uint32_t>();
+        auto vertexBuffer = resource(record.Read<uint32_t>());
+        auto indexBuffer = resource(record.Read<uint32_t>());
+        auto indexType = record.Read<ResourceBindingState::IndexType>();
+        auto drawOps = record.ReadVector<ResourceBindingState::DrawOP>();
+        auto dispatches = record.ReadVector<CaptureFormat::Dispatch>();
+        auto indirectDraws = record.ReadVector<CaptureFormat::IndirectDraw>();
+
+        if (!bindingStates.count(stateId))
+            continue;
+
+        auto &state = bindingStates[stateId];
+        state->BindVertexBuffer(vertexBuffer);
+        state->BindIndexBuffer(indexBuffer, indexType);
+        state->BindDrawOp(drawOps);
+
+        std::vector<ResourceBindingState::DispatchOP> dispatchOps;
+        for (auto &dispatch : dispatches)
+        {
+            dispatchOps.push_back({.type = ResourceBindingState::DispatchOP::Type(dispatch.type),
+                                   .groupCount = {dispatch.groupCount[0], dispatch.groupCount[1], dispatch.groupCount[2]},
+                                   .resource = resource(dispatch.resource),
+                                   .elementSize = dispatch.elementSize,
+                                   .offset = dispatch.offset});
+        }
+        state->BindDispatchOp(dispatchOps);
+
+        std::vector<ResourceBindingState::IndirectDrawOP> indirectDrawOps;
+        for (auto &draw : indirectDraws)
+        {
+            indirectDrawOps.push_back({.resource = resource(draw.resource),
+                                       .offset = draw.offset,
+                                       .drawCount = draw.drawCount,
+                                       .stride = draw.stride,
+                                       .countResource = resource(draw.countResource),
+                                       .countOffset = draw.countOffset});
+        }
+        state->BindIndirectDrawOp(indirectDrawOps);
+    }
+
+    // per slot content changes belong to the recorded slot, the replayed image may be another one
+    auto contentCount = record.Read<uint32_t>();
+    for (uint32_t i = 0; i < contentCount; i++)
+    {
+        auto id = record.Read<uint32_t>();
+        size_t size;
+        auto bytes = record.ReadBytes(size);
+        auto handle = resource(id);
+        if (!handle)
+            continue;
+
+        if (handle->type == ResourceHandle::BUFFER_ARRAY || handle->type == ResourceHandle::STREAMING_BUFFER)
+        {
+            slotContents[{id, recordedImageIndex}] = {bytes, size};
+            continue;
+        }
+        writeContent(handle.get(), imageIndex, bytes, size);
+    }
+
+    // the recorded frame drew the content of its slot, it goes to the slot drawn now
+    for (auto &[key, content] : slotContents)
+    {
+        auto handle = resource(key.first);
+        if (key.second == recordedImageIndex && handle)
+        {
+            writeContent(handle.get(), imageIndex, content.first, content.second);
+        }
+    }
+
+    executor->Update();
+    executor->Execute();
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <Core/IntrusivePtr.h>
+
+#include <RHI/RHIRuntime.h>
+#include <RHI/CaptureFormat.h>
+
+// re-executes a capture written by CaptureRecorder on a headless runtime
+// shaders embedded in the capture are extracted to shaderDirectory and graphs are pointed at them
+class CaptureReplayer : public IntrusiveCounter<CaptureReplayer>
+{
+public:
+    CaptureReplayer(IntrusivePtr<RHIRuntime> rhiRuntime, std::string shaderDirectory = "CaptureShaders");
+    ~CaptureReplayer();
+
+    // throw if path is not a capture of a known version
+    void Load(std::string path);
+
+    uint32_t FrameCount()
+    {
+        return frameCount;
+    }
+
+    // replay all records, callback runs after each frame is submitted
+    void Replay(std::function<void(uint32_t frame, uint32_t imageIndex)> frameCallback = nullptr);
+
+    IntrusivePtr<SwapChain> GetSwapChain()
+    {
+        return swapChain;
+    }
+
+    IntrusivePtr<AuxiliaryExecutor> GetAuxiliaryExecutor()
+    {
+        return auxExecutor;
+    }
+
+private:
+    IntrusivePtr<RHIRuntime> rhiRuntime;
+    IntrusivePtr<AuxiliaryExecutor> auxExecutor;
+    IntrusivePtr<RenderGroupExecutor> executor;
+    IntrusivePtr<SwapChain> swapChain;
+
+    std::string shaderDirectory;
+
+    std::vector<char> data;
+    uint32_t frameCount = 0;
+
+    uint32_t width = 1024;
+    uint32_t height = 768;
+
+    // swapchain or render groups changed since the executor was prepared
+    bool executorDirty = true;
+
+    // capture id -> replayed object
+    std::unordered_map<uint32_t, IntrusivePtr<RenderGroup>> renderGroups;
+    std::unordered_map<uint32_t, IntrusivePtr<Pipeline>> pipelines;
+    std::unordered_map<uint32_t, IntrusivePtr<ResourceHandle>> resources;
+    std::unordered_map<uint32_t, IntrusivePtr<ResourceBindingState>> bindingStates;
+
+    // latest content of buffer arrays and streaming buffers by (id, recorded slot), points into data
+    std::map<std::pair<uint32_t, uint32_t>, std::pair<const char *, size_t>> slotContents;
+
+    // original shader path -> extracted file
+    std::unordered_map<std::string, std::string> shaderPaths;
+
+    IntrusivePtr<ResourceHandle> resource(uint32_t id);
+    bool resolve(const std::vector<uint32_t> &ids, std::vector<IntrusivePtr<ResourceHandle>> &handles);
+    std::string shaderPath(const std::string &path);
+
+    void replayRecord(CaptureFormat::Record type, CaptureFormat::Reader &record);
+    void replayFrame(CaptureFormat::Reader &record);
+    void writeContent(ResourceHandle *handle, uint32_t imageIndex, const char *bytes, size_t size);
+    void prepareExecutor();
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <vector>
+
+#include <RHI/ResourceHandle.h>
+
+// host side uniform data
+// copied into a per frame linear allocation when command buffer is recorded,
+// bound with a dynamic offset if the binding is declared dynamic
+class DynamicBuffer : public ResourceHandle
+{
+public:
+    DynamicBuffer(uint32_t size) : ResourceHandle(ResourceHandleType::DYNAMIC_BUFFER), buffer(size)
+    {
+    }
+
+    virtual ~DynamicBuffer() override
+    {
+    }
+
+    void *Map()
+    {
+        return buffer.data();
+    }
+
+    size_t Size()
+    {
+        return buffer.size();
+    }
+
+private:
+    std::vector<char> buffer;
+};
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <json_struct/json_struct.h>
+
+// what the last submitted frame recorded, counted while command buffers are built
+struct FrameStatistics
+{
+    struct Pass
+    {
+        // subpass global name
+        std::string name;
+
+        uint32_t drawCount;
+        uint32_t instanceCount;
+        uint64_t indexCount;
+        uint64_t vertexCount;
+        uint32_t dispatchCount;
+
+        // binds actually recorded, redundant rebinds are skipped and not counted
+        uint32_t pipelineBinds;
+        uint32_t descriptorBinds;
+
+        // pipeline statistics queries, valid if hasInvocations
+        // results lag a few frames behind like gpu timings
+        bool hasInvocations;
+        uint64_t vertexInvocations;
+        uint64_t fragmentInvocations;
+        uint64_t computeInvocations;
+
+        JS_OBJ(name, drawCount, instanceCount, indexCount, vertexCount, dispatchCount, pipelineBinds, descriptorBinds,
+               hasInvocations, vertexInvocations, fragmentInvocations, computeInvocations);
+    };
+
+    uint64_t frameIndex;
+
+    std::vector<Pass> passes;
+
+    // sums over passes
+    uint32_t drawCount;
+    uint32_t instanceCount;
+    uint64_t indexCount;
+    uint32_t dispatchCount;
+    uint32_t pipelineBinds;
+    uint32_t descriptorBinds;
+
+    // pipeline barriers recorded by the executors, each image/buffer/memory barrier counts
+    uint32_t barrierCount;
+
+    // auxiliary executor transfers since the previous frame
+    uint32_t copyCount;
+    uint64_t uploadBytes;
+    uint64_t readbackBytes;
+
+    JS_OBJ(frameIndex, passes, drawCount, instanceCount, indexCount, dispatchCount, pipelineBinds, descriptorBinds,
+           barrierCount, copyCount, uploadBytes, readbackBytes);
+
+    std::string ToJson()
+    {
+        return JS::serializeStruct(*this);
+    }
+};
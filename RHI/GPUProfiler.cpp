@@ -0,0 +1,67 @@
+#include <RHI/GPUProfiler.h>
+
+#include <algorithm>
+
+static GPUProfiler::Timing summarize(const std::string &name, const std::deque<double> &values)
+{
+    GPUProfiler::Timing timing = {
+        .name = name,
+        .last = values.back(),
+        .min = values.front(),
+        .avg = 0.0,
+        .max = values.front(),
+        .sampleCount = uint32_t(values.size())};
+
+    for (auto value : values)
+    {
+        timing.min = std::min(timing.min, value);
+        timing.max = std::max(timing.max, value);
+        timing.avg += value;
+    }
+    timing.avg /= values.size();
+
+    return timing;
+}
+
+std::vector<GPUProfiler::Timing> GPUProfiler::GetTimings()
+{
+    std::vector<Timing> timings;
+    for (auto &name : names)
+    {
+        timings.push_back(summarize(name, samples[name]));
+    }
+    return timings;
+}
+
+bool GPUProfiler::GetTiming(const std::string &name, Timing &timing)
+{
+    auto it = samples.find(name);
+    if (it == samples.end())
+    {
+        return false;
+    }
+
+    timing = summarize(name, it->second);
+    return true;
+}
+
+void GPUProfiler::ClearTimings()
+{
+    names.clear();
+    samples.clear();
+}
+
+void GPUProfiler::addSample(const std::string &name, double milliseconds)
+{
+    auto &values = samples[name];
+    if (values.empty())
+    {
+        names.push_back(name);
+    }
+
+    values.push_back(milliseconds);
+    if (values.size() > SAMPLE_WINDOW)
+    {
+        values.pop_front();
+    }
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <Core/IntrusivePtr.h>
+
+// gpu time of render groups and subpasses, keyed by frame graph names
+// queries are read back without stalling, so results lag a few frames behind
+class GPUProfiler : public IntrusiveCounter<GPUProfiler>
+{
+public:
+    virtual ~GPUProfiler() = default;
+
+    struct Timing
+    {
+        std::string name;
+
+        // milliseconds, min/avg/max over the last SAMPLE_WINDOW frames
+        double last;
+        double min;
+        double avg;
+        double max;
+        uint32_t sampleCount;
+    };
+
+    static constexpr uint32_t SAMPLE_WINDOW = 120;
+
+    // false if the device can not time queue work, e.g. timestampPeriod is 0
+    virtual bool Supported() = 0;
+
+    void SetEnabled(bool enabled)
+    {
+        this->enabled = enabled;
+    }
+
+    bool IsEnabled()
+    {
+        return enabled && Supported();
+    }
+
+    // "frame" for the whole submission, group names and subpass global names
+    // in the order they were first seen
+    std::vector<Timing> GetTimings();
+    bool GetTiming(const std::string &name, Timing &timing);
+
+    void ClearTimings();
+
+protected:
+    bool enabled = false;
+
+    void addSample(const std::string &name, double milliseconds);
+
+private:
+    std::vector<std::string> names;
+    std::unordered_map<std::string, std::deque<double>> samples;
+};
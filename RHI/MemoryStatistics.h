@@ -0,0 +1,87 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <json_struct/json_struct.h>
+
+// what a device allocation is used for
+enum class MemoryCategory : uint32_t
+{
+    ATTACHMENT,
+    TEXTURE,
+    GEOMETRY,
+    UNIFORM,
+    STAGING,
+    OTHER,
+    COUNT
+};
+
+inline const char *MemoryCategoryName(MemoryCategory category)
+{
+    switch (category)
+    {
+    case MemoryCategory::ATTACHMENT:
+        return "attachment";
+    case MemoryCategory::TEXTURE:
+        return "texture";
+    case MemoryCategory::GEOMETRY:
+        return "geometry";
+    case MemoryCategory::UNIFORM:
+        return "uniform";
+    case MemoryCategory::STAGING:
+        return "staging";
+    default:
+        return "other";
+    }
+}
+
+// snapshot of device memory, all sizes in bytes
+struct MemoryStatistics
+{
+    struct Heap
+    {
+        uint32_t index;
+        bool deviceLocal;
+
+        // usage / budget of the whole process as reported by the driver
+        uint64_t usage;
+        uint64_t budget;
+
+        // vma blocks allocated from this heap and the allocations inside them
+        uint32_t blockCount;
+        uint64_t blockBytes;
+        uint32_t allocationCount;
+        uint64_t allocationBytes;
+
+        JS_OBJ(index, deviceLocal, usage, budget, blockCount, blockBytes, allocationCount, allocationBytes);
+    };
+
+    struct Category
+    {
+        std::string name;
+        uint64_t allocationCount;
+        uint64_t allocationBytes;
+
+        JS_OBJ(name, allocationCount, allocationBytes);
+    };
+
+    std::vector<Heap> heaps;
+    std::vector<Category> categories;
+
+    uint64_t blockBytes;
+    uint64_t allocationBytes;
+    uint32_t unusedRangeCount;
+    uint64_t unusedRangeSizeMax;
+
+    // 0 if free space inside blocks is one contiguous range, approaching 1 as it is scattered
+    float fragmentation;
+
+    JS_OBJ(heaps, categories, blockBytes, allocationBytes, unusedRangeCount, unusedRangeSizeMax, fragmentation);
+
+    std::string ToJson()
+    {
+        return JS::serializeStruct(*this);
+    }
+};
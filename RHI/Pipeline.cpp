@@ -1,5 +1,15 @@
 #include <RHI/Pipeline.h>
 
+#include <RHI/CaptureRecorder.h>
+
 Pipeline::Pipeline(std::string groupName, std::string pipelineName) : groupName(groupName), pipelineName(pipelineName)
 {
 }
+
+Pipeline::~Pipeline()
+{
+    if (captureRecorder)
+    {
+        captureRecorder->RecordDestroy(this);
+    }
+}
@@ -4,11 +4,13 @@
 
 #include <Core/IntrusivePtr.h>
 
+class CaptureRecorder;
+
 class Pipeline : public IntrusiveCounter<Pipeline>
 {
 public:
     Pipeline(std::string groupName, std::string pipelineName);
-    virtual ~Pipeline() = default;
+    virtual ~Pipeline();
     virtual void Build() = 0;
 
     std::string GetPipelineName()
@@ -18,4 +20,7 @@ public:
 
     std::string pipelineName;
     std::string groupName;
+
+    // set while a capture recorder keeps records of the pipeline, they are dropped on destruction
+    CaptureRecorder *captureRecorder = nullptr;
 };
\ No newline at end of file
@@ -146,6 +146,16 @@ struct PipelineStates
 
 struct ComputePipelineStates
 {
-    std::array<uint8_t, 3> localGroupSize;
+    // zero keeps the workgroup size declared in the shader
+    // applied through local_size_x_id = 0, local_size_y_id = 1, local_size_z_id = 2
+    std::array<uint32_t, 3> localGroupSize = {};
+
+    // time candidate workgroup sizes on the first frame and keep the fastest, needs RuntimeConfig::workgroupTuning
+    // and RESOURCE_SIZE dispatches only, candidates run the dispatches a few extra times on the live resources
+    bool autotune = false;
+    // the dispatches only overwrite their outputs from inputs they do not write, so running them again is harmless
+    // autotune pipelines without it keep their size
+    bool idempotent = false;
+
     ShaderState shaderState;
 };
\ No newline at end of file
@@ -10,11 +10,18 @@
 #include <RHI/PipelineStates.h>
 #include <RHI/Buffer.h>
 #include <RHI/MutableBuffer.h>
+#include <RHI/DynamicBuffer.h>
+#include <RHI/StreamingBuffer.h>
 #include <RHI/Texture.h>
 #include <RHI/ResourceBindingState.h>
 #include <RHI/SwapChain.h>
 #include <RHI/Sampler.h>
 #include <RHI/AuxiliaryExecutor.h>
+#include <RHI/MemoryStatistics.h>
+#include <RHI/GPUProfiler.h>
+#include <RHI/FrameStatistics.h>
+#include <RHI/CaptureRecorder.h>
+#include <RHI/RuntimeConfig.h>
 #include <RHI/PipelineStates.h>
 
 class RHIRuntime : public IntrusiveCounter<RHIRuntime>
@@ -24,10 +31,27 @@ public:
     virtual IntrusivePtr<RenderGroup> CreateRenderGroup(IntrusivePtr<Graph> graph) = 0;
     virtual IntrusivePtr<Buffer> CreateBuffer(Buffer::TypeBits type, MemoryPropertyBits memoryProperties, uint32_t size) = 0;
     virtual IntrusivePtr<MutableBuffer> CreateMutableBuffer(Buffer::TypeBits type, MemoryPropertyBits memoryProperties, uint32_t size) = 0;
+    virtual IntrusivePtr<DynamicBuffer> CreateDynamicBuffer(uint32_t size) = 0;
+    virtual IntrusivePtr<StreamingBuffer> CreateStreamingBuffer(Buffer::TypeBits type, uint32_t initialCapacity = 64 * 1024) = 0;
     virtual IntrusivePtr<Texture> CreateTexture(TextureFormat format, Texture::UsageBits type, MemoryPropertyBits memoryProperties, Texture::Extent extent, Texture::Configuration config = Texture::Configuration::Default()) = 0;
     virtual IntrusivePtr<Sampler> CreateSampler(IntrusivePtr<Texture> texture, Sampler::Configuration config = Sampler::Configuration()) = 0;
     virtual IntrusivePtr<RenderGroupExecutor> CreateRenderGroupExecutor() = 0;
     virtual IntrusivePtr<ResourceBindingState> CreateResourceBindingState(IntrusivePtr<Pipeline> pipeline) = 0;
     virtual IntrusivePtr<SwapChain> CreateSwapChain(void *handle, uint32_t width, uint32_t height, IntrusivePtr<SwapChain> oldSwapChain) = 0;
     virtual IntrusivePtr<AuxiliaryExecutor> CreateAuxiliaryExecutor() = 0;
+
+    // heap budgets, per category totals and fragmentation, walks all memory blocks
+    virtual MemoryStatistics GetMemoryStatistics() = 0;
+
+    // disabled by default, timings of every render group executed by this runtime
+    virtual IntrusivePtr<GPUProfiler> GetGPUProfiler() = 0;
+
+    // draw, bind, barrier and transfer counters of the last submitted frame
+    virtual FrameStatistics GetFrameStatistics() = 0;
+
+    // disabled by default, rhi calls of this runtime for frame capture and replay
+    virtual IntrusivePtr<CaptureRecorder> GetCaptureRecorder() = 0;
+
+    // device, layers and present mode granted for the RuntimeConfig
+    virtual RuntimeInfo GetRuntimeInfo() = 0;
 };
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+#include <Core/IntrusivePtr.h>
+#include <RHI/Texture.h>
+#include <RHI/TextureFormat.h>
+
+// ticket of an asynchronous gpu -> cpu copy
+// the copy is recorded on the next AuxiliaryExecutor::Execute and resolves once that submission completes
+class Readback : public IntrusiveCounter<Readback>
+{
+public:
+    virtual ~Readback() = default;
+
+    // true once the gpu finished the copy or it failed, never blocks
+    virtual bool Ready() = 0;
+
+    // submit the copy if it is still pending and block until it completed
+    virtual void Wait() = 0;
+
+    // true if the copy was dropped by AuxiliaryExecutor::Reset before it was submitted, waits if not ready
+    virtual bool Failed() = 0;
+
+    // host visible copy of the data, waits if not ready, nullptr if failed
+    virtual const void *Data() = 0;
+
+    size_t Size()
+    {
+        return size;
+    }
+
+    // texture readbacks only, rows are tightly packed
+    TextureFormat GetTextureFormat()
+    {
+        return format;
+    }
+
+    Texture::Extent GetExtent()
+    {
+        return extent;
+    }
+
+protected:
+    size_t size = 0;
+    TextureFormat format = TextureFormat::FORMAT_NONE;
+    Texture::Extent extent = {};
+};
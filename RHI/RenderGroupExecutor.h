@@ -33,6 +33,11 @@ public:
     // reset to init state when swapchain recreate
     virtual void Reset() = 0;
 
+    // swapchain recreated with another extent, pipelines, command buffers and fences are kept
+    // only attachments, framebuffers and descriptors referring to attachments are rebuilt
+    // an image acquired for the current frame is acquired again from the new swapchain
+    virtual void Resize(IntrusivePtr<SwapChain> swapChain) = 0;
+
     virtual void AddRenderGroup(IntrusivePtr<RenderGroup> group) = 0;
 
     // bind global resources(per frame), shared among all rendergroups
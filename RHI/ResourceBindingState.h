@@ -54,6 +54,64 @@ public:
         return this->drawOps;
     }
 
+    // draws whose parameters are written on the gpu, recorded after the DrawOPs
+    // VkDrawIndexedIndirectCommand records if an index buffer is bound, VkDrawIndirectCommand otherwise
+    struct IndirectDrawOP
+    {
+        IntrusivePtr<ResourceHandle> resource;
+        uint64_t offset = 0;
+        uint32_t drawCount = 1;
+        // 0 for tightly packed records
+        uint32_t stride = 0;
+
+        // uint32_t draw count read from countResource at countOffset, at most drawCount records are drawn
+        // without drawIndirectCount support all drawCount records are issued, the ones past the count must draw nothing
+        IntrusivePtr<ResourceHandle> countResource;
+        uint64_t countOffset = 0;
+    };
+
+    void BindIndirectDrawOp(std::vector<IndirectDrawOP> indirectDrawOps)
+    {
+        this->indirectDrawOps = indirectDrawOps;
+    }
+
+    std::vector<IndirectDrawOP> &GetIndirectDrawOps()
+    {
+        return this->indirectDrawOps;
+    }
+
+    // workgroup count of a compute pipeline, dispatched in order
+    struct DispatchOP
+    {
+        enum Type
+        {
+            // groupCount as is
+            DIRECT,
+            // enough groups to cover the extent of resource (texture) or its element count (buffer size / elementSize)
+            // the swapchain extent is covered if resource is empty
+            RESOURCE_SIZE,
+            // VkDispatchIndirectCommand read from resource at offset
+            INDIRECT,
+        };
+
+        Type type = DIRECT;
+        glm::u32vec3 groupCount = {1, 1, 1};
+
+        IntrusivePtr<ResourceHandle> resource;
+        uint32_t elementSize = 4;
+        uint64_t offset = 0;
+    };
+
+    void BindDispatchOp(std::vector<DispatchOP> dispatchOps)
+    {
+        this->dispatchOps = dispatchOps;
+    }
+
+    std::vector<DispatchOP> &GetDispatchOps()
+    {
+        return this->dispatchOps;
+    }
+
     enum IndexType
     {
         INDEX_TYPE_UINT16 = 0,
@@ -82,6 +140,11 @@ public:
         return indexBuffer;
     }
 
+    IndexType GetIndexBufferType()
+    {
+        return indexType;
+    }
+
     void RegisterUpdateCallback(UpdateCallback callback)
     {
         updateCallbacks.push_back(callback);
@@ -99,10 +162,14 @@ protected:
     IntrusivePtr<Pipeline> pipeline;
     IntrusivePtr<ResourceHandle> vertexBuffer;
     IntrusivePtr<ResourceHandle> indexBuffer;
-    IndexType indexType;
+    IndexType indexType = INDEX_TYPE_UINT32;
 
     // define how renderer will draw the buffer
     std::vector<DrawOP> drawOps;
+    std::vector<IndirectDrawOP> indirectDrawOps;
+
+    // compute pipelines only
+    std::vector<DispatchOP> dispatchOps;
 
     std::vector<UpdateCallback> updateCallbacks;
 };
\ No newline at end of file
@@ -0,0 +1,11 @@
+#include <RHI/ResourceHandle.h>
+
+#include <RHI/CaptureRecorder.h>
+
+ResourceHandle::~ResourceHandle()
+{
+    if (captureRecorder)
+    {
+        captureRecorder->RecordDestroy(this);
+    }
+}
@@ -2,6 +2,8 @@
 
 #include <Core/IntrusivePtr.h>
 
+class CaptureRecorder;
+
 class ResourceHandle : public IntrusiveCounter<ResourceHandle>
 {
 public:
@@ -10,14 +12,19 @@ public:
         BUFFER,
         BUFFER_ARRAY,
         TEXTURE,
-        SAMPLER
+        SAMPLER,
+        DYNAMIC_BUFFER,
+        STREAMING_BUFFER
     };
 
     // avoid dynamic_cast
     ResourceHandleType type;
 
+    // set while a capture recorder keeps records of the handle, they are dropped on destruction
+    CaptureRecorder *captureRecorder = nullptr;
+
     ResourceHandle(ResourceHandleType type) : type(type) {}
-    virtual ~ResourceHandle() = default;
+    virtual ~ResourceHandle();
 
     template <class T>
     T *As()
@@ -0,0 +1,79 @@
+#include <RHI/RuntimeConfig.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
+
+#include <Core/ReadFile.h>
+
+static bool ParseBool(const std::string &value)
+{
+    return value == "1" || value == "true" || value == "on" || value == "yes";
+}
+
+void RuntimeConfig::ApplyEnvironment()
+{
+    // a malformed value keeps the current setting instead of aborting startup
+    auto env = [](const char *name, auto apply)
+    {
+        if (auto value = std::getenv(name))
+        {
+            try
+            {
+                apply(std::string(value));
+            }
+            catch (const std::logic_error &)
+            {
+                spdlog::warn("runtime config: ignoring {}={}, not a valid value", name, value);
+            }
+        }
+    };
+
+    env("PIXEL_PRESENT_MODE", [&](std::string value)
+        { presentMode = value; });
+    env("PIXEL_MIN_IMAGE_COUNT", [&](std::string value)
+        { minImageCount = std::stoul(value); });
+    env("PIXEL_VALIDATION", [&](std::string value)
+        { validation = ParseBool(value); });
+    env("PIXEL_DEBUG_UTILS", [&](std::string value)
+        { debugUtils = ParseBool(value); });
+    env("PIXEL_DEVICE_INDEX", [&](std::string value)
+        { deviceIndex = std::stoi(value); });
+    env("PIXEL_DEVICE_NAME", [&](std::string value)
+        { deviceName = value; });
+    env("PIXEL_DEVICE_TYPE", [&](std::string value)
+        { deviceType = value; });
+    env("PIXEL_WORKGROUP_TUNING", [&](std::string value)
+        { workgroupTuning = ParseBool(value); });
+    env("PIXEL_WORKGROUP_TUNING_CACHE", [&](std::string value)
+        { workgroupTuningCache = value; });
+}
+
+RuntimeConfig RuntimeConfig::Load(std::string path)
+{
+    RuntimeConfig config;
+    if (!std::filesystem::exists(path))
+    {
+        spdlog::info("runtime config {} not found, using defaults", path);
+        return config;
+    }
+
+    auto jsonStr = ReadStringFile(path);
+    JS::ParseContext context(jsonStr);
+    if (context.parseTo(config) != JS::Error::NoError)
+    {
+        throw std::runtime_error("failed to parse runtime config " + path + ": " + context.makeErrorString());
+    }
+
+    return config;
+}
+
+RuntimeConfig RuntimeConfig::FromEnvironment(bool headless)
+{
+    RuntimeConfig config;
+    config.headless = headless;
+    config.ApplyEnvironment();
+    return config;
+}
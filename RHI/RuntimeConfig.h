@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+
+#include <json_struct/json_struct.h>
+
+// runtime creation options, defaults match a debug build
+// fields can be loaded from json and overridden by PIXEL_* environment variables
+struct RuntimeConfig
+{
+    // no window system, swapchains render into offscreen textures
+    bool headless = false;
+
+    // fifo, fifo_relaxed, mailbox, immediate
+    // unsupported modes fall back towards fifo which is always available
+    std::string presentMode = "fifo";
+
+    // requested swapchain images, clamped to the surface limits
+    uint32_t minImageCount = 2;
+
+#ifdef NDEBUG
+    bool validation = false;
+    bool debugUtils = false;
+#else
+    bool validation = true;
+    bool debugUtils = true;
+#endif
+
+    // device selection, checked in this order, first physical device if nothing matches
+    // index into the enumerated devices, -1 to ignore
+    int32_t deviceIndex = -1;
+    // case insensitive substring of the device name
+    std::string deviceName;
+    // discrete, integrated, virtual, cpu
+    std::string deviceType = "discrete";
+
+    // compute pipelines created with autotune time candidate workgroup sizes,
+    // winners are kept per device and shader in workgroupTuningCache
+    // otherwise they run with the size declared in the shader
+    bool workgroupTuning = false;
+    std::string workgroupTuningCache = "workgroup_tuning.json";
+
+    JS_OBJ(headless, presentMode, minImageCount, validation, debugUtils, deviceIndex, deviceName, deviceType, workgroupTuning, workgroupTuningCache);
+
+    // PIXEL_PRESENT_MODE, PIXEL_MIN_IMAGE_COUNT, PIXEL_VALIDATION, PIXEL_DEBUG_UTILS,
+    // PIXEL_DEVICE_INDEX, PIXEL_DEVICE_NAME, PIXEL_DEVICE_TYPE,
+    // PIXEL_WORKGROUP_TUNING, PIXEL_WORKGROUP_TUNING_CACHE
+    void ApplyEnvironment();
+
+    // throw if the file exists but is not valid json
+    static RuntimeConfig Load(std::string path);
+
+    // defaults with environment overrides
+    static RuntimeConfig FromEnvironment(bool headless = false);
+};
+
+// what the driver actually granted for a RuntimeConfig
+struct RuntimeInfo
+{
+    std::string deviceName;
+    std::string deviceType;
+    bool validation = false;
+    bool debugUtils = false;
+
+    // of the latest swapchain
+    std::string presentMode;
+    uint32_t imageCount = 0;
+
+    // compute shaders may use subgroup arithmetic (GL_KHR_shader_subgroup_arithmetic)
+    uint32_t subgroupSize = 0;
+    bool subgroupArithmetic = false;
+
+    // indirect draws may start at a non zero firstInstance
+    bool drawIndirectFirstInstance = false;
+    // fragment shaders may write storage buffers and images
+    bool fragmentStoresAndAtomics = false;
+
+    JS_OBJ(deviceName, deviceType, validation, debugUtils, presentMode, imageCount, subgroupSize, subgroupArithmetic, drawIndirectFirstInstance, fragmentStoresAndAtomics);
+};
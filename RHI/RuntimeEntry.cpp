@@ -8,7 +8,7 @@ IntrusivePtr<RHIRuntime> RuntimeEntry::Create()
     {
     case Type::VULKAN:
     {
-        return new VulkanRuntime();
+        return new VulkanRuntime(config);
     }
     default:
         return nullptr;
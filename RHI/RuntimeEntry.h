@@ -1,6 +1,7 @@
 #pragma once
 
 #include <RHI/RHIRuntime.h>
+#include <RHI/RuntimeConfig.h>
 
 class RuntimeEntry
 {
@@ -10,7 +11,12 @@ public:
         VULKAN
     };
 
-    RuntimeEntry(Type type) : type(type)
+    // default config with PIXEL_* environment overrides
+    RuntimeEntry(Type type, bool headless = false) : type(type), config(RuntimeConfig::FromEnvironment(headless))
+    {
+    }
+
+    RuntimeEntry(Type type, RuntimeConfig config) : type(type), config(config)
     {
     }
 
@@ -18,4 +24,5 @@ public:
 
 private:
     Type type;
+    RuntimeConfig config;
 };
\ No newline at end of file
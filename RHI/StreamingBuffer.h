@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include <RHI/ResourceHandle.h>
+#include <RHI/Buffer.h>
+
+// host written geometry (ui, debug lines, gizmos) rebuilt every frame
+// each frame in flight owns its own slice, a slice only reallocates
+// when the requested size exceeds its high-water mark, growing geometrically
+class StreamingBuffer : public ResourceHandle
+{
+public:
+    // return write-only mapped memory of at least size bytes for frameIndex
+    // previous content is not preserved on growth
+    virtual void *Map(uint32_t frameIndex, size_t size) = 0;
+
+    // 0 if frameIndex has not been mapped yet
+    virtual size_t Capacity(uint32_t frameIndex) = 0;
+
+    // what was written through the last Map of frameIndex, nullptr unless it was mapped while capturing
+    virtual const void *CapturedContent(uint32_t frameIndex, size_t &size) = 0;
+
+protected:
+    StreamingBuffer() : ResourceHandle(ResourceHandleType::STREAMING_BUFFER) {}
+    virtual ~StreamingBuffer() = default;
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <Core/IntrusivePtr.h>
+#include <RHI/Texture.h>
 
 class SwapChain : public IntrusiveCounter<SwapChain>
 {
@@ -11,4 +12,9 @@ public:
     virtual uint32_t ImageSize() = 0;
     virtual uint32_t Acquire(uint32_t currentFrame) = 0;
     virtual bool Present(uint32_t index, uint32_t currentFrame) = 0;
+
+    // images are plain offscreen textures, nothing is presented
+    virtual bool IsHeadless() = 0;
+
+    virtual IntrusivePtr<Texture> GetTexture(uint32_t index) = 0;
 };
\ No newline at end of file
@@ -75,6 +75,11 @@ public:
         return extent;
     }
 
+    TextureFormat GetTextureFormat()
+    {
+        return format;
+    }
+
     uint16_t LayerCount()
     {
         return layers;
@@ -2,77 +2,160 @@
 #include <RHI/VulkanRuntime/Runtime.h>
 #include <RHI/VulkanRuntime/Buffer.h>
 
+#include <Core/Trace.h>
+
 #include <vector>
+#include <algorithm>
 #include <stdexcept>
 
-VulkanAuxiliaryExecutor::VulkanAuxiliaryExecutor(IntrusivePtr<Context> context) : context(context)
+VulkanAuxiliaryExecutor::VulkanAuxiliaryExecutor(IntrusivePtr<Context> context, IntrusivePtr<VulkanStatisticsCollector> statistics, IntrusivePtr<CaptureRecorder> captureRecorder) : context(context), statistics(statistics), captureRecorder(captureRecorder)
 {
-    prepareCommandPool();
+    prepareFrames();
 }
 
 VulkanAuxiliaryExecutor::~VulkanAuxiliaryExecutor()
 {
-    vkDestroyCommandPool(context->GetVkDevice(), graphicCommandPool, nullptr);
-    vkDestroyCommandPool(context->GetVkDevice(), computeCommandPool, nullptr);
+    recycleAllFrames();
+    for (auto &frame : frames)
+    {
+        vkDestroyFence(context->GetVkDevice(), frame.fence, nullptr);
+        vkDestroyCommandPool(context->GetVkDevice(), frame.commandPool, nullptr);
+    }
 }
 
 bool VulkanAuxiliaryExecutor::Execute()
 {
-    std::vector<VkCommandBuffer> commandBuffers;
-    if (submitGroups.empty())
+    if (!hasPendingWork())
     {
         return false;
     }
-    for (auto &submitGroup : submitGroups)
+
+    TRACE_SCOPE("VulkanAuxiliaryExecutor::Execute");
+
+    auto &frame = frames[currentFrame];
+    recycleFrame(frame);
+
+    auto commandBuffer = frame.commandBuffer;
+    VkCommandBufferBeginInfo cmdBufferBeginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    cmdBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &cmdBufferBeginInfo);
+
+    auto recordBarriers = [this, commandBuffer](BarrierBatch &batch)
+    {
+        if (batch.Empty())
+            return;
+
+        statistics->AddBarriers(batch.bufferBarriers.size() + batch.imageBarriers.size());
+
+        vkCmdPipelineBarrier(commandBuffer,
+                             batch.srcStageMask,
+                             batch.dstStageMask,
+                             0,
+                             0, nullptr,
+                             (uint32_t)batch.bufferBarriers.size(), batch.bufferBarriers.data(),
+                             (uint32_t)batch.imageBarriers.size(), batch.imageBarriers.data());
+    };
+
+    for (auto &transition : preTransferTransitions)
+    {
+        recordBarriers(transition);
+    }
+
+    recordBarriers(preTransferBarriers);
+
+    for (auto &copy : bufferCopies)
+    {
+        vkCmdCopyBuffer(commandBuffer, copy.srcBuffer, copy.dstBuffer, 1, &copy.region);
+    }
+
+    for (auto &copy : imageCopies)
+    {
+        vkCmdCopyBufferToImage(commandBuffer,
+                               copy.srcBuffer,
+                               copy.dstImage,
+                               VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                               (uint32_t)copy.regions.size(),
+                               copy.regions.data());
+    }
+
+    recordBarriers(postTransferBarriers);
+
+    for (auto &transition : postTransferTransitions)
+    {
+        recordBarriers(transition);
+    }
+
+    recordBarriers(preReadbackBarriers);
+
+    for (auto &readback : imageReadbacks)
+    {
+        vkCmdCopyImageToBuffer(commandBuffer, readback.srcImage, readback.srcLayout, readback.dstBuffer, 1, &readback.region);
+    }
+
+    for (auto &readback : bufferReadbacks)
     {
-        commandBuffers.push_back(submitGroup.commandBuffer);
+        vkCmdCopyBuffer(commandBuffer, readback.srcBuffer, readback.dstBuffer, 1, &readback.region);
     }
 
-    VkFenceCreateInfo fenceInfo = {};
-    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
-    VkFence fence;
-    vkCreateFence(context->GetVkDevice(), &fenceInfo, nullptr, &fence);
+    recordBarriers(postReadbackBarriers);
+
+    vkEndCommandBuffer(commandBuffer);
 
     VkSubmitInfo submitInfo = {};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
-    submitInfo.commandBufferCount = (uint32_t)commandBuffers.size();
-    submitInfo.pCommandBuffers = commandBuffers.data();
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
 
-    if (vkQueueSubmit(context->GetQueue(VK_QUEUE_GRAPHICS_BIT).queue, 1, &submitInfo, fence) != VK_SUCCESS)
+    frame.deletionSerial = context->GetDeletionQueue().Submit();
+    if (vkQueueSubmit(context->GetQueue(VK_QUEUE_GRAPHICS_BIT).queue, 1, &submitInfo, frame.fence) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to submit auxiliary command buffer!");
     }
 
-    auto result = vkWaitForFences(context->GetVkDevice(), 1, &fence, VK_TRUE, UINT32_MAX);
-    vkDestroyFence(context->GetVkDevice(), fence, nullptr);
-
-    for (auto &group : submitGroups)
+    // later submissions on the same queue are ordered after the barriers above,
+    // no need to wait for the fence here
+    for (auto &texture : pendingTransitions)
     {
-        if (group.dstTexture)
-        {
-            static_cast<VulkanTexture *>(group.dstTexture.get())->inTransition = false;
-        }
+        texture->inTransition = false;
     }
-    submitGroups.clear();
 
-    this->resetCommandPool();
-    
+    frame.submitSerial = submitSerial++;
+    frame.resources = std::move(pendingResources);
+
+    statistics->AddTransfers(bufferCopies.size() + imageCopies.size() + imageReadbacks.size() + bufferReadbacks.size(), pendingUploadBytes, pendingReadbackBytes);
+    pendingUploadBytes = 0;
+    pendingReadbackBytes = 0;
+
+    preTransferTransitions.clear();
+    preTransferBarriers.Clear();
+    postTransferBarriers.Clear();
+    postTransferTransitions.clear();
+    bufferCopies.clear();
+    imageCopies.clear();
+    preReadbackBarriers.Clear();
+    postReadbackBarriers.Clear();
+    imageReadbacks.clear();
+    bufferReadbacks.clear();
+    pendingResources.clear();
+    pendingTransitions.clear();
+
+    currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
+
     return true;
 }
 
 void VulkanAuxiliaryExecutor::WaitIdle()
 {
     vkDeviceWaitIdle(context->GetVkDevice());
+    recycleAllFrames();
+    context->GetDeletionQueue().Flush();
 }
 
-static void setImageLayout(
-    VkCommandBuffer cmdbuffer,
+static VkImageMemoryBarrier imageLayoutBarrier(
     VkImage image,
     VkImageLayout oldImageLayout,
     VkImageLayout newImageLayout,
-    VkImageSubresourceRange subresourceRange,
-    VkPipelineStageFlags srcStageMask,
-    VkPipelineStageFlags dstStageMask)
+    VkImageSubresourceRange subresourceRange)
 {
     // Create an image barrier object
     VkImageMemoryBarrier imageMemoryBarrier = {};
@@ -174,20 +257,22 @@ static void setImageLayout(
         }
         imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
         break;
+
+    case VK_IMAGE_LAYOUT_GENERAL:
+        // Image will be read or written in a shader (storage image)
+        // Make sure any writes to the image have been finished
+        if (imageMemoryBarrier.srcAccessMask == 0)
+        {
+            imageMemoryBarrier.srcAccessMask = VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+        }
+        imageMemoryBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        break;
     default:
         // Other source layouts aren't handled (yet)
         break;
     }
 
-    // Put barrier inside setup command buffer
-    vkCmdPipelineBarrier(
-        cmdbuffer,
-        srcStageMask,
-        dstStageMask,
-        0,
-        0, nullptr,
-        0, nullptr,
-        1, &imageMemoryBarrier);
+    return imageMemoryBarrier;
 }
 
 void VulkanAuxiliaryExecutor::TransferResource(IntrusivePtr<Texture> gpuTexture, IntrusivePtr<Buffer> hostBuffer, TransferConfig config)
@@ -195,10 +280,311 @@ void VulkanAuxiliaryExecutor::TransferResource(IntrusivePtr<Texture> gpuTexture,
     auto texture = static_cast<VulkanTexture *>(gpuTexture.get());
     auto stagingBuffer = static_cast<VulkanBuffer *>(hostBuffer.get());
 
-    auto commandBuffer = allocateCommandBuffer(graphicCommandPool);
-    VkCommandBufferBeginInfo cmdBufferBeginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
-    vkBeginCommandBuffer(commandBuffer, &cmdBufferBeginInfo);
+    if (captureRecorder->IsEnabled())
+    {
+        captureRecorder->RecordTransfer(texture, stagingBuffer->Map(), stagingBuffer->Size(), config);
+    }
+
+    queueTextureTransfer(texture, stagingBuffer->GetBuffer(), 0, config);
+    pendingUploadBytes += stagingBuffer->Size();
+
+    pendingResources.push_back(texture);
+    pendingResources.push_back(stagingBuffer);
+}
+
+void VulkanAuxiliaryExecutor::TransferResource(IntrusivePtr<Buffer> gpuBuffer, IntrusivePtr<Buffer> hostBuffer)
+{
+    auto buffer = static_cast<VulkanBuffer *>(gpuBuffer.get());
+    auto stagingBuffer = static_cast<VulkanBuffer *>(hostBuffer.get());
+
+    // the allocation of either buffer may be larger than the buffer itself
+    auto size = std::min(stagingBuffer->GetCreatedSize(), buffer->GetCreatedSize());
+
+    if (captureRecorder->IsEnabled())
+    {
+        captureRecorder->RecordTransfer(buffer, stagingBuffer->Map(), size);
+    }
+
+    queueBufferTransfer(buffer->GetBuffer(), stagingBuffer->GetBuffer(), 0, size);
+    pendingUploadBytes += size;
+
+    pendingResources.push_back(buffer);
+    pendingResources.push_back(stagingBuffer);
+}
+
+void VulkanAuxiliaryExecutor::TransferResource(IntrusivePtr<Texture> gpuTexture, const void *data, size_t size, TransferConfig config)
+{
+    auto texture = static_cast<VulkanTexture *>(gpuTexture.get());
+    captureRecorder->RecordTransfer(texture, data, size, config);
+    auto staging = allocateStaging(data, size);
+
+    queueTextureTransfer(texture, staging.buffer, staging.offset, config);
+    pendingUploadBytes += size;
+
+    pendingResources.push_back(texture);
+    if (staging.fallbackBuffer)
+        pendingResources.push_back(staging.fallbackBuffer);
+}
+
+void VulkanAuxiliaryExecutor::TransferResource(IntrusivePtr<Buffer> gpuBuffer, const void *data, size_t size)
+{
+    auto buffer = static_cast<VulkanBuffer *>(gpuBuffer.get());
+    captureRecorder->RecordTransfer(buffer, data, size);
+    auto staging = allocateStaging(data, size);
+
+    queueBufferTransfer(buffer->GetBuffer(), staging.buffer, staging.offset, size);
+    pendingUploadBytes += size;
+
+    pendingResources.push_back(buffer);
+    if (staging.fallbackBuffer)
+        pendingResources.push_back(staging.fallbackBuffer);
+}
+
+// layout the runtime leaves a texture in between submissions
+static VkImageLayout restingLayout(VulkanTexture *texture)
+{
+    if (texture->IsSwapChain() && texture->IsExternal())
+        return VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    if (texture->GetUsage() & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT))
+        return VK_IMAGE_LAYOUT_GENERAL;
+    return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+IntrusivePtr<Readback> VulkanAuxiliaryExecutor::ReadbackResource(IntrusivePtr<Texture> gpuTexture, uint32_t mipLevel, uint32_t arrayLayer)
+{
+    auto texture = static_cast<VulkanTexture *>(gpuTexture.get());
+
+    auto textureFormat = texture->GetTextureFormat();
+    auto aspectMask = textureFormat == TextureFormat::FORMAT_D16_UNORM ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+
+    Texture::Extent extent = {
+        .width = std::max(texture->GetExtent().width >> mipLevel, 1u),
+        .height = std::max(texture->GetExtent().height >> mipLevel, 1u),
+        .depth = std::max(texture->GetExtent().depth >> mipLevel, 1u)};
+    size_t size = size_t(extent.width) * extent.height * extent.depth * GeneralFormatToSize(textureFormat);
+
+    auto readbackBuffer = createReadbackBuffer(size);
 
+    VkImageSubresourceRange subresourceRange = {};
+    subresourceRange.aspectMask = aspectMask;
+    subresourceRange.baseMipLevel = mipLevel;
+    subresourceRange.levelCount = 1;
+    subresourceRange.baseArrayLayer = arrayLayer;
+    subresourceRange.layerCount = 1;
+
+    // GENERAL can be copied from directly, other layouts go through TRANSFER_SRC and back
+    auto layout = restingLayout(texture);
+    auto copyLayout = layout == VK_IMAGE_LAYOUT_GENERAL ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    auto preBarrier = imageLayoutBarrier(texture->GetImage(), layout, copyLayout, subresourceRange);
+    preBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    preBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    preReadbackBarriers.imageBarriers.push_back(preBarrier);
+    preReadbackBarriers.srcStageMask |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    preReadbackBarriers.dstStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+    VkBufferImageCopy region = {};
+    region.bufferOffset = 0;
+    region.imageSubresource.aspectMask = aspectMask;
+    region.imageSubresource.mipLevel = mipLevel;
+    region.imageSubresource.baseArrayLayer = arrayLayer;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = {extent.width, extent.height, extent.depth};
+
+    imageReadbacks.push_back(ImageReadback{
+        .srcImage = texture->GetImage(),
+        .srcLayout = copyLayout,
+        .dstBuffer = readbackBuffer->GetBuffer(),
+        .region = region});
+
+    if (copyLayout != layout)
+    {
+        auto postBarrier = imageLayoutBarrier(texture->GetImage(), copyLayout, layout, subresourceRange);
+        postBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+        postBarrier.dstAccessMask = 0;
+        postReadbackBarriers.imageBarriers.push_back(postBarrier);
+        postReadbackBarriers.srcStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+        postReadbackBarriers.dstStageMask |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    }
+
+    pendingResources.push_back(texture);
+    pendingReadbackBytes += size;
+
+    IntrusivePtr<VulkanReadback> readback = new VulkanReadback(this, readbackBuffer, submitSerial);
+    readback->size = size;
+    readback->format = textureFormat;
+    readback->extent = extent;
+    return readback;
+}
+
+IntrusivePtr<Readback> VulkanAuxiliaryExecutor::ReadbackResource(IntrusivePtr<Buffer> gpuBuffer, size_t offset, size_t size)
+{
+    auto buffer = static_cast<VulkanBuffer *>(gpuBuffer.get());
+    auto bufferSize = buffer->GetCreatedSize();
+    if (offset >= bufferSize || size > bufferSize - offset)
+    {
+        throw std::runtime_error("readback range exceeds the buffer!");
+    }
+    if (size == 0)
+    {
+        size = bufferSize - offset;
+    }
+
+    auto readbackBuffer = createReadbackBuffer(size);
+
+    // writes from any earlier submission (compute, transfer) must be visible to the copy
+    VkBufferMemoryBarrier bufferMemoryBarrier = {};
+    bufferMemoryBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferMemoryBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    bufferMemoryBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+    bufferMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferMemoryBarrier.buffer = buffer->GetBuffer();
+    bufferMemoryBarrier.offset = offset;
+    bufferMemoryBarrier.size = size;
+    preReadbackBarriers.bufferBarriers.push_back(bufferMemoryBarrier);
+    preReadbackBarriers.srcStageMask |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    preReadbackBarriers.dstStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+    bufferReadbacks.push_back(BufferCopy{
+        .srcBuffer = buffer->GetBuffer(),
+        .dstBuffer = readbackBuffer->GetBuffer(),
+        .region = {
+            .srcOffset = offset,
+            .dstOffset = 0,
+            .size = size,
+        }});
+
+    pendingResources.push_back(buffer);
+    pendingReadbackBytes += size;
+
+    IntrusivePtr<VulkanReadback> readback = new VulkanReadback(this, readbackBuffer, submitSerial);
+    readback->size = size;
+    return readback;
+}
+
+IntrusivePtr<VulkanBuffer> VulkanAuxiliaryExecutor::createReadbackBuffer(size_t size)
+{
+    VkBufferCreateInfo bufferCI = {};
+    bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferCI.size = size;
+
+    // random access lets vma prefer host cached memory, cpu reads it back
+    VmaAllocationCreateInfo memoryCI = {};
+    memoryCI.usage = VMA_MEMORY_USAGE_AUTO;
+    memoryCI.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT;
+    memoryCI.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    IntrusivePtr<VulkanBuffer> readbackBuffer = new VulkanBuffer(context);
+    if (!readbackBuffer->Allocate(bufferCI, memoryCI))
+    {
+        throw std::runtime_error("failed to allocate readback buffer!");
+    }
+
+    // host-visible copy is written by the transfer, make it visible to host reads
+    VkBufferMemoryBarrier bufferMemoryBarrier = {};
+    bufferMemoryBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufferMemoryBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    bufferMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferMemoryBarrier.buffer = readbackBuffer->GetBuffer();
+    bufferMemoryBarrier.offset = 0;
+    bufferMemoryBarrier.size = VK_WHOLE_SIZE;
+    postReadbackBarriers.bufferBarriers.push_back(bufferMemoryBarrier);
+    postReadbackBarriers.srcStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+    postReadbackBarriers.dstStageMask |= VK_PIPELINE_STAGE_HOST_BIT;
+
+    pendingResources.push_back(readbackBuffer);
+
+    return readbackBuffer;
+}
+
+bool VulkanAuxiliaryExecutor::PollSubmission(uint64_t serial, bool wait)
+{
+    if (serial <= completedSerial)
+    {
+        return true;
+    }
+
+    // still queued, nothing to wait on until it is submitted
+    if (serial >= submitSerial)
+    {
+        if (!wait)
+        {
+            return false;
+        }
+        Execute();
+    }
+
+    if (!wait)
+    {
+        for (auto &frame : frames)
+        {
+            if (frame.submitSerial == serial && vkGetFenceStatus(context->GetVkDevice(), frame.fence) != VK_SUCCESS)
+            {
+                return false;
+            }
+        }
+    }
+
+    // retire in submission order up to serial
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        auto &frame = frames[(currentFrame + i) % MAX_FRAMES_IN_FLIGHT];
+        if (frame.submitSerial && frame.submitSerial <= serial)
+        {
+            recycleFrame(frame);
+        }
+    }
+
+    return serial <= completedSerial;
+}
+
+VulkanAuxiliaryExecutor::StagingAllocation VulkanAuxiliaryExecutor::allocateStaging(const void *data, size_t size)
+{
+    if (!stagingRing)
+    {
+        stagingRing = new VulkanStagingRing(context, STAGING_RING_SIZE);
+
+        // bufferOffset of buffer to image copies must be a multiple of 4 and texel size
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(context->GetVkPhysicalDevice(), &properties);
+        stagingAlignment = std::max<VkDeviceSize>(properties.limits.optimalBufferCopyOffsetAlignment, 16);
+    }
+
+    VulkanStagingRing::Allocation allocation;
+    bool allocated = stagingRing->Allocate(size, stagingAlignment, submitSerial, allocation);
+
+    // ring is full, flush pending transfers and wait until their regions retire
+    if (!allocated && size <= stagingRing->Capacity())
+    {
+        Execute();
+        recycleAllFrames();
+        allocated = stagingRing->Allocate(size, stagingAlignment, submitSerial, allocation);
+    }
+
+    if (allocated)
+    {
+        memcpy(allocation.data, data, size);
+        return StagingAllocation{
+            .buffer = allocation.buffer,
+            .offset = allocation.offset};
+    }
+
+    // larger than the whole ring, use a dedicated buffer
+    auto fallbackBuffer = new VulkanBuffer(context);
+    fallbackBuffer->Allocate(Buffer::BUFFER_USAGE_TRANSFER_SRC_BIT, MemoryProperty::MEMORY_PROPERTY_HOST_VISIBLE_BIT | MemoryProperty::MEMORY_PROPERTY_HOST_COHERENT_BIT, size);
+    memcpy(fallbackBuffer->Map(), data, size);
+    return StagingAllocation{
+        .buffer = fallbackBuffer->GetBuffer(),
+        .offset = 0,
+        .fallbackBuffer = fallbackBuffer};
+}
+
+void VulkanAuxiliaryExecutor::queueTextureTransfer(VulkanTexture *texture, VkBuffer srcBuffer, VkDeviceSize srcOffset, const TransferConfig &config)
+{
     VkImageSubresourceRange subresourceRange = {};
     subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     subresourceRange.baseMipLevel = 0;
@@ -211,15 +597,16 @@ void VulkanAuxiliaryExecutor::TransferResource(IntrusivePtr<Texture> gpuTexture,
         throw std::runtime_error("mipmapBufferLevelOffsets not found when texture mipmapLevel > 1");
     }
 
-    setImageLayout(commandBuffer,
-                   texture->GetImage(),
-                   VK_IMAGE_LAYOUT_UNDEFINED,
-                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                   subresourceRange,
-                   VK_PIPELINE_STAGE_HOST_BIT,
-                   VK_PIPELINE_STAGE_TRANSFER_BIT);
+    preTransferBarriers.imageBarriers.push_back(imageLayoutBarrier(texture->GetImage(),
+                                                                   VK_IMAGE_LAYOUT_UNDEFINED,
+                                                                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                                   subresourceRange));
+    preTransferBarriers.srcStageMask |= VK_PIPELINE_STAGE_HOST_BIT;
+    preTransferBarriers.dstStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
 
-    std::vector<VkBufferImageCopy> bufferCopyRegions;
+    ImageCopy imageCopy = {
+        .srcBuffer = srcBuffer,
+        .dstImage = texture->GetImage()};
     for (uint32_t i = 0; i < texture->LevelCount(); i++)
     {
         // Setup a buffer image copy structure for the current mip level
@@ -231,68 +618,75 @@ void VulkanAuxiliaryExecutor::TransferResource(IntrusivePtr<Texture> gpuTexture,
         bufferCopyRegion.imageExtent.width = texture->GetExtent().width >> i;
         bufferCopyRegion.imageExtent.height = texture->GetExtent().height >> i;
         bufferCopyRegion.imageExtent.depth = texture->GetExtent().depth;
-        bufferCopyRegion.bufferOffset = config.mipmapBufferLevelOffsets.empty() ? 0 : config.mipmapBufferLevelOffsets[i];
-        bufferCopyRegions.push_back(bufferCopyRegion);
-    }
-
-    vkCmdCopyBufferToImage(
-        commandBuffer,
-        stagingBuffer->GetBuffer(),
-        texture->GetImage(),
-        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-        (uint32_t)bufferCopyRegions.size(),
-        bufferCopyRegions.data());
-
-    setImageLayout(commandBuffer,
-                   texture->GetImage(),
-                   VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-                   VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
-                   subresourceRange,
-                   VK_PIPELINE_STAGE_TRANSFER_BIT,
-                   VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT);
-
-    vkEndCommandBuffer(commandBuffer);
-
-    this->submitGroups.push_back(SubmitGroup{
-        .commandBuffer = commandBuffer,
-        .dstTexture = texture,
-        .srcBuffer = stagingBuffer});
+        bufferCopyRegion.bufferOffset = srcOffset + (config.mipmapBufferLevelOffsets.empty() ? 0 : config.mipmapBufferLevelOffsets[i]);
+        imageCopy.regions.push_back(bufferCopyRegion);
+    }
+    imageCopies.push_back(std::move(imageCopy));
+
+    // storage images stay GENERAL so compute passes can keep writing them
+    texture->layout = restingLayout(texture);
+    postTransferBarriers.imageBarriers.push_back(imageLayoutBarrier(texture->GetImage(),
+                                                                    VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                                    texture->layout,
+                                                                    subresourceRange));
+    postTransferBarriers.srcStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+    // vertex shaders may sample the texture too
+    postTransferBarriers.dstStageMask |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
 }
 
-void VulkanAuxiliaryExecutor::TransferResource(IntrusivePtr<Buffer> gpuBuffer, IntrusivePtr<Buffer> hostBuffer)
+void VulkanAuxiliaryExecutor::queueBufferTransfer(VkBuffer dstBuffer, VkBuffer srcBuffer, VkDeviceSize srcOffset, VkDeviceSize size)
 {
-    auto buffer = static_cast<VulkanBuffer *>(gpuBuffer.get());
-    auto stagingBuffer = static_cast<VulkanBuffer *>(hostBuffer.get());
-
-    auto commandBuffer = allocateCommandBuffer(graphicCommandPool);
-    VkCommandBufferBeginInfo cmdBufferBeginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
-    vkBeginCommandBuffer(commandBuffer, &cmdBufferBeginInfo);
-
-    VkBufferCopy bufferCopyRegion = {
-        .srcOffset = 0,
-        .dstOffset = 0,
-        .size = stagingBuffer->Size(),
-    };
-
-    vkCmdCopyBuffer(commandBuffer, stagingBuffer->GetBuffer(), buffer->GetBuffer(), 1, &bufferCopyRegion);
-
-    vkEndCommandBuffer(commandBuffer);
+    // frames still in flight may read or write the buffer, the copy waits for them
+    VkBufferMemoryBarrier preCopyBarrier = {};
+    preCopyBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    preCopyBarrier.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+    preCopyBarrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    preCopyBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    preCopyBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    preCopyBarrier.buffer = dstBuffer;
+    preCopyBarrier.offset = 0;
+    preCopyBarrier.size = size;
+
+    preTransferBarriers.bufferBarriers.push_back(preCopyBarrier);
+    preTransferBarriers.srcStageMask |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+    preTransferBarriers.dstStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+
+    bufferCopies.push_back(BufferCopy{
+        .srcBuffer = srcBuffer,
+        .dstBuffer = dstBuffer,
+        .region = {
+            .srcOffset = srcOffset,
+            .dstOffset = 0,
+            .size = size,
+        }});
+
+    // make the copy visible to any later read (vertex, index, uniform, storage)
+    VkBufferMemoryBarrier bufferMemoryBarrier = {};
+    bufferMemoryBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+    bufferMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    bufferMemoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
+    bufferMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    bufferMemoryBarrier.buffer = dstBuffer;
+    bufferMemoryBarrier.offset = 0;
+    bufferMemoryBarrier.size = size;
+
+    postTransferBarriers.bufferBarriers.push_back(bufferMemoryBarrier);
+    postTransferBarriers.srcStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+    postTransferBarriers.dstStageMask |= VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+}
 
-    this->submitGroups.push_back(SubmitGroup{
-        .commandBuffer = commandBuffer,
-        .dstBuffer = buffer,
-        .srcBuffer = stagingBuffer});
+bool VulkanAuxiliaryExecutor::hasPendingWork()
+{
+    return !preTransferTransitions.empty() || !preTransferBarriers.Empty() || !postTransferBarriers.Empty() || !postTransferTransitions.empty() ||
+           !bufferCopies.empty() || !imageCopies.empty() || !imageReadbacks.empty() || !bufferReadbacks.empty();
 }
-#include <spdlog/spdlog.h>
+
 bool VulkanAuxiliaryExecutor::SetImageLayout(IntrusivePtr<VulkanTexture> texture, ImageLayoutConfig config)
 {
     if (texture->inTransition)
         return false;
 
-    auto commandBuffer = allocateCommandBuffer(graphicCommandPool);
-    VkCommandBufferBeginInfo cmdBufferBeginInfo = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
-    vkBeginCommandBuffer(commandBuffer, &cmdBufferBeginInfo);
-
     VkImageMemoryBarrier imageMemoryBarrier = {};
     imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
     imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
@@ -302,60 +696,124 @@ bool VulkanAuxiliaryExecutor::SetImageLayout(IntrusivePtr<VulkanTexture> texture
     imageMemoryBarrier.image = texture->GetImage();
     imageMemoryBarrier.subresourceRange = texture->GetImageSubResourceRange(config.aspectMask);
 
-    vkCmdPipelineBarrier(commandBuffer, config.srcStageMask, config.dstStageMask, VK_DEPENDENCY_BY_REGION_BIT, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
+    // a barrier of its own, the upload barriers of the same image must not share its oldLayout
+    BarrierBatch transition;
+    transition.srcStageMask = config.srcStageMask;
+    transition.dstStageMask = config.dstStageMask;
 
-    vkEndCommandBuffer(commandBuffer);
+    // an image uploaded in this submission is transitioned after the copy from its resting layout,
+    // from UNDEFINED the uploaded data would be discarded
+    auto uploaded = std::any_of(imageCopies.begin(), imageCopies.end(), [&](const ImageCopy &copy)
+                                { return copy.dstImage == texture->GetImage(); });
+    if (uploaded)
+    {
+        imageMemoryBarrier.oldLayout = texture->layout;
+        imageMemoryBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        imageMemoryBarrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+        transition.srcStageMask |= VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
+
+    transition.imageBarriers.push_back(imageMemoryBarrier);
+    (uploaded ? postTransferTransitions : preTransferTransitions).push_back(std::move(transition));
 
-    this->submitGroups.push_back(SubmitGroup{
-        .commandBuffer = commandBuffer,
-        .dstTexture = texture});
+    pendingResources.push_back(texture);
+    pendingTransitions.push_back(texture);
 
     texture->inTransition = true;
+    texture->layout = config.newLayout;
 
     return true;
 }
 
-void VulkanAuxiliaryExecutor::prepareCommandPool()
+void VulkanAuxiliaryExecutor::prepareFrames()
 {
+    for (auto &frame : frames)
     {
         VkCommandPoolCreateInfo cmdPoolInfo = {};
         cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
         cmdPoolInfo.queueFamilyIndex = context->GetQueue(VK_QUEUE_GRAPHICS_BIT).familyIndex;
-        cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-        auto result = vkCreateCommandPool(context->GetVkDevice(), &cmdPoolInfo, nullptr, &graphicCommandPool);
+        cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+        auto result = vkCreateCommandPool(context->GetVkDevice(), &cmdPoolInfo, nullptr, &frame.commandPool);
+
+        VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+        commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        commandBufferAllocateInfo.commandPool = frame.commandPool;
+        commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandBufferAllocateInfo.commandBufferCount = 1;
+        result = vkAllocateCommandBuffers(context->GetVkDevice(), &commandBufferAllocateInfo, &frame.commandBuffer);
+
+        VkFenceCreateInfo fenceInfo = {};
+        fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+        result = vkCreateFence(context->GetVkDevice(), &fenceInfo, nullptr, &frame.fence);
     }
+}
+
+// wait for the frame submission, then make its command buffer and staging regions reusable
+void VulkanAuxiliaryExecutor::recycleFrame(FrameResources &frame)
+{
+    if (frame.submitSerial == 0)
+        return;
+
+    auto result = vkWaitForFences(context->GetVkDevice(), 1, &frame.fence, VK_TRUE, UINT64_MAX);
+    vkResetFences(context->GetVkDevice(), 1, &frame.fence);
+    vkResetCommandPool(context->GetVkDevice(), frame.commandPool, 0);
 
+    if (stagingRing)
     {
-        VkCommandPoolCreateInfo cmdPoolInfo = {};
-        cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
-        cmdPoolInfo.queueFamilyIndex = context->GetQueue(VK_QUEUE_COMPUTE_BIT).familyIndex;
-        cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-        auto result = vkCreateCommandPool(context->GetVkDevice(), &cmdPoolInfo, nullptr, &computeCommandPool);
+        stagingRing->Retire(frame.submitSerial);
     }
-}
 
-void VulkanAuxiliaryExecutor::resetCommandPool()
-{
-    vkDestroyCommandPool(context->GetVkDevice(), graphicCommandPool, nullptr);
-    vkDestroyCommandPool(context->GetVkDevice(), computeCommandPool, nullptr);
-    prepareCommandPool();
+    completedSerial = std::max(completedSerial, frame.submitSerial);
+    context->GetDeletionQueue().Complete(frame.deletionSerial);
+
+    frame.resources.clear();
+    frame.submitSerial = 0;
 }
 
-VkCommandBuffer VulkanAuxiliaryExecutor::allocateCommandBuffer(VkCommandPool pool)
+void VulkanAuxiliaryExecutor::recycleAllFrames()
 {
-    VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
-    commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
-    commandBufferAllocateInfo.commandPool = pool;
-    commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    commandBufferAllocateInfo.commandBufferCount = 1;
-
-    VkCommandBuffer cmdBuffer;
-    vkAllocateCommandBuffers(context->GetVkDevice(), &commandBufferAllocateInfo, &cmdBuffer);
-    return cmdBuffer;
+    // oldest submission first, keeps staging retirement in order
+    for (uint32_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++)
+    {
+        recycleFrame(frames[(currentFrame + i) % MAX_FRAMES_IN_FLIGHT]);
+    }
 }
 
 void VulkanAuxiliaryExecutor::Reset()
 {
-    this->submitGroups.clear();
-    resetCommandPool();
-}
\ No newline at end of file
+    recycleAllFrames();
+
+    // readbacks queued since the last Execute fail instead of resolving without data
+    if (!imageReadbacks.empty() || !bufferReadbacks.empty())
+    {
+        droppedSerials.insert(submitSerial);
+    }
+
+    preTransferTransitions.clear();
+    preTransferBarriers.Clear();
+    postTransferBarriers.Clear();
+    postTransferTransitions.clear();
+    bufferCopies.clear();
+    imageCopies.clear();
+    preReadbackBarriers.Clear();
+    postReadbackBarriers.Clear();
+    imageReadbacks.clear();
+    bufferReadbacks.clear();
+    pendingResources.clear();
+    // the dropped transitions never run, the textures may be transitioned again
+    for (auto &texture : pendingTransitions)
+    {
+        texture->inTransition = false;
+    }
+    pendingTransitions.clear();
+    pendingUploadBytes = 0;
+    pendingReadbackBytes = 0;
+
+    // dropped transfers never reach the gpu, their staging regions are free
+    if (stagingRing)
+    {
+        stagingRing->Retire(submitSerial);
+    }
+    completedSerial = submitSerial;
+    submitSerial++;
+}
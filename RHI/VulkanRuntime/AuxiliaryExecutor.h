@@ -3,12 +3,21 @@
 #include <RHI/AuxiliaryExecutor.h>
 #include <RHI/VulkanRuntime/Context.h>
 #include <RHI/VulkanRuntime/Texture.h>
+#include <RHI/VulkanRuntime/StagingRing.h>
+#include <RHI/VulkanRuntime/Buffer.h>
+#include <RHI/VulkanRuntime/Readback.h>
+#include <RHI/VulkanRuntime/StatisticsCollector.h>
+#include <RHI/CaptureRecorder.h>
 #include <vulkan/vulkan.h>
 
+#include <array>
+#include <unordered_set>
+#include <vector>
+
 class VulkanAuxiliaryExecutor : public AuxiliaryExecutor
 {
 public:
-    VulkanAuxiliaryExecutor(IntrusivePtr<Context> context);
+    VulkanAuxiliaryExecutor(IntrusivePtr<Context> context, IntrusivePtr<VulkanStatisticsCollector> statistics, IntrusivePtr<CaptureRecorder> captureRecorder);
     virtual ~VulkanAuxiliaryExecutor();
 
     // build command buffer
@@ -19,9 +28,23 @@ public:
 
     virtual void TransferResource(IntrusivePtr<Texture> gpuTexture, IntrusivePtr<Buffer> hostBuffer, TransferConfig config = {}) override;
     virtual void TransferResource(IntrusivePtr<Buffer> gpuBuffer, IntrusivePtr<Buffer> hostBuffer) override;
+    virtual void TransferResource(IntrusivePtr<Texture> gpuTexture, const void *data, size_t size, TransferConfig config = {}) override;
+    virtual void TransferResource(IntrusivePtr<Buffer> gpuBuffer, const void *data, size_t size) override;
+
+    virtual IntrusivePtr<Readback> ReadbackResource(IntrusivePtr<Texture> gpuTexture, uint32_t mipLevel = 0, uint32_t arrayLayer = 0) override;
+    virtual IntrusivePtr<Readback> ReadbackResource(IntrusivePtr<Buffer> gpuBuffer, size_t offset = 0, size_t size = 0) override;
 
     virtual void Reset() override;
 
+    // true if submission with serial completed, flush and block on it if wait
+    bool PollSubmission(uint64_t serial, bool wait);
+
+    // true if the work queued under serial was dropped by Reset instead of being submitted
+    bool IsSubmissionDropped(uint64_t serial)
+    {
+        return droppedSerials.count(serial);
+    }
+
     struct ImageLayoutConfig
     {
         VkImageAspectFlags aspectMask;
@@ -37,24 +60,121 @@ public:
 
 private:
     IntrusivePtr<Context> context;
+    IntrusivePtr<VulkanStatisticsCollector> statistics;
+    IntrusivePtr<CaptureRecorder> captureRecorder;
+
+    // bytes queued since the last Execute
+    uint64_t pendingUploadBytes = 0;
+    uint64_t pendingReadbackBytes = 0;
 
-    VkCommandPool graphicCommandPool;
-    VkCommandPool computeCommandPool;
+    static constexpr uint32_t MAX_FRAMES_IN_FLIGHT = 2;
 
-    struct SubmitGroup
+    // one command buffer per submission, pool is reset once the fence signaled
+    struct FrameResources
     {
+        VkCommandPool commandPool;
         VkCommandBuffer commandBuffer;
+        VkFence fence;
+
+        // serial of the submission using this frame, 0 if idle
+        uint64_t submitSerial = 0;
+        uint64_t deletionSerial = 0;
 
         // ptr copy to keep resource alive during submit
-        IntrusivePtr<Texture> dstTexture;
-        IntrusivePtr<Buffer> dstBuffer;
-        IntrusivePtr<Buffer> srcBuffer;
+        std::vector<IntrusivePtr<ResourceHandle>> resources;
+    };
+
+    std::array<FrameResources, MAX_FRAMES_IN_FLIGHT> frames;
+    uint32_t currentFrame = 0;
+
+    struct BarrierBatch
+    {
+        std::vector<VkImageMemoryBarrier> imageBarriers;
+        std::vector<VkBufferMemoryBarrier> bufferBarriers;
+        VkPipelineStageFlags srcStageMask = 0;
+        VkPipelineStageFlags dstStageMask = 0;
+
+        bool Empty()
+        {
+            return imageBarriers.empty() && bufferBarriers.empty();
+        }
+
+        void Clear()
+        {
+            *this = {};
+        }
+    };
+
+    struct BufferCopy
+    {
+        VkBuffer srcBuffer;
+        VkBuffer dstBuffer;
+        VkBufferCopy region;
     };
 
-    // commandBuffers to be submit
-    std::vector<SubmitGroup> submitGroups;
+    struct ImageCopy
+    {
+        VkBuffer srcBuffer;
+        VkImage dstImage;
+        std::vector<VkBufferImageCopy> regions;
+    };
+
+    struct ImageReadback
+    {
+        VkImage srcImage;
+        VkImageLayout srcLayout;
+        VkBuffer dstBuffer;
+        VkBufferImageCopy region;
+    };
+
+    // recorded into a single command buffer on Execute:
+    // preTransferTransitions -> preTransferBarriers -> copies -> postTransferBarriers -> postTransferTransitions
+    // -> preReadbackBarriers -> readbacks -> postReadbackBarriers
+    // SetImageLayout transitions are one barrier each in request order
+    std::vector<BarrierBatch> preTransferTransitions;
+    BarrierBatch preTransferBarriers;
+    std::vector<BufferCopy> bufferCopies;
+    std::vector<ImageCopy> imageCopies;
+    BarrierBatch postTransferBarriers;
+    std::vector<BarrierBatch> postTransferTransitions;
+
+    BarrierBatch preReadbackBarriers;
+    std::vector<ImageReadback> imageReadbacks;
+    std::vector<BufferCopy> bufferReadbacks;
+    BarrierBatch postReadbackBarriers;
+
+    std::vector<IntrusivePtr<ResourceHandle>> pendingResources;
+    std::vector<IntrusivePtr<VulkanTexture>> pendingTransitions;
+
+    // created on first raw data transfer
+    IntrusivePtr<VulkanStagingRing> stagingRing;
+    static constexpr VkDeviceSize STAGING_RING_SIZE = 32 * 1024 * 1024;
+    VkDeviceSize stagingAlignment = 16;
+
+    // staging regions allocated before the next Execute retire with this value
+    uint64_t submitSerial = 1;
+    // every submission up to this serial has completed
+    uint64_t completedSerial = 0;
+    // serials Reset dropped with readbacks queued, they completed without running
+    std::unordered_set<uint64_t> droppedSerials;
+
+    struct StagingAllocation
+    {
+        VkBuffer buffer;
+        VkDeviceSize offset;
+
+        // set when data does not fit into the ring
+        IntrusivePtr<Buffer> fallbackBuffer;
+    };
+
+    StagingAllocation allocateStaging(const void *data, size_t size);
+    IntrusivePtr<VulkanBuffer> createReadbackBuffer(size_t size);
+
+    void queueTextureTransfer(VulkanTexture *texture, VkBuffer srcBuffer, VkDeviceSize srcOffset, const TransferConfig &config);
+    void queueBufferTransfer(VkBuffer dstBuffer, VkBuffer srcBuffer, VkDeviceSize srcOffset, VkDeviceSize size);
+    bool hasPendingWork();
 
-    void prepareCommandPool();
-    void resetCommandPool();
-    VkCommandBuffer allocateCommandBuffer(VkCommandPool pool);
+    void prepareFrames();
+    void recycleFrame(FrameResources &frame);
+    void recycleAllFrames();
 };
\ No newline at end of file
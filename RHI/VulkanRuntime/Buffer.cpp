@@ -1,5 +1,18 @@
 #include <RHI/VulkanRuntime/Buffer.h>
 
+#include <stdexcept>
+
+static MemoryCategory BufferMemoryCategory(VkBufferUsageFlags usage)
+{
+    if (usage & (VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT))
+        return MemoryCategory::GEOMETRY;
+    if (usage & VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+        return MemoryCategory::UNIFORM;
+    if (!(usage & ~(VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT)))
+        return MemoryCategory::STAGING;
+    return MemoryCategory::OTHER;
+}
+
 VulkanBuffer::VulkanBuffer(IntrusivePtr<Context> context) : context(context)
 {
 }
@@ -11,7 +24,16 @@ VulkanBuffer::~VulkanBuffer()
     {
         vmaUnmapMemory(allocator, bufferAllocation);
     }
-    vmaDestroyBuffer(allocator, buffer, bufferAllocation);
+
+    // in flight frames may still read the buffer
+    context->GetDeletionQueue().Retire([context = context.get(), category = memoryCategory, buffer = buffer, allocation = bufferAllocation, bufferViews = bufferViews]()
+                                       {
+                                           for (auto &[_, bufferView] : bufferViews)
+                                           {
+                                               vkDestroyBufferView(context->GetVkDevice(), bufferView, nullptr);
+                                           }
+                                           context->UntrackAllocation(category, allocation);
+                                           vmaDestroyBuffer(context->GetVmaAllocator(), buffer, allocation); });
 }
 
 bool VulkanBuffer::Allocate(Buffer::TypeBits type, MemoryPropertyBits memoryProperties, uint32_t size)
@@ -26,12 +48,22 @@ bool VulkanBuffer::Allocate(Buffer::TypeBits type, MemoryPropertyBits memoryProp
 
     auto result = vmaCreateBuffer(context->GetVmaAllocator(), &bufferCI, &memoryCI, &buffer, &bufferAllocation, &bufferAllocationInfo);
 
+    memoryCategory = BufferMemoryCategory(bufferCI.usage);
+    context->TrackAllocation(memoryCategory, bufferAllocation);
+
     return result == VK_SUCCESS;
 }
 
 bool VulkanBuffer::Allocate(VkBufferCreateInfo bufferCI, VmaAllocationCreateInfo memoryCI)
 {
+    this->bufferCI = bufferCI;
+    this->memoryCI = memoryCI;
+
     auto result = vmaCreateBuffer(context->GetVmaAllocator(), &bufferCI, &memoryCI, &buffer, &bufferAllocation, &bufferAllocationInfo);
+
+    memoryCategory = BufferMemoryCategory(bufferCI.usage);
+    context->TrackAllocation(memoryCategory, bufferAllocation);
+
     return result == VK_SUCCESS;
 }
 
@@ -45,6 +77,31 @@ IntrusivePtr<Buffer> VulkanBuffer::Clone()
     return newBuffer;
 }
 
+VkBufferView VulkanBuffer::GetBufferView(VkFormat format)
+{
+    if (bufferViews.count(format))
+    {
+        return bufferViews[format];
+    }
+
+    VkBufferViewCreateInfo bufferViewCI = {};
+    bufferViewCI.sType = VK_STRUCTURE_TYPE_BUFFER_VIEW_CREATE_INFO;
+    bufferViewCI.buffer = buffer;
+    bufferViewCI.format = format;
+    bufferViewCI.offset = 0;
+    bufferViewCI.range = VK_WHOLE_SIZE;
+
+    VkBufferView bufferView = VK_NULL_HANDLE;
+    auto result = vkCreateBufferView(context->GetVkDevice(), &bufferViewCI, nullptr, &bufferView);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create buffer view");
+    }
+
+    bufferViews[format] = bufferView;
+    return bufferView;
+}
+
 void *VulkanBuffer::Map()
 {
     if (mappedData)
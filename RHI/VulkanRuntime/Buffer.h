@@ -1,4 +1,6 @@
 #pragma once
+#include <unordered_map>
+
 #include <vulkan/vulkan.h>
 
 #include <RHI/Buffer.h>
@@ -22,19 +24,34 @@ public:
         return bufferAllocationInfo.size;
     }
 
+    // size the VkBuffer was created with, Size() is the allocation and may be larger
+    VkDeviceSize GetCreatedSize()
+    {
+        return bufferCI.size;
+    }
+
+    // view for texel buffer descriptors, created once per format
+    VkBufferView GetBufferView(VkFormat format);
+
     virtual IntrusivePtr<Buffer> Clone() override;
 
 private:
     friend class VulkanRuntime;
+    friend class VulkanAuxiliaryExecutor;
+    friend class VulkanStreamingBuffer;
     IntrusivePtr<Context> context;
 
-    VkBuffer buffer;
-    VmaAllocation bufferAllocation;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    VmaAllocation bufferAllocation = VK_NULL_HANDLE;
     VmaAllocationInfo bufferAllocationInfo;
     void *mappedData = nullptr;
 
-    VkBufferCreateInfo bufferCI;
-    VmaAllocationCreateInfo memoryCI;
+    std::unordered_map<VkFormat, VkBufferView> bufferViews;
+
+    MemoryCategory memoryCategory = MemoryCategory::OTHER;
+
+    VkBufferCreateInfo bufferCI = {};
+    VmaAllocationCreateInfo memoryCI = {};
     
     virtual bool Allocate(Buffer::TypeBits type, MemoryPropertyBits memoryProperties, uint32_t size) override;
     bool Allocate(VkBufferCreateInfo bufferCI, VmaAllocationCreateInfo memoryCI);
@@ -18,6 +18,11 @@ public:
         this->computePassNode = cn->As<ComputeRenderPassGraphNode*>();
     }
 
+    IntrusivePtr<ComputeRenderPassGraphNode> &GetComputePassNode()
+    {
+        return computePassNode;
+    }
+
 private:
     friend class VulkanComputePipeline;
     friend class VulkanGroupExecutor;
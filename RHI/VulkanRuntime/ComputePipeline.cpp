@@ -1,4 +1,9 @@
 #include <RHI/VulkanRuntime/ComputePipeline.h>
+#include <RHI/VulkanRuntime/WorkgroupTuner.h>
+
+#include <stdexcept>
+
+#include <spdlog/spdlog.h>
 
 VulkanComputePipeline::VulkanComputePipeline(IntrusivePtr<Context> context, IntrusivePtr<VulkanComputePass> computePass, std::string pipelineName, std::string groupName, ComputePipelineStates pipelineStates) : VulkanPipeline(context, groupName, pipelineName), computePass(computePass), pipelineStates(pipelineStates)
 {
@@ -6,18 +11,21 @@ VulkanComputePipeline::VulkanComputePipeline(IntrusivePtr<Context> context, Intr
 
 VulkanComputePipeline::~VulkanComputePipeline()
 {
-}
+    context->GetDeletionQueue().Retire([device = context->GetVkDevice(), shaderModules = shaderModules, pipeline = pipeline]()
+                                       {
+                                           for (auto &shaderModule : shaderModules)
+                                           {
+                                               vkDestroyShaderModule(device, shaderModule, nullptr);
+                                           }
 
-IntrusivePtr<VulkanPipelineLayout> &VulkanComputePipeline::GetPipelineLayout()
-{
-    return pipelineLayout;
+                                           vkDestroyPipeline(device, pipeline, nullptr); });
 }
 
 void VulkanComputePipeline::Build()
 {
-    if (pipelineStates.shaderState.Empty())
+    auto crp = computePass->computePassNode;
+    if (pipelineStates.shaderState.computeShaderPath.empty())
     {
-        auto crp = computePass->computePassNode;
         pipelineStates.shaderState.computeShaderPath = crp->computeShader;
     }
     std::vector<VkPipelineShaderStageCreateInfo> shaderStateCI = TranslateShaderState(pipelineStates.shaderState);
@@ -25,10 +33,85 @@ void VulkanComputePipeline::Build()
     IntrusivePtr<SPIVReflection> computeReflection = new SPIVReflection(shaderCode[VK_SHADER_STAGE_COMPUTE_BIT]);
 
     this->pipelineLayout = new VulkanPipelineLayout(context);
-    this->pipelineLayout->Build({computeReflection});
+    std::vector<std::pair<uint32_t, uint32_t>> dynamicBindings;
+    for (auto &[_, bindingSet] : crp->bindingSets)
+    {
+        if (bindingSet.dynamic)
+        {
+            dynamicBindings.push_back({bindingSet.set, bindingSet.binding});
+        }
+    }
+    this->pipelineLayout->Build({computeReflection}, dynamicBindings);
+
+    shaderStage = shaderStateCI.at(0);
+    reflectedLocalGroupSize = computeReflection->GetLocalSize();
+    shaderHash = VulkanWorkgroupTuner::HashShader(shaderCode[VK_SHADER_STAGE_COMPUTE_BIT]);
+
+    // leading ids only, a size needs x to be specialized before y
+    tunableDimensions = 0;
+    while (tunableDimensions < 3 && computeReflection->HasSpecializationConstant(tunableDimensions))
+    {
+        tunableDimensions++;
+    }
+
+    auto &groupSize = pipelineStates.localGroupSize;
+    if (groupSize[0] && groupSize[1] && groupSize[2] && tunableDimensions)
+    {
+        SetLocalGroupSize(groupSize);
+        return;
+    }
+
+    if (groupSize[0] && groupSize[1] && groupSize[2])
+    {
+        spdlog::warn("compute pipeline {}: shader has no local_size_x_id, keeping its declared size", pipelineName);
+    }
+    localGroupSize = reflectedLocalGroupSize;
+    createPipeline(false);
+}
+
+void VulkanComputePipeline::SetLocalGroupSize(std::array<uint32_t, 3> size)
+{
+    auto &limits = context->GetLimits();
+    if (size[0] > limits.maxComputeWorkGroupSize[0] || size[1] > limits.maxComputeWorkGroupSize[1] || size[2] > limits.maxComputeWorkGroupSize[2] ||
+        uint64_t(size[0]) * size[1] * size[2] > limits.maxComputeWorkGroupInvocations)
+    {
+        throw std::runtime_error("compute pipeline " + pipelineName + ": local group size exceeds the device limits");
+    }
+
+    localGroupSize = size;
+    createPipeline(true);
+}
+
+void VulkanComputePipeline::createPipeline(bool specialize)
+{
+    // a recorded command buffer may still use the previous pipeline
+    if (pipeline != VK_NULL_HANDLE)
+    {
+        context->GetDeletionQueue().Retire([device = context->GetVkDevice(), pipeline = pipeline]()
+                                           { vkDestroyPipeline(device, pipeline, nullptr); });
+        pipeline = VK_NULL_HANDLE;
+    }
+
+    // shaders declaring local_size_x_id = 0, local_size_y_id = 1, local_size_z_id = 2 take localGroupSize
+    // ids not used by the shader are ignored
+    std::array<VkSpecializationMapEntry, 3> specializationEntries;
+    VkSpecializationInfo specializationInfo = {};
+    auto stage = shaderStage;
+    if (specialize)
+    {
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            specializationEntries[i] = {i, uint32_t(i * sizeof(uint32_t)), sizeof(uint32_t)};
+        }
+        specializationInfo.mapEntryCount = (uint32_t)specializationEntries.size();
+        specializationInfo.pMapEntries = specializationEntries.data();
+        specializationInfo.dataSize = sizeof(localGroupSize);
+        specializationInfo.pData = localGroupSize.data();
+        stage.pSpecializationInfo = &specializationInfo;
+    }
 
     VkComputePipelineCreateInfo pipelineCreateInfo = {VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO};
-    pipelineCreateInfo.stage = shaderStateCI.at(0);
+    pipelineCreateInfo.stage = stage;
     pipelineCreateInfo.layout = pipelineLayout->GetLayout();
 
     auto result = vkCreateComputePipelines(context->GetVkDevice(),
@@ -36,4 +119,8 @@ void VulkanComputePipeline::Build()
                                            1, &pipelineCreateInfo,
                                            VK_NULL_HANDLE,
                                            &this->pipeline);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create compute pipeline " + pipelineName);
+    }
 }
\ No newline at end of file
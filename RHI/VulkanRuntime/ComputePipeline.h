@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+
 #include <RHI/PipelineStates.h>
 #include <RHI/VulkanRuntime/Pipeline.h>
 
@@ -16,8 +18,6 @@ public:
     virtual ~VulkanComputePipeline() override;
     virtual void Build() override;
 
-    IntrusivePtr<VulkanPipelineLayout> &GetPipelineLayout();
-
     VkPipeline GetPipeline()
     {
         return pipeline;
@@ -28,7 +28,45 @@ public:
         return computePass;
     }
 
+    // localGroupSize of the pipeline states if set, otherwise the size declared in the shader
+    std::array<uint32_t, 3> GetLocalGroupSize()
+    {
+        return localGroupSize;
+    }
+
+    // recreate the pipeline specialized to size, throw if it exceeds the device limits
+    void SetLocalGroupSize(std::array<uint32_t, 3> size);
+
+    std::array<uint32_t, 3> GetReflectedLocalGroupSize()
+    {
+        return reflectedLocalGroupSize;
+    }
+
+    // number of leading local_size_*_id constants declared by the shader, 0 if the size is fixed
+    uint32_t GetTunableDimensions()
+    {
+        return tunableDimensions;
+    }
+
+    uint64_t GetShaderHash()
+    {
+        return shaderHash;
+    }
+
+    const ComputePipelineStates &GetPipelineStates()
+    {
+        return pipelineStates;
+    }
+
 private:
+    std::array<uint32_t, 3> localGroupSize = {1, 1, 1};
+    std::array<uint32_t, 3> reflectedLocalGroupSize = {1, 1, 1};
+    uint32_t tunableDimensions = 0;
+    uint64_t shaderHash = 0;
+
+    VkPipelineShaderStageCreateInfo shaderStage = {};
+    void createPipeline(bool specialize);
+
     std::string subPassName;
 
     ComputePipelineStates pipelineStates;
@@ -2,6 +2,9 @@
 
 Context::~Context()
 {
+    vkDeviceWaitIdle(logicalDevice);
+    deletionQueue.Flush();
+
     vmaDestroyAllocator(vmaAllocator);
     vkDestroyDevice(logicalDevice, nullptr);
     physicalDevice = nullptr;
@@ -13,4 +16,87 @@ Context::~Context()
     }
 
     vkDestroyInstance(instance, nullptr);
-}
\ No newline at end of file
+}
+
+void Context::TrackAllocation(MemoryCategory category, VmaAllocation allocation)
+{
+    if (!allocation)
+    {
+        return;
+    }
+
+    VmaAllocationInfo allocationInfo;
+    vmaGetAllocationInfo(vmaAllocator, allocation, &allocationInfo);
+
+    std::lock_guard<std::mutex> lock(categoryUsageMutex);
+    auto &usage = categoryUsages[size_t(category)];
+    usage.allocationCount++;
+    usage.allocationBytes += allocationInfo.size;
+}
+
+void Context::UntrackAllocation(MemoryCategory category, VmaAllocation allocation)
+{
+    if (!allocation)
+    {
+        return;
+    }
+
+    VmaAllocationInfo allocationInfo;
+    vmaGetAllocationInfo(vmaAllocator, allocation, &allocationInfo);
+
+    std::lock_guard<std::mutex> lock(categoryUsageMutex);
+    auto &usage = categoryUsages[size_t(category)];
+    usage.allocationCount--;
+    usage.allocationBytes -= allocationInfo.size;
+}
+
+MemoryStatistics Context::GetMemoryStatistics()
+{
+    MemoryStatistics statistics = {};
+
+    const VkPhysicalDeviceMemoryProperties *memoryProperties;
+    vmaGetMemoryProperties(vmaAllocator, &memoryProperties);
+
+    std::vector<VmaBudget> budgets(memoryProperties->memoryHeapCount);
+    vmaGetHeapBudgets(vmaAllocator, budgets.data());
+
+    for (uint32_t i = 0; i < memoryProperties->memoryHeapCount; i++)
+    {
+        auto &budget = budgets[i];
+        statistics.heaps.push_back(MemoryStatistics::Heap{
+            .index = i,
+            .deviceLocal = bool(memoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT),
+            .usage = budget.usage,
+            .budget = budget.budget,
+            .blockCount = budget.statistics.blockCount,
+            .blockBytes = budget.statistics.blockBytes,
+            .allocationCount = budget.statistics.allocationCount,
+            .allocationBytes = budget.statistics.allocationBytes});
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(categoryUsageMutex);
+        for (size_t i = 0; i < categoryUsages.size(); i++)
+        {
+            statistics.categories.push_back(MemoryStatistics::Category{
+                .name = MemoryCategoryName(MemoryCategory(i)),
+                .allocationCount = categoryUsages[i].allocationCount,
+                .allocationBytes = categoryUsages[i].allocationBytes});
+        }
+    }
+
+    // walks every block, keep it out of per frame paths
+    VmaTotalStatistics totalStatistics;
+    vmaCalculateStatistics(vmaAllocator, &totalStatistics);
+
+    auto &total = totalStatistics.total;
+    statistics.blockBytes = total.statistics.blockBytes;
+    statistics.allocationBytes = total.statistics.allocationBytes;
+    statistics.unusedRangeCount = total.unusedRangeCount;
+    statistics.unusedRangeSizeMax = total.unusedRangeCount ? total.unusedRangeSizeMax : 0;
+
+    auto freeBytes = statistics.blockBytes - statistics.allocationBytes;
+    statistics.fragmentation = freeBytes ? 1.0f - float(statistics.unusedRangeSizeMax) / float(freeBytes) : 0.0f;
+
+    return statistics;
+}
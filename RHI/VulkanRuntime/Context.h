@@ -1,9 +1,13 @@
 #pragma once
 
+#include <array>
+#include <mutex>
 #include <unordered_map>
 
 #include <RHI/VulkanRuntime/Instance.h>
+#include <RHI/VulkanRuntime/DeletionQueue.h>
 #include <Core/IntrusivePtr.h>
+#include <RHI/MemoryStatistics.h>
 
 #include <vk_mem_alloc.h>
 
@@ -44,21 +48,79 @@ public:
         return queueContextMap[queueType];
     }
 
+    // per category accounting of vma allocations, resources report their own allocations
+    void TrackAllocation(MemoryCategory category, VmaAllocation allocation);
+    void UntrackAllocation(MemoryCategory category, VmaAllocation allocation);
+
+    MemoryStatistics GetMemoryStatistics();
+
+    const VkPhysicalDeviceFeatures &GetEnabledFeatures()
+    {
+        return enabledFeatures;
+    }
+
+    // limits of the physical device, queried once when the device is created
+    const VkPhysicalDeviceLimits &GetLimits()
+    {
+        return limits;
+    }
+
+    // vkCmdDrawIndexedIndirectCount and vkCmdDrawIndirectCount are usable
+    bool IsDrawIndirectCountEnabled()
+    {
+        return drawIndirectCountEnabled;
+    }
+
+    // validation layers found and enabled
+    bool IsValidationEnabled()
+    {
+        return validationEnabled;
+    }
+
+    bool IsDebugUtilsEnabled()
+    {
+        return debugUtilsEnabled;
+    }
+
+    // destroy vulkan objects once the gpu is done with them, deleters must not hold the context
+    VulkanDeletionQueue &GetDeletionQueue()
+    {
+        return deletionQueue;
+    }
+
 private:
     friend class ContextBuilder;
 
     VkInstance instance;
-    VkDebugUtilsMessengerEXT debugMessenger;
+    VkDebugUtilsMessengerEXT debugMessenger = VK_NULL_HANDLE;
+
+    bool validationEnabled = false;
+    bool debugUtilsEnabled = false;
 
     void initInstance();
 
     VkPhysicalDevice physicalDevice;
     VkDevice logicalDevice;
 
+    VkPhysicalDeviceFeatures enabledFeatures = {};
+    VkPhysicalDeviceLimits limits = {};
+    bool drawIndirectCountEnabled = false;
+
     std::unordered_map<VkQueueFlagBits, DeviceQueue> queueContextMap;
 
     VmaAllocator vmaAllocator;
 
+    VulkanDeletionQueue deletionQueue;
+
+    struct CategoryUsage
+    {
+        uint64_t allocationCount;
+        uint64_t allocationBytes;
+    };
+
+    std::mutex categoryUsageMutex;
+    std::array<CategoryUsage, size_t(MemoryCategory::COUNT)> categoryUsages = {};
+
     std::vector<VkExtensionProperties> enabledInstanceExtensions;
     std::vector<VkLayerProperties> enabledInstanceLayers;
 };
\ No newline at end of file
@@ -1,4 +1,5 @@
 
+#include <cstring>
 #include <unordered_set>
 #include <vulkan/vulkan.hpp>
 
@@ -45,7 +46,7 @@ boost::intrusive_ptr<Context> ContextBuilder::Build()
 
 boost::intrusive_ptr<Context> ContextBuilder::DefaultBuild()
 {
-    return SetInstanceExtensions({}).EnableValidationLayer().SetInstanceLayers({"VK_LAYER_KHRONOS_validation"}).SetDeviceExtensions({VK_KHR_SWAPCHAIN_EXTENSION_NAME}).Build();
+    return SetInstanceExtensions({}).EnableValidationLayer().EnableDebugUtils().SetInstanceLayers({"VK_LAYER_KHRONOS_validation"}).SetDeviceExtensions({VK_KHR_SWAPCHAIN_EXTENSION_NAME}).Build();
 }
 
 ContextBuilder &ContextBuilder::SetInstanceExtensions(std::vector<const char *> &&instanceExtensions)
@@ -80,22 +81,40 @@ ContextBuilder &ContextBuilder::SetDeviceLayers(std::vector<const char *> &&laye
 ContextBuilder &ContextBuilder::EnableValidationLayer()
 {
     enableValidationLayers = true;
+    return *this;
+}
+
+ContextBuilder &ContextBuilder::EnableDebugUtils()
+{
+    auto result = std::find_if(availableInstanceExtensions.begin(), availableInstanceExtensions.end(), [](VkExtensionProperties &value)
+                               { return strcmp(value.extensionName, VK_EXT_DEBUG_UTILS_EXTENSION_NAME) == 0; });
+    if (result == availableInstanceExtensions.end())
+    {
+        spdlog::info("extension {} not support", VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
+        return *this;
+    }
+
+    enableDebugUtils = true;
     instanceExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
     return *this;
 }
 
 void ContextBuilder::BuildInstance()
 {
-    // check layer
-    for (auto requiredLayer : instanceLayers)
+    // check layer, drop unsupported ones so instance creation still succeeds (ci boxes, lavapipe)
+    for (auto it = instanceLayers.begin(); it != instanceLayers.end();)
     {
+        auto requiredLayer = *it;
         auto result = std::find_if(availableInstanceLayers.begin(), availableInstanceLayers.end(), [&](VkLayerProperties &value)
                                    { return std::string(requiredLayer) == std::string(value.layerName); });
 
         if (result == availableInstanceLayers.end())
         {
             spdlog::info("layer {} not support", requiredLayer);
+            it = instanceLayers.erase(it);
+            continue;
         }
+        it++;
     }
 
     VkApplicationInfo ai = {};
@@ -131,7 +150,10 @@ void ContextBuilder::BuildInstance()
         exit(-1);
     }
 
-    if (!enableValidationLayers)
+    context->validationEnabled = enableValidationLayers && !instanceLayers.empty();
+    context->debugUtilsEnabled = enableDebugUtils;
+
+    if (!enableDebugUtils)
     {
         return;
     }
@@ -188,7 +210,7 @@ int ContextBuilder::DefaultPhysicalDeviceSelector(std::vector<VkPhysicalDevice>
         spdlog::info("found device {}", deviceProperties.deviceName);
         if (deviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU)
         {
-            return 0;
+            return i;
         }
     }
 
@@ -311,9 +333,51 @@ void ContextBuilder::BuildLogicalDevice()
         dqcis.push_back(dqci);
     }
 
+    // let vma query real heap budgets instead of estimating from its own blocks
+    for (auto &extension : availablePhysicalDeviceExtensions)
+    {
+        if (strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+        {
+            deviceExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+            memoryBudgetEnabled = true;
+        }
+    }
+
+    VkPhysicalDeviceFeatures supportedFeatures;
+    vkGetPhysicalDeviceFeatures(context->physicalDevice, &supportedFeatures);
+
     VkPhysicalDeviceFeatures pdf = {};
+    // optional, invocation counts in frame statistics
+    pdf.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+    // optional, indirect draws with drawCount > 1 are split otherwise
+    pdf.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+    pdf.drawIndirectFirstInstance = supportedFeatures.drawIndirectFirstInstance;
+    // optional, storage buffer writes from fragment shaders
+    pdf.fragmentStoresAndAtomics = supportedFeatures.fragmentStoresAndAtomics;
+
+    // optional, indirect draw counts read from a buffer, all records are issued otherwise
+    VkPhysicalDeviceProperties deviceProperties;
+    vkGetPhysicalDeviceProperties(context->physicalDevice, &deviceProperties);
+    context->limits = deviceProperties.limits;
+
+    VkPhysicalDeviceVulkan12Features vulkan12Features = {};
+    vulkan12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+    if (deviceProperties.apiVersion >= VK_API_VERSION_1_2)
+    {
+        VkPhysicalDeviceVulkan12Features supported12Features = {};
+        supported12Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceFeatures2 features2 = {};
+        features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        features2.pNext = &supported12Features;
+        vkGetPhysicalDeviceFeatures2(context->physicalDevice, &features2);
+        vulkan12Features.drawIndirectCount = supported12Features.drawIndirectCount;
+    }
 
     VkDeviceCreateInfo dci = {};
+    if (deviceProperties.apiVersion >= VK_API_VERSION_1_2)
+    {
+        dci.pNext = &vulkan12Features;
+    }
     dci.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
     dci.queueCreateInfoCount = dqcis.size();
     dci.pQueueCreateInfos = dqcis.data();
@@ -326,6 +390,9 @@ void ContextBuilder::BuildLogicalDevice()
         dci.ppEnabledLayerNames = deviceLayers.data();
     }
 
+    context->enabledFeatures = pdf;
+    context->drawIndirectCountEnabled = vulkan12Features.drawIndirectCount;
+
     if (vkCreateDevice(context->physicalDevice, &dci, nullptr, &context->logicalDevice) != VK_SUCCESS)
     {
         throw std::runtime_error("Failed to create logical device!");
@@ -351,6 +418,10 @@ void ContextBuilder::BuildVMA()
     allocatorCreateInfo.physicalDevice = context->physicalDevice;
     allocatorCreateInfo.device = context->logicalDevice;
     allocatorCreateInfo.instance = context->instance;
+    if (memoryBudgetEnabled)
+    {
+        allocatorCreateInfo.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+    }
 
     vmaCreateAllocator(&allocatorCreateInfo, &context->vmaAllocator);
 }
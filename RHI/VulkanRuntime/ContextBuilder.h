@@ -18,6 +18,8 @@ public:
     ContextBuilder& SetDeviceExtensions(std::vector<const char*>&& extensions);
     ContextBuilder& SetDeviceLayers(std::vector<const char*>&& layers);
     ContextBuilder& EnableValidationLayer();
+    // debug utils messenger, validation messages are only reported with it
+    ContextBuilder& EnableDebugUtils();
     ContextBuilder& BuildDebugUtilsMessenger(PFN_vkDebugUtilsMessengerCallbackEXT callback);
     ContextBuilder& SelectPhysicalDevice(std::function<int(std::vector<VkPhysicalDevice>)> selector);
 
@@ -34,6 +36,8 @@ private:
     std::vector<VkLayerProperties> availablePhysicalDeviceLayers;
 
     bool enableValidationLayers;
+    bool enableDebugUtils = false;
+    bool memoryBudgetEnabled = false;
     PFN_vkDebugUtilsMessengerCallbackEXT debugUtilsMessengerCallback;
 
     // pick discrete GPU by default
@@ -0,0 +1,70 @@
+#include <RHI/VulkanRuntime/DeletionQueue.h>
+
+#include <algorithm>
+#include <vector>
+
+VulkanDeletionQueue::~VulkanDeletionQueue()
+{
+    Flush();
+}
+
+uint64_t VulkanDeletionQueue::Submit()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return ++submittedSerial;
+}
+
+void VulkanDeletionQueue::Complete(uint64_t serial)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (serial <= completedSerial)
+            return;
+        completedSerial = serial;
+    }
+    collect(serial);
+}
+
+void VulkanDeletionQueue::Retire(std::function<void()> deleter)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    // an already recorded command buffer may still be submitted with the next serial
+    entries.push_back({submittedSerial + 1, std::move(deleter)});
+}
+
+void VulkanDeletionQueue::Flush()
+{
+    uint64_t serial;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        // nothing in flight, the next submission cannot see retired objects either
+        completedSerial = ++submittedSerial;
+        serial = completedSerial;
+    }
+    collect(serial);
+}
+
+size_t VulkanDeletionQueue::PendingCount()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return entries.size();
+}
+
+void VulkanDeletionQueue::collect(uint64_t serial)
+{
+    // deleters run outside the lock, they may retire other objects
+    std::vector<std::function<void()>> deleters;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        while (!entries.empty() && entries.front().serial <= serial)
+        {
+            deleters.push_back(std::move(entries.front().deleter));
+            entries.pop_front();
+        }
+    }
+
+    for (auto &deleter : deleters)
+    {
+        deleter();
+    }
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+
+// vulkan objects released while the gpu may still use them
+// an object is retired with the serial of the next queue submission
+// and destroyed once every submission up to that serial has completed
+class VulkanDeletionQueue
+{
+public:
+    ~VulkanDeletionQueue();
+
+    // serial of a new queue submission, call right before vkQueueSubmit
+    uint64_t Submit();
+
+    // fence of submission serial signaled, destroy what it retired
+    // executors share the graphics queue, so earlier submissions are complete as well
+    void Complete(uint64_t serial);
+
+    void Retire(std::function<void()> deleter);
+
+    // device is idle, destroy everything
+    void Flush();
+
+    size_t PendingCount();
+
+private:
+    struct Entry
+    {
+        uint64_t serial;
+        std::function<void()> deleter;
+    };
+
+    std::mutex mutex;
+
+    // ordered by serial
+    std::deque<Entry> entries;
+
+    uint64_t submittedSerial = 0;
+    uint64_t completedSerial = 0;
+
+    void collect(uint64_t serial);
+};
@@ -1,6 +1,8 @@
 #include <RHI/VulkanRuntime/DescriptorSet.h>
 
+#include <map>
 #include <stdexcept>
+#include <string>
 
 #include <RHI/VulkanRuntime/PipelineLayout.h>
 
@@ -9,6 +11,11 @@
 #include <RHI/VulkanRuntime/Sampler.h>
 #include <RHI/ConstantBuffer.h>
 #include <RHI/MutableBuffer.h>
+#include <RHI/DynamicBuffer.h>
+
+#include <Core/Trace.h>
+
+#include <spdlog/spdlog.h>
 
 VulkanDescriptorSet::VulkanDescriptorSet(IntrusivePtr<Context> context, IntrusivePtr<Pipeline> pipeline) : context(context), pipeline(pipeline)
 {
@@ -18,14 +25,16 @@ VulkanDescriptorSet::VulkanDescriptorSet(IntrusivePtr<Context> context, Intrusiv
 
 VulkanDescriptorSet::~VulkanDescriptorSet()
 {
-    vkDestroyDescriptorPool(context->GetVkDevice(), descriptorPool, nullptr);
+    // descriptor sets of the pool may be bound by in flight frames
+    context->GetDeletionQueue().Retire([device = context->GetVkDevice(), descriptorPool = descriptorPool]()
+                                       { vkDestroyDescriptorPool(device, descriptorPool, nullptr); });
     frameDescriptor.clear();
     constantBuffer.reset();
 }
 
 void VulkanDescriptorSet::AllocateExtraDescriptorSets(uint32_t frameIndex)
 {
-    auto vulkanPipeline = static_cast<VulkanGraphicsPipeline *>(pipeline.get());
+    auto vulkanPipeline = static_cast<VulkanPipeline *>(pipeline.get());
     auto layouts = vulkanPipeline->GetPipelineLayout()->GetSetsLayouts();
 
     VkDescriptorSetAllocateInfo descriptorSetAllocateInfo = {};
@@ -81,7 +90,7 @@ void VulkanDescriptorSet::ClearInternal()
 
 void VulkanDescriptorSet::AllocateDescriptorPool(IntrusivePtr<Pipeline> &pipeline)
 {
-    auto vulkanPipeline = static_cast<VulkanGraphicsPipeline *>(pipeline.get());
+    auto vulkanPipeline = static_cast<VulkanPipeline *>(pipeline.get());
     auto &bindingsInSets = vulkanPipeline->GetPipelineLayout()->GetBindingsInSets();
 
     std::vector<VkDescriptorPoolSize> poolSizes;
@@ -118,6 +127,7 @@ static void WriteDescriptorValidate(std::vector<IntrusivePtr<ResourceHandle>> &r
     bool bufferArrayType = false;
     bool textureType = false;
     bool samplerType = false;
+    bool dynamicBufferType = false;
     for (auto resource : resources)
     {
         if (boost::dynamic_pointer_cast<VulkanBuffer>(resource))
@@ -136,6 +146,10 @@ static void WriteDescriptorValidate(std::vector<IntrusivePtr<ResourceHandle>> &r
         {
             samplerType = true;
         }
+        if (boost::dynamic_pointer_cast<DynamicBuffer>(resource))
+        {
+            dynamicBufferType = true;
+        }
     }
 
     uint8_t typeCounter = 0;
@@ -148,6 +162,8 @@ static void WriteDescriptorValidate(std::vector<IntrusivePtr<ResourceHandle>> &r
         typeCounter += 1;
     if (samplerType)
         typeCounter += 1;
+    if (dynamicBufferType)
+        typeCounter += 1;
 
     assert(typeCounter == 1);
 #endif
@@ -161,6 +177,8 @@ void VulkanDescriptorSet::WriteDescriptor(uint32_t frameIndex, uint32_t set, uin
 
 void VulkanDescriptorSet::WriteDescriptor(uint32_t frameIndex, uint32_t set, uint32_t binding, std::vector<IntrusivePtr<ResourceHandle>> &resources)
 {
+    TRACE_SCOPE("VulkanDescriptorSet::WriteDescriptor");
+
     WriteDescriptorValidate(resources);
 
     if (frameDescriptor[frameIndex].descriptorSets.empty())
@@ -168,48 +186,106 @@ void VulkanDescriptorSet::WriteDescriptor(uint32_t frameIndex, uint32_t set, uin
         AllocateExtraDescriptorSets(frameIndex);
     }
 
-    switch (resources[0]->type)
+    if (resources[0]->type == ResourceHandle::DYNAMIC_BUFFER)
     {
-    case ResourceHandle::BUFFER_ARRAY:
-    case ResourceHandle::BUFFER:
+        // written in ResolveDynamicBuffers when command buffer is recorded
+        frameDescriptor[frameIndex].dynamicBufferSlices[set].erase(binding);
+        return;
+    }
+
+    // the shader decides how the resource is accessed
+    auto vulkanPipeline = static_cast<VulkanPipeline *>(pipeline.get());
+    auto descriptorType = vulkanPipeline->GetPipelineLayout()->GetDescriptorType(set, binding);
+
+    switch (descriptorType)
+    {
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+    case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+    case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
     {
-        WriteDescriptorBuffer(frameIndex, set, binding, resources);
+        WriteDescriptorBuffer(frameIndex, set, binding, resources, descriptorType);
         break;
     }
-    case ResourceHandle::TEXTURE:
+    case VK_DESCRIPTOR_TYPE_UNIFORM_TEXEL_BUFFER:
+    case VK_DESCRIPTOR_TYPE_STORAGE_TEXEL_BUFFER:
     {
-        throw std::runtime_error("no impl");
+        WriteDescriptorTexelBuffer(frameIndex, set, binding, resources, descriptorType);
+        break;
     }
-    case ResourceHandle::SAMPLER:
+    case VK_DESCRIPTOR_TYPE_SAMPLER:
+    case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+    case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+    case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+    case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+    {
+        WriteDescriptorImage(frameIndex, set, binding, resources, descriptorType);
+        break;
+    }
+    case VK_DESCRIPTOR_TYPE_MAX_ENUM:
     {
-        WriteDescriptorSampler(frameIndex, set, binding, resources);
+        spdlog::warn("set {} binding {} is not used by pipeline {}", set, binding, pipeline->GetPipelineName());
         break;
     }
+    default:
+        throw std::runtime_error("unsupported descriptor type " + std::to_string(uint32_t(descriptorType)));
     }
 }
 
-void VulkanDescriptorSet::WriteDescriptorBuffer(uint32_t frameIndex, uint32_t set, uint32_t binding, std::vector<IntrusivePtr<ResourceHandle>> &resources)
+static VulkanBuffer *ResolveBuffer(IntrusivePtr<ResourceHandle> &resource, uint32_t frameIndex)
 {
-    std::vector<VkWriteDescriptorSet> writeDescriptorSets;
+    switch (resource->type)
+    {
+    case ResourceHandle::BUFFER_ARRAY:
+    {
+        auto bufferArray = static_cast<MutableBuffer *>(resource.get());
+        return static_cast<VulkanBuffer *>(bufferArray->GetBuffer(frameIndex).get());
+    }
+    case ResourceHandle::BUFFER:
+        return static_cast<VulkanBuffer *>(resource.get());
+    default:
+        throw std::runtime_error("buffer descriptor requires a buffer resource");
+    }
+}
+
+// samplers expose the texture they sample
+static VulkanTexture *ResolveTexture(IntrusivePtr<ResourceHandle> &resource)
+{
+    switch (resource->type)
+    {
+    case ResourceHandle::TEXTURE:
+        return static_cast<VulkanTexture *>(resource.get());
+    case ResourceHandle::SAMPLER:
+        return static_cast<VulkanSampler *>(resource.get())->GetTexture().get();
+    default:
+        throw std::runtime_error("image descriptor requires a texture or sampler resource");
+    }
+}
+
+// layout the texture is left in by the auxiliary executor and render passes
+static VkImageLayout ShaderAccessLayout(VulkanTexture *texture, VkDescriptorType descriptorType)
+{
+    if (descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+        return VK_IMAGE_LAYOUT_GENERAL;
+    if (texture->GetUsage() & (VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_STORAGE_BIT))
+        return VK_IMAGE_LAYOUT_GENERAL;
+    return VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+static VkImageView ShaderView(VulkanTexture *texture)
+{
+    auto aspectMask = texture->GetTextureFormat() == TextureFormat::FORMAT_D16_UNORM ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT;
+    return texture->GetShaderView(texture->GetFormat(), aspectMask);
+}
 
+void VulkanDescriptorSet::WriteDescriptorBuffer(uint32_t frameIndex, uint32_t set, uint32_t binding, std::vector<IntrusivePtr<ResourceHandle>> &resources, VkDescriptorType descriptorType)
+{
     std::vector<VkDescriptorBufferInfo> bufferInfos(resources.size());
 
     for (int i = 0; i < resources.size(); i++)
     {
-        VulkanBuffer *buffer = nullptr;
-        if (resources[i]->type == ResourceHandle::BUFFER_ARRAY)
-        {
-            auto bufferArray = dynamic_cast<MutableBuffer *>(resources[i].get());
-            buffer = static_cast<VulkanBuffer *>(bufferArray->GetBuffer(frameIndex).get());
-        }
-        else
-        {
-            // if resource is BUFFER
-            buffer = static_cast<VulkanBuffer *>(resources[i].get());
-        }
-
         VkDescriptorBufferInfo bufferInfo = {
-            .buffer = buffer->GetBuffer(),
+            .buffer = ResolveBuffer(resources[i], frameIndex)->GetBuffer(),
             .offset = 0,
             .range = VK_WHOLE_SIZE};
         bufferInfos[i] = bufferInfo;
@@ -218,61 +294,79 @@ void VulkanDescriptorSet::WriteDescriptorBuffer(uint32_t frameIndex, uint32_t se
     VkWriteDescriptorSet writeDescriptorSet = {};
     writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     writeDescriptorSet.dstSet = frameDescriptor[frameIndex].descriptorSets[set];
-    writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+    writeDescriptorSet.descriptorType = descriptorType;
     writeDescriptorSet.dstBinding = binding;
     writeDescriptorSet.pBufferInfo = bufferInfos.data();
     writeDescriptorSet.descriptorCount = (uint32_t)bufferInfos.size();
 
-    writeDescriptorSets.push_back(writeDescriptorSet);
-
-    vkUpdateDescriptorSets(context->GetVkDevice(), (uint32_t)writeDescriptorSets.size(), writeDescriptorSets.data(), 0, nullptr);
+    vkUpdateDescriptorSets(context->GetVkDevice(), 1, &writeDescriptorSet, 0, nullptr);
 }
 
-void VulkanDescriptorSet::WriteDescriptorSampler(uint32_t frameIndex, uint32_t set, uint32_t binding, std::vector<IntrusivePtr<ResourceHandle>> &resources)
+void VulkanDescriptorSet::WriteDescriptorTexelBuffer(uint32_t frameIndex, uint32_t set, uint32_t binding, std::vector<IntrusivePtr<ResourceHandle>> &resources, VkDescriptorType descriptorType)
 {
-    std::vector<VkWriteDescriptorSet> writeDescriptorSets;
+    auto vulkanPipeline = static_cast<VulkanPipeline *>(pipeline.get());
+    auto format = vulkanPipeline->GetPipelineLayout()->GetImageFormat(set, binding);
+    // uniform texel buffers (samplerBuffer) declare no format, read them as vec4
+    if (format == VK_FORMAT_UNDEFINED)
+    {
+        format = VK_FORMAT_R32G32B32A32_SFLOAT;
+    }
 
-    std::vector<VkDescriptorImageInfo> samplerInfos(resources.size());
+    std::vector<VkBufferView> bufferViews(resources.size());
 
     for (int i = 0; i < resources.size(); i++)
     {
-        auto sampler = dynamic_cast<VulkanSampler *>(resources[i].get());
-        auto texture = sampler->GetTexture();
-        // TODO
-        // UpdateRequest ur{
-        //     texture, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT};
-        // this->updateRequests.push_back(ur);
-        VkImageViewCreateInfo ci = {};
-        ci.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-        ci.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        ci.format = texture->GetFormat();
-        ci.subresourceRange = {};
-        ci.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        ci.subresourceRange.baseMipLevel = 0;
-        ci.subresourceRange.levelCount = texture->LevelCount();
-        ci.subresourceRange.baseArrayLayer = 0;
-        ci.subresourceRange.layerCount = texture->LayerCount();
-        ci.image = texture->GetImage();
-        auto textureView = texture->CreateTextureView(ci);
-        sampler->StoreTextureView(textureView);
-        VkDescriptorImageInfo samplerInfo = {
-            .sampler = sampler->GetSampler(),
-            .imageView = textureView->GetImageView(),
-            .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL};
-        samplerInfos[i] = samplerInfo;
+        bufferViews[i] = ResolveBuffer(resources[i], frameIndex)->GetBufferView(format);
     }
 
     VkWriteDescriptorSet writeDescriptorSet = {};
     writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
     writeDescriptorSet.dstSet = frameDescriptor[frameIndex].descriptorSets[set];
-    writeDescriptorSet.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    writeDescriptorSet.descriptorType = descriptorType;
     writeDescriptorSet.dstBinding = binding;
-    writeDescriptorSet.pImageInfo = samplerInfos.data();
-    writeDescriptorSet.descriptorCount = (uint32_t)samplerInfos.size();
+    writeDescriptorSet.pTexelBufferView = bufferViews.data();
+    writeDescriptorSet.descriptorCount = (uint32_t)bufferViews.size();
+
+    vkUpdateDescriptorSets(context->GetVkDevice(), 1, &writeDescriptorSet, 0, nullptr);
+}
 
-    writeDescriptorSets.push_back(writeDescriptorSet);
+void VulkanDescriptorSet::WriteDescriptorImage(uint32_t frameIndex, uint32_t set, uint32_t binding, std::vector<IntrusivePtr<ResourceHandle>> &resources, VkDescriptorType descriptorType)
+{
+    std::vector<VkDescriptorImageInfo> imageInfos(resources.size());
+
+    for (int i = 0; i < resources.size(); i++)
+    {
+        VkDescriptorImageInfo imageInfo = {};
 
-    vkUpdateDescriptorSets(context->GetVkDevice(), (uint32_t)writeDescriptorSets.size(), writeDescriptorSets.data(), 0, nullptr);
+        if (descriptorType == VK_DESCRIPTOR_TYPE_SAMPLER || descriptorType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+        {
+            if (resources[i]->type != ResourceHandle::SAMPLER)
+            {
+                throw std::runtime_error("sampler descriptor requires a sampler resource");
+            }
+            imageInfo.sampler = static_cast<VulkanSampler *>(resources[i].get())->GetSampler();
+        }
+
+        if (descriptorType != VK_DESCRIPTOR_TYPE_SAMPLER)
+        {
+            // views are cached by the texture, the bound resource keeps it alive
+            auto texture = ResolveTexture(resources[i]);
+            imageInfo.imageView = ShaderView(texture);
+            imageInfo.imageLayout = ShaderAccessLayout(texture, descriptorType);
+        }
+
+        imageInfos[i] = imageInfo;
+    }
+
+    VkWriteDescriptorSet writeDescriptorSet = {};
+    writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+    writeDescriptorSet.dstSet = frameDescriptor[frameIndex].descriptorSets[set];
+    writeDescriptorSet.descriptorType = descriptorType;
+    writeDescriptorSet.dstBinding = binding;
+    writeDescriptorSet.pImageInfo = imageInfos.data();
+    writeDescriptorSet.descriptorCount = (uint32_t)imageInfos.size();
+
+    vkUpdateDescriptorSets(context->GetVkDevice(), 1, &writeDescriptorSet, 0, nullptr);
 }
 
 void VulkanDescriptorSet::Copy(uint32_t targetFrameIndex, uint32_t set, uint32_t binding)
@@ -282,7 +376,9 @@ void VulkanDescriptorSet::Copy(uint32_t targetFrameIndex, uint32_t set, uint32_t
     switch (originalResource->type)
     {
     case ResourceHandle::ResourceHandleType::SAMPLER:
+    case ResourceHandle::ResourceHandleType::TEXTURE:
     case ResourceHandle::ResourceHandleType::BUFFER:
+    case ResourceHandle::ResourceHandleType::DYNAMIC_BUFFER:
     {
         this->Bind(targetFrameIndex, set, binding, originalResource, originalResourceMeta.internal);
         break;
@@ -298,3 +394,80 @@ void VulkanDescriptorSet::Copy(uint32_t targetFrameIndex, uint32_t set, uint32_t
         break;
     }
 }
+
+std::vector<uint32_t> VulkanDescriptorSet::ResolveDynamicBuffers(uint32_t frameIndex, VulkanUniformAllocator *allocator)
+{
+    TRACE_SCOPE("VulkanDescriptorSet::ResolveDynamicBuffers");
+
+    std::vector<uint32_t> dynamicOffsets;
+
+    auto vulkanPipeline = static_cast<VulkanPipeline *>(pipeline.get());
+    auto &bindingsInSets = vulkanPipeline->GetPipelineLayout()->GetBindingsInSets();
+    auto &fd = frameDescriptor[frameIndex];
+
+    for (uint32_t set = 0; set < fd.descriptorSets.size(); set++)
+    {
+        // sorted by binding, same binding may be reflected from several stages
+        std::map<uint32_t, VkDescriptorSetLayoutBinding> layoutBindings;
+        for (auto &layoutBinding : bindingsInSets[set])
+        {
+            layoutBindings[layoutBinding.binding] = layoutBinding;
+        }
+
+        for (auto &[binding, layoutBinding] : layoutBindings)
+        {
+            bool dynamic = layoutBinding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC ||
+                           layoutBinding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+
+            std::vector<IntrusivePtr<ResourceHandle>> *resources = nullptr;
+            if (fd.resourceHandlesMaps.count(set) && fd.resourceHandlesMaps[set].count(binding))
+            {
+                resources = &fd.resourceHandlesMaps[set][binding].resourceHandles;
+            }
+
+            // static buffer bound to a dynamic binding
+            if (!resources || resources->empty() || (*resources)[0]->type != ResourceHandle::DYNAMIC_BUFFER)
+            {
+                if (dynamic)
+                    dynamicOffsets.insert(dynamicOffsets.end(), layoutBinding.descriptorCount, 0);
+                continue;
+            }
+
+            std::vector<VkDescriptorBufferInfo> bufferInfos;
+            std::vector<WrittenSlice> slices;
+            for (auto &resource : *resources)
+            {
+                auto dynamicBuffer = static_cast<DynamicBuffer *>(resource.get());
+                auto allocation = allocator->Allocate(frameIndex, dynamicBuffer->Size());
+                memcpy(allocation.data, dynamicBuffer->Map(), dynamicBuffer->Size());
+
+                bufferInfos.push_back(VkDescriptorBufferInfo{
+                    .buffer = allocation.buffer,
+                    .offset = dynamic ? 0 : allocation.offset,
+                    .range = dynamicBuffer->Size()});
+                slices.push_back({allocation.generation, bufferInfos.back().offset, bufferInfos.back().range});
+
+                if (dynamic)
+                    dynamicOffsets.push_back(allocation.offset);
+            }
+
+            // dynamic descriptors only change when the allocator page changes
+            auto &writtenSlices = fd.dynamicBufferSlices[set][binding];
+            if (writtenSlices != slices)
+            {
+                VkWriteDescriptorSet writeDescriptorSet = {};
+                writeDescriptorSet.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                writeDescriptorSet.dstSet = fd.descriptorSets[set];
+                writeDescriptorSet.descriptorType = layoutBinding.descriptorType;
+                writeDescriptorSet.dstBinding = binding;
+                writeDescriptorSet.pBufferInfo = bufferInfos.data();
+                writeDescriptorSet.descriptorCount = (uint32_t)bufferInfos.size();
+
+                vkUpdateDescriptorSets(context->GetVkDevice(), 1, &writeDescriptorSet, 0, nullptr);
+                writtenSlices = std::move(slices);
+            }
+        }
+    }
+
+    return dynamicOffsets;
+}
@@ -6,6 +6,7 @@
 
 #include <RHI/VulkanRuntime/Context.h>
 #include <RHI/VulkanRuntime/GraphicsPipeline.h>
+#include <RHI/VulkanRuntime/UniformAllocator.h>
 
 #include <vulkan/vulkan.h>
 
@@ -27,8 +28,10 @@ public:
     void WriteDescriptor(uint32_t frameIndex, uint32_t set, uint32_t binding, IntrusivePtr<ResourceHandle> &resource);
     void WriteDescriptor(uint32_t frameIndex, uint32_t set, uint32_t binding, std::vector<IntrusivePtr<ResourceHandle>> &resources);
 
-    void WriteDescriptorBuffer(uint32_t frameIndex, uint32_t set, uint32_t binding, std::vector<IntrusivePtr<ResourceHandle>> &resources);
-    void WriteDescriptorSampler(uint32_t frameIndex, uint32_t set, uint32_t binding, std::vector<IntrusivePtr<ResourceHandle>> &resources);
+    // descriptorType is the reflected type of set/binding
+    void WriteDescriptorBuffer(uint32_t frameIndex, uint32_t set, uint32_t binding, std::vector<IntrusivePtr<ResourceHandle>> &resources, VkDescriptorType descriptorType);
+    void WriteDescriptorTexelBuffer(uint32_t frameIndex, uint32_t set, uint32_t binding, std::vector<IntrusivePtr<ResourceHandle>> &resources, VkDescriptorType descriptorType);
+    void WriteDescriptorImage(uint32_t frameIndex, uint32_t set, uint32_t binding, std::vector<IntrusivePtr<ResourceHandle>> &resources, VkDescriptorType descriptorType);
 
     // bind internal resources
     void Bind(uint32_t frameIndex, uint32_t set, uint32_t binding, IntrusivePtr<ResourceHandle> resource, bool internal);
@@ -39,6 +42,10 @@ public:
     // clear all internal resource in resourceMap
     void ClearInternal();
 
+    // copy DynamicBuffer data of frameIndex into allocator slices and point descriptors at them
+    // return dynamic offsets ordered by set and binding, as vkCmdBindDescriptorSets expects
+    std::vector<uint32_t> ResolveDynamicBuffers(uint32_t frameIndex, VulkanUniformAllocator *allocator);
+
     IntrusivePtr<Context> context;
     IntrusivePtr<Pipeline> pipeline;
 
@@ -57,12 +64,24 @@ public:
     // sets -> bindings -> resource handles
     using ResourceHandleMap = std::unordered_map<uint32_t, std::unordered_map<uint32_t, ResourceHandleMeta>>;
 
+    // uniform allocator slice a dynamic buffer descriptor points at, by page generation and not by the reusable VkBuffer
+    struct WrittenSlice
+    {
+        uint64_t generation;
+        VkDeviceSize offset;
+        VkDeviceSize range;
+
+        bool operator==(const WrittenSlice &other) const = default;
+    };
+
     struct FrameDescriptor
     {
         // different set of descriptors may be bind
         std::vector<VkDescriptorSet> descriptorSets;
         // hold resource's ref
         ResourceHandleMap resourceHandlesMaps;
+        // sets -> bindings -> last written DynamicBuffer slices
+        std::unordered_map<uint32_t, std::unordered_map<uint32_t, std::vector<WrittenSlice>>> dynamicBufferSlices;
     };
 
     ResourceHandleMap &GetResourceHandlesMap(uint32_t frameIndex)
@@ -0,0 +1,212 @@
+#include <RHI/VulkanRuntime/GPUProfiler.h>
+
+#include <Core/Trace.h>
+
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+VulkanGPUProfiler::VulkanGPUProfiler(IntrusivePtr<Context> context) : context(context)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(context->GetVkPhysicalDevice(), &properties);
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(context->GetVkPhysicalDevice(), &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(context->GetVkPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+    auto validBits = queueFamilies[context->GetQueue(VK_QUEUE_GRAPHICS_BIT).familyIndex].timestampValidBits;
+
+    // software implementations may report a zero period, timings are meaningless then
+    if (validBits && properties.limits.timestampPeriod > 0.0f)
+    {
+        timestampPeriod = properties.limits.timestampPeriod;
+        timestampMask = validBits >= 64 ? UINT64_MAX : (uint64_t(1) << validBits) - 1;
+    }
+}
+
+VulkanGPUProfiler::~VulkanGPUProfiler()
+{
+    Release();
+}
+
+bool VulkanGPUProfiler::Supported()
+{
+    return timestampPeriod > 0.0f;
+}
+
+void VulkanGPUProfiler::Prepare(uint32_t imageCount)
+{
+    Release();
+
+    if (!Supported())
+    {
+        return;
+    }
+
+    frames.resize(imageCount);
+    for (auto &frame : frames)
+    {
+        VkQueryPoolCreateInfo queryPoolCI = {};
+        queryPoolCI.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolCI.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolCI.queryCount = MAX_SCOPES * 2;
+        if (vkCreateQueryPool(context->GetVkDevice(), &queryPoolCI, nullptr, &frame.queryPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create timestamp query pool!");
+        }
+    }
+}
+
+void VulkanGPUProfiler::Release()
+{
+    for (auto &frame : frames)
+    {
+        vkDestroyQueryPool(context->GetVkDevice(), frame.queryPool, nullptr);
+    }
+    frames.clear();
+}
+
+void VulkanGPUProfiler::BeginFrame(uint32_t imageIndex)
+{
+    if (imageIndex >= frames.size())
+    {
+        return;
+    }
+
+    auto &frame = frames[imageIndex];
+    resolve(frame);
+    frame.scopes.clear();
+}
+
+void VulkanGPUProfiler::RecordReset(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+    if (imageIndex >= frames.size())
+    {
+        return;
+    }
+
+    vkCmdResetQueryPool(commandBuffer, frames[imageIndex].queryPool, 0, MAX_SCOPES * 2);
+}
+
+uint32_t VulkanGPUProfiler::BeginScope(VkCommandBuffer commandBuffer, uint32_t imageIndex, std::string groupName, std::string name)
+{
+    if (!IsEnabled() || imageIndex >= frames.size())
+    {
+        return INVALID_SCOPE;
+    }
+
+    auto &frame = frames[imageIndex];
+    if (frame.scopes.size() >= MAX_SCOPES)
+    {
+        return INVALID_SCOPE;
+    }
+
+    uint32_t scope = frame.scopes.size();
+    frame.scopes.push_back(Scope{
+        .groupName = groupName,
+        .name = name});
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.queryPool, scope * 2);
+    return scope;
+}
+
+void VulkanGPUProfiler::EndScope(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t scope)
+{
+    if (scope == INVALID_SCOPE)
+    {
+        return;
+    }
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frames[imageIndex].queryPool, scope * 2 + 1);
+}
+
+void VulkanGPUProfiler::MarkSubmit(uint32_t imageIndex)
+{
+    if (imageIndex >= frames.size())
+    {
+        return;
+    }
+
+    frames[imageIndex].submitTime = Trace::Now();
+}
+
+void VulkanGPUProfiler::resolve(FrameQueries &frame)
+{
+    if (frame.scopes.empty())
+    {
+        return;
+    }
+
+    // no wait flag, results that are not available yet are dropped rather than stalling the cpu
+    std::vector<uint64_t> timestamps(frame.scopes.size() * 2);
+    auto result = vkGetQueryPoolResults(context->GetVkDevice(), frame.queryPool, 0, timestamps.size(),
+                                        timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+    if (result != VK_SUCCESS)
+    {
+        return;
+    }
+
+    auto toMilliseconds = [this](uint64_t begin, uint64_t end)
+    {
+        return double((end - begin) & timestampMask) * timestampPeriod / 1000000.0;
+    };
+
+    struct Span
+    {
+        uint64_t begin;
+        uint64_t end;
+    };
+
+    // groups span from their first subpass begin to their last subpass end
+    std::vector<std::string> groupNames;
+    std::unordered_map<std::string, Span> groupSpans;
+    std::unordered_map<std::string, std::vector<uint32_t>> groupScopes;
+    Span frameSpan = {UINT64_MAX, 0};
+
+    for (uint32_t i = 0; i < frame.scopes.size(); i++)
+    {
+        auto &scope = frame.scopes[i];
+        auto begin = timestamps[i * 2] & timestampMask;
+        auto end = timestamps[i * 2 + 1] & timestampMask;
+
+        if (!groupSpans.count(scope.groupName))
+        {
+            groupNames.push_back(scope.groupName);
+            groupSpans[scope.groupName] = {begin, end};
+        }
+
+        auto &span = groupSpans[scope.groupName];
+        span.begin = std::min(span.begin, begin);
+        span.end = std::max(span.end, end);
+        groupScopes[scope.groupName].push_back(i);
+
+        frameSpan.begin = std::min(frameSpan.begin, begin);
+        frameSpan.end = std::max(frameSpan.end, end);
+    }
+
+    addSample("frame", toMilliseconds(frameSpan.begin, frameSpan.end));
+
+    // gpu and cpu clocks are not calibrated, the first gpu timestamp is placed at the submit time
+    if (Trace::IsEnabled() && frame.submitTime)
+    {
+        auto toTraceTime = [&](uint64_t timestamp)
+        {
+            return frame.submitTime + uint64_t(double((timestamp - frameSpan.begin) & timestampMask) * timestampPeriod);
+        };
+
+        for (uint32_t i = 0; i < frame.scopes.size(); i++)
+        {
+            Trace::AddGPUZone(frame.scopes[i].name, toTraceTime(timestamps[i * 2] & timestampMask), toTraceTime(timestamps[i * 2 + 1] & timestampMask));
+        }
+    }
+    for (auto &groupName : groupNames)
+    {
+        addSample(groupName, toMilliseconds(groupSpans[groupName].begin, groupSpans[groupName].end));
+        for (auto i : groupScopes[groupName])
+        {
+            addSample(frame.scopes[i].name, toMilliseconds(timestamps[i * 2] & timestampMask, timestamps[i * 2 + 1] & timestampMask));
+        }
+    }
+}
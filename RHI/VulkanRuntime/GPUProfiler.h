@@ -0,0 +1,69 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include <RHI/GPUProfiler.h>
+#include <RHI/VulkanRuntime/Context.h>
+
+// timestamp queries around subpasses, one query pool per swapchain image
+// the whole pool is reset at the start of the frame submission, scopes are
+// written while render groups record and read back when the image comes around again
+class VulkanGPUProfiler : public GPUProfiler
+{
+public:
+    VulkanGPUProfiler(IntrusivePtr<Context> context);
+    virtual ~VulkanGPUProfiler() override;
+
+    virtual bool Supported() override;
+
+    // (re)create query pools, one per image
+    void Prepare(uint32_t imageCount);
+    void Release();
+
+    // resolve the previous results of imageIndex and start collecting new scopes
+    void BeginFrame(uint32_t imageIndex);
+
+    // recorded before any scope of the frame, outside of render passes
+    void RecordReset(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
+    static constexpr uint32_t INVALID_SCOPE = UINT32_MAX;
+
+    // return INVALID_SCOPE if disabled or the pool is full
+    uint32_t BeginScope(VkCommandBuffer commandBuffer, uint32_t imageIndex, std::string groupName, std::string name);
+    void EndScope(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t scope);
+
+    // cpu time of the submission, anchors gpu zones on the trace timeline
+    void MarkSubmit(uint32_t imageIndex);
+
+private:
+    IntrusivePtr<Context> context;
+
+    // nanoseconds per tick, 0 if timestamps are unsupported
+    float timestampPeriod = 0.0f;
+    uint64_t timestampMask = 0;
+
+    static constexpr uint32_t MAX_SCOPES = 256;
+
+    struct Scope
+    {
+        std::string groupName;
+        std::string name;
+    };
+
+    struct FrameQueries
+    {
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+
+        // scope i owns queries 2i (begin) and 2i + 1 (end)
+        std::vector<Scope> scopes;
+
+        uint64_t submitTime = 0;
+    };
+
+    std::vector<FrameQueries> frames;
+
+    void resolve(FrameQueries &frame);
+};
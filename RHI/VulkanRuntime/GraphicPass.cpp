@@ -13,7 +13,8 @@ VulkanGraphicPass::VulkanGraphicPass(IntrusivePtr<Context> context, IntrusivePtr
 
 VulkanGraphicPass::~VulkanGraphicPass()
 {
-    vkDestroyRenderPass(context->GetVkDevice(), renderPass, nullptr);
+    context->GetDeletionQueue().Retire([device = context->GetVkDevice(), renderPass = renderPass]()
+                                       { vkDestroyRenderPass(device, renderPass, nullptr); });
 }
 
 VkRenderPass VulkanGraphicPass::GetRenderPass()
@@ -161,7 +162,8 @@ void VulkanGraphicPass::Build(std::vector<std::string> subPasses)
                     attachmentRefIndex = attachmentCounter++;
                     subPassAttachmentNodes.push_back(agn);
                 }
-                referencesGroup.inputRefs.push_back({(uint32_t)attachmentRefIndex, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL});
+                // attachments are sampled in the layout they are kept in
+                referencesGroup.inputRefs.push_back({(uint32_t)attachmentRefIndex, VK_IMAGE_LAYOUT_GENERAL});
             }
         }
 
@@ -307,9 +309,10 @@ void VulkanGraphicPass::Build(std::vector<std::string> subPasses)
                 VkSubpassDependency dependency{};
                 dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
                 dependency.dstSubpass = 0;
-                dependency.srcStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+                // written by an earlier render pass
+                dependency.srcStageMask = attachmentNode->depthStencil ? VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT : VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
                 dependency.dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
-                dependency.srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT;
+                dependency.srcAccessMask = attachmentNode->depthStencil ? VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT : VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
                 dependency.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
                 dependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
                 dependencies.push_back(dependency);
@@ -236,18 +236,14 @@ VulkanGraphicsPipeline::VulkanGraphicsPipeline(IntrusivePtr<Context> context, In
 
 VulkanGraphicsPipeline::~VulkanGraphicsPipeline()
 {
-    auto device = context->GetVkDevice();
-    for (auto &shaderModule : shaderModules)
-    {
-        vkDestroyShaderModule(device, shaderModule, nullptr);
-    }
-
-    vkDestroyPipeline(device, pipeline, nullptr);
-}
-
-IntrusivePtr<VulkanPipelineLayout> &VulkanGraphicsPipeline::GetPipelineLayout()
-{
-    return pipelineLayout;
+    context->GetDeletionQueue().Retire([device = context->GetVkDevice(), shaderModules = shaderModules, pipeline = pipeline]()
+                                       {
+                                           for (auto &shaderModule : shaderModules)
+                                           {
+                                               vkDestroyShaderModule(device, shaderModule, nullptr);
+                                           }
+
+                                           vkDestroyPipeline(device, pipeline, nullptr); });
 }
 
 void VulkanGraphicsPipeline::Build()
@@ -327,7 +323,15 @@ void VulkanGraphicsPipeline::Build()
     pipelineCI.pVertexInputState = &inputVertexStateCI;
     IntrusivePtr<SPIVReflection> fragmentReflection = new SPIVReflection(shaderCode[VK_SHADER_STAGE_FRAGMENT_BIT]);
     this->pipelineLayout = new VulkanPipelineLayout(context);
-    this->pipelineLayout->Build({vertexReflection, fragmentReflection});
+    std::vector<std::pair<uint32_t, uint32_t>> dynamicBindings;
+    for (auto &[_, bindingSet] : vulkanRenderPass->graphicRenderPasses[subPassIndex]->bindingSets)
+    {
+        if (bindingSet.dynamic)
+        {
+            dynamicBindings.push_back({bindingSet.set, bindingSet.binding});
+        }
+    }
+    this->pipelineLayout->Build({vertexReflection, fragmentReflection}, dynamicBindings);
     pipelineCI.layout = this->pipelineLayout->GetLayout();
 
     auto result = vkCreateGraphicsPipelines(context->GetVkDevice(), nullptr, 1, &pipelineCI, nullptr, &pipeline);
@@ -16,8 +16,6 @@ public:
     virtual ~VulkanGraphicsPipeline() override;
     virtual void Build() override;
 
-    IntrusivePtr<VulkanPipelineLayout> &GetPipelineLayout();
-
     VkPipeline GetPipeline();
 
     IntrusivePtr<VulkanGraphicPass> GetRenderPass();
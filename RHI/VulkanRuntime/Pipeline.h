@@ -18,6 +18,11 @@ public:
     VulkanPipeline(IntrusivePtr<Context> context, std::string groupName, std::string pipelineName);
     virtual void Build() = 0;
 
+    IntrusivePtr<VulkanPipelineLayout> &GetPipelineLayout()
+    {
+        return pipelineLayout;
+    }
+
 protected:
     IntrusivePtr<Context> context;
     std::vector<VkShaderModule> shaderModules;
@@ -27,5 +32,5 @@ protected:
 
     IntrusivePtr<VulkanPipelineLayout> pipelineLayout;
 
-    VkPipeline pipeline;
+    VkPipeline pipeline = VK_NULL_HANDLE;
 };
\ No newline at end of file
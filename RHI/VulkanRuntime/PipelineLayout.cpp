@@ -1,5 +1,7 @@
 #include <RHI/VulkanRuntime/PipelineLayout.h>
 
+#include <algorithm>
+
 #include <spirv_reflect.h>
 
 #include <spdlog/spdlog.h>
@@ -12,16 +14,17 @@ VulkanPipelineLayout::VulkanPipelineLayout(IntrusivePtr<Context> context) : cont
 
 VulkanPipelineLayout::~VulkanPipelineLayout()
 {
-    auto device = context->GetVkDevice();
-    for (auto &desriptorSetLayout : desriptorSetLayouts)
-    {
-        vkDestroyDescriptorSetLayout(device, desriptorSetLayout, nullptr);
-    }
-
-    vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+    context->GetDeletionQueue().Retire([device = context->GetVkDevice(), desriptorSetLayouts = desriptorSetLayouts, pipelineLayout = pipelineLayout]()
+                                       {
+                                           for (auto &desriptorSetLayout : desriptorSetLayouts)
+                                           {
+                                               vkDestroyDescriptorSetLayout(device, desriptorSetLayout, nullptr);
+                                           }
+
+                                           vkDestroyPipelineLayout(device, pipelineLayout, nullptr); });
 }
 
-void VulkanPipelineLayout::Build(std::vector<IntrusivePtr<SPIVReflection>> reflections)
+void VulkanPipelineLayout::Build(std::vector<IntrusivePtr<SPIVReflection>> reflections, std::vector<std::pair<uint32_t, uint32_t>> dynamicBindings)
 {
     bindingsInSets.resize(8);
     for (auto reflection : reflections)
@@ -31,10 +34,25 @@ void VulkanPipelineLayout::Build(std::vector<IntrusivePtr<SPIVReflection>> refle
         for (uint32_t i = 0; i < descriptorState.descriptorSetLayoutSets.size(); i++)
         {
             auto layoutInSet = descriptorState.descriptorSetLayoutSets[i];
-            std::copy(layoutInSet.begin(), layoutInSet.end(), std::back_inserter(bindingsInSets[i]));
 
             for (uint32_t j = 0; j < layoutInSet.size(); j++)
             {
+                // same binding reflected from several stages is one layout binding
+                auto sameBinding = std::find_if(bindingsInSets[i].begin(), bindingsInSets[i].end(), [&](auto &layoutBinding)
+                                                { return layoutBinding.binding == layoutInSet[j].binding; });
+                if (sameBinding != bindingsInSets[i].end())
+                {
+                    sameBinding->stageFlags |= layoutInSet[j].stageFlags;
+                }
+                else
+                {
+                    bindingsInSets[i].push_back(layoutInSet[j]);
+                }
+
+                if (layoutInSet[j].format != VK_FORMAT_UNDEFINED)
+                {
+                    imageFormats[{i, layoutInSet[j].binding}] = layoutInSet[j].format;
+                }
 
                 SetBindingQuery sbq = {
                     .set = i,
@@ -52,6 +70,25 @@ void VulkanPipelineLayout::Build(std::vector<IntrusivePtr<SPIVReflection>> refle
         }
     }
 
+    // reflection can not tell dynamic uniform and storage buffers apart
+    for (auto [set, binding] : dynamicBindings)
+    {
+        for (auto &layoutBinding : bindingsInSets[set])
+        {
+            if (layoutBinding.binding != binding)
+                continue;
+
+            if (layoutBinding.descriptorType == VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+            {
+                layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+            }
+            else if (layoutBinding.descriptorType == VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+            {
+                layoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC;
+            }
+        }
+    }
+
     for (uint32_t i = 0; i < bindingsInSets.size(); i++)
     {
         auto bindings = bindingsInSets[i];
@@ -81,6 +118,27 @@ void VulkanPipelineLayout::Build(std::vector<IntrusivePtr<SPIVReflection>> refle
     auto result = vkCreatePipelineLayout(context->GetVkDevice(), &pPipelineLayoutCreateInfo, nullptr, &this->pipelineLayout);
 }
 
+VkDescriptorType VulkanPipelineLayout::GetDescriptorType(uint32_t set, uint32_t binding)
+{
+    if (set < bindingsInSets.size())
+    {
+        for (auto &layoutBinding : bindingsInSets[set])
+        {
+            if (layoutBinding.binding == binding)
+            {
+                return layoutBinding.descriptorType;
+            }
+        }
+    }
+    return VK_DESCRIPTOR_TYPE_MAX_ENUM;
+}
+
+VkFormat VulkanPipelineLayout::GetImageFormat(uint32_t set, uint32_t binding)
+{
+    auto format = imageFormats.find({set, binding});
+    return format == imageFormats.end() ? VK_FORMAT_UNDEFINED : format->second;
+}
+
 void VulkanPipelineLayout::ParseFromReflect(std::vector<char> spirv_code)
 {
 }
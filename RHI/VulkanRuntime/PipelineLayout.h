@@ -1,5 +1,6 @@
 #pragma once
 
+#include <map>
 #include <vector>
 #include <string>
 
@@ -14,7 +15,8 @@ public:
     VulkanPipelineLayout(IntrusivePtr<Context> context);
     ~VulkanPipelineLayout();
 
-    void Build(std::vector<IntrusivePtr<SPIVReflection>> reflections);
+    // dynamicBindings: (set, binding) of uniform or storage buffers declared as *_BUFFER_DYNAMIC
+    void Build(std::vector<IntrusivePtr<SPIVReflection>> reflections, std::vector<std::pair<uint32_t, uint32_t>> dynamicBindings = {});
 
     void ParseFromReflect(std::vector<char> spirv_code);
 
@@ -38,6 +40,11 @@ public:
         return uniformNameBindingMap;
     }
 
+    VkDescriptorType GetDescriptorType(uint32_t set, uint32_t binding);
+
+    // format declared in the shader for storage images and texel buffers
+    VkFormat GetImageFormat(uint32_t set, uint32_t binding);
+
 private:
     IntrusivePtr<Context> context;
     std::vector<VkDescriptorSetLayout> desriptorSetLayouts;
@@ -45,6 +52,8 @@ private:
 
     std::vector<VkPushConstantRange> pushConstantRanges;
     std::vector<std::vector<VkDescriptorSetLayoutBinding>> bindingsInSets;
+    // (set, binding) -> declared image format
+    std::map<std::pair<uint32_t, uint32_t>, VkFormat> imageFormats;
 
     struct SetBindingQuery
     {
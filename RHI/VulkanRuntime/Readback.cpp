@@ -0,0 +1,42 @@
+#include <RHI/VulkanRuntime/Readback.h>
+#include <RHI/VulkanRuntime/AuxiliaryExecutor.h>
+
+VulkanReadback::VulkanReadback(IntrusivePtr<VulkanAuxiliaryExecutor> executor, IntrusivePtr<VulkanBuffer> buffer, uint64_t submitSerial) : executor(executor), buffer(buffer), submitSerial(submitSerial)
+{
+}
+
+VulkanReadback::~VulkanReadback()
+{
+}
+
+bool VulkanReadback::Ready()
+{
+    if (!ready)
+    {
+        ready = executor->PollSubmission(submitSerial, false);
+    }
+    return ready;
+}
+
+void VulkanReadback::Wait()
+{
+    if (!ready)
+    {
+        ready = executor->PollSubmission(submitSerial, true);
+    }
+}
+
+bool VulkanReadback::Failed()
+{
+    Wait();
+    return executor->IsSubmissionDropped(submitSerial);
+}
+
+const void *VulkanReadback::Data()
+{
+    if (Failed())
+    {
+        return nullptr;
+    }
+    return buffer->Map();
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <RHI/Readback.h>
+#include <RHI/VulkanRuntime/Buffer.h>
+
+class VulkanAuxiliaryExecutor;
+class VulkanReadback : public Readback
+{
+public:
+    VulkanReadback(IntrusivePtr<VulkanAuxiliaryExecutor> executor, IntrusivePtr<VulkanBuffer> buffer, uint64_t submitSerial);
+    virtual ~VulkanReadback() override;
+
+    virtual bool Ready() override;
+    virtual void Wait() override;
+    virtual bool Failed() override;
+    virtual const void *Data() override;
+
+private:
+    friend class VulkanAuxiliaryExecutor;
+
+    IntrusivePtr<VulkanAuxiliaryExecutor> executor;
+    IntrusivePtr<VulkanBuffer> buffer;
+
+    // serial of the auxiliary submission carrying the copy
+    uint64_t submitSerial;
+    bool ready = false;
+};
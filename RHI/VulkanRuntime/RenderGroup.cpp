@@ -1,7 +1,11 @@
 #include <RHI/VulkanRuntime/RenderGroup.h>
 
+#include <algorithm>
+
 #include <spdlog/spdlog.h>
 
+#include <Core/Trace.h>
+
 #include <RHI/ConstantBuffer.h>
 
 #include <RHI/VulkanRuntime/PipelineLayout.h>
@@ -9,19 +13,17 @@
 #include <RHI/VulkanRuntime/GraphicsPipeline.h>
 #include <RHI/VulkanRuntime/ComputePipeline.h>
 
-VulkanRenderGroup::VulkanRenderGroup(IntrusivePtr<Context> context, IntrusivePtr<Graph> graph, IntrusivePtr<VulkanAuxiliaryExecutor> auxiliaryExecutor) : RenderGroup(graph), context(context), auxiliaryExecutor(auxiliaryExecutor)
+VulkanRenderGroup::VulkanRenderGroup(IntrusivePtr<Context> context, IntrusivePtr<Graph> graph, IntrusivePtr<VulkanAuxiliaryExecutor> auxiliaryExecutor, IntrusivePtr<VulkanGPUProfiler> gpuProfiler, IntrusivePtr<VulkanStatisticsCollector> statistics, IntrusivePtr<CaptureRecorder> captureRecorder, IntrusivePtr<VulkanWorkgroupTuner> workgroupTuner) : RenderGroup(graph), context(context), auxiliaryExecutor(auxiliaryExecutor), gpuProfiler(gpuProfiler), statistics(statistics), captureRecorder(captureRecorder), workgroupTuner(workgroupTuner)
 {
     prepareCommandPool();
+    uniformAllocator = new VulkanUniformAllocator(context);
 }
 
 VulkanRenderGroup::~VulkanRenderGroup()
 {
-    vkDeviceWaitIdle(context->GetVkDevice());
-
     Reset();
-
-    vkDestroyCommandPool(context->GetVkDevice(), graphicCommandPool, nullptr);
-    vkDestroyCommandPool(context->GetVkDevice(), computeCommandPool, nullptr);
+    releaseCommandPool();
+    captureRecorder->RecordDestroy(this);
 }
 
 void VulkanRenderGroup::Build()
@@ -49,6 +51,8 @@ void VulkanRenderGroup::Build()
 
 void VulkanRenderGroup::Update(uint32_t currentImageIndex, VulkanSwapChain *swapChain)
 {
+    TRACE_SCOPE("VulkanRenderGroup::Update");
+
     for (auto [_, cbs] : this->renderPassResourceMap)
     {
         vkResetCommandBuffer(cbs.commandBuffers[currentImageIndex], 0);
@@ -61,32 +65,34 @@ void VulkanRenderGroup::Update(uint32_t currentImageIndex, VulkanSwapChain *swap
 
     this->auxiliaryExecutor->Execute();
 
+    // inputs are uploaded and nothing of this group is in flight yet
+    if (workgroupTuner && !workgroupsTuned)
+    {
+        tuneComputePipelines(currentImageIndex, swapChain);
+        workgroupsTuned = true;
+    }
+
     // rebuild the command buffer at lastFrame index
     buildCommandBuffer(currentImageIndex, swapChain);
 }
 
 void VulkanRenderGroup::Reset()
 {
+    releaseFrameBuffers();
+
     for (auto &[_, resource] : renderPassResourceMap)
     {
-        resource.attachmentImages.clear();
-
-        for (auto &fb : resource.frameBuffers)
-        {
-            vkDestroyFramebuffer(context->GetVkDevice(), fb, nullptr);
-        }
-
-        resource.frameBuffers.clear();
-
-        vkDestroyCommandPool(context->GetVkDevice(), graphicCommandPool, nullptr);
-        vkDestroyCommandPool(context->GetVkDevice(), computeCommandPool, nullptr);
-
-        graphicCommandPool = nullptr;
-        computeCommandPool = nullptr;
+        resource.commandBuffers.clear();
+    }
 
+    for (auto &[_, resource] : computePassResourceMap)
+    {
         resource.commandBuffers.clear();
     }
 
+    // command buffers are freed with their pools
+    releaseCommandPool();
+
     for (auto &[pipeline, drawStates] : resourceBindingStates)
     {
         for (auto &drawState : drawStates)
@@ -102,11 +108,65 @@ void VulkanRenderGroup::Reset()
     prepareCommandPool();
 }
 
+void VulkanRenderGroup::Resize(VulkanSwapChain *swapChain)
+{
+    TRACE_SCOPE("VulkanRenderGroup::Resize");
+
+    releaseFrameBuffers();
+    groupScopeResources.clear();
+
+    // internal bindings refer to the old attachments
+    for (auto &[pipeline, drawStates] : resourceBindingStates)
+    {
+        for (auto &drawState : drawStates)
+        {
+            static_cast<VulkanResourceBindingState *>(drawState.get())->GetDescriptorSet()->ClearInternal();
+        }
+    }
+
+    for (auto &[name, renderPass] : renderPasses)
+    {
+        prepareFrameBuffer(renderPass, swapChain);
+    }
+
+    resolveDrawStatesDescriptors(swapChain);
+}
+
+void VulkanRenderGroup::releaseFrameBuffers()
+{
+    for (auto &[_, resource] : renderPassResourceMap)
+    {
+        resource.attachmentImages.clear();
+
+        context->GetDeletionQueue().Retire([device = context->GetVkDevice(), frameBuffers = resource.frameBuffers]()
+                                           {
+                                               for (auto &fb : frameBuffers)
+                                               {
+                                                   vkDestroyFramebuffer(device, fb, nullptr);
+                                               } });
+
+        resource.frameBuffers.clear();
+    }
+}
+
 void VulkanRenderGroup::AddBindingState(IntrusivePtr<ResourceBindingState> state)
 {
-    auto vgp = static_cast<VulkanGraphicsPipeline *>(state->GetPipeline().get());
-    this->resourceBindingStates[vgp].push_back(static_cast<VulkanResourceBindingState *>(state.get()));
-    this->pipelineMap[vgp->pipelineName] = vgp;
+    // graphic or compute pipeline
+    auto &pipeline = state->GetPipeline();
+    this->resourceBindingStates[pipeline].push_back(static_cast<VulkanResourceBindingState *>(state.get()));
+    this->pipelineMap[pipeline->pipelineName] = pipeline;
+    captureRecorder->RecordAddBindingState(this, state.get());
+}
+
+void VulkanRenderGroup::GetBindingStates(std::vector<ResourceBindingState *> &states)
+{
+    for (auto &[_, drawStates] : resourceBindingStates)
+    {
+        for (auto &drawState : drawStates)
+        {
+            states.push_back(drawState.get());
+        }
+    }
 }
 
 void VulkanRenderGroup::Prepare(VulkanSwapChain *swapChain)
@@ -119,7 +179,7 @@ void VulkanRenderGroup::Prepare(VulkanSwapChain *swapChain)
 
     for (auto &[name, computePass] : computePasses)
     {
-        // prepareResources(computePass, swapChain);
+        prepareCommandBuffer(computePass, swapChain);
     }
 
     // make sure all descriptor set in layout is valid
@@ -148,6 +208,7 @@ IntrusivePtr<Pipeline> VulkanRenderGroup::CreatePipeline(std::string subPassName
     auto pipeline = new VulkanGraphicsPipeline(context, rp, Name(), subPassName, pipelineStates);
     pipeline->groupName = this->Name();
     pipeline->Build();
+    captureRecorder->RecordPipeline(pipeline, this, subPassName, pipelineStates);
     return pipeline;
 }
 
@@ -162,16 +223,27 @@ IntrusivePtr<Pipeline> VulkanRenderGroup::CreatePipeline(std::string subPassName
     auto pipeline = new VulkanComputePipeline(context, rp, Name(), subPassName, pipelineStates);
     pipeline->groupName = this->Name();
     pipeline->Build();
+    captureRecorder->RecordPipeline(pipeline, this, subPassName, pipelineStates);
     return pipeline;
 }
 
 std::vector<VkCommandBuffer> VulkanRenderGroup::GetCommandBuffer(uint32_t currentImageIndex)
 {
     std::vector<VkCommandBuffer> result;
-    // TODO, sort by topo
-    for (auto [_, cbs] : renderPassResourceMap)
+    // passes reading a compute output are placed after the compute pass
+    for (auto &[level, passes] : this->graph->Topo().levelsRenderPassOnly)
     {
-        result.push_back(cbs.commandBuffers[currentImageIndex]);
+        for (auto &pass : passes)
+        {
+            if (renderPasses.count(pass->LocalName()))
+            {
+                result.push_back(renderPassResourceMap[renderPasses[pass->LocalName()]].commandBuffers[currentImageIndex]);
+            }
+            else if (computePasses.count(pass->LocalName()))
+            {
+                result.push_back(computePassResourceMap[computePasses[pass->LocalName()]].commandBuffers[currentImageIndex]);
+            }
+        }
     }
     return result;
 }
@@ -200,8 +272,24 @@ void VulkanRenderGroup::prepareCommandPool()
     }
 }
 
+void VulkanRenderGroup::releaseCommandPool()
+{
+    context->GetDeletionQueue().Retire([device = context->GetVkDevice(), graphicCommandPool = graphicCommandPool, computeCommandPool = computeCommandPool]()
+                                       {
+                                           vkDestroyCommandPool(device, graphicCommandPool, nullptr);
+                                           vkDestroyCommandPool(device, computeCommandPool, nullptr); });
+
+    graphicCommandPool = VK_NULL_HANDLE;
+    computeCommandPool = VK_NULL_HANDLE;
+}
+
 void VulkanRenderGroup::buildCommandBuffer(uint32_t imageIndex, VulkanSwapChain *swapchain)
 {
+    TRACE_SCOPE("VulkanRenderGroup::buildCommandBuffer");
+
+    // command buffers of imageIndex are done, so are their uniform slices
+    uniformAllocator->Reset(imageIndex);
+
     // renderPasses may contain more than 1 subpass
     for (auto &[passName, rp] : renderPasses)
     {
@@ -244,6 +332,11 @@ void VulkanRenderGroup::buildCommandBuffer(uint32_t imageIndex, VulkanSwapChain
         viewport.maxDepth = 1.0f;
         vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
 
+        // state bound in this command buffer, identical rebinds are skipped
+        VkPipeline boundPipeline = VK_NULL_HANDLE;
+        std::vector<VkDescriptorSet> boundDescriptorSets;
+        std::vector<uint32_t> boundDynamicOffsets;
+
         // for each subpass in renderPass
         for (auto &subpass : renderPass->graphicRenderPasses)
         {
@@ -254,6 +347,10 @@ void VulkanRenderGroup::buildCommandBuffer(uint32_t imageIndex, VulkanSwapChain
 
             auto &drawStates = this->resourceBindingStates[pipeline];
 
+            auto profileScope = gpuProfiler->BeginScope(commandBuffer, imageIndex, Name(), subpass->GlobalName());
+            auto statisticsQuery = statistics->BeginQuery(commandBuffer, imageIndex, subpass->GlobalName());
+            auto &passStatistics = statistics->Pass(subpass->GlobalName());
+
             // if (drawStates.empty())
             // {
             //     vkCmdNextSubpass(commandBuffer, VK_SUBPASS_CONTENTS_INLINE);
@@ -266,12 +363,26 @@ void VulkanRenderGroup::buildCommandBuffer(uint32_t imageIndex, VulkanSwapChain
                 auto &descriptorSets = drawState->GetDescriptorSets(imageIndex);
                 auto constantBuffer = static_cast<ConstantBuffer *>(drawState->GetConstantBuffer().get());
 
-                if (drawState->GetDrawOps().empty() && (!drawState->GetVertexBuffers() || !drawState->GetIndexBuffers()))
+                if (drawState->GetDrawOps().empty() && drawState->GetIndirectDrawOps().empty() && (!drawState->GetVertexBuffers() || !drawState->GetIndexBuffers()))
+                {
+                    continue;
+                }
+
+                // streaming geometry might not be written for this frame yet
+                auto vertexBuffer = drawState->GetVertexBuffer(imageIndex);
+                auto indexBuffer = drawState->GetIndexBuffer(imageIndex);
+                if ((drawState->GetVertexBuffers() && !vertexBuffer) || (drawState->GetIndexBuffers() && !indexBuffer))
                 {
                     continue;
                 }
 
-                vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->GetPipeline());
+                if (boundPipeline != pipeline->GetPipeline())
+                {
+                    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline->GetPipeline());
+                    boundPipeline = pipeline->GetPipeline();
+                    boundDescriptorSets.clear();
+                    passStatistics.pipelineBinds++;
+                }
 
                 if (constantBuffer)
                 {
@@ -282,16 +393,21 @@ void VulkanRenderGroup::buildCommandBuffer(uint32_t imageIndex, VulkanSwapChain
 
                 if (!descriptorSets.empty())
                 {
-                    vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout->GetLayout(), 0, descriptorSets.size(), descriptorSets.data(), 0, nullptr);
+                    auto dynamicOffsets = drawState->GetDescriptorSet()->ResolveDynamicBuffers(imageIndex, uniformAllocator.get());
+                    if (descriptorSets != boundDescriptorSets || dynamicOffsets != boundDynamicOffsets)
+                    {
+                        vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout->GetLayout(), 0, descriptorSets.size(), descriptorSets.data(), dynamicOffsets.size(), dynamicOffsets.data());
+                        boundDescriptorSets = descriptorSets;
+                        boundDynamicOffsets = dynamicOffsets;
+                        passStatistics.descriptorBinds++;
+                    }
                 }
 
                 const VkDeviceSize offsets[1] = {0};
-                auto vertexBuffer = drawState->GetVertexBuffer(imageIndex);
                 if (vertexBuffer)
                 {
                     vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer->GetBuffer(), offsets);
                 }
-                auto indexBuffer = drawState->GetIndexBuffer(imageIndex);
                 if (indexBuffer)
                 {
                     vkCmdBindIndexBuffer(commandBuffer, indexBuffer->GetBuffer(), 0, drawState->GetIndexType());
@@ -312,11 +428,69 @@ void VulkanRenderGroup::buildCommandBuffer(uint32_t imageIndex, VulkanSwapChain
                     }
                     vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
                     if (drawOP.indexCount)
+                    {
                         vkCmdDrawIndexed(commandBuffer, drawOP.indexCount, drawOP.instanceCount, drawOP.firstIndex, drawOP.vertexOffset, drawOP.firstInstance);
+                        passStatistics.indexCount += uint64_t(drawOP.indexCount) * drawOP.instanceCount;
+                    }
                     else if (drawOP.vertexCount)
+                    {
                         vkCmdDraw(commandBuffer, drawOP.vertexCount, drawOP.instanceCount, 0, 0);
+                        passStatistics.vertexCount += uint64_t(drawOP.vertexCount) * drawOP.instanceCount;
+                    }
+                    else
+                    {
+                        continue;
+                    }
+                    passStatistics.drawCount++;
+                    passStatistics.instanceCount += drawOP.instanceCount;
+                }
+
+                // counts are on the gpu, only the draws are counted
+                for (auto &drawOP : drawState->GetIndirectDrawOps())
+                {
+                    auto buffer = VulkanResourceBindingState::GetBuffer(drawOP.resource, imageIndex);
+                    if (!buffer || !drawOP.drawCount)
+                        continue;
+
+                    scissor.extent = swapchain->extent;
+                    scissor.offset = {0, 0};
+                    vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+                    uint32_t stride = drawOP.stride ? drawOP.stride : uint32_t(indexBuffer ? sizeof(VkDrawIndexedIndirectCommand) : sizeof(VkDrawIndirectCommand));
+
+                    // the count is on the gpu too, drawCount is the upper bound
+                    IntrusivePtr<VulkanBuffer> countBuffer;
+                    if (drawOP.countResource && context->IsDrawIndirectCountEnabled())
+                    {
+                        countBuffer = VulkanResourceBindingState::GetBuffer(drawOP.countResource, imageIndex);
+                    }
+                    if (countBuffer)
+                    {
+                        if (indexBuffer)
+                            vkCmdDrawIndexedIndirectCount(commandBuffer, buffer->GetBuffer(), drawOP.offset, countBuffer->GetBuffer(), drawOP.countOffset, drawOP.drawCount, stride);
+                        else
+                            vkCmdDrawIndirectCount(commandBuffer, buffer->GetBuffer(), drawOP.offset, countBuffer->GetBuffer(), drawOP.countOffset, drawOP.drawCount, stride);
+                        passStatistics.drawCount += drawOP.drawCount;
+                        continue;
+                    }
+
+                    // one record per call without multiDrawIndirect
+                    bool multiDraw = context->GetEnabledFeatures().multiDrawIndirect;
+                    for (uint32_t i = 0; i < (multiDraw ? 1 : drawOP.drawCount); i++)
+                    {
+                        auto offset = drawOP.offset + uint64_t(i) * stride;
+                        auto drawCount = multiDraw ? drawOP.drawCount : 1;
+                        if (indexBuffer)
+                            vkCmdDrawIndexedIndirect(commandBuffer, buffer->GetBuffer(), offset, drawCount, stride);
+                        else
+                            vkCmdDrawIndirect(commandBuffer, buffer->GetBuffer(), offset, drawCount, stride);
+                    }
+                    passStatistics.drawCount += drawOP.drawCount;
                 }
             }
+
+            statistics->EndQuery(commandBuffer, imageIndex, statisticsQuery);
+            gpuProfiler->EndScope(commandBuffer, imageIndex, profileScope);
         }
 
         vkCmdEndRenderPass(commandBuffer);
@@ -324,17 +498,293 @@ void VulkanRenderGroup::buildCommandBuffer(uint32_t imageIndex, VulkanSwapChain
         vkEndCommandBuffer(commandBuffer);
     }
 
-    for (auto &[name, cp] : computePasses)
+    for (auto &[name, computePass] : computePasses)
     {
-        auto computePass = static_cast<VulkanComputePass *>(cp.get());
-        auto &computePassResource = computePassResourceMap[computePass];
-        auto &commandBuffer = computePassResource.commandBuffers[imageIndex];
+        buildComputeCommandBuffer(computePass, imageIndex, swapchain);
+    }
+}
 
-        VkCommandBufferBeginInfo cmdBufferBeginInfo = {};
-        cmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+// stages and accesses of the passes consuming the outputs of passNode
+// unknown consumers (other groups, readbacks) get a full barrier
+static void ConsumerMasks(RenderPassGraphNode *passNode, VkPipelineStageFlags &stageMask, VkAccessFlags &accessMask)
+{
+    stageMask = 0;
+    accessMask = 0;
 
-        vkBeginCommandBuffer(commandBuffer, &cmdBufferBeginInfo);
+    for (auto &output : passNode->outputs)
+    {
+        if (output->type == GraphNode::GRAPHIC_PASS)
+        {
+            stageMask |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT | VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            accessMask |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT | VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT;
+        }
+        else if (output->type == GraphNode::COMPUTE_PASS)
+        {
+            stageMask |= VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+            accessMask |= VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_UNIFORM_READ_BIT | VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        }
+    }
+
+    if (!stageMask)
+    {
+        stageMask = VK_PIPELINE_STAGE_ALL_COMMANDS_BIT;
+        accessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+    }
+}
+
+// stages of the graphic passes writing storage resources read by passNode
+// compute producers make their writes visible themselves, graphic passes do not
+static void GraphicProducerMasks(RenderPassGraphNode *passNode, VkPipelineStageFlags &stageMask, VkAccessFlags &accessMask)
+{
+    stageMask = 0;
+    accessMask = 0;
+
+    for (auto &input : passNode->inputs)
+    {
+        if (input->type == GraphNode::GRAPHIC_PASS)
+        {
+            stageMask |= VK_PIPELINE_STAGE_VERTEX_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            accessMask |= VK_ACCESS_SHADER_WRITE_BIT;
+        }
+    }
+}
+
+static uint32_t DivideRoundUp(uint32_t size, uint32_t groupSize)
+{
+    return (size + groupSize - 1) / groupSize;
+}
+
+void VulkanRenderGroup::buildComputeCommandBuffer(IntrusivePtr<VulkanComputePass> &computePass, uint32_t imageIndex, VulkanSwapChain *swapchain)
+{
+    auto &computePassResource = computePassResourceMap[computePass];
+    auto &commandBuffer = computePassResource.commandBuffers[imageIndex];
+    auto &passNode = computePass->GetComputePassNode();
+
+    VkCommandBufferBeginInfo cmdBufferBeginInfo = {};
+    cmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+
+    vkBeginCommandBuffer(commandBuffer, &cmdBufferBeginInfo);
+
+    // no pipeline created for this pass
+    if (!pipelineMap.count(passNode->LocalName()))
+    {
         vkEndCommandBuffer(commandBuffer);
+        return;
+    }
+
+    auto pipeline = static_cast<VulkanComputePipeline *>(pipelineMap[passNode->LocalName()].get());
+
+    VkPipelineStageFlags consumerStages;
+    VkAccessFlags consumerAccess;
+    ConsumerMasks(passNode.get(), consumerStages, consumerAccess);
+
+    VkPipelineStageFlags producerStages;
+    VkAccessFlags producerAccess;
+    GraphicProducerMasks(passNode.get(), producerStages, producerAccess);
+
+    // outputs may still be read by the consumers of the previous frame, inputs may be written by graphic passes before
+    {
+        VkMemoryBarrier memoryBarrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = producerAccess,
+            .dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT};
+        vkCmdPipelineBarrier(commandBuffer, consumerStages | producerStages, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+
+    auto profileScope = gpuProfiler->BeginScope(commandBuffer, imageIndex, Name(), passNode->GlobalName());
+    auto statisticsQuery = statistics->BeginQuery(commandBuffer, imageIndex, passNode->GlobalName());
+    auto &passStatistics = statistics->Pass(passNode->GlobalName());
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->GetPipeline());
+    passStatistics.pipelineBinds++;
+
+    recordDispatches(commandBuffer, pipeline, imageIndex, swapchain, &passStatistics);
+
+    statistics->EndQuery(commandBuffer, imageIndex, statisticsQuery);
+    gpuProfiler->EndScope(commandBuffer, imageIndex, profileScope);
+
+    // make the outputs visible to the passes reading them
+    {
+        VkMemoryBarrier memoryBarrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT,
+            .dstAccessMask = consumerAccess};
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, consumerStages, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+    }
+    statistics->AddBarriers(2);
+
+    vkEndCommandBuffer(commandBuffer);
+}
+
+void VulkanRenderGroup::recordDispatches(VkCommandBuffer commandBuffer, VulkanComputePipeline *pipeline, uint32_t imageIndex, VulkanSwapChain *swapchain, FrameStatistics::Pass *passStatistics,
+                                         const std::vector<std::vector<uint32_t>> *dynamicOffsets)
+{
+    auto &pipelineLayout = pipeline->GetPipelineLayout();
+    auto localGroupSize = pipeline->GetLocalGroupSize();
+
+    auto &dispatchStates = resourceBindingStates[pipeline];
+    for (size_t i = 0; i < dispatchStates.size(); i++)
+    {
+        auto &dispatchState = dispatchStates[i];
+        if (dispatchState->GetDispatchOps().empty())
+            continue;
+
+        auto &descriptorSets = dispatchState->GetDescriptorSets(imageIndex);
+        auto constantBuffer = static_cast<ConstantBuffer *>(dispatchState->GetConstantBuffer().get());
+
+        if (constantBuffer)
+        {
+            vkCmdPushConstants(commandBuffer, pipelineLayout->GetLayout(),
+                               VK_SHADER_STAGE_COMPUTE_BIT,
+                               0, constantBuffer->Size(), constantBuffer->Map());
+        }
+
+        if (!descriptorSets.empty())
+        {
+            auto offsets = dynamicOffsets ? dynamicOffsets->at(i) : dispatchState->GetDescriptorSet()->ResolveDynamicBuffers(imageIndex, uniformAllocator.get());
+            vkCmdBindDescriptorSets(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipelineLayout->GetLayout(), 0, descriptorSets.size(), descriptorSets.data(), offsets.size(), offsets.data());
+            if (passStatistics)
+                passStatistics->descriptorBinds++;
+        }
+
+        for (auto &dispatchOP : dispatchState->GetDispatchOps())
+        {
+            switch (dispatchOP.type)
+            {
+            case ResourceBindingState::DispatchOP::DIRECT:
+            {
+                auto &groupCount = dispatchOP.groupCount;
+                if (!groupCount.x || !groupCount.y || !groupCount.z)
+                    continue;
+                vkCmdDispatch(commandBuffer, groupCount.x, groupCount.y, groupCount.z);
+                break;
+            }
+            case ResourceBindingState::DispatchOP::RESOURCE_SIZE:
+            {
+                glm::u32vec3 size = {swapchain->extent.width, swapchain->extent.height, 1};
+                if (dispatchOP.resource && dispatchOP.resource->type == ResourceHandle::TEXTURE)
+                {
+                    auto extent = dispatchOP.resource->As<Texture>()->GetExtent();
+                    size = {extent.width, extent.height, extent.depth};
+                }
+                else if (dispatchOP.resource)
+                {
+                    auto buffer = VulkanResourceBindingState::GetBuffer(dispatchOP.resource, imageIndex);
+                    if (!buffer)
+                        continue;
+                    // the allocation may be larger than the buffer, its tail holds no elements
+                    size = {uint32_t(buffer->GetCreatedSize() / std::max(dispatchOP.elementSize, 1u)), 1, 1};
+                }
+
+                glm::u32vec3 groupCount = {DivideRoundUp(size.x, localGroupSize[0]), DivideRoundUp(size.y, localGroupSize[1]), DivideRoundUp(size.z, localGroupSize[2])};
+                if (!groupCount.x || !groupCount.y || !groupCount.z)
+                    continue;
+                vkCmdDispatch(commandBuffer, groupCount.x, groupCount.y, groupCount.z);
+                break;
+            }
+            case ResourceBindingState::DispatchOP::INDIRECT:
+            {
+                auto buffer = VulkanResourceBindingState::GetBuffer(dispatchOP.resource, imageIndex);
+                if (!buffer)
+                    continue;
+                vkCmdDispatchIndirect(commandBuffer, buffer->GetBuffer(), dispatchOP.offset);
+                break;
+            }
+            }
+            if (passStatistics)
+                passStatistics->dispatchCount++;
+        }
+    }
+}
+
+void VulkanRenderGroup::tuneComputePipelines(uint32_t imageIndex, VulkanSwapChain *swapChain)
+{
+    TRACE_SCOPE("VulkanRenderGroup::tuneComputePipelines");
+
+    for (auto &[name, basePipeline] : pipelineMap)
+    {
+        auto pipeline = dynamic_cast<VulkanComputePipeline *>(basePipeline.get());
+        if (!pipeline || !pipeline->GetPipelineStates().autotune)
+            continue;
+
+        if (!pipeline->GetTunableDimensions())
+        {
+            spdlog::warn("workgroup tuning: {} has no local_size_x_id, keeping {}x{}x{}", name, pipeline->GetLocalGroupSize()[0], pipeline->GetLocalGroupSize()[1], pipeline->GetLocalGroupSize()[2]);
+            continue;
+        }
+
+        // the group count of the other dispatch types does not follow the workgroup size
+        auto &states = resourceBindingStates[pipeline];
+        bool resourceSized = !states.empty();
+        for (auto &state : states)
+        {
+            for (auto &dispatchOP : state->GetDispatchOps())
+            {
+                resourceSized &= dispatchOP.type == ResourceBindingState::DispatchOP::RESOURCE_SIZE;
+            }
+        }
+        if (!resourceSized)
+        {
+            spdlog::warn("workgroup tuning: {} needs RESOURCE_SIZE dispatches only", name);
+            continue;
+        }
+
+        std::array<uint32_t, 3> best;
+        if (workgroupTuner->Lookup(pipeline->GetShaderHash(), best))
+        {
+            pipeline->SetLocalGroupSize(best);
+            spdlog::info("workgroup tuning: {} cached {}x{}x{}", name, best[0], best[1], best[2]);
+            continue;
+        }
+
+        if (!workgroupTuner->Supported())
+        {
+            spdlog::warn("workgroup tuning: no timestamps on this queue, {} keeps its size", name);
+            continue;
+        }
+
+        // candidates run on the live resources, anything accumulating or reading its own output would be left corrupted
+        if (!pipeline->GetPipelineStates().idempotent)
+        {
+            spdlog::warn("workgroup tuning: {} is not declared idempotent, keeping its size", name);
+            continue;
+        }
+
+        // the uniforms do not change between candidates, resolve them once instead of allocating per run
+        std::vector<std::vector<uint32_t>> dynamicOffsets;
+        for (auto &state : states)
+        {
+            auto &offsets = dynamicOffsets.emplace_back();
+            if (!state->GetDispatchOps().empty() && !state->GetDescriptorSets(imageIndex).empty())
+            {
+                offsets = state->GetDescriptorSet()->ResolveDynamicBuffers(imageIndex, uniformAllocator.get());
+            }
+        }
+
+        double bestTime = 0.0;
+        best = pipeline->GetLocalGroupSize();
+        for (auto &candidate : workgroupTuner->Candidates(pipeline->GetTunableDimensions()))
+        {
+            pipeline->SetLocalGroupSize(candidate);
+            auto time = workgroupTuner->Measure([&](VkCommandBuffer commandBuffer)
+                                                {
+                                                    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline->GetPipeline());
+                                                    recordDispatches(commandBuffer, pipeline, imageIndex, swapChain, nullptr, &dynamicOffsets); });
+            spdlog::info("workgroup tuning: {} {}x{}x{} {:.3f}ms", name, candidate[0], candidate[1], candidate[2], time);
+
+            if (bestTime == 0.0 || time < bestTime)
+            {
+                bestTime = time;
+                best = candidate;
+            }
+        }
+
+        pipeline->SetLocalGroupSize(best);
+        if (bestTime > 0.0)
+        {
+            workgroupTuner->Store(pipeline->GetShaderHash(), best, bestTime);
+        }
+        spdlog::info("workgroup tuning: {} tuned to {}x{}x{}", name, best[0], best[1], best[2]);
     }
 }
 
@@ -349,6 +799,8 @@ uint32_t VulkanRenderGroup::DeferAttachmentUsage(IntrusivePtr<AttachmentGraphNod
     if (attachmentNode->inputSubPassNames.size() != 0 || attachmentNode->input)
     {
         usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+        // depth inputs are read through a sampler like color ones
+        usage |= VK_IMAGE_USAGE_SAMPLED_BIT;
     }
     if (attachmentNode->color)
     {
@@ -393,6 +845,20 @@ void VulkanRenderGroup::prepareCommandBuffer(IntrusivePtr<VulkanGraphicPass> &re
     }
 }
 
+void VulkanRenderGroup::prepareCommandBuffer(IntrusivePtr<VulkanComputePass> &computePass, VulkanSwapChain *swapChain)
+{
+    auto scTextureSize = swapChain->GetTextures().size();
+    auto &commandBuffers = computePassResourceMap[computePass].commandBuffers;
+
+    VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+    commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferAllocateInfo.commandPool = graphicCommandPool;
+    commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferAllocateInfo.commandBufferCount = uint32_t(scTextureSize);
+    commandBuffers.resize(scTextureSize);
+    auto result = vkAllocateCommandBuffers(context->GetVkDevice(), &commandBufferAllocateInfo, commandBuffers.data());
+}
+
 IntrusivePtr<VulkanTexture> VulkanRenderGroup::CreateAttachmentResource(VulkanSwapChain *swapChain, IntrusivePtr<AttachmentGraphNode> attachmentNode)
 {
     auto texture = new VulkanTexture(context);
@@ -530,15 +996,26 @@ void VulkanRenderGroup::resolveDrawStatesDescriptors(VulkanSwapChain *swapChain)
 {
     for (auto &[pipeline, drawStates] : resourceBindingStates)
     {
-        auto vulkanPL = static_cast<VulkanGraphicsPipeline *>(pipeline.get());
-        auto vulkanRP = vulkanPL->GetRenderPass();
-
-        auto subPassNode = vulkanRP->GetGraphicRenderPassGraphNode(vulkanPL->GetPipelineName());
+        // compute passes have no internal resources, their buffers are bound by the user
+        IntrusivePtr<VulkanGraphicPass> vulkanRP;
+        RenderPassGraphNode *subPassNode = nullptr;
+        if (computePasses.count(pipeline->GetPipelineName()))
+        {
+            subPassNode = computePasses[pipeline->GetPipelineName()]->GetComputePassNode().get();
+        }
+        else
+        {
+            auto vulkanPL = static_cast<VulkanGraphicsPipeline *>(pipeline.get());
+            vulkanRP = vulkanPL->GetRenderPass();
+            subPassNode = vulkanRP->GetGraphicRenderPassGraphNode(vulkanPL->GetPipelineName());
+        }
 
         // check every drawState's set binding of pipeline
         // if the resourceName is in attachmentImages, then it's the internal resource
         for (auto &drawState : drawStates)
         {
+            prepareStorageImages(static_cast<VulkanResourceBindingState *>(drawState.get()));
+
             // check each set binding in subpass
             for (auto &[resourceName, bindingSet] : subPassNode->bindingSets)
             {
@@ -561,14 +1038,19 @@ void VulkanRenderGroup::resolveDrawStatesDescriptors(VulkanSwapChain *swapChain)
                     if (frameIndex == 0)
                     {
                         IntrusivePtr<ResourceHandle> resource;
-                        if (bindingSet.type == GraphNode::ATTACHMENT)
+                        if (vulkanRP && bindingSet.type == GraphNode::ATTACHMENT)
                         {
                             resource = renderPassResourceMap[vulkanRP].attachmentImages[resourceName][frameIndex].sampler;
                         }
-                        if (bindingSet.type == GraphNode::BUFFER)
+                        if (vulkanRP && bindingSet.type == GraphNode::BUFFER && !renderPassResourceMap[vulkanRP].buffers[resourceName].empty())
                         {
                             resource = renderPassResourceMap[vulkanRP].buffers[resourceName][frameIndex];
                         }
+                        if (!resource)
+                        {
+                            spdlog::warn("resource {} of {} is not bound", resourceName, pipeline->GetPipelineName());
+                            break;
+                        }
                         vulkanDrawState->BindInternal(frameIndex, bindingSet.set, bindingSet.binding, resource);
                     }
                     else
@@ -582,3 +1064,32 @@ void VulkanRenderGroup::resolveDrawStatesDescriptors(VulkanSwapChain *swapChain)
         }
     }
 }
+
+void VulkanRenderGroup::prepareStorageImages(VulkanResourceBindingState *drawState)
+{
+    for (auto &[set, bindings] : drawState->GetDescriptorSet()->GetResourceHandlesMap(0))
+    {
+        for (auto &[binding, desc] : bindings)
+        {
+            for (auto &resource : desc.resourceHandles)
+            {
+                if (resource->type != ResourceHandle::TEXTURE)
+                    continue;
+
+                auto texture = boost::static_pointer_cast<VulkanTexture>(resource);
+                // uploaded textures are already left in GENERAL
+                if (!(texture->GetUsage() & VK_IMAGE_USAGE_STORAGE_BIT) || texture->GetLayout() != VK_IMAGE_LAYOUT_UNDEFINED)
+                    continue;
+
+                VulkanAuxiliaryExecutor::ImageLayoutConfig config = {
+                    .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+                    .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+                    .newLayout = VK_IMAGE_LAYOUT_GENERAL,
+                    .srcStageMask = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                    .dstStageMask = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT};
+
+                this->auxiliaryExecutor->SetImageLayout(texture, config);
+            }
+        }
+    }
+}
@@ -10,13 +10,18 @@
 #include <RHI/VulkanRuntime/SwapChain.h>
 #include <RHI/VulkanRuntime/ResourceBindingState.h>
 #include <RHI/VulkanRuntime/AuxiliaryExecutor.h>
+#include <RHI/VulkanRuntime/UniformAllocator.h>
+#include <RHI/VulkanRuntime/GPUProfiler.h>
+#include <RHI/VulkanRuntime/StatisticsCollector.h>
+#include <RHI/VulkanRuntime/WorkgroupTuner.h>
+#include <RHI/CaptureRecorder.h>
 
 #include <vulkan/vulkan.h>
 
 class VulkanRenderGroup : public RenderGroup
 {
 public:
-    VulkanRenderGroup(IntrusivePtr<Context> context, IntrusivePtr<Graph> graph, IntrusivePtr<VulkanAuxiliaryExecutor> auxiliaryExecutor);
+    VulkanRenderGroup(IntrusivePtr<Context> context, IntrusivePtr<Graph> graph, IntrusivePtr<VulkanAuxiliaryExecutor> auxiliaryExecutor, IntrusivePtr<VulkanGPUProfiler> gpuProfiler, IntrusivePtr<VulkanStatisticsCollector> statistics, IntrusivePtr<CaptureRecorder> captureRecorder, IntrusivePtr<VulkanWorkgroupTuner> workgroupTuner);
     virtual ~VulkanRenderGroup();
 
     // build renderpasses and compute pipeline
@@ -39,6 +44,12 @@ public:
 
     void Reset();
 
+    // swapchain extent changed, rebuild attachments, framebuffers and internal descriptors
+    void Resize(VulkanSwapChain *swapChain);
+
+    // all draw states added to this group
+    void GetBindingStates(std::vector<ResourceBindingState *> &states);
+
     std::vector<VkCommandBuffer> GetCommandBuffer(uint32_t currentImageIndex);
 
     IntrusivePtr<VulkanGraphicPass> GetRenderPass(std::string name);
@@ -51,6 +62,16 @@ public:
 private:
     IntrusivePtr<Context> context;
     IntrusivePtr<VulkanAuxiliaryExecutor> auxiliaryExecutor;
+    IntrusivePtr<VulkanGPUProfiler> gpuProfiler;
+    IntrusivePtr<VulkanStatisticsCollector> statistics;
+    IntrusivePtr<CaptureRecorder> captureRecorder;
+
+    // may be null, autotune pipelines are tuned on the first update
+    IntrusivePtr<VulkanWorkgroupTuner> workgroupTuner;
+    bool workgroupsTuned = false;
+
+    // DynamicBuffer slices, rewound each time the frame is recorded
+    IntrusivePtr<VulkanUniformAllocator> uniformAllocator;
 
     std::unordered_map<std::string, IntrusivePtr<VulkanGraphicPass>> renderPasses;
     std::unordered_map<std::string, IntrusivePtr<VulkanComputePass>> computePasses;
@@ -87,25 +108,43 @@ private:
     // subpass name -> graphic, compute pipeline
     std::unordered_map<std::string, IntrusivePtr<Pipeline>> pipelineMap;
 
-    VkCommandPool graphicCommandPool;
-    VkCommandPool computeCommandPool;
+    VkCommandPool graphicCommandPool = VK_NULL_HANDLE;
+    VkCommandPool computeCommandPool = VK_NULL_HANDLE;
     void prepareCommandPool();
+    // pools may still be executing, destroyed through the deletion queue
+    void releaseCommandPool();
 
     // create VkCommandBuffer and VkFramebuffer
     // 1 per frame
     void prepareCommandBuffer(IntrusivePtr<VulkanGraphicPass> &renderPass, VulkanSwapChain *swapChain);
+    // compute passes are submitted with the graphic passes, allocated from the graphic pool
+    void prepareCommandBuffer(IntrusivePtr<VulkanComputePass> &computePass, VulkanSwapChain *swapChain);
     
     // 1. layout transition from UNDEFINED to GENERAL for each attachment
     //    setting layout for shared attachment if restrained by inTransition state
     // 2. create texture and framebuffer (per frame)
     void prepareFrameBuffer(IntrusivePtr<VulkanGraphicPass> &renderPass, VulkanSwapChain *swapChain);
+    // attachments and framebuffers of all render passes
+    void releaseFrameBuffers();
     
     // allocate internal resources for descriptor resolving
     void prepareResources(IntrusivePtr<VulkanGraphicPass> &renderPass, VulkanSwapChain *swapChain);
 
     // record command buffer at imageIndex
     void buildCommandBuffer(uint32_t imageIndex, VulkanSwapChain *swapChain);
+    // dispatches of all states, barriers towards the passes reading the outputs
+    void buildComputeCommandBuffer(IntrusivePtr<VulkanComputePass> &computePass, uint32_t imageIndex, VulkanSwapChain *swapChain);
+    // constants, descriptors and dispatches of the states of a bound compute pipeline, passStatistics may be null
+    // dynamicOffsets holds offsets already resolved per state, null to resolve them from the uniform allocator
+    void recordDispatches(VkCommandBuffer commandBuffer, VulkanComputePipeline *pipeline, uint32_t imageIndex, VulkanSwapChain *swapChain, FrameStatistics::Pass *passStatistics,
+                          const std::vector<std::vector<uint32_t>> *dynamicOffsets = nullptr);
+
+    // time the candidate sizes of the idempotent autotune pipelines, or apply the cached winners
+    void tuneComputePipelines(uint32_t imageIndex, VulkanSwapChain *swapChain);
 
     // allocate all texture resource
     void resolveDrawStatesDescriptors(VulkanSwapChain *swapChain);
+
+    // layout transition from UNDEFINED to GENERAL for storage textures bound by the user
+    void prepareStorageImages(VulkanResourceBindingState *drawState);
 };
\ No newline at end of file
@@ -12,9 +12,11 @@
 
 #include <FrameGraph/Graph.h>
 
+#include <Core/Trace.h>
+
 #include <spdlog/spdlog.h>
 
-VulkanGroupExecutor::VulkanGroupExecutor(IntrusivePtr<Context> context) : context(context)
+VulkanGroupExecutor::VulkanGroupExecutor(IntrusivePtr<Context> context, IntrusivePtr<VulkanGPUProfiler> gpuProfiler, IntrusivePtr<VulkanStatisticsCollector> statistics, IntrusivePtr<CaptureRecorder> captureRecorder) : context(context), gpuProfiler(gpuProfiler), statistics(statistics), captureRecorder(captureRecorder)
 {
 }
 
@@ -28,11 +30,13 @@ void VulkanGroupExecutor::AddRenderGroup(IntrusivePtr<RenderGroup> group)
 {
     auto vrp = (VulkanRenderGroup *)group.get();
     this->renderGroups[group->Name()] = vrp;
+    captureRecorder->RecordAddRenderGroup(vrp);
 }
 
 void VulkanGroupExecutor::BindResource(std::string name, std::vector<IntrusivePtr<ResourceHandle>> resources)
 {
     this->sharedResources[name] = resources;
+    captureRecorder->RecordBindGlobalResource(name, resources);
 }
 
 void VulkanGroupExecutor::Reset()
@@ -40,11 +44,15 @@ void VulkanGroupExecutor::Reset()
     releaseFences();
     releaseSharedResources();
     releaseRenderCommandBuffers();
+    gpuProfiler->Release();
+    statistics->Release();
 
     queueCompleteFences.clear();
+    queueSubmitSerials.clear();
 
     currentFrame = 0;
     currentImage = 0;
+    frameAcquired = false;
 
     for (auto &[name, rg] : renderGroups)
     {
@@ -60,6 +68,7 @@ void VulkanGroupExecutor::prepareFences()
     fenceCreateInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
     fenceCreateInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
     queueCompleteFences.resize(vulkanSC->GetTextures().size());
+    queueSubmitSerials.assign(vulkanSC->GetTextures().size(), 0);
     for (auto &fence : queueCompleteFences)
     {
         vkCreateFence(context->GetVkDevice(), &fenceCreateInfo, nullptr, &fence);
@@ -79,6 +88,81 @@ void VulkanGroupExecutor::releaseSharedResources()
     sharedResources.clear();
 }
 
+void VulkanGroupExecutor::releaseSharedAttachments()
+{
+    for (auto &[groupName, renderGroup] : renderGroups)
+    {
+        for (auto sharedKey : renderGroup->GetGraph()->GetSharedResourceKeys())
+        {
+            if (renderGroup->GetGraph()->GetNodeMap().at(sharedKey)->type == GraphNode::ATTACHMENT)
+            {
+                sharedResources.erase(sharedKey);
+            }
+        }
+    }
+}
+
+void VulkanGroupExecutor::waitInFlightFrames()
+{
+    std::vector<VkFence> fences;
+    for (uint32_t i = 0; i < queueCompleteFences.size(); i++)
+    {
+        // waited and reset by Acquire, nothing is submitted with it yet
+        if (frameAcquired && i == currentFrame)
+            continue;
+        fences.push_back(queueCompleteFences[i]);
+    }
+
+    if (!fences.empty())
+    {
+        vkWaitForFences(context->GetVkDevice(), (uint32_t)fences.size(), fences.data(), VK_TRUE, UINT64_MAX);
+    }
+}
+
+void VulkanGroupExecutor::Resize(IntrusivePtr<SwapChain> newSwapChain)
+{
+    TRACE_SCOPE("VulkanGroupExecutor::Resize");
+
+    auto oldSC = static_cast<VulkanSwapChain *>(this->swapChain.get());
+    auto newSC = static_cast<VulkanSwapChain *>(newSwapChain.get());
+    bool reacquire = frameAcquired;
+
+    // per image objects depend on the image count, rebuild everything
+    if (!oldSC || oldSC->ImageSize() != newSC->ImageSize())
+    {
+        WaitIdle();
+        Reset();
+        SetSwapChain(newSwapChain);
+        Prepare();
+        if (reacquire)
+        {
+            Acquire();
+        }
+        return;
+    }
+
+    // descriptor sets and sync command buffers are rewritten in place
+    waitInFlightFrames();
+
+    SetSwapChain(newSwapChain);
+
+    releaseSharedAttachments();
+    prepareSharedResources();
+
+    for (auto &[name, rg] : renderGroups)
+    {
+        rg->Resize(newSC);
+    }
+
+    // barriers refer to the new swapchain images
+    prepareGlobalSynchronization();
+
+    if (reacquire)
+    {
+        currentImage = newSC->Acquire(currentFrame);
+    }
+}
+
 void VulkanGroupExecutor::prepareSharedResources()
 {
     auto vulkanSC = static_cast<VulkanSwapChain *>(this->swapChain.get());
@@ -132,6 +216,8 @@ void VulkanGroupExecutor::Prepare()
     prepareRenderCommandBuffers();
     prepareSharedResources();
     prepareRenderGroupTopo();
+    gpuProfiler->Prepare(swapChainImageSize);
+    statistics->Prepare(swapChainImageSize);
 
     for (auto &[name, rg] : renderGroups)
     {
@@ -183,14 +269,19 @@ void VulkanGroupExecutor::releaseRenderCommandBuffers()
     renderGroupSyncMap.clear();
     globalSynCommands = {};
 
-    vkDestroyCommandPool(context->GetVkDevice(), commandPool, nullptr);
+    context->GetDeletionQueue().Retire([device = context->GetVkDevice(), commandPool = commandPool]()
+                                       { vkDestroyCommandPool(device, commandPool, nullptr); });
     commandPool = VK_NULL_HANDLE;
 }
 
 void VulkanGroupExecutor::prepareGlobalSynchronization()
 {
-    globalSynCommands.afterGroupExec = createCommandBuffer(swapChain->ImageSize());
-    globalSynCommands.beforeGroupExec = createCommandBuffer(swapChain->ImageSize());
+    // allocated once per Prepare, recorded again on Resize
+    if (globalSynCommands.afterGroupExec.empty())
+    {
+        globalSynCommands.afterGroupExec = createCommandBuffer(swapChain->ImageSize());
+        globalSynCommands.beforeGroupExec = createCommandBuffer(swapChain->ImageSize());
+    }
 
     std::string swapChainKey;
     // search swapchain attachment
@@ -204,6 +295,9 @@ void VulkanGroupExecutor::prepareGlobalSynchronization()
 
     assert(!swapChainKey.empty());
 
+    // headless images are not presented, they stay GENERAL like any other attachment
+    auto finalLayout = swapChain->IsHeadless() ? VK_IMAGE_LAYOUT_GENERAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+
     for (int idx = 0; idx < swapChain->ImageSize(); idx++)
     {
         auto presentTexture = static_cast<VulkanTexture *>(sharedResources[swapChainKey][idx].get());
@@ -214,6 +308,9 @@ void VulkanGroupExecutor::prepareGlobalSynchronization()
         {
             auto &beforeGroupExecCommand = globalSynCommands.beforeGroupExec[idx];
             vkBeginCommandBuffer(beforeGroupExecCommand, &cmdBufferBeginInfo);
+            // timestamp queries of this image are written by the render groups after this point
+            gpuProfiler->RecordReset(beforeGroupExecCommand, idx);
+            statistics->RecordReset(beforeGroupExecCommand, idx);
             VkImageMemoryBarrier imageMemoryBarrier = {};
             imageMemoryBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
             imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
@@ -234,7 +331,7 @@ void VulkanGroupExecutor::prepareGlobalSynchronization()
             imageMemoryBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
             imageMemoryBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
             imageMemoryBarrier.oldLayout = VK_IMAGE_LAYOUT_GENERAL;
-            imageMemoryBarrier.newLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+            imageMemoryBarrier.newLayout = finalLayout;
             imageMemoryBarrier.image = presentTexture->GetImage();
             imageMemoryBarrier.subresourceRange = presentTexture->GetImageSubResourceRange(VK_IMAGE_ASPECT_COLOR_BIT);
             vkCmdPipelineBarrier(afterGroupExecCommand, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_DEPENDENCY_BY_REGION_BIT, 0, nullptr, 0, nullptr, 1, &imageMemoryBarrier);
@@ -303,6 +400,8 @@ void VulkanGroupExecutor::prepareRenderGroupTopo()
 
 bool VulkanGroupExecutor::Execute()
 {
+    TRACE_SCOPE("VulkanGroupExecutor::Execute");
+
     auto vulkanSC = static_cast<VulkanSwapChain *>(this->swapChain.get());
 
     std::vector<VkCommandBuffer> commandBuffers;
@@ -312,12 +411,16 @@ bool VulkanGroupExecutor::Execute()
     // topo sort rendergroups, render group order is deferred from subpasses
     // subpass dependencies must not be cyclic
     // aggregate command buffers
+    // a group with several passes is submitted once, it orders its own passes
+    std::unordered_set<std::string> groupNames;
     for (auto &[level, nodes] : this->globalGraph->Topo().levelsRenderPassOnly)
     {
         for (auto node : nodes)
         {
+            if (!groupNames.insert(node->GroupName()).second)
+                continue;
             groups.push_back(this->renderGroups.at(node->GroupName()));
-            spdlog::info("{} {}", level, node->GlobalName());
+            spdlog::trace("{} {}", level, node->GlobalName());
         }
     }
 
@@ -338,23 +441,33 @@ bool VulkanGroupExecutor::Execute()
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 
-    VkSemaphore waitSemaphores[] = {vulkanSC->GetImageAvailableSemaphores()[currentFrame]};
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
-
     submitInfo.commandBufferCount = (uint32_t)commandBuffers.size();
     submitInfo.pCommandBuffers = commandBuffers.data();
 
-    VkSemaphore signalSemaphores[] = {vulkanSC->GetRenderFinishedSemaphores()[currentFrame]};
-    submitInfo.signalSemaphoreCount = 1;
-    submitInfo.pSignalSemaphores = signalSemaphores;
+    // headless frames are ordered by the queue alone, there is no acquire or present to wait on
+    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
+    if (!vulkanSC->IsHeadless())
+    {
+        submitInfo.waitSemaphoreCount = 1;
+        submitInfo.pWaitSemaphores = &vulkanSC->GetImageAvailableSemaphores()[currentFrame];
+        submitInfo.pWaitDstStageMask = waitStages;
+
+        submitInfo.signalSemaphoreCount = 1;
+        submitInfo.pSignalSemaphores = &vulkanSC->GetRenderFinishedSemaphores()[currentFrame];
+    }
 
+    gpuProfiler->MarkSubmit(currentImage);
+    queueSubmitSerials[currentFrame] = context->GetDeletionQueue().Submit();
     if (vkQueueSubmit(context->GetQueue(VK_QUEUE_GRAPHICS_BIT).queue, 1, &submitInfo, queueCompleteFences[currentFrame]) != VK_SUCCESS)
     {
         throw std::runtime_error("failed to submit draw command buffer!");
     }
+    frameAcquired = false;
+
+    // layout transitions around the frame and one memory barrier after each group
+    statistics->AddBarriers(2 + groups.size());
+    statistics->EndFrame();
+    captureRecorder->EndFrame();
 
     bool presentResult = swapChain->Present(currentImage, currentFrame);
     if (!presentResult)
@@ -373,11 +486,18 @@ uint32_t VulkanGroupExecutor::CurrentImage()
 
 uint32_t VulkanGroupExecutor::Acquire()
 {
+    TRACE_SCOPE("VulkanGroupExecutor::Acquire");
+
     auto vulkanSC = static_cast<VulkanSwapChain *>(this->swapChain.get());
 
     vkWaitForFences(context->GetVkDevice(), 1, &queueCompleteFences[currentFrame], VK_TRUE, UINT64_MAX);
     vkResetFences(context->GetVkDevice(), 1, &queueCompleteFences[currentFrame]);
 
+    // objects released while this frame was in flight can go now
+    context->GetDeletionQueue().Complete(queueSubmitSerials[currentFrame]);
+
+    frameAcquired = true;
+
     currentImage = vulkanSC->Acquire(currentFrame);
     if (currentImage == -1)
     {
@@ -390,8 +510,24 @@ uint32_t VulkanGroupExecutor::Acquire()
 
 void VulkanGroupExecutor::Update()
 {
+    TRACE_SCOPE("VulkanGroupExecutor::Update");
+
     auto vulkanSC = static_cast<VulkanSwapChain *>(this->swapChain.get());
 
+    // command buffers of currentImage are about to be rebuilt, collect their timestamps first
+    gpuProfiler->BeginFrame(currentImage);
+    statistics->BeginFrame(currentImage);
+
+    if (captureRecorder->IsCapturing())
+    {
+        std::vector<ResourceBindingState *> drawStates;
+        for (auto &[_, rg] : this->renderGroups)
+        {
+            rg->GetBindingStates(drawStates);
+        }
+        captureRecorder->RecordFrame(currentImage, drawStates);
+    }
+
     // aggregate command buffers
     for (auto [_, rg] : this->renderGroups)
     {
@@ -402,4 +538,5 @@ void VulkanGroupExecutor::Update()
 void VulkanGroupExecutor::WaitIdle()
 {
     vkDeviceWaitIdle(context->GetVkDevice());
+    context->GetDeletionQueue().Flush();
 }
@@ -10,12 +10,15 @@
 #include <RHI/VulkanRuntime/GraphicsPipeline.h>
 #include <RHI/VulkanRuntime/RenderGroup.h>
 #include <RHI/VulkanRuntime/AuxiliaryExecutor.h>
+#include <RHI/VulkanRuntime/GPUProfiler.h>
+#include <RHI/VulkanRuntime/StatisticsCollector.h>
+#include <RHI/CaptureRecorder.h>
 #include <vulkan/vulkan.h>
 
 class VulkanGroupExecutor : public RenderGroupExecutor
 {
 public:
-    VulkanGroupExecutor(IntrusivePtr<Context> context);
+    VulkanGroupExecutor(IntrusivePtr<Context> context, IntrusivePtr<VulkanGPUProfiler> gpuProfiler, IntrusivePtr<VulkanStatisticsCollector> statistics, IntrusivePtr<CaptureRecorder> captureRecorder);
     virtual ~VulkanGroupExecutor() override;
 
     virtual uint32_t CurrentImage() override;
@@ -26,6 +29,7 @@ public:
     virtual void Update() override;
     virtual void WaitIdle() override;
     virtual void Reset() override;
+    virtual void Resize(IntrusivePtr<SwapChain> swapChain) override;
 
     virtual void AddRenderGroup(IntrusivePtr<RenderGroup> group) override;
 
@@ -33,6 +37,9 @@ public:
 
 private:
     IntrusivePtr<Context> context;
+    IntrusivePtr<VulkanGPUProfiler> gpuProfiler;
+    IntrusivePtr<VulkanStatisticsCollector> statistics;
+    IntrusivePtr<CaptureRecorder> captureRecorder;
     // command buffers for global operations
     VkCommandPool commandPool = VK_NULL_HANDLE;
     std::vector<VkCommandBuffer> renderCommandBuffers;
@@ -45,12 +52,19 @@ private:
     std::unordered_map<std::string, std::vector<IntrusivePtr<ResourceHandle>>> sharedResources;
 
     std::vector<VkFence> queueCompleteFences;
+    // deletion queue serial of the submission guarded by each fence
+    std::vector<uint64_t> queueSubmitSerials;
 
     void prepareFences();
     void releaseFences();
     // allocate all shared resources (per frame), store in sharedResources
     void prepareSharedResources();
     void releaseSharedResources();
+    // shared attachments only, global resources from BindResource are kept
+    void releaseSharedAttachments();
+
+    // wait frames submitted by this executor, not the whole device
+    void waitInFlightFrames();
 
     void prepareRenderCommandBuffers();
     void releaseRenderCommandBuffers();
@@ -78,4 +92,7 @@ private:
 
     uint64_t currentFrame = 0;
     int32_t currentImage = 0;
+
+    // acquired but not yet submitted, fence of currentFrame is reset
+    bool frameAcquired = false;
 };
\ No newline at end of file
@@ -10,28 +10,32 @@
 #include <RHI/VulkanRuntime/TextureView.h>
 #include <RHI/VulkanRuntime/Sampler.h>
 
-VulkanResourceBindingState::VulkanResourceBindingState(IntrusivePtr<Context> context, IntrusivePtr<Pipeline> pipeline) : ResourceBindingState(pipeline), context(context)
+VulkanResourceBindingState::VulkanResourceBindingState(IntrusivePtr<Context> context, IntrusivePtr<Pipeline> pipeline, IntrusivePtr<CaptureRecorder> captureRecorder) : ResourceBindingState(pipeline), context(context), captureRecorder(captureRecorder)
 {
     this->descriptorSet = new VulkanDescriptorSet(context, pipeline);
 }
 
 VulkanResourceBindingState::~VulkanResourceBindingState()
 {
+    captureRecorder->RecordDestroy(this);
 }
 
 void VulkanResourceBindingState::Bind(IntrusivePtr<ResourceHandle> resource)
 {
     descriptorSet->Bind(resource);
+    captureRecorder->RecordBindConstant(this, resource.get());
 }
 
 void VulkanResourceBindingState::Bind(uint32_t set, uint32_t binding, IntrusivePtr<ResourceHandle> resource)
 {
     descriptorSet->Bind(set, binding, resource);
+    captureRecorder->RecordBind(this, set, binding, {resource});
 }
 
 void VulkanResourceBindingState::Bind(uint32_t set, uint32_t binding, std::vector<IntrusivePtr<ResourceHandle>> resources)
 {
     descriptorSet->Bind(set, binding, resources);
+    captureRecorder->RecordBind(this, set, binding, resources);
 }
 
 void VulkanResourceBindingState::BindInternal(uint32_t frameIndex, uint32_t set, uint32_t binding, IntrusivePtr<ResourceHandle> resource)
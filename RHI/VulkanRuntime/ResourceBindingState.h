@@ -5,50 +5,52 @@
 
 #include <RHI/ResourceBindingState.h>
 #include <RHI/MutableBuffer.h>
+#include <RHI/CaptureRecorder.h>
 
 #include <RHI/VulkanRuntime/Context.h>
 #include <RHI/VulkanRuntime/Buffer.h>
+#include <RHI/VulkanRuntime/StreamingBuffer.h>
 #include <RHI/VulkanRuntime/Texture.h>
 #include <RHI/VulkanRuntime/DescriptorSet.h>
 
 class VulkanResourceBindingState : public ResourceBindingState
 {
 public:
-    VulkanResourceBindingState(IntrusivePtr<Context> context, IntrusivePtr<Pipeline> pipeline);
+    VulkanResourceBindingState(IntrusivePtr<Context> context, IntrusivePtr<Pipeline> pipeline, IntrusivePtr<CaptureRecorder> captureRecorder);
     virtual ~VulkanResourceBindingState() override;
     virtual void Bind(IntrusivePtr<ResourceHandle> resource) override;
     virtual void Bind(uint32_t set, uint32_t binding, IntrusivePtr<ResourceHandle> resource) override;
     virtual void Bind(uint32_t set, uint32_t binding, std::vector<IntrusivePtr<ResourceHandle>> resources) override;
 
-    IntrusivePtr<VulkanBuffer> GetVertexBuffer(uint32_t frameIndex)
+    // buffer of frameIndex behind a buffer, buffer array or streaming buffer handle
+    static IntrusivePtr<VulkanBuffer> GetBuffer(IntrusivePtr<ResourceHandle> &buffer, uint32_t frameIndex)
     {
-        if (!vertexBuffer)
+        if (!buffer)
             return nullptr;
 
-        if (this->vertexBuffer->type == ResourceHandle::BUFFER_ARRAY)
+        if (buffer->type == ResourceHandle::BUFFER_ARRAY)
         {
-            auto mutableMuffer = static_cast<MutableBuffer *>(this->vertexBuffer.get());
+            auto mutableMuffer = static_cast<MutableBuffer *>(buffer.get());
             return static_cast<VulkanBuffer *>(mutableMuffer->GetBuffer(frameIndex).get());
         }
+        else if (buffer->type == ResourceHandle::STREAMING_BUFFER)
+        {
+            return static_cast<VulkanStreamingBuffer *>(buffer.get())->GetBuffer(frameIndex);
+        }
         else
         {
-            return static_cast<VulkanBuffer *>(this->vertexBuffer.get());
+            return static_cast<VulkanBuffer *>(buffer.get());
         }
     }
 
+    IntrusivePtr<VulkanBuffer> GetVertexBuffer(uint32_t frameIndex)
+    {
+        return GetBuffer(this->vertexBuffer, frameIndex);
+    }
+
     IntrusivePtr<VulkanBuffer> GetIndexBuffer(uint32_t frameIndex)
     {
-        if (!indexBuffer)
-            return nullptr;
-        if (this->indexBuffer->type == ResourceHandle::BUFFER_ARRAY)
-        {
-            auto mutableMuffer = static_cast<MutableBuffer *>(this->indexBuffer.get());
-            return static_cast<VulkanBuffer *>(mutableMuffer->GetBuffer(frameIndex).get());
-        }
-        else
-        {
-            return static_cast<VulkanBuffer *>(this->indexBuffer.get());
-        }
+        return GetBuffer(this->indexBuffer, frameIndex);
     }
 
     std::vector<VkDescriptorSet> &GetDescriptorSets(uint32_t frameIndex)
@@ -105,6 +107,7 @@ public:
 
 private:
     IntrusivePtr<Context> context;
+    IntrusivePtr<CaptureRecorder> captureRecorder;
 
     IntrusivePtr<VulkanDescriptorSet> descriptorSet;
 
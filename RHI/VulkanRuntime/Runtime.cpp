@@ -1,5 +1,8 @@
 #include <RHI/VulkanRuntime/Runtime.h>
 
+#include <algorithm>
+#include <cctype>
+
 #include <spdlog/spdlog.h>
 
 #include <RHI/ConstantBuffer.h>
@@ -10,6 +13,7 @@
 #include <RHI/VulkanRuntime/GraphicsPipeline.h>
 #include <RHI/VulkanRuntime/ComputePipeline.h>
 #include <RHI/VulkanRuntime/Buffer.h>
+#include <RHI/VulkanRuntime/StreamingBuffer.h>
 #include <RHI/VulkanRuntime/Texture.h>
 #include <RHI/VulkanRuntime/Sampler.h>
 #include <RHI/VulkanRuntime/TextureView.h>
@@ -17,43 +21,190 @@
 #include <RHI/VulkanRuntime/SwapChain.h>
 #include <RHI/VulkanRuntime/SwapChainBuilder.h>
 #include <RHI/VulkanRuntime/AuxiliaryExecutor.h>
+#include <RHI/VulkanRuntime/GPUProfiler.h>
+#include <RHI/VulkanRuntime/StatisticsCollector.h>
 
 #ifdef WINDOW_USE_GLFW
 #include <GLFW/glfw3.h>
 #endif
 
-VulkanRuntime::VulkanRuntime()
+static const std::unordered_map<std::string, VkPhysicalDeviceType> DEVICE_TYPES = {
+    {"discrete", VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU},
+    {"integrated", VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU},
+    {"virtual", VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU},
+    {"cpu", VK_PHYSICAL_DEVICE_TYPE_CPU}};
+
+static std::string ToLower(std::string str)
 {
-    std::vector<const char *> instanceExts;
+    std::transform(str.begin(), str.end(), str.begin(), [](unsigned char c)
+                   { return std::tolower(c); });
+    return str;
+}
 
-#ifdef WINDOW_USE_GLFW
-    glfwInit();
+static std::string DeviceTypeName(VkPhysicalDeviceType type)
+{
+    for (auto &[name, value] : DEVICE_TYPES)
+    {
+        if (value == type)
+            return name;
+    }
+    return "other";
+}
+
+// requested mode first, then the closest modes towards fifo
+static std::vector<VkPresentModeKHR> PresentModeCandidates(const std::string &presentMode)
+{
+    if (presentMode == "mailbox")
+        return {VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR};
+    if (presentMode == "immediate")
+        return {VK_PRESENT_MODE_IMMEDIATE_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_FIFO_KHR};
+    if (presentMode == "fifo_relaxed")
+        return {VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_FIFO_KHR};
+    if (presentMode != "fifo")
+        spdlog::warn("unknown present mode {}, using fifo", presentMode);
+    return {VK_PRESENT_MODE_FIFO_KHR};
+}
+
+static std::string PresentModeName(VkPresentModeKHR mode)
+{
+    switch (mode)
+    {
+    case VK_PRESENT_MODE_IMMEDIATE_KHR:
+        return "immediate";
+    case VK_PRESENT_MODE_MAILBOX_KHR:
+        return "mailbox";
+    case VK_PRESENT_MODE_FIFO_RELAXED_KHR:
+        return "fifo_relaxed";
+    default:
+        return "fifo";
+    }
+}
 
-    uint32_t count;
-    const char **extensions = glfwGetRequiredInstanceExtensions(&count);
-    for (int i = 0; i < count; i++)
+// index, then name, then type, first device if nothing matches
+static int SelectDevice(const RuntimeConfig &config, std::vector<VkPhysicalDevice> devices)
+{
+    std::vector<VkPhysicalDeviceProperties> properties(devices.size());
+    for (int i = 0; i < devices.size(); i++)
     {
-        instanceExts.push_back(extensions[i]);
+        vkGetPhysicalDeviceProperties(devices[i], &properties[i]);
+        spdlog::info("found device {}: {} ({})", i, properties[i].deviceName, DeviceTypeName(properties[i].deviceType));
     }
+
+    if (devices.empty())
+        return -1;
+
+    if (config.deviceIndex >= 0)
+    {
+        if (config.deviceIndex < devices.size())
+            return config.deviceIndex;
+        spdlog::warn("device index {} out of range", config.deviceIndex);
+    }
+
+    if (!config.deviceName.empty())
+    {
+        for (int i = 0; i < devices.size(); i++)
+        {
+            if (ToLower(properties[i].deviceName).find(ToLower(config.deviceName)) != std::string::npos)
+                return i;
+        }
+        spdlog::warn("no device named {}", config.deviceName);
+    }
+
+    if (DEVICE_TYPES.count(config.deviceType))
+    {
+        for (int i = 0; i < devices.size(); i++)
+        {
+            if (properties[i].deviceType == DEVICE_TYPES.at(config.deviceType))
+                return i;
+        }
+    }
+
+    return 0;
+}
+
+VulkanRuntime::VulkanRuntime(RuntimeConfig config) : config(config), headless(config.headless)
+{
+    std::vector<const char *> instanceExts;
+    std::vector<const char *> deviceExts;
+
+    if (!headless)
+    {
+#ifdef WINDOW_USE_GLFW
+        glfwInit();
+
+        uint32_t count;
+        const char **extensions = glfwGetRequiredInstanceExtensions(&count);
+        for (int i = 0; i < count; i++)
+        {
+            instanceExts.push_back(extensions[i]);
+        }
 #endif
+        deviceExts.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+    }
 
-    std::vector<const char *> enableLayers = {"VK_LAYER_KHRONOS_validation"};
+    std::vector<const char *> enableLayers;
+    if (config.validation)
+    {
+        enableLayers.push_back("VK_LAYER_KHRONOS_validation");
 
 // VK_LAYER_LUNARG_monitor not support on mac
 #ifndef __APPLE__
-    enableLayers.push_back("VK_LAYER_LUNARG_monitor");
+        enableLayers.push_back("VK_LAYER_LUNARG_monitor");
 #endif
+    }
+
+    ContextBuilder builder;
+    builder.SetInstanceExtensions(std::move(instanceExts))
+        .SetInstanceLayers(std::move(enableLayers))
+        .SetDeviceExtensions(std::move(deviceExts))
+        .SelectPhysicalDevice([config](std::vector<VkPhysicalDevice> devices)
+                              { return SelectDevice(config, devices); });
+    if (config.validation)
+    {
+        builder.EnableValidationLayer();
+    }
+    if (config.debugUtils)
+    {
+        builder.EnableDebugUtils();
+    }
+    context = builder.Build();
+
+    VkPhysicalDeviceSubgroupProperties subgroupProperties = {};
+    subgroupProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SUBGROUP_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties2 = {};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties2.pNext = &subgroupProperties;
+    vkGetPhysicalDeviceProperties2(context->GetVkPhysicalDevice(), &properties2);
+
+    auto &properties = properties2.properties;
+    runtimeInfo.deviceName = properties.deviceName;
+    runtimeInfo.deviceType = DeviceTypeName(properties.deviceType);
+    runtimeInfo.validation = context->IsValidationEnabled();
+    runtimeInfo.debugUtils = context->IsDebugUtilsEnabled();
+    runtimeInfo.subgroupSize = subgroupProperties.subgroupSize;
+    runtimeInfo.subgroupArithmetic = (subgroupProperties.supportedStages & VK_SHADER_STAGE_COMPUTE_BIT) &&
+                                     (subgroupProperties.supportedOperations & VK_SUBGROUP_FEATURE_BASIC_BIT) &&
+                                     (subgroupProperties.supportedOperations & VK_SUBGROUP_FEATURE_ARITHMETIC_BIT);
+    runtimeInfo.drawIndirectFirstInstance = context->GetEnabledFeatures().drawIndirectFirstInstance;
+    runtimeInfo.fragmentStoresAndAtomics = context->GetEnabledFeatures().fragmentStoresAndAtomics;
+    spdlog::info("device {} ({}), validation {}, debug utils {}, subgroup size {}", runtimeInfo.deviceName, runtimeInfo.deviceType, runtimeInfo.validation, runtimeInfo.debugUtils, runtimeInfo.subgroupSize);
 
-    context = ContextBuilder()
-                  .SetInstanceExtensions(std::move(instanceExts))
-                  .EnableValidationLayer()
-                  .SetInstanceLayers(std::move(enableLayers))
-                  .SetDeviceExtensions({VK_KHR_SWAPCHAIN_EXTENSION_NAME})
-                  .Build();
+    gpuProfiler = new VulkanGPUProfiler(context);
+    statisticsCollector = new VulkanStatisticsCollector(context);
+    captureRecorder = new CaptureRecorder();
+
+    if (config.workgroupTuning)
+    {
+        workgroupTuner = new VulkanWorkgroupTuner(context, config.workgroupTuningCache);
+    }
 }
 
 VulkanRuntime::~VulkanRuntime()
 {
+    gpuProfiler.reset();
+    statisticsCollector.reset();
+    captureRecorder.reset();
+    workgroupTuner.reset();
     context.reset();
 }
 
@@ -64,19 +215,24 @@ IntrusivePtr<Context> VulkanRuntime::GetContext()
 
 IntrusivePtr<RenderGroup> VulkanRuntime::CreateRenderGroup(IntrusivePtr<Graph> graph)
 {
-    auto ae = new VulkanAuxiliaryExecutor(context);
-    return new VulkanRenderGroup(context, graph, ae);
+    auto ae = new VulkanAuxiliaryExecutor(context, statisticsCollector, captureRecorder);
+    auto renderGroup = new VulkanRenderGroup(context, graph, ae, gpuProfiler, statisticsCollector, captureRecorder, workgroupTuner);
+    captureRecorder->RecordRenderGroup(renderGroup, graph.get());
+    return renderGroup;
 }
 
 IntrusivePtr<Buffer> VulkanRuntime::CreateBuffer(Buffer::TypeBits type, MemoryPropertyBits memoryProperties, uint32_t size)
 {
     if (memoryProperties & MemoryProperty::MEMORY_PROPERTY_HOST_LOCAL_BIT)
     {
-        return new ConstantBuffer(size);
+        auto constantBuffer = new ConstantBuffer(size);
+        captureRecorder->RecordBuffer(constantBuffer, type, memoryProperties, size);
+        return constantBuffer;
     }
 
     auto buffer = new VulkanBuffer(context);
     buffer->Allocate(type, memoryProperties, size);
+    captureRecorder->RecordBuffer(buffer, type, memoryProperties, size);
     return buffer;
 }
 
@@ -84,13 +240,29 @@ IntrusivePtr<MutableBuffer> VulkanRuntime::CreateMutableBuffer(Buffer::TypeBits
 {
     auto defaultBuffer = CreateBuffer(type, memoryProperties, size);
     auto bufferArray = new MutableBuffer(defaultBuffer);
+    captureRecorder->RecordMutableBuffer(bufferArray, defaultBuffer.get());
     return bufferArray;
 }
 
+IntrusivePtr<DynamicBuffer> VulkanRuntime::CreateDynamicBuffer(uint32_t size)
+{
+    auto buffer = new DynamicBuffer(size);
+    captureRecorder->RecordDynamicBuffer(buffer);
+    return buffer;
+}
+
+IntrusivePtr<StreamingBuffer> VulkanRuntime::CreateStreamingBuffer(Buffer::TypeBits type, uint32_t initialCapacity)
+{
+    auto buffer = new VulkanStreamingBuffer(context, type, initialCapacity, captureRecorder);
+    captureRecorder->RecordStreamingBuffer(buffer, type, initialCapacity);
+    return buffer;
+}
+
 IntrusivePtr<Texture> VulkanRuntime::CreateTexture(TextureFormat format, Texture::UsageBits type, MemoryPropertyBits memoryProperties, Texture::Extent extent, Texture::Configuration config)
 {
     auto texture = new VulkanTexture(context);
     texture->Allocate(format, type, memoryProperties, extent, config);
+    captureRecorder->RecordTexture(texture, format, type, memoryProperties, extent, config);
     return texture;
 }
 
@@ -98,18 +270,21 @@ IntrusivePtr<Sampler> VulkanRuntime::CreateSampler(IntrusivePtr<Texture> texture
 {
     auto sampler = new VulkanSampler(context, texture);
     sampler->Allocate(config);
+    captureRecorder->RecordSampler(sampler, texture.get(), config);
     return sampler;
 }
 
 IntrusivePtr<RenderGroupExecutor> VulkanRuntime::CreateRenderGroupExecutor()
 {
-    auto rpe = new VulkanGroupExecutor(context);
+    auto rpe = new VulkanGroupExecutor(context, gpuProfiler, statisticsCollector, captureRecorder);
     return rpe;
 }
 
 IntrusivePtr<ResourceBindingState> VulkanRuntime::CreateResourceBindingState(IntrusivePtr<Pipeline> pipeline)
 {
-    return new VulkanResourceBindingState(context, pipeline);
+    auto state = new VulkanResourceBindingState(context, pipeline, captureRecorder);
+    captureRecorder->RecordBindingState(state, pipeline.get());
+    return state;
 }
 
 IntrusivePtr<SwapChain> VulkanRuntime::CreateSwapChain(void *handle, uint32_t width, uint32_t height, IntrusivePtr<SwapChain> oldSwapChain)
@@ -118,17 +293,55 @@ IntrusivePtr<SwapChain> VulkanRuntime::CreateSwapChain(void *handle, uint32_t wi
     auto builder = SwapChainBuilder(context)
                        .SetExtent(width, height)
                        .SetHandle(handle)
-                       .SetPreferPresentMode(VK_PRESENT_MODE_FIFO_KHR)
-                       .SetPreferFormat({VK_FORMAT_B8G8R8A8_UNORM});
-    if (osc)
+                       .SetPreferPresentModes(PresentModeCandidates(config.presentMode))
+                       .SetBufferCount(config.minImageCount)
+                       .SetPreferFormat({VK_FORMAT_B8G8R8A8_UNORM})
+                       .SetHeadless(headless);
+    if (osc && !headless)
     {
         builder.SetSurface(osc->GetSurface())
             .SetOldSwapChain(osc);
     }
-    return builder.Build();
+    captureRecorder->RecordSwapChain(width, height);
+
+    auto swapChain = builder.Build();
+
+    auto presentMode = PresentModeName(swapChain->GetPresentMode());
+    if (presentMode != runtimeInfo.presentMode || swapChain->ImageSize() != runtimeInfo.imageCount)
+    {
+        spdlog::info("swapchain present mode {} (requested {}), {} images (requested {})", presentMode, config.presentMode, swapChain->ImageSize(), config.minImageCount);
+    }
+    runtimeInfo.presentMode = headless ? "headless" : presentMode;
+    runtimeInfo.imageCount = swapChain->ImageSize();
+    return swapChain;
 }
 
 IntrusivePtr<AuxiliaryExecutor> VulkanRuntime::CreateAuxiliaryExecutor()
 {
-    return new VulkanAuxiliaryExecutor(context);
+    return new VulkanAuxiliaryExecutor(context, statisticsCollector, captureRecorder);
+}
+
+MemoryStatistics VulkanRuntime::GetMemoryStatistics()
+{
+    return context->GetMemoryStatistics();
+}
+
+IntrusivePtr<GPUProfiler> VulkanRuntime::GetGPUProfiler()
+{
+    return gpuProfiler;
+}
+
+FrameStatistics VulkanRuntime::GetFrameStatistics()
+{
+    return statisticsCollector->GetFrameStatistics();
+}
+
+IntrusivePtr<CaptureRecorder> VulkanRuntime::GetCaptureRecorder()
+{
+    return captureRecorder;
+}
+
+RuntimeInfo VulkanRuntime::GetRuntimeInfo()
+{
+    return runtimeInfo;
 }
@@ -5,11 +5,14 @@
 #include <RHI/Memory.h>
 #include <RHI/RHIRuntime.h>
 #include <RHI/VulkanRuntime/Context.h>
+#include <RHI/VulkanRuntime/GPUProfiler.h>
+#include <RHI/VulkanRuntime/StatisticsCollector.h>
+#include <RHI/VulkanRuntime/WorkgroupTuner.h>
 
 class VulkanRuntime : public RHIRuntime
 {
 public:
-    VulkanRuntime();
+    VulkanRuntime(RuntimeConfig config = {});
     virtual ~VulkanRuntime() override;
 
     IntrusivePtr<Context> GetContext();
@@ -17,13 +20,34 @@ public:
     virtual IntrusivePtr<RenderGroup> CreateRenderGroup(IntrusivePtr<Graph> graph) override;
     virtual IntrusivePtr<Buffer> CreateBuffer(Buffer::TypeBits type, MemoryPropertyBits, uint32_t size) override;
     virtual IntrusivePtr<MutableBuffer> CreateMutableBuffer(Buffer::TypeBits type, MemoryPropertyBits memoryProperties, uint32_t size) override;
+    virtual IntrusivePtr<DynamicBuffer> CreateDynamicBuffer(uint32_t size) override;
+    virtual IntrusivePtr<StreamingBuffer> CreateStreamingBuffer(Buffer::TypeBits type, uint32_t initialCapacity) override;
     virtual IntrusivePtr<Texture> CreateTexture(TextureFormat format, Texture::UsageBits type, MemoryPropertyBits memoryProperties, Texture::Extent extent, Texture::Configuration config) override;
     virtual IntrusivePtr<Sampler> CreateSampler(IntrusivePtr<Texture> texture, Sampler::Configuration config) override;
     virtual IntrusivePtr<RenderGroupExecutor> CreateRenderGroupExecutor() override;
     virtual IntrusivePtr<ResourceBindingState> CreateResourceBindingState(IntrusivePtr<Pipeline> pipeline) override;
     virtual IntrusivePtr<SwapChain> CreateSwapChain(void *handle, uint32_t width, uint32_t height, IntrusivePtr<SwapChain> oldSwapChain) override;
     virtual IntrusivePtr<AuxiliaryExecutor> CreateAuxiliaryExecutor() override;
+    virtual MemoryStatistics GetMemoryStatistics() override;
+    virtual IntrusivePtr<GPUProfiler> GetGPUProfiler() override;
+    virtual FrameStatistics GetFrameStatistics() override;
+    virtual IntrusivePtr<CaptureRecorder> GetCaptureRecorder() override;
+    virtual RuntimeInfo GetRuntimeInfo() override;
 
 private:
     IntrusivePtr<Context> context = nullptr;
+
+    // shared by all render groups and executors
+    IntrusivePtr<VulkanGPUProfiler> gpuProfiler;
+    IntrusivePtr<VulkanStatisticsCollector> statisticsCollector;
+    IntrusivePtr<CaptureRecorder> captureRecorder;
+
+    // null unless RuntimeConfig::workgroupTuning
+    IntrusivePtr<VulkanWorkgroupTuner> workgroupTuner;
+
+    RuntimeConfig config;
+    RuntimeInfo runtimeInfo;
+
+    // no window system, swapchains render into offscreen textures
+    bool headless = false;
 };
\ No newline at end of file
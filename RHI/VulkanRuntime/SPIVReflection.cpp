@@ -179,6 +179,40 @@ SPIVReflection::~SPIVReflection()
     spvReflectDestroyShaderModule(&module);
 }
 
+std::array<uint32_t, 3> SPIVReflection::GetLocalSize()
+{
+    std::array<uint32_t, 3> localSize = {1, 1, 1};
+    if (module.entry_point_count == 0)
+        return localSize;
+
+    auto &size = module.entry_points[0].local_size;
+    localSize = {std::max(size.x, 1u), std::max(size.y, 1u), std::max(size.z, 1u)};
+    return localSize;
+}
+
+bool SPIVReflection::HasSpecializationConstant(uint32_t specId)
+{
+    static constexpr uint32_t HEADER_WORDS = 5;
+    static constexpr uint32_t OP_DECORATE = 71;
+    static constexpr uint32_t DECORATION_SPEC_ID = 1;
+
+    auto words = reinterpret_cast<const uint32_t *>(shaderCode.data());
+    auto wordCount = shaderCode.size() / sizeof(uint32_t);
+
+    // OpDecorate | target | SpecId | id
+    for (size_t i = HEADER_WORDS; i < wordCount;)
+    {
+        auto length = words[i] >> 16;
+        auto opcode = words[i] & 0xffff;
+        if (length == 0)
+            break;
+        if (opcode == OP_DECORATE && length == 4 && i + 3 < wordCount && words[i + 2] == DECORATION_SPEC_ID && words[i + 3] == specId)
+            return true;
+        i += length;
+    }
+    return false;
+}
+
 SPIVReflection::InputVertexState SPIVReflection::ParseInputVertexState()
 {
     auto shaderType = module.entry_points[0].spirv_execution_model;
@@ -255,6 +289,7 @@ SPIVReflection::DescriptorLayoutState SPIVReflection::ParseDescriptorLayoutState
             layoutBinding.stageFlags = TranslateShaderStage(module.spirv_execution_model);
             layoutBinding.pImmutableSamplers = nullptr;
             layoutBinding.name = reflectBinding->name;
+            layoutBinding.format = TranslateReflectImageFormat(reflectBinding->image.image_format);
             bindings.push_back(layoutBinding);
         }
 
@@ -312,6 +347,49 @@ VkDescriptorType SPIVReflection::TranslateReflectDescriptorType(SpvReflectDescri
     return VK_DESCRIPTOR_TYPE_MAX_ENUM;
 }
 
+VkFormat SPIVReflection::TranslateReflectImageFormat(SpvImageFormat format)
+{
+    switch (format)
+    {
+    case SpvImageFormatRgba32f:
+        return VK_FORMAT_R32G32B32A32_SFLOAT;
+    case SpvImageFormatRgba16f:
+        return VK_FORMAT_R16G16B16A16_SFLOAT;
+    case SpvImageFormatR32f:
+        return VK_FORMAT_R32_SFLOAT;
+    case SpvImageFormatRgba8:
+        return VK_FORMAT_R8G8B8A8_UNORM;
+    case SpvImageFormatRgba8Snorm:
+        return VK_FORMAT_R8G8B8A8_SNORM;
+    case SpvImageFormatRg32f:
+        return VK_FORMAT_R32G32_SFLOAT;
+    case SpvImageFormatRg16f:
+        return VK_FORMAT_R16G16_SFLOAT;
+    case SpvImageFormatR16f:
+        return VK_FORMAT_R16_SFLOAT;
+    case SpvImageFormatR8:
+        return VK_FORMAT_R8_UNORM;
+    case SpvImageFormatRg8:
+        return VK_FORMAT_R8G8_UNORM;
+    case SpvImageFormatRgba32i:
+        return VK_FORMAT_R32G32B32A32_SINT;
+    case SpvImageFormatRg32i:
+        return VK_FORMAT_R32G32_SINT;
+    case SpvImageFormatR32i:
+        return VK_FORMAT_R32_SINT;
+    case SpvImageFormatRgba32ui:
+        return VK_FORMAT_R32G32B32A32_UINT;
+    case SpvImageFormatRg32ui:
+        return VK_FORMAT_R32G32_UINT;
+    case SpvImageFormatR32ui:
+        return VK_FORMAT_R32_UINT;
+    case SpvImageFormatRgba8ui:
+        return VK_FORMAT_R8G8B8A8_UINT;
+    default:
+        return VK_FORMAT_UNDEFINED;
+    }
+}
+
 VkFlags SPIVReflection::TranslateShaderStage(SpvExecutionModel type)
 {
     switch (type)
@@ -320,6 +398,8 @@ VkFlags SPIVReflection::TranslateShaderStage(SpvExecutionModel type)
         return VK_SHADER_STAGE_VERTEX_BIT;
     case SpvExecutionModelFragment:
         return VK_SHADER_STAGE_FRAGMENT_BIT;
+    case SpvExecutionModelGLCompute:
+        return VK_SHADER_STAGE_COMPUTE_BIT;
     default:
     {
         return VK_SHADER_STAGE_FLAG_BITS_MAX_ENUM;
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include <vulkan/vulkan.h>
 #include <spirv_reflect.h>
@@ -9,6 +10,8 @@
 struct VkDescriptorSetLayoutBindingWithName : VkDescriptorSetLayoutBinding
 {
     std::string name;
+    // declared format of storage images and texel buffers, undefined if not declared
+    VkFormat format;
 };
 
 class SPIVReflection : public IntrusiveCounter<SPIVReflection>
@@ -34,8 +37,15 @@ public:
     DescriptorLayoutState ParseDescriptorLayoutState();
 
     static VkDescriptorType TranslateReflectDescriptorType(SpvReflectDescriptorType type);
+    static VkFormat TranslateReflectImageFormat(SpvImageFormat format);
     static VkFlags TranslateShaderStage(SpvExecutionModel type);
 
+    // workgroup size of a compute entry point, 1 for components set through specialization constants
+    std::array<uint32_t, 3> GetLocalSize();
+
+    // a constant decorated with SpecId specId exists
+    bool HasSpecializationConstant(uint32_t specId);
+
     SpvExecutionModel GetShaderType()
     {
         return this->module.spirv_execution_model;
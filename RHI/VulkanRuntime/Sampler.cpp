@@ -6,7 +6,8 @@ VulkanSampler::VulkanSampler(IntrusivePtr<Context> context, IntrusivePtr<Texture
 
 VulkanSampler::~VulkanSampler()
 {
-    vkDestroySampler(context->GetVkDevice(), sampler, nullptr);
+    context->GetDeletionQueue().Retire([device = context->GetVkDevice(), sampler = sampler]()
+                                       { vkDestroySampler(device, sampler, nullptr); });
 }
 
 bool VulkanSampler::Allocate(Configuration config)
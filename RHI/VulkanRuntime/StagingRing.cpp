@@ -0,0 +1,97 @@
+#include <RHI/VulkanRuntime/StagingRing.h>
+
+#include <stdexcept>
+
+static VkDeviceSize alignUp(VkDeviceSize value, VkDeviceSize alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+VulkanStagingRing::VulkanStagingRing(IntrusivePtr<Context> context, VkDeviceSize capacity) : context(context), capacity(capacity)
+{
+    VkBufferCreateInfo bufferCI = {};
+    bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCI.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bufferCI.size = capacity;
+
+    VmaAllocationCreateInfo memoryCI = {};
+    memoryCI.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    memoryCI.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    VmaAllocationInfo allocationInfo;
+    auto result = vmaCreateBuffer(context->GetVmaAllocator(), &bufferCI, &memoryCI, &buffer, &bufferAllocation, &allocationInfo);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create staging ring buffer!");
+    }
+    mappedData = (char *)allocationInfo.pMappedData;
+    context->TrackAllocation(MemoryCategory::STAGING, bufferAllocation);
+}
+
+VulkanStagingRing::~VulkanStagingRing()
+{
+    context->UntrackAllocation(MemoryCategory::STAGING, bufferAllocation);
+    vmaDestroyBuffer(context->GetVmaAllocator(), buffer, bufferAllocation);
+}
+
+bool VulkanStagingRing::Allocate(VkDeviceSize size, VkDeviceSize alignment, uint64_t retireValue, Allocation &allocation)
+{
+    if (size == 0 || size > capacity)
+    {
+        return false;
+    }
+
+    VkDeviceSize begin;
+    if (inFlightRegions.empty())
+    {
+        begin = 0;
+    }
+    else
+    {
+        auto tail = inFlightRegions.front().begin;
+        auto aligned = alignUp(head, alignment);
+        if (head > tail)
+        {
+            // free space is [head, capacity) and [0, tail)
+            if (aligned + size <= capacity)
+                begin = aligned;
+            else if (size <= tail)
+                begin = 0;
+            else
+                return false;
+        }
+        else
+        {
+            // wrapped, free space is [head, tail)
+            if (aligned + size <= tail)
+                begin = aligned;
+            else
+                return false;
+        }
+    }
+
+    head = begin + size;
+    inFlightRegions.push_back(Region{
+        .begin = begin,
+        .end = head,
+        .retireValue = retireValue});
+
+    allocation = Allocation{
+        .buffer = buffer,
+        .offset = begin,
+        .data = mappedData + begin};
+    return true;
+}
+
+void VulkanStagingRing::Retire(uint64_t completedValue)
+{
+    while (!inFlightRegions.empty() && inFlightRegions.front().retireValue <= completedValue)
+    {
+        inFlightRegions.pop_front();
+    }
+
+    if (inFlightRegions.empty())
+    {
+        head = 0;
+    }
+}
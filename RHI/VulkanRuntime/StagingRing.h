@@ -0,0 +1,56 @@
+#pragma once
+
+#include <deque>
+
+#include <vulkan/vulkan.h>
+
+#include <Core/IntrusivePtr.h>
+#include <RHI/VulkanRuntime/Context.h>
+
+// persistently mapped host visible buffer, sub-allocated as a ring
+// each region is tagged with a retire value (submit serial / timeline value)
+// and reclaimed once the gpu work using it has completed
+class VulkanStagingRing : public IntrusiveCounter<VulkanStagingRing>
+{
+public:
+    VulkanStagingRing(IntrusivePtr<Context> context, VkDeviceSize capacity);
+    ~VulkanStagingRing();
+
+    struct Allocation
+    {
+        VkBuffer buffer;
+        VkDeviceSize offset;
+        void *data;
+    };
+
+    // return false if there is no room left until some regions retire
+    bool Allocate(VkDeviceSize size, VkDeviceSize alignment, uint64_t retireValue, Allocation &allocation);
+
+    // release all regions with retireValue <= completedValue
+    void Retire(uint64_t completedValue);
+
+    VkDeviceSize Capacity()
+    {
+        return capacity;
+    }
+
+private:
+    IntrusivePtr<Context> context;
+
+    VkBuffer buffer;
+    VmaAllocation bufferAllocation;
+    char *mappedData = nullptr;
+
+    VkDeviceSize capacity;
+    VkDeviceSize head = 0;
+
+    struct Region
+    {
+        VkDeviceSize begin;
+        VkDeviceSize end;
+        uint64_t retireValue;
+    };
+
+    // ordered by allocation, front is the oldest live region
+    std::deque<Region> inFlightRegions;
+};
@@ -0,0 +1,192 @@
+#include <RHI/VulkanRuntime/StatisticsCollector.h>
+
+#include <stdexcept>
+
+// result order follows the bit order of the flags
+static constexpr VkQueryPipelineStatisticFlags PIPELINE_STATISTICS =
+    VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+    VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+VulkanStatisticsCollector::VulkanStatisticsCollector(IntrusivePtr<Context> context) : context(context)
+{
+    pipelineStatisticsSupported = context->GetEnabledFeatures().pipelineStatisticsQuery;
+}
+
+VulkanStatisticsCollector::~VulkanStatisticsCollector()
+{
+    Release();
+}
+
+bool VulkanStatisticsCollector::PipelineStatisticsSupported()
+{
+    return pipelineStatisticsSupported;
+}
+
+void VulkanStatisticsCollector::Prepare(uint32_t imageCount)
+{
+    Release();
+
+    if (!pipelineStatisticsSupported)
+    {
+        return;
+    }
+
+    frames.resize(imageCount);
+    for (auto &frame : frames)
+    {
+        VkQueryPoolCreateInfo queryPoolCI = {};
+        queryPoolCI.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolCI.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+        queryPoolCI.queryCount = MAX_QUERIES;
+        queryPoolCI.pipelineStatistics = PIPELINE_STATISTICS;
+        if (vkCreateQueryPool(context->GetVkDevice(), &queryPoolCI, nullptr, &frame.queryPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create pipeline statistics query pool!");
+        }
+    }
+}
+
+void VulkanStatisticsCollector::Release()
+{
+    for (auto &frame : frames)
+    {
+        vkDestroyQueryPool(context->GetVkDevice(), frame.queryPool, nullptr);
+    }
+    frames.clear();
+}
+
+void VulkanStatisticsCollector::BeginFrame(uint32_t imageIndex)
+{
+    if (imageIndex >= frames.size())
+    {
+        return;
+    }
+
+    auto &frame = frames[imageIndex];
+    if (!frame.names.empty())
+    {
+        // same as gpu timings, unavailable results are skipped instead of waited for
+        std::vector<Invocations> results(frame.names.size());
+        auto result = vkGetQueryPoolResults(context->GetVkDevice(), frame.queryPool, 0, results.size(),
+                                            results.size() * sizeof(Invocations), results.data(), sizeof(Invocations), VK_QUERY_RESULT_64_BIT);
+        if (result == VK_SUCCESS)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (uint32_t i = 0; i < frame.names.size(); i++)
+            {
+                invocations[frame.names[i]] = results[i];
+            }
+        }
+    }
+
+    frame.names.clear();
+}
+
+void VulkanStatisticsCollector::EndFrame()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    for (auto &pass : current.passes)
+    {
+        auto it = invocations.find(pass.name);
+        if (it == invocations.end())
+            continue;
+
+        pass.hasInvocations = true;
+        pass.vertexInvocations = it->second.vertex;
+        pass.fragmentInvocations = it->second.fragment;
+        pass.computeInvocations = it->second.compute;
+    }
+
+    for (auto &pass : current.passes)
+    {
+        current.drawCount += pass.drawCount;
+        current.instanceCount += pass.instanceCount;
+        current.indexCount += pass.indexCount;
+        current.dispatchCount += pass.dispatchCount;
+        current.pipelineBinds += pass.pipelineBinds;
+        current.descriptorBinds += pass.descriptorBinds;
+    }
+
+    current.frameIndex = frameIndex++;
+    last = std::move(current);
+
+    current = {};
+    passIndices.clear();
+}
+
+void VulkanStatisticsCollector::RecordReset(VkCommandBuffer commandBuffer, uint32_t imageIndex)
+{
+    if (imageIndex >= frames.size())
+    {
+        return;
+    }
+
+    vkCmdResetQueryPool(commandBuffer, frames[imageIndex].queryPool, 0, MAX_QUERIES);
+}
+
+uint32_t VulkanStatisticsCollector::BeginQuery(VkCommandBuffer commandBuffer, uint32_t imageIndex, std::string name)
+{
+    if (imageIndex >= frames.size())
+    {
+        return INVALID_QUERY;
+    }
+
+    auto &frame = frames[imageIndex];
+    if (frame.names.size() >= MAX_QUERIES)
+    {
+        return INVALID_QUERY;
+    }
+
+    uint32_t query = frame.names.size();
+    frame.names.push_back(name);
+
+    vkCmdBeginQuery(commandBuffer, frame.queryPool, query, 0);
+    return query;
+}
+
+void VulkanStatisticsCollector::EndQuery(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t query)
+{
+    if (query == INVALID_QUERY)
+    {
+        return;
+    }
+
+    vkCmdEndQuery(commandBuffer, frames[imageIndex].queryPool, query);
+}
+
+FrameStatistics::Pass &VulkanStatisticsCollector::Pass(const std::string &name)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = passIndices.find(name);
+    if (it != passIndices.end())
+    {
+        return current.passes[it->second];
+    }
+
+    passIndices[name] = current.passes.size();
+    current.passes.push_back(FrameStatistics::Pass{.name = name});
+    return current.passes.back();
+}
+
+void VulkanStatisticsCollector::AddBarriers(uint32_t count)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    current.barrierCount += count;
+}
+
+void VulkanStatisticsCollector::AddTransfers(uint32_t copyCount, uint64_t uploadBytes, uint64_t readbackBytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    current.copyCount += copyCount;
+    current.uploadBytes += uploadBytes;
+    current.readbackBytes += readbackBytes;
+}
+
+FrameStatistics VulkanStatisticsCollector::GetFrameStatistics()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return last;
+}
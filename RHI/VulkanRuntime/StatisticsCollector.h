@@ -0,0 +1,87 @@
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+#include <vulkan/vulkan.h>
+
+#include <RHI/FrameStatistics.h>
+#include <RHI/VulkanRuntime/Context.h>
+
+// per frame counters of what the executors record
+// render groups count draws and binds while building command buffers, auxiliary
+// executors count barriers and transfers, the group executor publishes on submit
+// invocation counts come from pipeline statistics queries, one pool per swapchain image
+class VulkanStatisticsCollector : public IntrusiveCounter<VulkanStatisticsCollector>
+{
+public:
+    VulkanStatisticsCollector(IntrusivePtr<Context> context);
+    ~VulkanStatisticsCollector();
+
+    // false if the device has no pipelineStatisticsQuery feature
+    bool PipelineStatisticsSupported();
+
+    // (re)create query pools, one per image
+    void Prepare(uint32_t imageCount);
+    void Release();
+
+    // resolve the previous invocation counts of imageIndex
+    void BeginFrame(uint32_t imageIndex);
+
+    // publish counters recorded since the previous EndFrame
+    void EndFrame();
+
+    // recorded before any query of the frame, outside of render passes
+    void RecordReset(VkCommandBuffer commandBuffer, uint32_t imageIndex);
+
+    static constexpr uint32_t INVALID_QUERY = UINT32_MAX;
+
+    // invocation counts of a subpass, must begin and end inside the same subpass
+    uint32_t BeginQuery(VkCommandBuffer commandBuffer, uint32_t imageIndex, std::string name);
+    void EndQuery(VkCommandBuffer commandBuffer, uint32_t imageIndex, uint32_t query);
+
+    // counters of the frame being recorded, the reference is valid until the next Pass call
+    FrameStatistics::Pass &Pass(const std::string &name);
+    void AddBarriers(uint32_t count);
+    void AddTransfers(uint32_t copyCount, uint64_t uploadBytes, uint64_t readbackBytes);
+
+    // last published frame
+    FrameStatistics GetFrameStatistics();
+
+private:
+    IntrusivePtr<Context> context;
+
+    bool pipelineStatisticsSupported = false;
+
+    static constexpr uint32_t MAX_QUERIES = 64;
+
+    struct FrameQueries
+    {
+        VkQueryPool queryPool = VK_NULL_HANDLE;
+        std::vector<std::string> names;
+    };
+
+    std::vector<FrameQueries> frames;
+
+    // auxiliary executors may be driven from other threads than the renderer
+    std::mutex mutex;
+
+    FrameStatistics current = {};
+    FrameStatistics last = {};
+    uint64_t frameIndex = 0;
+
+    // subpass name -> index in current.passes
+    std::unordered_map<std::string, size_t> passIndices;
+
+    struct Invocations
+    {
+        uint64_t vertex;
+        uint64_t fragment;
+        uint64_t compute;
+    };
+
+    // latest resolved results per subpass
+    std::unordered_map<std::string, Invocations> invocations;
+};
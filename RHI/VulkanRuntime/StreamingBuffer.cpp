@@ -0,0 +1,100 @@
+#include <RHI/VulkanRuntime/StreamingBuffer.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+VulkanStreamingBuffer::VulkanStreamingBuffer(IntrusivePtr<Context> context, Buffer::TypeBits usage, VkDeviceSize initialCapacity, IntrusivePtr<CaptureRecorder> captureRecorder) : context(context), usage(usage), initialCapacity(initialCapacity), captureRecorder(captureRecorder)
+{
+}
+
+VulkanStreamingBuffer::~VulkanStreamingBuffer()
+{
+}
+
+void *VulkanStreamingBuffer::Map(uint32_t frameIndex, size_t size)
+{
+    if (frameBuffers.size() <= frameIndex)
+    {
+        frameBuffers.resize(frameIndex + 1);
+        captured.resize(frameIndex + 1);
+        capturePending.resize(frameIndex + 1);
+    }
+
+    auto &buffer = frameBuffers[frameIndex];
+    if (!buffer || buffer->Size() < size)
+    {
+        // double the high-water mark so steadily growing content only reallocates log(n) times
+        VkDeviceSize capacity = buffer ? buffer->Size() : initialCapacity;
+        capacity = std::max<VkDeviceSize>(capacity, 1);
+        while (capacity < size)
+        {
+            capacity *= 2;
+        }
+
+        VkBufferCreateInfo bufferCI = {};
+        bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferCI.usage = usage;
+        bufferCI.size = capacity;
+
+        // sequential write lets vma pick write-combined memory, device local if the bar is host visible
+        VmaAllocationCreateInfo memoryCI = {};
+        memoryCI.usage = VMA_MEMORY_USAGE_AUTO;
+        memoryCI.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT;
+        memoryCI.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+        // the old buffer of this frame is no longer referenced by gpu once the frame is being rebuilt
+        IntrusivePtr<VulkanBuffer> newBuffer = new VulkanBuffer(context);
+        if (!newBuffer->Allocate(bufferCI, memoryCI))
+        {
+            throw std::runtime_error("failed to allocate streaming buffer!");
+        }
+        buffer = newBuffer;
+    }
+
+    if (captureRecorder && captureRecorder->IsCapturing())
+    {
+        captured[frameIndex].assign(size, 0);
+        capturePending[frameIndex] = true;
+        return captured[frameIndex].data();
+    }
+
+    captured[frameIndex].clear();
+    capturePending[frameIndex] = false;
+    return buffer->Map();
+}
+
+size_t VulkanStreamingBuffer::Capacity(uint32_t frameIndex)
+{
+    if (frameBuffers.size() <= frameIndex || !frameBuffers[frameIndex])
+    {
+        return 0;
+    }
+    return frameBuffers[frameIndex]->Size();
+}
+
+const void *VulkanStreamingBuffer::CapturedContent(uint32_t frameIndex, size_t &size)
+{
+    if (captured.size() <= frameIndex || captured[frameIndex].empty())
+    {
+        return nullptr;
+    }
+    size = captured[frameIndex].size();
+    return captured[frameIndex].data();
+}
+
+IntrusivePtr<VulkanBuffer> VulkanStreamingBuffer::GetBuffer(uint32_t frameIndex)
+{
+    if (frameBuffers.size() <= frameIndex)
+    {
+        return nullptr;
+    }
+
+    // the application is done writing once the frame is recorded
+    if (capturePending[frameIndex])
+    {
+        memcpy(frameBuffers[frameIndex]->Map(), captured[frameIndex].data(), captured[frameIndex].size());
+        capturePending[frameIndex] = false;
+    }
+    return frameBuffers[frameIndex];
+}
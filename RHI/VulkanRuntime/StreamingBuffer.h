@@ -0,0 +1,38 @@
+#pragma once
+
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include <RHI/StreamingBuffer.h>
+#include <RHI/CaptureRecorder.h>
+#include <RHI/VulkanRuntime/Context.h>
+#include <RHI/VulkanRuntime/Buffer.h>
+
+class VulkanStreamingBuffer : public StreamingBuffer
+{
+public:
+    VulkanStreamingBuffer(IntrusivePtr<Context> context, Buffer::TypeBits usage, VkDeviceSize initialCapacity, IntrusivePtr<CaptureRecorder> captureRecorder);
+    virtual ~VulkanStreamingBuffer() override;
+
+    virtual void *Map(uint32_t frameIndex, size_t size) override;
+    virtual size_t Capacity(uint32_t frameIndex) override;
+    virtual const void *CapturedContent(uint32_t frameIndex, size_t &size) override;
+
+    // nullptr if frameIndex has not been mapped yet, flushes the host copy written while capturing
+    IntrusivePtr<VulkanBuffer> GetBuffer(uint32_t frameIndex);
+
+private:
+    IntrusivePtr<Context> context;
+
+    Buffer::TypeBits usage;
+    VkDeviceSize initialCapacity;
+
+    std::vector<IntrusivePtr<VulkanBuffer>> frameBuffers;
+
+    // mapped memory is write-only, while capturing the application writes a host copy the recorder can read
+    IntrusivePtr<CaptureRecorder> captureRecorder;
+    std::vector<std::vector<char>> captured;
+    // copy not yet written to the frame buffer
+    std::vector<bool> capturePending;
+};
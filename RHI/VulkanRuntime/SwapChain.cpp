@@ -8,17 +8,30 @@ VulkanSwapChain::VulkanSwapChain(IntrusivePtr<Context> context) : context(contex
 
 VulkanSwapChain::~VulkanSwapChain()
 {
-    for (int i = 0; i < imageAvailableSemaphores.size(); i++)
-    {
-        vkDestroySemaphore(context->GetVkDevice(), imageAvailableSemaphores[i], nullptr);
-        vkDestroySemaphore(context->GetVkDevice(), renderFinishedSemaphores[i], nullptr);
-    }
-
-    vkDestroySwapchainKHR(context->GetVkDevice(), swapChain, nullptr);
+    // frames in flight may still wait on the semaphores or present the images
+    context->GetDeletionQueue().Retire([device = context->GetVkDevice(), imageAvailableSemaphores = imageAvailableSemaphores, renderFinishedSemaphores = renderFinishedSemaphores, swapChain = swapChain]()
+                                       {
+                                           for (int i = 0; i < imageAvailableSemaphores.size(); i++)
+                                           {
+                                               vkDestroySemaphore(device, imageAvailableSemaphores[i], nullptr);
+                                               vkDestroySemaphore(device, renderFinishedSemaphores[i], nullptr);
+                                           }
+
+                                           if (swapChain)
+                                           {
+                                               vkDestroySwapchainKHR(device, swapChain, nullptr);
+                                           } });
 }
 
 uint32_t VulkanSwapChain::Acquire(uint32_t currentFrame)
 {
+    if (headless)
+    {
+        auto imageIndex = nextImage;
+        nextImage = (nextImage + 1) % swapChainTextures.size();
+        return imageIndex;
+    }
+
     uint32_t imageIndex;
     VkResult result = vkAcquireNextImageKHR(context->GetVkDevice(), swapChain, UINT64_MAX, imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
     if (result == VK_ERROR_OUT_OF_DATE_KHR)
@@ -34,6 +47,11 @@ uint32_t VulkanSwapChain::Acquire(uint32_t currentFrame)
 
 bool VulkanSwapChain::Present(uint32_t index, uint32_t currentFrame)
 {
+    if (headless)
+    {
+        return true;
+    }
+
     VkSemaphore signalSemaphores[] = {renderFinishedSemaphores[currentFrame]};
 
     VkPresentInfoKHR presentInfo{};
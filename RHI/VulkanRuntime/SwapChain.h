@@ -22,6 +22,16 @@ public:
         return this->swapChainTextures.size();
     }
 
+    virtual bool IsHeadless() override
+    {
+        return headless;
+    }
+
+    virtual IntrusivePtr<Texture> GetTexture(uint32_t index) override
+    {
+        return swapChainTextures[index];
+    }
+
     std::vector<IntrusivePtr<VulkanTexture>> &GetTextures()
     {
         return swapChainTextures;
@@ -42,6 +52,12 @@ public:
         return surface;
     }
 
+    // mode granted by the surface, may differ from the preferred one
+    VkPresentModeKHR GetPresentMode()
+    {
+        return presentMode;
+    }
+
 private:
     friend class SwapChainBuilder;
     friend class VulkanRenderGroup;
@@ -54,11 +70,15 @@ private:
     VkExtent2D extent;
 
     IntrusivePtr<Surface> surface;
-    VkSwapchainKHR swapChain;
+    VkSwapchainKHR swapChain = VK_NULL_HANDLE;
     std::vector<IntrusivePtr<VulkanTexture>> swapChainTextures;
 
     std::vector<VkSemaphore> imageAvailableSemaphores;
     std::vector<VkSemaphore> renderFinishedSemaphores;
 
+    // headless swapchain cycles through its images without surface and semaphores
+    bool headless = false;
+    uint32_t nextImage = 0;
+
     void InitSync(uint32_t imageSize);
 };
\ No newline at end of file
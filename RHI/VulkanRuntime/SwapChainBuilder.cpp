@@ -34,7 +34,13 @@ SwapChainBuilder &SwapChainBuilder::SetPreferDepthStencilFormat(VkFormat format)
 
 SwapChainBuilder &SwapChainBuilder::SetPreferPresentMode(VkPresentModeKHR mode)
 {
-    this->preferPresentMode = mode;
+    this->preferPresentModes = {mode};
+    return *this;
+}
+
+SwapChainBuilder &SwapChainBuilder::SetPreferPresentModes(std::vector<VkPresentModeKHR> modes)
+{
+    this->preferPresentModes = modes;
     return *this;
 }
 
@@ -56,6 +62,12 @@ SwapChainBuilder &SwapChainBuilder::SetOldSwapChain(IntrusivePtr<VulkanSwapChain
     return *this;
 }
 
+SwapChainBuilder &SwapChainBuilder::SetHeadless(bool headless)
+{
+    this->headless = headless;
+    return *this;
+}
+
 void SwapChainBuilder::BuildSurface()
 {
     this->surface = new Surface(context, this->windowHandle);
@@ -96,9 +108,13 @@ void SwapChainBuilder::BuildSwapChainProperties()
     newSwapChain->capabilities = capabilities;
 
     newSwapChain->presentMode = VK_PRESENT_MODE_FIFO_KHR;
-    if (std::find(presentModes.begin(), presentModes.end(), preferPresentMode) != presentModes.end())
+    for (auto mode : preferPresentModes)
     {
-        newSwapChain->presentMode = preferPresentMode;
+        if (std::find(presentModes.begin(), presentModes.end(), mode) != presentModes.end())
+        {
+            newSwapChain->presentMode = mode;
+            break;
+        }
     }
 
 #ifndef NDEBUG
@@ -125,7 +141,12 @@ void SwapChainBuilder::BuildSwapChain()
     sci.sType = VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR;
     sci.surface = surface->GetSurface();
 
-    sci.minImageCount = std::max(capabilities.minImageCount, (uint32_t)2);
+    // maxImageCount 0 means unlimited
+    sci.minImageCount = std::max({capabilities.minImageCount, bufferCount, (uint32_t)2});
+    if (capabilities.maxImageCount)
+    {
+        sci.minImageCount = std::min(sci.minImageCount, capabilities.maxImageCount);
+    }
     sci.imageFormat = newSwapChain->format.format;
     sci.imageColorSpace = newSwapChain->format.colorSpace;
     sci.imageExtent = this->windowExtent;
@@ -165,7 +186,32 @@ void SwapChainBuilder::BuildSwapChain()
     for (int i = 0; i < imageCount; i++)
     {
         IntrusivePtr<VulkanTexture> texture = new VulkanTexture(context);
-        texture->Assign(images[i], newSwapChain->format.format);
+        texture->Assign(images[i], newSwapChain->format.format, sci.imageExtent);
+        texture->SetSwapChain();
+        newSwapChain->swapChainTextures[i] = texture;
+    }
+}
+
+void SwapChainBuilder::BuildOffscreenImages()
+{
+    newSwapChain->headless = true;
+    newSwapChain->format = preferFormat;
+    newSwapChain->presentMode = preferPresentModes.front();
+    newSwapChain->extent = this->windowExtent;
+
+    // transfer src so that frames can be read back
+    auto usage = Texture::Usage::IMAGE_USAGE_COLOR_ATTACHMENT_BIT | Texture::Usage::IMAGE_USAGE_TRANSFER_SRC_BIT | Texture::Usage::IMAGE_USAGE_SAMPLED_BIT;
+
+    auto imageCount = std::max(bufferCount, (uint32_t)2);
+    newSwapChain->swapChainTextures.resize(imageCount);
+    for (int i = 0; i < imageCount; i++)
+    {
+        IntrusivePtr<VulkanTexture> texture = new VulkanTexture(context);
+        auto result = texture->Allocate(VkFormatToGeneralFormat(preferFormat.format), usage, MemoryProperty::MEMORY_PROPERTY_DEVICE_LOCAL_BIT, {windowExtent.width, windowExtent.height, 1}, Texture::Configuration::Default());
+        if (!result)
+        {
+            throw std::runtime_error("Failed to create offscreen image");
+        }
         texture->SetSwapChain();
         newSwapChain->swapChainTextures[i] = texture;
     }
@@ -203,6 +249,14 @@ void SwapChainBuilder::ResolveDepthStencilFormat()
 IntrusivePtr<VulkanSwapChain> SwapChainBuilder::Build()
 {
     this->newSwapChain = new VulkanSwapChain(context);
+
+    if (headless)
+    {
+        BuildOffscreenImages();
+        ResolveDepthStencilFormat();
+        return this->newSwapChain;
+    }
+
     // build surface if surface is not provided
     if (!surface)
         BuildSurface();
@@ -210,6 +264,7 @@ IntrusivePtr<VulkanSwapChain> SwapChainBuilder::Build()
     BuildSwapChain();
     ResolveDepthStencilFormat();
     newSwapChain->surface = this->surface;
-    newSwapChain->InitSync(std::max(capabilities.minImageCount, (uint32_t)2));
+    // frames cycle through all images granted by the driver, one semaphore pair each
+    newSwapChain->InitSync(newSwapChain->swapChainTextures.size());
     return this->newSwapChain;
 }
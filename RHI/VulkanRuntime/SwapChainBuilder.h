@@ -1,5 +1,7 @@
 #pragma once
 
+#include <vector>
+
 #include <vulkan/vulkan.h>
 #include <RHI/VulkanRuntime/Context.h>
 #include <RHI/VulkanRuntime/SwapChain.h>
@@ -14,9 +16,14 @@ public:
     SwapChainBuilder &SetPreferFormat(VkSurfaceFormatKHR format);
     SwapChainBuilder &SetPreferDepthStencilFormat(VkFormat format);
     SwapChainBuilder &SetPreferPresentMode(VkPresentModeKHR mode);
+    // first supported mode wins, FIFO if none is supported
+    SwapChainBuilder &SetPreferPresentModes(std::vector<VkPresentModeKHR> modes);
+    // minimum image count, clamped to the surface capabilities
     SwapChainBuilder &SetBufferCount(uint32_t count);
     SwapChainBuilder &SetSurface(IntrusivePtr<Surface> surface);
     SwapChainBuilder &SetOldSwapChain(IntrusivePtr<VulkanSwapChain> oldSwapChain);
+    // render into offscreen textures, no surface or presentation
+    SwapChainBuilder &SetHeadless(bool headless);
     IntrusivePtr<VulkanSwapChain> Build();
 
 private:
@@ -27,14 +34,16 @@ private:
     IntrusivePtr<Context> context;
     VkSurfaceFormatKHR preferFormat;
     VkFormat preferDepthStencilFormat = VK_FORMAT_UNDEFINED;
-    VkPresentModeKHR preferPresentMode;
+    std::vector<VkPresentModeKHR> preferPresentModes = {VK_PRESENT_MODE_FIFO_KHR};
     uint32_t bufferCount = 2;
     IntrusivePtr<Surface> surface;
+    bool headless = false;
 
     void *windowHandle;
 
     void BuildSurface();
     void BuildSwapChainProperties();
     void BuildSwapChain();
+    void BuildOffscreenImages();
     void ResolveDepthStencilFormat();
 };
\ No newline at end of file
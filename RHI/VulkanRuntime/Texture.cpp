@@ -1,6 +1,8 @@
 #include <RHI/VulkanRuntime/Texture.h>
 #include <RHI/VulkanRuntime/TextureView.h>
 
+#include <stdexcept>
+
 VulkanTexture::VulkanTexture(IntrusivePtr<Context> context) : context(context)
 {
 }
@@ -12,9 +14,14 @@ VulkanTexture::~VulkanTexture()
         vmaUnmapMemory(context->GetVmaAllocator(), imageAllocation);
     }
 
+    releaseShaderViews();
+
     if (!IsExternal())
     {
-        vmaDestroyImage(context->GetVmaAllocator(), image, imageAllocation);
+        context->GetDeletionQueue().Retire([context = context.get(), category = memoryCategory, image = image, allocation = imageAllocation]()
+                                           {
+                                               context->UntrackAllocation(category, allocation);
+                                               vmaDestroyImage(context->GetVmaAllocator(), image, allocation); });
     }
 }
 
@@ -48,7 +55,12 @@ bool VulkanTexture::Allocate(TextureFormat format, UsageBits type, MemoryPropert
 
     auto result = vmaCreateImage(allocator, &imageCI, &allocInfo, &image, &imageAllocation, &imageAllocationInfo);
 
+    auto attachmentUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+    memoryCategory = (imageCI.usage & attachmentUsage) ? MemoryCategory::ATTACHMENT : MemoryCategory::TEXTURE;
+    context->TrackAllocation(memoryCategory, imageAllocation);
+
     this->format = format;
+    this->usage = imageCI.usage;
     this->mimapLevel = config.mipLevels;
     this->layers = config.arrayLayers;
     this->samples = config.samples;
@@ -67,6 +79,46 @@ IntrusivePtr<VulkanTextureView> VulkanTexture::CreateTextureView(VkImageViewCrea
     return view;
 }
 
+VkImageView VulkanTexture::GetShaderView(VkFormat format, VkImageAspectFlags aspectMask)
+{
+    auto key = std::make_pair(format, aspectMask);
+    if (shaderViews.count(key))
+    {
+        return shaderViews[key];
+    }
+
+    VkImageViewCreateInfo ci = {};
+    ci.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+    ci.viewType = LayerCount() > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+    ci.format = format;
+    ci.subresourceRange = {};
+    ci.subresourceRange.aspectMask = aspectMask;
+    ci.subresourceRange.baseMipLevel = 0;
+    ci.subresourceRange.levelCount = LevelCount();
+    ci.subresourceRange.baseArrayLayer = 0;
+    ci.subresourceRange.layerCount = LayerCount();
+    ci.image = image;
+
+    VkImageView imageView = VK_NULL_HANDLE;
+    if (vkCreateImageView(context->GetVkDevice(), &ci, nullptr, &imageView) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create shader image view");
+    }
+
+    shaderViews[key] = imageView;
+    return imageView;
+}
+
+void VulkanTexture::releaseShaderViews()
+{
+    for (auto &[_, imageView] : shaderViews)
+    {
+        context->GetDeletionQueue().Retire([device = context->GetVkDevice(), imageView = imageView]()
+                                           { vkDestroyImageView(device, imageView, nullptr); });
+    }
+    shaderViews.clear();
+}
+
 void *VulkanTexture::Map()
 {
     if (!mappedData)
@@ -81,10 +133,15 @@ void *VulkanTexture::Map()
     return (char *)mappedData;
 }
 
-void VulkanTexture::Assign(VkImage image, VkFormat format)
+void VulkanTexture::Assign(VkImage image, VkFormat format, VkExtent2D extent)
 {
+    releaseShaderViews();
     this->image = image;
     this->format = VkFormatToGeneralFormat(format);
+    this->mimapLevel = 1;
+    this->layers = 1;
+    this->samples = 1;
+    this->extent = {extent.width, extent.height, 1};
 }
 
 VkFormat VulkanTexture::GetFormat()
@@ -1,5 +1,6 @@
 #pragma once
 
+#include <map>
 #include <unordered_set>
 
 #include <RHI/Texture.h>
@@ -76,9 +77,11 @@ public:
     VulkanTexture(IntrusivePtr<Context> context);
     virtual ~VulkanTexture() override;
     virtual bool Allocate(TextureFormat format, UsageBits type, MemoryPropertyBits memoryProperties, Extent extent, Configuration config) override;
-    void Assign(VkImage image, VkFormat format);
+    void Assign(VkImage image, VkFormat format, VkExtent2D extent = {});
 
     IntrusivePtr<VulkanTextureView> CreateTextureView(VkImageViewCreateInfo ci);
+    // view of all levels and layers for shader descriptors, created once per format and aspect
+    VkImageView GetShaderView(VkFormat format, VkImageAspectFlags aspectMask);
     void *Map() override;
 
     VkImage GetImage();
@@ -89,6 +92,17 @@ public:
     bool IsSwapChain();
     void SetSwapChain();
 
+    VkImageUsageFlags GetUsage()
+    {
+        return usage;
+    }
+
+    // last layout set through the auxiliary executor
+    VkImageLayout GetLayout()
+    {
+        return layout;
+    }
+
 private:
     friend class VulkanRuntime;
     friend class VulkanAuxiliaryExecutor;
@@ -98,9 +112,17 @@ private:
     VmaAllocation imageAllocation = VK_NULL_HANDLE;
     VmaAllocationInfo imageAllocationInfo;
     void *mappedData = nullptr;
+    VkImageUsageFlags usage = 0;
+    VkImageLayout layout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+    MemoryCategory memoryCategory = MemoryCategory::TEXTURE;
 
     // whether textue is ref by command buffer
     bool inTransition = false;
 
     bool isSwapChain = false;
+
+    std::map<std::pair<VkFormat, VkImageAspectFlags>, VkImageView> shaderViews;
+    // retire the cached views, the image they refer to is going away
+    void releaseShaderViews();
 };
\ No newline at end of file
@@ -13,5 +13,6 @@ bool VulkanTextureView::Allocate(IntrusivePtr<VulkanTexture> parent, VkImageView
 
 VulkanTextureView::~VulkanTextureView()
 {
-    vkDestroyImageView(context->GetVkDevice(), imageView, nullptr);
+    context->GetDeletionQueue().Retire([device = context->GetVkDevice(), imageView = imageView]()
+                                       { vkDestroyImageView(device, imageView, nullptr); });
 }
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include <RHI/VulkanRuntime/UniformAllocator.h>
+
+#include <algorithm>
+#include <atomic>
+#include <stdexcept>
+
+static std::atomic<uint64_t> pageGeneration = 1;
+
+VulkanUniformAllocator::VulkanUniformAllocator(IntrusivePtr<Context> context, VkDeviceSize pageSize) : context(context), pageSize(pageSize)
+{
+    VkPhysicalDeviceProperties properties;
+    vkGetPhysicalDeviceProperties(context->GetVkPhysicalDevice(), &properties);
+    // slices may be bound as uniform or storage buffers
+    alignment = std::max<VkDeviceSize>({properties.limits.minUniformBufferOffsetAlignment, properties.limits.minStorageBufferOffsetAlignment, 16});
+}
+
+VulkanUniformAllocator::~VulkanUniformAllocator()
+{
+    for (auto &[_, pages] : framePages)
+    {
+        for (auto &page : pages)
+        {
+            destroyPage(page);
+        }
+    }
+}
+
+void VulkanUniformAllocator::Reset(uint32_t frameIndex)
+{
+    auto &pages = framePages[frameIndex];
+    if (pages.empty())
+    {
+        return;
+    }
+
+    // frame overflowed last time, merge into a single page so bound buffers stay stable
+    if (pages.size() > 1)
+    {
+        VkDeviceSize totalSize = 0;
+        for (auto &page : pages)
+        {
+            totalSize += page.size;
+            destroyPage(page);
+        }
+        pages.clear();
+        pages.push_back(createPage(totalSize));
+    }
+
+    pages.back().head = 0;
+}
+
+VulkanUniformAllocator::Allocation VulkanUniformAllocator::Allocate(uint32_t frameIndex, VkDeviceSize size)
+{
+    auto &pages = framePages[frameIndex];
+
+    auto alignedSize = (size + alignment - 1) / alignment * alignment;
+    if (pages.empty() || pages.back().head + alignedSize > pages.back().size)
+    {
+        // grow geometrically, earlier slices of this frame stay in the old pages
+        auto newSize = pages.empty() ? pageSize : pages.back().size * 2;
+        pages.push_back(createPage(std::max(newSize, alignedSize)));
+    }
+
+    auto &page = pages.back();
+    Allocation allocation = {
+        .buffer = page.buffer,
+        .offset = uint32_t(page.head),
+        .data = page.mappedData + page.head,
+        .generation = page.generation};
+    page.head += alignedSize;
+
+    return allocation;
+}
+
+VulkanUniformAllocator::Page VulkanUniformAllocator::createPage(VkDeviceSize size)
+{
+    VkBufferCreateInfo bufferCI = {};
+    bufferCI.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    bufferCI.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+    bufferCI.size = size;
+
+    VmaAllocationCreateInfo memoryCI = {};
+    memoryCI.flags = VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    memoryCI.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+
+    Page page = {};
+    VmaAllocationInfo allocationInfo;
+    auto result = vmaCreateBuffer(context->GetVmaAllocator(), &bufferCI, &memoryCI, &page.buffer, &page.allocation, &allocationInfo);
+    if (result != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create uniform allocator page!");
+    }
+
+    context->TrackAllocation(MemoryCategory::UNIFORM, page.allocation);
+
+    page.mappedData = (char *)allocationInfo.pMappedData;
+    page.size = size;
+    page.head = 0;
+    page.generation = pageGeneration++;
+    return page;
+}
+
+void VulkanUniformAllocator::destroyPage(Page &page)
+{
+    context->GetDeletionQueue().Retire([context = context.get(), buffer = page.buffer, allocation = page.allocation]()
+                                       {
+                                           context->UntrackAllocation(MemoryCategory::UNIFORM, allocation);
+                                           vmaDestroyBuffer(context->GetVmaAllocator(), buffer, allocation); });
+}
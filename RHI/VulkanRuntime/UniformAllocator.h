@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#include <vulkan/vulkan.h>
+
+#include <Core/IntrusivePtr.h>
+#include <RHI/VulkanRuntime/Context.h>
+
+// per frame linear allocator for uniform data
+// each frame owns persistently mapped pages, slices are handed out with
+// min uniform/storage buffer offset alignment and the whole frame is rewound at once
+class VulkanUniformAllocator : public IntrusiveCounter<VulkanUniformAllocator>
+{
+public:
+    VulkanUniformAllocator(IntrusivePtr<Context> context, VkDeviceSize pageSize = 1024 * 1024);
+    ~VulkanUniformAllocator();
+
+    struct Allocation
+    {
+        VkBuffer buffer;
+        uint32_t offset;
+        void *data;
+        // of the page, unique over all allocators, a destroyed page's handle may come back for a new one
+        uint64_t generation;
+    };
+
+    // gpu work of frameIndex must be completed
+    void Reset(uint32_t frameIndex);
+
+    Allocation Allocate(uint32_t frameIndex, VkDeviceSize size);
+
+private:
+    IntrusivePtr<Context> context;
+
+    VkDeviceSize pageSize;
+    VkDeviceSize alignment;
+
+    struct Page
+    {
+        VkBuffer buffer;
+        VmaAllocation allocation;
+        char *mappedData;
+        VkDeviceSize size;
+        VkDeviceSize head;
+        uint64_t generation;
+    };
+
+    // the last page is the one being allocated from
+    std::unordered_map<uint32_t, std::vector<Page>> framePages;
+
+    Page createPage(VkDeviceSize size);
+    void destroyPage(Page &page);
+};
@@ -0,0 +1,273 @@
+#include <RHI/VulkanRuntime/WorkgroupTuner.h>
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <stdexcept>
+
+#include <json_struct/json_struct.h>
+#include <spdlog/spdlog.h>
+
+#include <Core/ReadFile.h>
+
+struct WorkgroupTuningEntry
+{
+    std::string device;
+    std::string shader;
+    std::vector<uint32_t> localGroupSize;
+    double milliseconds;
+
+    JS_OBJ(device, shader, localGroupSize, milliseconds);
+};
+
+struct WorkgroupTuningCache
+{
+    std::vector<WorkgroupTuningEntry> entries;
+
+    JS_OBJ(entries);
+};
+
+static std::string ToHex(const uint8_t *data, size_t size)
+{
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    for (size_t i = 0; i < size; i++)
+    {
+        hex.push_back(digits[data[i] >> 4]);
+        hex.push_back(digits[data[i] & 0xf]);
+    }
+    return hex;
+}
+
+VulkanWorkgroupTuner::VulkanWorkgroupTuner(IntrusivePtr<Context> context, std::string cachePath) : context(context), cachePath(cachePath)
+{
+    VkPhysicalDeviceIDProperties idProperties = {};
+    idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+    VkPhysicalDeviceProperties2 properties2 = {};
+    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+    properties2.pNext = &idProperties;
+    vkGetPhysicalDeviceProperties2(context->GetVkPhysicalDevice(), &properties2);
+
+    deviceUUID = ToHex(idProperties.deviceUUID, VK_UUID_SIZE);
+    limits = properties2.properties.limits;
+
+    uint32_t queueFamilyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(context->GetVkPhysicalDevice(), &queueFamilyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(context->GetVkPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+    auto queue = context->GetQueue(VK_QUEUE_GRAPHICS_BIT);
+    auto validBits = queueFamilies[queue.familyIndex].timestampValidBits;
+    if (validBits && limits.timestampPeriod > 0.0f)
+    {
+        timestampPeriod = limits.timestampPeriod;
+        timestampMask = validBits >= 64 ? UINT64_MAX : (uint64_t(1) << validBits) - 1;
+    }
+
+    VkCommandPoolCreateInfo cmdPoolInfo = {};
+    cmdPoolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+    cmdPoolInfo.queueFamilyIndex = queue.familyIndex;
+    cmdPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    if (vkCreateCommandPool(context->GetVkDevice(), &cmdPoolInfo, nullptr, &commandPool) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to create workgroup tuner command pool!");
+    }
+
+    VkCommandBufferAllocateInfo commandBufferAllocateInfo = {};
+    commandBufferAllocateInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+    commandBufferAllocateInfo.commandPool = commandPool;
+    commandBufferAllocateInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandBufferAllocateInfo.commandBufferCount = 1;
+    vkAllocateCommandBuffers(context->GetVkDevice(), &commandBufferAllocateInfo, &commandBuffer);
+
+    VkFenceCreateInfo fenceInfo = {};
+    fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    vkCreateFence(context->GetVkDevice(), &fenceInfo, nullptr, &fence);
+
+    if (Supported())
+    {
+        VkQueryPoolCreateInfo queryPoolCI = {};
+        queryPoolCI.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        queryPoolCI.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        queryPoolCI.queryCount = MAX_REPEATS * 2;
+        if (vkCreateQueryPool(context->GetVkDevice(), &queryPoolCI, nullptr, &queryPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create timestamp query pool!");
+        }
+    }
+
+    load();
+}
+
+VulkanWorkgroupTuner::~VulkanWorkgroupTuner()
+{
+    // Measure waits for its submission, nothing is in flight
+    vkDestroyQueryPool(context->GetVkDevice(), queryPool, nullptr);
+    vkDestroyFence(context->GetVkDevice(), fence, nullptr);
+    vkDestroyCommandPool(context->GetVkDevice(), commandPool, nullptr);
+}
+
+bool VulkanWorkgroupTuner::Supported()
+{
+    return timestampPeriod > 0.0f;
+}
+
+// fnv-1a 64
+uint64_t VulkanWorkgroupTuner::HashShader(const std::vector<char> &shaderCode)
+{
+    uint64_t hash = 14695981039346656037ull;
+    for (auto c : shaderCode)
+    {
+        hash ^= uint8_t(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+std::string VulkanWorkgroupTuner::key(uint64_t shaderHash)
+{
+    return deviceUUID + "/" + ToHex(reinterpret_cast<const uint8_t *>(&shaderHash), sizeof(shaderHash));
+}
+
+bool VulkanWorkgroupTuner::Lookup(uint64_t shaderHash, std::array<uint32_t, 3> &localGroupSize)
+{
+    auto it = entries.find(key(shaderHash));
+    if (it == entries.end())
+        return false;
+
+    localGroupSize = it->second.localGroupSize;
+    return true;
+}
+
+void VulkanWorkgroupTuner::Store(uint64_t shaderHash, std::array<uint32_t, 3> localGroupSize, double milliseconds)
+{
+    entries[key(shaderHash)] = {localGroupSize, milliseconds};
+    save();
+}
+
+std::vector<std::array<uint32_t, 3>> VulkanWorkgroupTuner::Candidates(uint32_t dimensions)
+{
+    std::vector<std::array<uint32_t, 3>> sizes;
+    if (dimensions == 1)
+    {
+        for (uint32_t x = 32; x <= 1024; x *= 2)
+        {
+            sizes.push_back({x, 1, 1});
+        }
+    }
+    else if (dimensions >= 2)
+    {
+        sizes = {{8, 4, 1}, {8, 8, 1}, {16, 8, 1}, {16, 16, 1}, {32, 8, 1}, {32, 16, 1}, {32, 32, 1}};
+    }
+
+    std::erase_if(sizes, [&](const std::array<uint32_t, 3> &size)
+                  { return size[0] > limits.maxComputeWorkGroupSize[0] ||
+                           size[1] > limits.maxComputeWorkGroupSize[1] ||
+                           size[0] * size[1] * size[2] > limits.maxComputeWorkGroupInvocations; });
+    return sizes;
+}
+
+double VulkanWorkgroupTuner::Measure(std::function<void(VkCommandBuffer)> record, uint32_t repeats)
+{
+    if (!Supported())
+    {
+        return 0.0;
+    }
+
+    repeats = std::clamp(repeats, 1u, MAX_REPEATS);
+
+    VkCommandBufferBeginInfo cmdBufferBeginInfo = {};
+    cmdBufferBeginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    cmdBufferBeginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commandBuffer, &cmdBufferBeginInfo);
+    vkCmdResetQueryPool(commandBuffer, queryPool, 0, repeats * 2);
+
+    for (uint32_t i = 0; i < repeats; i++)
+    {
+        // runs do not overlap each other or earlier submissions
+        VkMemoryBarrier memoryBarrier = {
+            .sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER,
+            .srcAccessMask = VK_ACCESS_MEMORY_WRITE_BIT,
+            .dstAccessMask = VK_ACCESS_MEMORY_READ_BIT | VK_ACCESS_MEMORY_WRITE_BIT};
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &memoryBarrier, 0, nullptr, 0, nullptr);
+
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, queryPool, i * 2);
+        record(commandBuffer);
+        vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, queryPool, i * 2 + 1);
+    }
+
+    vkEndCommandBuffer(commandBuffer);
+
+    VkSubmitInfo submitInfo = {};
+    submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &commandBuffer;
+    if (vkQueueSubmit(context->GetQueue(VK_QUEUE_GRAPHICS_BIT).queue, 1, &submitInfo, fence) != VK_SUCCESS)
+    {
+        throw std::runtime_error("failed to submit workgroup tuning command buffer!");
+    }
+    vkWaitForFences(context->GetVkDevice(), 1, &fence, VK_TRUE, UINT64_MAX);
+    vkResetFences(context->GetVkDevice(), 1, &fence);
+    vkResetCommandBuffer(commandBuffer, 0);
+
+    std::array<uint64_t, MAX_REPEATS * 2> timestamps = {};
+    vkGetQueryPoolResults(context->GetVkDevice(), queryPool, 0, repeats * 2, sizeof(uint64_t) * repeats * 2, timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
+
+    double fastest = std::numeric_limits<double>::max();
+    for (uint32_t i = 0; i < repeats; i++)
+    {
+        auto ticks = (timestamps[i * 2 + 1] - timestamps[i * 2]) & timestampMask;
+        fastest = std::min(fastest, double(ticks) * timestampPeriod / 1000000.0);
+    }
+    return fastest;
+}
+
+void VulkanWorkgroupTuner::load()
+{
+    if (!std::filesystem::exists(cachePath))
+        return;
+
+    WorkgroupTuningCache cache;
+    auto jsonStr = ReadStringFile(cachePath);
+    JS::ParseContext parseContext(jsonStr);
+    if (parseContext.parseTo(cache) != JS::Error::NoError)
+    {
+        spdlog::warn("ignoring workgroup tuning cache {}: {}", cachePath, parseContext.makeErrorString());
+        return;
+    }
+
+    for (auto &entry : cache.entries)
+    {
+        if (entry.localGroupSize.size() != 3)
+            continue;
+        entries[entry.device + "/" + entry.shader] = {{entry.localGroupSize[0], entry.localGroupSize[1], entry.localGroupSize[2]}, entry.milliseconds};
+    }
+    spdlog::info("loaded {} workgroup sizes from {}", entries.size(), cachePath);
+}
+
+void VulkanWorkgroupTuner::save()
+{
+    WorkgroupTuningCache cache;
+    for (auto &[name, entry] : entries)
+    {
+        auto separator = name.find('/');
+        cache.entries.push_back({
+            .device = name.substr(0, separator),
+            .shader = name.substr(separator + 1),
+            .localGroupSize = {entry.localGroupSize.begin(), entry.localGroupSize.end()},
+            .milliseconds = entry.milliseconds});
+    }
+
+    // stable file content across runs
+    std::sort(cache.entries.begin(), cache.entries.end(), [](const WorkgroupTuningEntry &a, const WorkgroupTuningEntry &b)
+              { return a.device != b.device ? a.device < b.device : a.shader < b.shader; });
+
+    std::ofstream file(cachePath);
+    if (!file)
+    {
+        spdlog::warn("failed to write workgroup tuning cache {}", cachePath);
+        return;
+    }
+    file << JS::serializeStruct(cache);
+}
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <array>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <vulkan/vulkan.h>
+
+#include <Core/IntrusivePtr.h>
+#include <RHI/VulkanRuntime/Context.h>
+
+// times compute dispatches with candidate workgroup sizes and remembers the fastest
+// winners are persisted as json, keyed by device uuid and a hash of the spir-v
+class VulkanWorkgroupTuner : public IntrusiveCounter<VulkanWorkgroupTuner>
+{
+public:
+    VulkanWorkgroupTuner(IntrusivePtr<Context> context, std::string cachePath);
+    ~VulkanWorkgroupTuner();
+
+    // false if the queue has no usable timestamps
+    bool Supported();
+
+    static uint64_t HashShader(const std::vector<char> &shaderCode);
+
+    // tuned size of the shader on this device
+    bool Lookup(uint64_t shaderHash, std::array<uint32_t, 3> &localGroupSize);
+
+    // remember and persist the size
+    void Store(uint64_t shaderHash, std::array<uint32_t, 3> localGroupSize, double milliseconds);
+
+    // sizes within the device limits, x only for 1 dimension, x and y for 2
+    std::vector<std::array<uint32_t, 3>> Candidates(uint32_t dimensions);
+
+    // submit the commands and wait, gpu milliseconds of the fastest of repeats runs
+    // every run is preceded by a full memory barrier
+    double Measure(std::function<void(VkCommandBuffer)> record, uint32_t repeats = 3);
+
+private:
+    IntrusivePtr<Context> context;
+    std::string cachePath;
+
+    // hex of VkPhysicalDeviceIDProperties::deviceUUID
+    std::string deviceUUID;
+
+    VkPhysicalDeviceLimits limits;
+
+    float timestampPeriod = 0.0f;
+    uint64_t timestampMask = 0;
+
+    static constexpr uint32_t MAX_REPEATS = 8;
+
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+    VkFence fence = VK_NULL_HANDLE;
+    VkQueryPool queryPool = VK_NULL_HANDLE;
+
+    struct Entry
+    {
+        std::array<uint32_t, 3> localGroupSize;
+        double milliseconds;
+    };
+
+    // "device/shader" -> entry, entries of other devices are kept for saving
+    std::unordered_map<std::string, Entry> entries;
+
+    std::string key(uint64_t shaderHash);
+    void load();
+    void save();
+};